@@ -47,6 +47,11 @@ public:
 
     static bool VirtualProtect( void* ptr, size_t size, VProtect flags = VProtect::NoAccess );
 
+    /// Request (or opt-out of) huge pages for the specified memory region.
+    /// Returns false if not supported.
+    /// NOTE: Pages must not yet be faulted.
+    static bool VirtualAdviseHugePages( void* ptr, size_t size, bool enable );
+
     /// Set the processor affinity mask for the current process
     // static uint64 SetCurrentProcessAffinityMask( uint64 mask );
 
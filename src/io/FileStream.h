@@ -21,8 +21,9 @@ enum class FileMode : uint16
 enum class FileFlags : uint32
 {
     None        = 0,
-    NoBuffering = 1 << 0,
-    LargeFile   = 1 << 1,
+    NoBuffering    = 1 << 0,
+    LargeFile      = 1 << 1,
+    NoWriteThrough = 1 << 2,   // With NoBuffering: Don't wait for each write to reach the device. Call Flush() to persist the data.
 };
 ImplementFlagOps( FileFlags );
 
@@ -83,7 +84,11 @@ public:
 
     static size_t GetBlockSizeForPath( const char* pathU8 );
 
-    // Change name or location of file
+    // Bytes available to the user on the file system of the given path. Returns 0 on failure.
+    static uint64 GetFreeSpaceForPath( const char* pathU8 );
+
+    // Change name or location of file, replacing an existing file at the new path.
+    // Fails if the paths are on different file systems or volumes, rather than copying the file.
     static bool   Move( const char* oldPathU8, const char* newPathU8, int32* outError = nullptr );
 
 private:
@@ -26,6 +26,14 @@ void PlotValidatorPrintUsage();
 void PlotCompareMain( GlobalPlotConfig& gCfg, CliParser& cli );
 void PlotCompareMainPrintUsage();
 
+// PlotProver.cpp
+void PlotProverMain( GlobalPlotConfig& gCfg, CliParser& cli );
+void PlotProverPrintUsage();
+
+// FarmSim.cpp
+void FarmSimMain( GlobalPlotConfig& gCfg, CliParser& cli );
+void FarmSimPrintUsage();
+
 
 
 struct Plotter 
@@ -82,29 +90,39 @@ int main( int argc, const char* argv[] )
     // Start plotting
     for( int64 i = 0; i < plotCount; i++ )
     {
-        // Generate a plot id and memo
-        PlotTools::GeneratePlotIdAndMemo( plotId, plotMemo, plotMemoSize,
-                                          cfg.farmerPublicKey, cfg.poolPublicKey, cfg.poolContractPuzzleHash );
+        const char* plotFileName = plotOutPath + outputFolderLen;
 
-        // Apply debug plot id and/or memo
-        if( cfg.plotIdStr )
-            HexStrToBytes( cfg.plotIdStr, BB_PLOT_ID_LEN*2, plotId, BB_PLOT_ID_LEN );
+        // Finish an interrupted plot first, if we were asked to resume one
+        const bool resuming = i == 0 && _plotter.disk && 
+                              _plotter.disk->GetResumePlot( plotId, plotMemo, plotMemoSize, (char*)plotFileName );
 
-        if( cfg.plotMemoStr )
+        if( !resuming )
         {
-            const size_t memoLen = strlen( cfg.plotMemoStr );
-            HexStrToBytes( cfg.plotMemoStr, memoLen, plotMemo, memoLen/2 );
+            // Generate a plot id and memo
+            PlotTools::GeneratePlotIdAndMemo( plotId, plotMemo, plotMemoSize,
+                                              cfg.farmerPublicKey, cfg.poolPublicKey, cfg.poolContractPuzzleHash );
+
+            // Apply debug plot id and/or memo
+            if( cfg.plotIdStr )
+                HexStrToBytes( cfg.plotIdStr, BB_PLOT_ID_LEN*2, plotId, BB_PLOT_ID_LEN );
+
+            if( cfg.plotMemoStr )
+            {
+                const size_t memoLen = strlen( cfg.plotMemoStr );
+                HexStrToBytes( cfg.plotMemoStr, memoLen, plotMemo, memoLen/2 );
+            }
+
+            // Set the plot file name
+            PlotTools::GenPlotFileName( plotId, (char*)plotFileName );
         }
 
         // Convert plot id to string
         PlotTools::PlotIdToString( plotId, plotIdStr );
 
-        // Set the plot file name
-        const char* plotFileName = plotOutPath + outputFolderLen;
-        PlotTools::GenPlotFileName( plotId, (char*)plotFileName );
-
         // Begin plot
-        if( cfg.plotCount == 0 )
+        if( resuming )
+            Log::Line( "Resuming plot %lld: %s", i+1, plotIdStr );
+        else if( cfg.plotCount == 0 )
             Log::Line( "Generating plot %lld: %s", i+1, plotIdStr );
         else
             Log::Line( "Generating plot %lld / %u: %s", i+1, cfg.plotCount, plotIdStr );
@@ -133,6 +151,9 @@ int main( int argc, const char* argv[] )
             plotter.Plot( req );
         }
     }
+
+    if( _plotter.disk )
+        _plotter.disk->WaitForRelocations();
 }
 
 //-----------------------------------------------------------
@@ -267,6 +288,16 @@ void ParseCommandLine( GlobalPlotConfig& cfg, int argc, const char* argv[] )
             PlotCompareMain( cfg, cli );
             exit( 0 );
         }
+        else if( cli.ArgConsume( "prove" ) )
+        {
+            PlotProverMain( cfg, cli );
+            exit( 0 );
+        }
+        else if( cli.ArgConsume( "farmsim" ) )
+        {
+            FarmSimMain( cfg, cli );
+            exit( 0 );
+        }
         else if( cli.ArgConsume( "help" ) )
         {
             if( cli.HasArgs() )
@@ -281,6 +312,10 @@ void ParseCommandLine( GlobalPlotConfig& cfg, int argc, const char* argv[] )
                     PlotValidatorPrintUsage();
                 else if( cli.ArgMatch( "plotcmp" ) )
                     PlotCompareMainPrintUsage();
+                else if( cli.ArgMatch( "prove" ) )
+                    PlotProverPrintUsage();
+                else if( cli.ArgMatch( "farmsim" ) )
+                    FarmSimPrintUsage();
                 else
                     Fatal( "Unknown command '%s'.", cli.Arg() );
 
@@ -407,6 +442,8 @@ R"(
  iotest     : Perform a write and read test on a specified disk.
  memtest    : Perform a memory (RAM) copy test.
  validate   : Validates all entries in a plot to ensure they all evaluate to a valid proof.
+ prove      : Looks up proofs for challenges in a plot and reports the lookup latency.
+ farmsim    : Simulates the harvester workload on a set of plots and reports the lookup latencies.
  help       : Output this help message, or help for a specific command, if specified.
 
 [GLOBAL_OPTIONS]:
@@ -133,6 +133,16 @@ bool SysHost::VirtualProtect( void* ptr, size_t size, VProtect flags )
     return r == 0;
 }
 
+//-----------------------------------------------------------
+bool SysHost::VirtualAdviseHugePages( void* ptr, size_t size, bool enable )
+{
+    ASSERT( ptr );
+
+    // Transparent huge pages
+    const int r = madvise( ptr, size, enable ? MADV_HUGEPAGE : MADV_NOHUGEPAGE );
+    return r == 0;
+}
+
 //-----------------------------------------------------------
 // uint64 SysHost::SetCurrentProcessAffinityMask( uint64 mask )
 // {
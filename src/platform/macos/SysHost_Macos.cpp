@@ -189,6 +189,13 @@ bool SysHost::VirtualProtect( void* ptr, size_t size, VProtect flags )
     return r == 0;
 }
 
+//-----------------------------------------------------------
+bool SysHost::VirtualAdviseHugePages( void* ptr, size_t size, bool enable )
+{
+    // Not supported
+    return false;
+}
+
 //-----------------------------------------------------------
 bool SysHost::SetCurrentThreadAffinityCpuId( uint32 cpuId )
 {
@@ -3,6 +3,7 @@
 #include "util/Log.h"
 
 #include <sys/stat.h>
+#include <sys/statvfs.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -34,7 +35,12 @@ bool FileStream::Open( const char* path, FileStream& file, FileMode mode, FileAc
 
     #if PLATFORM_IS_LINUX
         if( IsFlagSet( flags, FileFlags::NoBuffering ) )
-            fdFlags |= O_DIRECT | O_SYNC;
+        {
+            fdFlags |= O_DIRECT;
+
+            if( !IsFlagSet( flags, FileFlags::NoWriteThrough ) )
+                fdFlags |= O_SYNC;
+        }
 
         if( IsFlagSet( flags, FileFlags::LargeFile )  )
             fdFlags |= O_LARGEFILE;
@@ -325,6 +331,19 @@ size_t FileStream::GetBlockSizeForPath( const char* pathU8 )
     return file.BlockSize();
 }
 
+//-----------------------------------------------------------
+uint64 FileStream::GetFreeSpaceForPath( const char* pathU8 )
+{
+    struct statvfs fsStat;
+    if( statvfs( pathU8, &fsStat ) != 0 )
+    {
+        Log::Error( "GetFreeSpaceForPath() failed with error %d.", (int32)errno );
+        return 0;
+    }
+
+    return (uint64)fsStat.f_bavail * (uint64)fsStat.f_frsize;
+}
+
 //-----------------------------------------------------------
 bool FileStream::Move( const char* oldPathU8, const char* newPathU8, int32* outError )
 {
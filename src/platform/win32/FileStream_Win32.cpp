@@ -49,7 +49,12 @@ bool FileStream::Open( const char* path, FileStream& file, FileMode mode, FileAc
     DWORD dwAccess = 0;
 
     if( IsFlagSet( flags, FileFlags::NoBuffering ) )
-        dwFlags = FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH;
+    {
+        dwFlags = FILE_FLAG_NO_BUFFERING;
+
+        if( !IsFlagSet( flags, FileFlags::NoWriteThrough ) )
+            dwFlags |= FILE_FLAG_WRITE_THROUGH;
+    }
 
     if( IsFlagSet( access, FileAccess::Read ) )
         dwAccess = GENERIC_READ;
@@ -448,6 +453,28 @@ size_t FileStream::GetBlockSizeForPath( const char* pathU8 )
 //    return bytesPerSector * sectorsPerCluster;
 }
 
+//-----------------------------------------------------------
+uint64 FileStream::GetFreeSpaceForPath( const char* pathU8 )
+{
+    wchar_t path16Stack[BUF16_STACK_LEN];
+
+    wchar_t* path16 = Utf8ToUtf16( pathU8, path16Stack, BUF16_STACK_LEN );
+    if( !path16 )
+        return 0;
+
+    ULARGE_INTEGER freeBytes = {};
+    if( !::GetDiskFreeSpaceExW( path16, &freeBytes, NULL, NULL ) )
+    {
+        Log::Error( "GetFreeSpaceForPath() failed with error %d.", (int32)::GetLastError() );
+        freeBytes.QuadPart = 0;
+    }
+
+    if( path16 != path16Stack )
+        free( path16 );
+
+    return (uint64)freeBytes.QuadPart;
+}
+
 //-----------------------------------------------------------
 bool FileStream::Move( const char* oldPathU8, const char* newPathU8, int32* outError )
 {
@@ -466,7 +493,8 @@ bool FileStream::Move( const char* oldPathU8, const char* newPathU8, int32* outE
         return false;
     }
 
-    const BOOL moved = ::MoveFileW( oldPath16, newPath16 );
+    // No MOVEFILE_COPY_ALLOWED: Like rename(), don't silently copy across volumes
+    const BOOL moved = ::MoveFileExW( oldPath16, newPath16, MOVEFILE_REPLACE_EXISTING );
 
     if( !moved && outError )
         *outError = (int32)::GetLastError();
@@ -185,6 +185,13 @@ bool SysHost::VirtualProtect( void* ptr, size_t size, VProtect flags )
     return true;
 }
 
+//-----------------------------------------------------------
+bool SysHost::VirtualAdviseHugePages( void* ptr, size_t size, bool enable )
+{
+    // Large pages must be requested at allocation time on Windows
+    return false;
+}
+
 //-----------------------------------------------------------
 // uint64 SysHost::SetCurrentProcessAffinityMask( uint64 mask )
 // {
@@ -5,10 +5,15 @@
 #include "jobs/IOJob.h"
 #include "util/Util.h"
 #include "util/Log.h"
+#include "util/TraceLog.h"
 
 
 #define NULL_BUFFER -1
 
+// File set state flags for checkpoints
+#define FILE_SET_STATE_SLICES  (1u << 0)
+#define FILE_SET_STATE_DELETED (1u << 1)
+
 #ifdef _WIN32
     #define PATH_SEPA_STR "\\"
     #define CheckPathSeparator( x ) ((x) == '\\' || (x) == '/')
@@ -117,6 +122,10 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
     if( IsFlagSet( options, FileSetOptions::DirectIO ) )
         flags |= FileFlags::NoBuffering;
 
+    // Block-aligned files are synced once they are finished instead
+    if( IsFlagSet( options, FileSetOptions::BlockAlign ) )
+        flags |= FileFlags::NoWriteThrough;
+
     FileSet& fileSet = _files[(uint)fileId];
 
     if( !fileSet.name )
@@ -175,13 +184,17 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
         }
         
 
-        const FileMode fileMode =
+        FileMode fileMode =
         #if _DEBUG && ( BB_DP_DBG_READ_EXISTING_F1 || BB_DP_DBG_SKIP_PHASE_1 || BB_DP_P1_SKIP_TO_TABLE || BB_DP_DBG_SKIP_TO_C_TABLES )
             !isPlotFile ? FileMode::OpenOrCreate : FileMode::Create;
         #else
             FileMode::Create;
         #endif
 
+        // When resuming, existing files hold the data from before the checkpoint
+        if( _resumeMode )
+            fileMode = FileMode::OpenOrCreate;
+
         if( !isPlotFile )
             sprintf( baseName, "%s_%u.tmp", name, i );
         else
@@ -226,6 +239,9 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
         }
     }
 
+    if( _resumeMode )
+        RestoreFileSetState( fileId );
+
     return true;
 }
 
@@ -236,7 +252,7 @@ void DiskBufferQueue::SetTransform( FileId fileId, IIOTransform& transform )
 }
 
 //-----------------------------------------------------------
-void DiskBufferQueue::OpenPlotFile( const char* fileName, const byte* plotId, const byte* plotMemo, uint16 plotMemoSize )
+void DiskBufferQueue::OpenPlotFile( const char* fileName, const byte* plotId, const byte* plotMemo, uint16 plotMemoSize, const bool directIO )
 {
     // #TODO: fileName should not have .tmp here. 
     //        Change that and then change InitFile to add the .tmp like the rest of the files.
@@ -246,10 +262,38 @@ void DiskBufferQueue::OpenPlotFile( const char* fileName, const byte* plotId, co
     ASSERT( plotMemoSize );
     ASSERT( _plotFullName.length() == 0 );
 
+    const FileSetOptions options = directIO ? FileSetOptions::DirectIO | FileSetOptions::BlockAlign : FileSetOptions::None;
+
     // #TODO: Retry multiple-times.
-    const bool didOpen = InitFileSet( FileId::PLOT, fileName, 1 );
+    const bool didOpen = InitFileSet( FileId::PLOT, fileName, 1, options, nullptr );
     FatalIf( !didOpen, "Failed to open plot file." );
 
+    const size_t blockSize = BlockSize( FileId::PLOT );
+
+    if( directIO )
+    {
+        PlotWriteBuffer& wb = _plotWriteBuffer;
+
+        const size_t capacity = RoundUpToNextBoundaryT( (size_t)BB_DP_PLOT_WRITE_BUFFER_SIZE, blockSize );
+
+        if( wb.capacity != capacity )
+        {
+            if( wb.buffer )
+                bbvirtfree( wb.buffer );
+
+            wb.buffer   = bbvirtalloc<byte>( capacity );
+            wb.capacity = capacity;
+        }
+
+        // When resuming, the file already holds the data written before the checkpoint.
+        // Know about it, so that seeking to its end reads back the last partial block.
+        const FileSetState& resumeState = _resumeStates[(int)FileId::PLOT];
+
+        wb.offset = 0;
+        wb.size   = 0;
+        wb.end    = _resumeMode && resumeState.fileSizes ? (uint64)resumeState.fileSizes[0] : 0;
+    }
+
     // Write plot header
     const size_t headerSize =
         ( sizeof( kPOSMagic ) - 1 ) +
@@ -262,11 +306,18 @@ void DiskBufferQueue::OpenPlotFile( const char* fileName, const byte* plotId, co
         80              // Table pointers
     ;
 
-    _plotHeaderSize = headerSize;
+    // Pad the header so that the tables start block-aligned, like in PlotWriter.cpp
+    const size_t paddedHeaderSize = RoundUpToNextBoundaryT( headerSize, blockSize );
+
+    if( paddedHeaderSize > _plotHeaderSize )
+    {
+        if( _plotHeaderbuffer )
+            bbvirtfree( _plotHeaderbuffer );
 
-    // #TODO: Support block-aligned like in PlotWriter.cpp
-    if( !_plotHeaderbuffer )
-        _plotHeaderbuffer = bbvirtalloc<byte>( headerSize );
+        _plotHeaderbuffer = bbvirtalloc<byte>( paddedHeaderSize );
+    }
+
+    _plotHeaderSize = paddedHeaderSize;
 
     byte* header = _plotHeaderbuffer;
 
@@ -299,14 +350,218 @@ void DiskBufferQueue::OpenPlotFile( const char* fileName, const byte* plotId, co
         // Tables will be copied at the end.
         _plotTablesPointers = (uint64)(headerWriter - header);
 
+        // Zero-out the table pointers and padding
+        memset( headerWriter, 0, paddedHeaderSize - _plotTablesPointers );
+
         // Write the headers to disk
-        WriteFile( FileId::PLOT, 0, header, (size_t)headerSize );
+        WriteFile( FileId::PLOT, 0, header, paddedHeaderSize );
+
+        // Continue writing where we were at the checkpoint
+        if( _resumeMode && _resumeStates[(int)FileId::PLOT].fileSizes )
+            SeekFile( FileId::PLOT, 0, _resumeStates[(int)FileId::PLOT].fileSizes[0], SeekOrigin::Begin );
+
         CommitCommands();
     }
 }
 
 //-----------------------------------------------------------
-void DiskBufferQueue::FinishPlot( Fence& fence )
+void DiskBufferQueue::WriteFileSetStates( IStream& stream )
+{
+    auto Write = [&]( const void* data, const size_t size ) {
+        FatalIf( (size_t)stream.Write( data, size ) != size, 
+            "Failed to write file set states with error %d.", stream.GetError() );
+    };
+
+    for( FileId id = FileId::None+1; id < FileId::_COUNT; id++ )
+    {
+        FileSet& fileSet = _files[(int)id];
+
+        if( !fileSet.name || !fileSet.files.Ptr() )
+            continue;
+
+        const uint32 bucketCount = (uint32)fileSet.files.Length();
+        const bool   deleted     = !IsFileOpen( id, 0 );
+        const bool   hasSlices   = !deleted && fileSet.readSliceSizes.Ptr();
+        const uint32 flags       = ( hasSlices ? FILE_SET_STATE_SLICES : 0 ) | ( deleted ? FILE_SET_STATE_DELETED : 0 );
+        const uint32 header[5]   = { (uint32)id, bucketCount, fileSet.readBucket, fileSet.writeBucket, flags };
+        
+        Write( header, sizeof( header ) );
+
+        if( deleted )
+            continue;
+
+        // The plot file's last block may still be in the write buffer, and the file may hold padding past its end
+        const bool isBlockAlignedPlot = id == FileId::PLOT && IsPlotBlockAligned();
+        if( isBlockAlignedPlot )
+            FlushPlotWriteBuffer();
+
+        for( uint32 i = 0; i < bucketCount; i++ )
+        {
+            IStream& file = *fileSet.files[i];
+            
+            // Ensure the data is persisted before we claim it in the checkpoint
+            if( !IsFlagSet( fileSet.options, FileSetOptions::Cachable ) && !file.Flush() )
+                Log::Line( "Warning: Failed to flush %s_%u.tmp with error %d.", fileSet.name, i, file.GetError() );
+
+            const int64 size = isBlockAlignedPlot ? (int64)_plotWriteBuffer.end : (int64)file.Size();
+            FatalIf( size < 0, "Failed to obtain size of %s_%u.tmp with error %d.", fileSet.name, i, file.GetError() );
+
+            Write( &size, sizeof( size ) );
+        }
+
+        if( hasSlices )
+        {
+            for( uint32 i = 0; i < bucketCount; i++ )
+                Write( fileSet.readSliceSizes[i].Ptr(), sizeof( size_t ) * bucketCount );
+            for( uint32 i = 0; i < bucketCount; i++ )
+                Write( fileSet.writeSliceSizes[i].Ptr(), sizeof( size_t ) * bucketCount );
+        }
+    }
+
+    // Terminator
+    const uint32 end[5] = { (uint32)FileId::None, 0, 0, 0, 0 };
+    Write( end, sizeof( end ) );
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::ReadFileSetStates( IStream& stream )
+{
+    auto Read = [&]( void* data, const size_t size ) {
+        FatalIf( (size_t)stream.Read( data, size ) != size, 
+            "Failed to read file set states with error %d.", stream.GetError() );
+    };
+
+    EndResume();
+    _resumeMode = true;
+
+    for( ;; )
+    {
+        uint32 header[5];
+        Read( header, sizeof( header ) );
+
+        const FileId id = (FileId)header[0];
+        if( id == FileId::None )
+            break;
+
+        FatalIf( id >= FileId::_COUNT || header[1] == 0 || header[1] > BB_DP_MAX_BUCKET_COUNT+1,
+            "Invalid file set state in checkpoint." );
+
+        FileSetState& state = _resumeStates[(int)id];
+        
+        const uint32 bucketCount = header[1];
+        state.bucketCount = bucketCount;
+        state.readBucket  = header[2];
+        state.writeBucket = header[3];
+        state.deleted     = ( header[4] & FILE_SET_STATE_DELETED ) != 0;
+
+        if( state.deleted )
+            continue;
+
+        state.fileSizes = new int64[bucketCount];
+        Read( state.fileSizes, sizeof( int64 ) * bucketCount );
+
+        if( header[4] & FILE_SET_STATE_SLICES )
+        {
+            const size_t sliceCount = (size_t)bucketCount * bucketCount;
+            state.readSlices  = new size_t[sliceCount];
+            state.writeSlices = new size_t[sliceCount];
+
+            Read( state.readSlices , sizeof( size_t ) * sliceCount );
+            Read( state.writeSlices, sizeof( size_t ) * sliceCount );
+        }
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::EndResume()
+{
+    // File sets which were deleted before the checkpoint have been re-created
+    // empty when opened during the resume. Remove them again.
+    for( FileId id = FileId::None+1; id < FileId::_COUNT; id++ )
+    {
+        if( _resumeStates[(int)id].deleted && IsFileOpen( id, 0 ) )
+            DeleteBucketNow( id );
+    }
+
+    for( auto& state : _resumeStates )
+    {
+        delete[] state.fileSizes;
+        delete[] state.readSlices;
+        delete[] state.writeSlices;
+        state = {};
+    }
+
+    _resumeMode = false;
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::RestoreFileSetState( const FileId fileId )
+{
+    const FileSetState& state   = _resumeStates[(int)fileId];
+          FileSet&      fileSet = _files[(int)fileId];
+
+    // Not in the checkpoint (it will be written from scratch), or already deleted
+    if( !state.fileSizes )
+        return;
+
+    const uint32 bucketCount = (uint32)fileSet.files.Length();
+
+    FatalIf( state.bucketCount != bucketCount, 
+        "Cannot resume: File set '%s' has %u buckets, but the checkpoint has %u.", fileSet.name, bucketCount, state.bucketCount );
+
+    FatalIf( IsFlagSet( fileSet.options, FileSetOptions::Cachable ),
+        "Cannot resume: File set '%s' was kept in the cache.", fileSet.name );
+
+    for( uint32 i = 0; i < bucketCount; i++ )
+    {
+        IStream& file = *fileSet.files[i];
+        const int64 size = (int64)file.Size();
+
+        if( fileId == FileId::PLOT )
+        {
+            // Discard anything written after the checkpoint
+            FatalIf( size < state.fileSizes[i] || !file.Truncate( (ssize_t)state.fileSizes[i] ),
+                "Cannot resume: The plot file '%s' is missing or could not be restored.", fileSet.name );
+        }
+        else
+        {
+            FatalIf( size < state.fileSizes[i], 
+                "Cannot resume: Temporary file %s_%u.tmp is missing or truncated. Expected %lld bytes but found %lld.",
+                fileSet.name, i, (llu)state.fileSizes[i], (llu)size );
+        }
+    }
+
+    if( state.readSlices )
+    {
+        FatalIf( !fileSet.readSliceSizes.Ptr(), "Cannot resume: File set '%s' slice mode mismatch.", fileSet.name );
+
+        for( uint32 i = 0; i < bucketCount; i++ )
+        {
+            memcpy( fileSet.readSliceSizes [i].Ptr(), state.readSlices  + (size_t)i * bucketCount, sizeof( size_t ) * bucketCount );
+            memcpy( fileSet.writeSliceSizes[i].Ptr(), state.writeSlices + (size_t)i * bucketCount, sizeof( size_t ) * bucketCount );
+        }
+    }
+
+    fileSet.readBucket  = state.readBucket;
+    fileSet.writeBucket = state.writeBucket;
+}
+
+//-----------------------------------------------------------
+bool DiskBufferQueue::IsFileOpen( const FileId fileId, const uint32 bucket ) const
+{
+    const FileSet& fileSet = _files[(int)fileId];
+
+    if( !fileSet.files.Ptr() || !fileSet.files[bucket] )
+        return false;
+
+    if( IsFlagSet( fileSet.options, FileSetOptions::Cachable ) )
+        return static_cast<const HybridStream*>( fileSet.files[bucket] )->IsOpen();
+    
+    return static_cast<const FileStream*>( fileSet.files[bucket] )->IsOpen();
+}
+
+//-----------------------------------------------------------
+std::string DiskBufferQueue::FinishPlot( Fence& fence )
 {
     SignalFence( fence );
     CommitCommands();
@@ -320,6 +575,19 @@ void DiskBufferQueue::FinishPlot( Fence& fence )
     memcpy( baseName, plotTmpName, strlen( plotTmpName ) + 1 );
 
     fence.Wait();
+
+    // Write the last block and drop its padding. As we don't write through, this is the only time we sync.
+    if( IsPlotBlockAligned() )
+    {
+        IStream& file = *_files[(int)FileId::PLOT].files[0];
+
+        FlushPlotWriteBuffer();
+
+        FatalIf( !file.Truncate( (ssize_t)_plotWriteBuffer.end ),
+            "Failed to truncate plot file with error %d.", file.GetError() );
+        FatalIf( !file.Flush(), "Failed to flush plot file with error %d.", file.GetError() );
+    }
+
     CloseFileNow( FileId::PLOT, 0 );
 
     const uint32 RETRY_COUNT  = 10;
@@ -329,12 +597,17 @@ void DiskBufferQueue::FinishPlot( Fence& fence )
 
     int32 error = 0;
 
+    std::string finishedPlotPath;
+
     for( uint32 i = 0; i < RETRY_COUNT; i++ )
     {
         const bool success = FileStream::Move( plotPath, _plotFullName.c_str(), &error );
 
         if( success )
+        {
+            finishedPlotPath = _plotFullName;
             break;
+        }
         
         Log::Line( "Error: Could not rename plot file with error: %d.", error );
 
@@ -349,6 +622,7 @@ void DiskBufferQueue::FinishPlot( Fence& fence )
     }
 
     _plotFullName = "";
+    return finishedPlotPath;
 }
 
 //-----------------------------------------------------------
@@ -535,7 +809,7 @@ inline DiskBufferQueue::Command* DiskBufferQueue::GetCommandObject( Command::Com
     cmd->type = type;
 
     #if DBG_LOG_ENABLE
-        Log::Debug( "[DiskBufferQueue] > Snd: %s (%d)", DbgGetCommandName( type ), type );
+        Log::Debug( "[DiskBufferQueue] > Snd: %s (%d)", GetCommandName( type ), type );
     #endif
 
     return cmd;
@@ -558,6 +832,8 @@ void DiskBufferQueue::CommandThreadMain( DiskBufferQueue* self )
         ASSERT( threadBindId < SysHost::GetLogicalCPUCount() );
         SysHost::SetCurrentThreadAffinityCpuId( threadBindId );
     }
+
+    TraceLog::SetThreadName( "io dispatch" );
     self->CommandMain();
 }
 
@@ -610,9 +886,11 @@ void DiskBufferQueue::CommandMain()
 void DiskBufferQueue::ExecuteCommand( Command& cmd )
 {
     //#if DBG_LOG_ENABLE
-    //    Log::Debug( "[DiskBufferQueue] ^ Cmd Execute: %s (%d)", DbgGetCommandName( cmd.type ), cmd.type );
+    //    Log::Debug( "[DiskBufferQueue] ^ Cmd Execute: %s (%d)", GetCommandName( cmd.type ), cmd.type );
     //#endif
 
+    TRACE_SPAN( GetCommandName( cmd.type ), "io", TraceLog::IsEnabled() ? GetCommandFileId( cmd ) : -1 );
+
     switch( cmd.type )
     {
         case Command::WriteBuckets:
@@ -655,7 +933,9 @@ void DiskBufferQueue::ExecuteCommand( Command& cmd )
             #if DBG_LOG_ENABLE
                 Log::Debug( "[DiskBufferQueue] ^ Cmd SeekFile: (%u) bucket:%u offset:%lld origin:%ld", cmd.seek.fileId, cmd.seek.bucket, cmd.seek.offset, (int)cmd.seek.origin );
             #endif
-                if( !_files[(uint)cmd.seek.fileId].files[cmd.seek.bucket]->Seek( cmd.seek.offset, cmd.seek.origin ) )
+                if( cmd.seek.fileId == FileId::PLOT && IsPlotBlockAligned() )
+                    SeekPlotFile( cmd.seek.offset, cmd.seek.origin );
+                else if( !_files[(uint)cmd.seek.fileId].files[cmd.seek.bucket]->Seek( cmd.seek.offset, cmd.seek.origin ) )
                 {
                     int err = _files[(uint)cmd.seek.fileId].files[cmd.seek.bucket]->GetError();
                     Fatal( "[DiskBufferQueue] Failed to seek file %s.%u with error %d (0x%x)", 
@@ -801,14 +1081,14 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
                         "Failed to seek file %s.%u.tmp to slice boundary.", fileSet.name, fileBucketIdx );
                 }
 
-                WriteToFile( file, sliceWriteSize, buffer, (byte*)fileSet.blockBuffer, fileSet.name, fileBucketIdx );
+                WriteToFile( file, sliceWriteSize, buffer, (byte*)fileSet.blockBuffer, fileSet, fileBucketIdx );
 
                 buffer += sliceWriteSize;
             }
         }
         else
         {
-            WriteToFile( *fileSet.files[fileSet.writeBucket], writeSize, buffer, (byte*)fileSet.blockBuffer, fileSet.name, fileSet.writeBucket );
+            WriteToFile( *fileSet.files[fileSet.writeBucket], writeSize, buffer, (byte*)fileSet.blockBuffer, fileSet, fileSet.writeBucket );
         }
 
         if( ++fileSet.writeBucket >= bucketCount )
@@ -828,7 +1108,7 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
 
             // Only write up-to the block-aligned boundary. The caller is in charge of handling unlaigned data.
             ASSERT( bufferSize == bufferSize / blockSize * blockSize );
-            WriteToFile( *fileSet.files[i], bufferSize, buffer, (byte*)fileSet.blockBuffer, fileSet.name, i );
+            WriteToFile( *fileSet.files[i], bufferSize, buffer, (byte*)fileSet.blockBuffer, fileSet, i );
 
             // ASSERT( IsFlagSet( fileBuckets.files[i].GetFileAccess(), FileAccess::ReadWrite ) );
             buffer += bufferSize;
@@ -839,8 +1119,14 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
 //-----------------------------------------------------------
 void DiskBufferQueue::CndWriteFile( const Command& cmd )
 {
+    if( cmd.file.fileId == FileId::PLOT && IsPlotBlockAligned() )
+    {
+        WritePlotFile( cmd.file.buffer, cmd.file.size );
+        return;
+    }
+
     FileSet& fileBuckets = _files[(int)cmd.file.fileId];
-    WriteToFile( *fileBuckets.files[cmd.file.bucket], cmd.file.size, cmd.file.buffer, (byte*)fileBuckets.blockBuffer, fileBuckets.name, cmd.file.bucket );
+    WriteToFile( *fileBuckets.files[cmd.file.bucket], cmd.file.size, cmd.file.buffer, (byte*)fileBuckets.blockBuffer, fileBuckets, cmd.file.bucket );
 }
 
 //-----------------------------------------------------------
@@ -908,7 +1194,7 @@ void DiskBufferQueue::CmdReadBucket( const Command& cmd )
                 "Failed to seek while reading alternating bucket %s.%u.tmp.", fileSet.name, fileBucketIdx );
         }
 
-        ReadFromFile( stream, alignedSize, readBuffer.Ptr(), nullptr, blockSize, directIO, fileSet.name, fileBucketIdx );
+        ReadFromFile( stream, alignedSize, readBuffer.Ptr(), nullptr, blockSize, directIO, fileSet, fileBucketIdx );
 
         // Replace the temp block we just overwrote, if we have one
         if( tempBlock.Length() )
@@ -952,12 +1238,18 @@ void DiskBufferQueue::CmdReadFile( const Command& cmd )
     const bool   directIO  = IsFlagSet( fileSet.options, FileSetOptions::DirectIO );
     const size_t blockSize = fileSet.files[0]->BlockSize();
 
-    ReadFromFile( *fileSet.files[cmd.file.bucket], cmd.file.size, cmd.file.buffer, (byte*)fileSet.blockBuffer, blockSize, directIO, fileSet.name, cmd.file.bucket );
+    ReadFromFile( *fileSet.files[cmd.file.bucket], cmd.file.size, cmd.file.buffer, (byte*)fileSet.blockBuffer, blockSize, directIO, fileSet, cmd.file.bucket );
 }
 
 //-----------------------------------------------------------
 void DiskBufferQueue::CmdSeekBucket( const Command& cmd )
 {
+    if( cmd.seek.fileId == FileId::PLOT && IsPlotBlockAligned() )
+    {
+        SeekPlotFile( cmd.seek.offset, cmd.seek.origin );
+        return;
+    }
+
     FileSet&     fileBuckets = _files[(int)cmd.seek.fileId];
     const uint   bucketCount = (uint)fileBuckets.files.length;
 
@@ -978,8 +1270,167 @@ void DiskBufferQueue::CmdSeekBucket( const Command& cmd )
 }
 
 //-----------------------------------------------------------
-inline void DiskBufferQueue::WriteToFile( IStream& file, size_t size, const byte* buffer, byte* blockBuffer, const char* fileName, uint bucket )
+void DiskBufferQueue::WritePlotFile( const byte* buffer, size_t size )
+{
+    PlotWriteBuffer& wb = _plotWriteBuffer;
+    FileSet& fileSet    = _files[(int)FileId::PLOT];
+
+    AddBytes( _totalBytesWritten  , size );
+    AddBytes( fileSet.bytesWritten, size );
+
+    while( size )
+    {
+        const size_t copySize = std::min( size, wb.capacity - wb.size );
+
+        memcpy( wb.buffer + wb.size, buffer, copySize );
+        wb.size += copySize;
+        buffer  += copySize;
+        size    -= copySize;
+
+        wb.end = std::max( wb.end, wb.offset + wb.size );
+
+        if( wb.size == wb.capacity )
+        {
+            WritePlotBlocks( wb.buffer, wb.capacity );
+
+            wb.offset += wb.capacity;
+            wb.size    = 0;
+        }
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::SeekPlotFile( const int64 offset, const SeekOrigin origin )
+{
+    PlotWriteBuffer& wb   = _plotWriteBuffer;
+    IStream&         file = *_files[(int)FileId::PLOT].files[0];
+
+    const int64 position = origin == SeekOrigin::Begin   ? offset :
+                           origin == SeekOrigin::Current ? (int64)( wb.offset + wb.size ) + offset :
+                                                           (int64)wb.end + offset;
+    FatalIf( position < 0, "Invalid plot file seek." );
+
+    FlushPlotWriteBuffer();
+
+    const size_t blockSize   = file.BlockSize();
+    const uint64 blockOffset = (uint64)position / blockSize * blockSize;
+
+    wb.offset = blockOffset;
+    wb.size   = (size_t)( (uint64)position - blockOffset );
+
+    FatalIf( !file.Seek( (int64)blockOffset, SeekOrigin::Begin ),
+        "Failed to seek plot file with error %d.", file.GetError() );
+
+    // Landed in the middle of a block: Read back its start, as we'll re-write the block whole
+    if( wb.size )
+    {
+        size_t sizeRead = 0;
+
+        if( blockOffset < wb.end )
+        {
+            const ssize_t r = file.Read( wb.buffer, blockSize );
+            FatalIf( r < 0, "Failed to read plot file with error %d.", file.GetError() );
+            sizeRead = (size_t)r;
+
+            FatalIf( !file.Seek( (int64)blockOffset, SeekOrigin::Begin ),
+                "Failed to seek plot file with error %d.", file.GetError() );
+        }
+
+        if( sizeRead < wb.size )
+            memset( wb.buffer + sizeRead, 0, wb.size - sizeRead );
+    }
+
+    wb.end = std::max( wb.end, (uint64)position );
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::FlushPlotWriteBuffer()
+{
+    PlotWriteBuffer& wb      = _plotWriteBuffer;
+    FileSet&         fileSet = _files[(int)FileId::PLOT];
+    IStream&         file    = *fileSet.files[0];
+
+    if( wb.size == 0 )
+        return;
+
+    // Write the partial block whole, but keep it in the buffer so that we can continue
+    // filling it in. The file's size is fixed up when the plot is finished.
+    const size_t blockSize       = file.BlockSize();
+    const size_t writeSize       = RoundUpToNextBoundaryT( wb.size, blockSize );
+    const size_t lastBlockOffset = writeSize - blockSize;
+    const size_t lastBlockSize   = wb.size - lastBlockOffset;
+
+    if( lastBlockSize < blockSize )
+    {
+        // Keep what follows us in the last block if we had sought back
+        size_t blockEnd = lastBlockSize;
+
+        if( wb.offset + wb.size < wb.end )
+        {
+            FatalIf( !file.Seek( (int64)( wb.offset + lastBlockOffset ), SeekOrigin::Begin ),
+                "Failed to seek plot file with error %d.", file.GetError() );
+
+            const ssize_t r = file.Read( fileSet.blockBuffer, blockSize );
+            FatalIf( r < 0, "Failed to read plot file with error %d.", file.GetError() );
+
+            if( (size_t)r > blockEnd )
+            {
+                memcpy( wb.buffer + wb.size, (byte*)fileSet.blockBuffer + blockEnd, (size_t)r - blockEnd );
+                blockEnd = (size_t)r;
+            }
+
+            FatalIf( !file.Seek( (int64)wb.offset, SeekOrigin::Begin ),
+                "Failed to seek plot file with error %d.", file.GetError() );
+        }
+
+        memset( wb.buffer + lastBlockOffset + blockEnd, 0, blockSize - blockEnd );
+    }
+
+    WritePlotBlocks( wb.buffer, writeSize );
+
+    FatalIf( !file.Seek( (int64)wb.offset, SeekOrigin::Begin ),
+        "Failed to seek plot file with error %d.", file.GetError() );
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::WritePlotBlocks( const byte* buffer, size_t size )
 {
+    IStream& file = *_files[(int)FileId::PLOT].files[0];
+    ASSERT( size % file.BlockSize() == 0 );
+
+    #if _DEBUG || BB_IO_METRICS_ON
+        _writeMetrics.size += size;
+        _writeMetrics.count++;
+        const auto timer = TimerBegin();
+    #endif
+
+    while( size )
+    {
+        const ssize_t sizeWritten = file.Write( buffer, size );
+
+        if( sizeWritten < 1 )
+        {
+            const int err = file.GetError();
+            Fatal( "Failed to write to plot file with error %d (0x%x).", err, err );
+        }
+
+        size   -= (size_t)sizeWritten;
+        buffer += sizeWritten;
+    }
+
+    #if _DEBUG || BB_IO_METRICS_ON
+        _writeMetrics.time += TimerEndTicks( timer );
+    #endif
+}
+
+//-----------------------------------------------------------
+inline void DiskBufferQueue::WriteToFile( IStream& file, size_t size, const byte* buffer, byte* blockBuffer, FileSet& fileSet, uint bucket )
+{
+    const char* fileName = fileSet.name;
+
+    AddBytes( _totalBytesWritten  , size );
+    AddBytes( fileSet.bytesWritten, size );
+
     // if( !_useDirectIO )
     // {
         #if _DEBUG || BB_IO_METRICS_ON
@@ -1048,8 +1499,13 @@ inline void DiskBufferQueue::WriteToFile( IStream& file, size_t size, const byte
 }
 
 //-----------------------------------------------------------
-inline void DiskBufferQueue::ReadFromFile( IStream& file, size_t size, byte* buffer, byte* blockBuffer, const size_t blockSize, const bool directIO, const char* fileName, const uint bucket )
+inline void DiskBufferQueue::ReadFromFile( IStream& file, size_t size, byte* buffer, byte* blockBuffer, const size_t blockSize, const bool directIO, FileSet& fileSet, const uint bucket )
 {
+    const char* fileName = fileSet.name;
+
+    AddBytes( _totalBytesRead  , size );
+    AddBytes( fileSet.bytesRead, size );
+
     #if _DEBUG || BB_IO_METRICS_ON
         _readMetrics.size += size;
         _readMetrics.count++;
@@ -1160,7 +1616,7 @@ void DiskBufferQueue::CmdTruncateBucket( const Command& cmd )
 }
 
 //-----------------------------------------------------------
-inline const char* DiskBufferQueue::DbgGetCommandName( Command::CommandType type )
+inline const char* DiskBufferQueue::GetCommandName( Command::CommandType type )
 {
     switch( type )
     {
@@ -1170,6 +1626,12 @@ inline const char* DiskBufferQueue::DbgGetCommandName( Command::CommandType type
         case DiskBufferQueue::Command::WriteBuckets:
             return "WriteBuckets";
 
+        case DiskBufferQueue::Command::WriteBucketElements:
+            return "WriteBucketElements";
+
+        case DiskBufferQueue::Command::ReadBucket:
+            return "ReadBucket";
+
         case DiskBufferQueue::Command::ReadFile:
             return "ReadFile";
 
@@ -1197,9 +1659,47 @@ inline const char* DiskBufferQueue::DbgGetCommandName( Command::CommandType type
         case DiskBufferQueue::Command::TruncateBucket:
             return "TruncateBucket";
 
+        case DiskBufferQueue::Command::DBG_WriteSliceSizes:
+            return "DBG_WriteSliceSizes";
+
+        case DiskBufferQueue::Command::DBG_ReadSliceSizes:
+            return "DBG_ReadSliceSizes";
+
         default:
             ASSERT( 0 );
-            return nullptr;
+            return "Unknown";
+    }
+}
+
+//-----------------------------------------------------------
+int64 DiskBufferQueue::GetCommandFileId( const Command& cmd )
+{
+    switch( cmd.type )
+    {
+        case Command::WriteFile:
+        case Command::ReadFile:
+            return (int64)cmd.file.fileId;
+
+        case Command::WriteBuckets:
+        case Command::WriteBucketElements:
+            return (int64)cmd.buckets.fileId;
+
+        case Command::ReadBucket:
+            return (int64)cmd.readBucket.fileId;
+
+        case Command::SeekFile:
+        case Command::SeekBucket:
+            return (int64)cmd.seek.fileId;
+
+        case Command::DeleteFile:
+        case Command::DeleteBucket:
+            return (int64)cmd.deleteFile.fileId;
+
+        case Command::TruncateBucket:
+            return (int64)cmd.truncateBucket.fileId;
+
+        default:
+            return -1;
     }
 }
 
@@ -1275,6 +1775,7 @@ void DiskBufferQueue::CmdDbgReadSliceSizes( const Command& cmd )
 //-----------------------------------------------------------
 void DiskBufferQueue::DeleterThreadMain( DiskBufferQueue* self )
 {
+    TraceLog::SetThreadName( "io deleter" );
     self->DeleterMain();
 }
 
@@ -7,6 +7,7 @@
 #include "plotting/WorkHeap.h"
 #include "plotting/Tables.h"
 #include "FileId.h"
+#include <atomic>
 
 class Thread;
 class IIOTransform;
@@ -52,7 +53,8 @@ struct FileSet
     uint32             readBucket   = 0;                     // Current read/write bucket that generated slices. Valid when writing in interleaved mode and alternating mode
     uint32             writeBucket  = 0;
     FileSetOptions     options      = FileSetOptions::None;
-
+    std::atomic<uint64> bytesRead   { 0 };                   // Totals for the lifetime of the queue, modified only by the I/O thread.
+    std::atomic<uint64> bytesWritten{ 0 };                   // Atomic, as they are read by the stats server.
 };
 
 class DiskBufferQueue
@@ -180,10 +182,13 @@ public:
 
     void SetTransform( FileId fileId, IIOTransform& transform );
 
-    void OpenPlotFile( const char* fileName, const byte* plotId, const byte* plotMemo, uint16 plotMemoSize );
+    // With directIO, the plot file is written in whole blocks (see PlotWriteBuffer)
+    // and the tables start at a block-aligned offset after the header.
+    void OpenPlotFile( const char* fileName, const byte* plotId, const byte* plotMemo, uint16 plotMemoSize, bool directIO );
 
 /// Commands
-    void FinishPlot( Fence& fence );
+    // Returns the path of the finished plot, or an empty string if it could not be renamed
+    std::string FinishPlot( Fence& fence );
 
     void ResetHeap( const size_t heapSize, void* heapBuffer );
 
@@ -245,6 +250,20 @@ public:
         // const Span<Span<size_t>> SliceSizes( const FileId fileId ) const { return _files[(int)fileId].sliceSizes; }
     #endif
 
+    // Checkpoint support. These must only be called when the command queue is idle.
+    // Writes the state of all open file sets: Their slice sizes and the size of each bucket file.
+    void WriteFileSetStates( IStream& stream );
+
+    // Reads the file set states written by WriteFileSetStates() and enters resume mode:
+    // Subsequent calls to InitFileSet() will open the existing files without truncating
+    // them and restore the saved state of the file set.
+    void ReadFileSetStates( IStream& stream );
+
+    // Leave resume mode and discard any saved file set states.
+    void EndResume();
+
+    inline bool IsResuming() const { return _resumeMode; }
+
     #if _DEBUG
         void DebugWriteSliceSizes( const TableId table, const FileId fileId );
         void DebugReadSliceSizes( const TableId table, const FileId fileId );
@@ -272,6 +291,18 @@ public:
     inline double IOBufferWaitTime() const { return TicksToSeconds( _ioBufferWaitTime ); }
     inline void ResetIOBufferWaitCounter() { _ioBufferWaitTime = Duration::zero(); }
 
+    // Total bytes read from and written to all files so far. Only consistent while the queue is idle (after a fence).
+    inline uint64 TotalBytesRead()    const { return _totalBytesRead   .load( std::memory_order_relaxed ); }
+    inline uint64 TotalBytesWritten() const { return _totalBytesWritten.load( std::memory_order_relaxed ); }
+
+    // Same as above, but for a single file set. Files that were never opened report 0 bytes and a null name.
+    inline uint64      FileBytesRead   ( const FileId fileId ) const { return _files[(int)fileId].bytesRead   .load( std::memory_order_relaxed ); }
+    inline uint64      FileBytesWritten( const FileId fileId ) const { return _files[(int)fileId].bytesWritten.load( std::memory_order_relaxed ); }
+    inline const char* FileName        ( const FileId fileId ) const { return _files[(int)fileId].name;         }
+
+    // Number of committed commands which the dispatch thread has not yet picked up
+    inline int PendingCommandCount() const { return _commands.Count(); }
+
 
     #if _DEBUG || BB_IO_METRICS_ON
     //-----------------------------------------------------------
@@ -393,8 +424,20 @@ private:
     void CmdReadFile( const Command& cmd );
     void CmdSeekBucket( const Command& cmd );
 
-    void WriteToFile( IStream& file, size_t size, const byte* buffer, byte* blockBuffer, const char* fileName, uint bucket );
-    void ReadFromFile( IStream& file, size_t size, byte* buffer, byte* blockBuffer, const size_t blockSize, const bool directIO, const char* fileName, const uint bucket );
+    void WritePlotFile( const byte* buffer, size_t size );
+    void SeekPlotFile( int64 offset, SeekOrigin origin );
+    void FlushPlotWriteBuffer();
+    void WritePlotBlocks( const byte* buffer, size_t size );
+    inline bool IsPlotBlockAligned() const { return IsFlagSet( _files[(int)FileId::PLOT].options, FileSetOptions::BlockAlign ); }
+
+    void WriteToFile( IStream& file, size_t size, const byte* buffer, byte* blockBuffer, FileSet& fileSet, uint bucket );
+    // Single writer: No need for an atomic read-modify-write
+    inline static void AddBytes( std::atomic<uint64>& counter, const size_t size )
+    {
+        counter.store( counter.load( std::memory_order_relaxed ) + size, std::memory_order_relaxed );
+    }
+
+    void ReadFromFile( IStream& file, size_t size, byte* buffer, byte* blockBuffer, const size_t blockSize, const bool directIO, FileSet& fileSet, const uint bucket );
 
     void CmdDeleteFile( const Command& cmd );
     void CmdDeleteBucket( const Command& cmd );
@@ -405,7 +448,11 @@ private:
     void DeleteFileNow( const FileId fileId, const uint32 bucket );
     void DeleteBucketNow( const FileId fileId );
 
-    static const char* DbgGetCommandName( Command::CommandType type );
+    static const char* GetCommandName( Command::CommandType type );
+    static int64       GetCommandFileId( const Command& cmd );   // -1 if the command does not target a file
+
+    bool IsFileOpen( const FileId fileId, const uint32 bucket ) const;
+    void RestoreFileSetState( const FileId fileId );
 
     #if _DEBUG
         void CmdDbgWriteSliceSizes( const Command& cmd );
@@ -433,7 +480,39 @@ private:
     byte*            _plotHeaderbuffer   = nullptr;
     uint64           _plotTablesPointers = 0;               // Offset in the plot file to the tables pointer table
 
+    // When the plot file is opened with direct I/O (FileSetOptions::BlockAlign), writes to it are gathered here
+    // and written out in whole blocks. The last partial block stays in the buffer until it is filled.
+    // It is only written when seeking or finishing the plot, merged with what the file already holds in that block.
+    // Only used by the dispatch thread, or while the queue is idle.
+    struct PlotWriteBuffer
+    {
+        byte*  buffer   = nullptr;
+        size_t capacity = 0;    // Multiple of the plot file's block size
+        uint64 offset   = 0;    // Block-aligned offset of the start of the buffer in the file. Always the file's position.
+        size_t size     = 0;    // Bytes written to the buffer
+        uint64 end      = 0;    // End of the plot data in the file
+    };
+
+    PlotWriteBuffer  _plotWriteBuffer;
+
     Duration         _ioBufferWaitTime = Duration::zero();  // Total time spent waiting for IO buffers.
+    std::atomic<uint64> _totalBytesRead   { 0 };            // Only modified by the I/O thread, see AddBytes()
+    std::atomic<uint64> _totalBytesWritten{ 0 };
+
+    // Resume state, loaded from a checkpoint
+    struct FileSetState
+    {
+        uint32  bucketCount = 0;
+        uint32  readBucket  = 0;
+        uint32  writeBucket = 0;
+        bool    deleted     = false;    // The file set had already been deleted at the time of the checkpoint
+        int64*  fileSizes   = nullptr;  // Size of each bucket file at the time of the checkpoint
+        size_t* readSlices  = nullptr;  // bucketCount * bucketCount slice sizes, if the file set is interleaved
+        size_t* writeSlices = nullptr;
+    };
+
+    bool             _resumeMode = false;
+    FileSetState     _resumeStates[(size_t)FileId::_COUNT];
 
     // I/O thread stuff
     Thread            _dispatchThread;
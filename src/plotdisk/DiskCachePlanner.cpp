@@ -0,0 +1,165 @@
+#include "DiskCachePlanner.h"
+#include "util/Util.h"
+#include "util/Log.h"
+#include <algorithm>
+
+//-----------------------------------------------------------
+DiskCachePlanner::DiskCachePlanner( const size_t blockSize )
+    : _blockSize( blockSize )
+{
+    ASSERT( blockSize );
+}
+
+//-----------------------------------------------------------
+void DiskCachePlanner::AddUse( const FileId fileId, const char* name, const uint32 bucketCount, const size_t size )
+{
+    ASSERT( fileId > FileId::None && fileId < FileId::_COUNT );
+    ASSERT( bucketCount );
+
+    FileUsage& file = _files[(int)fileId];
+    ASSERT( file.bucketCount == 0 || file.bucketCount == bucketCount );
+    FatalIf( file.useCount >= MAX_USES_PER_FILE, "Too many cache uses for file set '%s'.", name );
+
+    file.name        = name;
+    file.bucketCount = bucketCount;
+    file.uses[file.useCount++] = size;
+}
+
+//-----------------------------------------------------------
+size_t DiskCachePlanner::Plan( const size_t cacheSize )
+{
+    // Each file's I/O savings function is piecewise linear:
+    // Between two consecutive use sizes, every byte of cache saves
+    // a write and a read for each use that is at least that large.
+    // We split it into segments of constant density and hand them out
+    // in order of highest density.
+    struct Segment
+    {
+        FileId fileId;
+        size_t length;
+        uint32 density;
+    };
+
+    Segment segments[(int)FileId::_COUNT * MAX_USES_PER_FILE];
+    uint32  segmentCount = 0;
+
+    for( FileId id = FileId::None; id < FileId::_COUNT; id++ )
+    {
+        FileUsage& file = _files[(int)id];
+        file.cacheSize = 0;
+
+        if( file.useCount == 0 )
+            continue;
+
+        ASSERT( file.useCount <= MAX_USES_PER_FILE );
+        const uint32 useCount = std::min( file.useCount, MAX_USES_PER_FILE );
+
+        size_t sizes[MAX_USES_PER_FILE];
+        memcpy( sizes, file.uses, sizeof( size_t ) * useCount );
+        std::sort( std::begin( sizes ), std::begin( sizes ) + useCount );
+
+        size_t prevSize = 0;
+        for( uint32 i = 0; i < useCount; i++ )
+        {
+            if( sizes[i] == prevSize )
+                continue;
+
+            segments[segmentCount++] = { id, sizes[i] - prevSize, useCount - i };
+            prevSize = sizes[i];
+        }
+    }
+
+    // #NOTE: Segments within the same file already have decreasing density,
+    //        so a stable sort keeps them in order.
+    std::stable_sort( segments, segments + segmentCount, []( const Segment& a, const Segment& b ) {
+        return a.density > b.density;
+    });
+
+    size_t remaining = cacheSize;
+
+    for( uint32 i = 0; i < segmentCount && remaining > 0; i++ )
+    {
+        const Segment& seg  = segments[i];
+        const size_t   size = std::min( seg.length, remaining );
+
+        _files[(int)seg.fileId].cacheSize += size;
+        remaining -= size;
+    }
+
+    // HybridStream splits the cache evenly between buckets,
+    // and each bucket's cache must be block-aligned.
+    size_t totalSize = 0;
+
+    for( FileId id = FileId::None; id < FileId::_COUNT; id++ )
+    {
+        FileUsage& file = _files[(int)id];
+
+        if( file.cacheSize == 0 )
+            continue;
+
+        const size_t granularity = (size_t)file.bucketCount * _blockSize;
+
+        file.cacheSize = file.cacheSize / granularity * granularity;
+        totalSize += file.cacheSize;
+    }
+
+    ASSERT( totalSize <= cacheSize );
+    return totalSize;
+}
+
+//-----------------------------------------------------------
+uint64 DiskCachePlanner::SavedIOBytes() const
+{
+    uint64 saved = 0;
+
+    for( uint32 i = 0; i < (uint32)FileId::_COUNT; i++ )
+    {
+        const FileUsage& file = _files[i];
+
+        for( uint32 j = 0; j < file.useCount; j++ )
+            saved += 2 * std::min( file.uses[j], file.cacheSize );
+    }
+
+    return saved;
+}
+
+//-----------------------------------------------------------
+uint64 DiskCachePlanner::TotalIOBytes() const
+{
+    uint64 total = 0;
+
+    for( uint32 i = 0; i < (uint32)FileId::_COUNT; i++ )
+    {
+        const FileUsage& file = _files[i];
+
+        for( uint32 j = 0; j < file.useCount; j++ )
+            total += 2 * file.uses[j];
+    }
+
+    return total;
+}
+
+//-----------------------------------------------------------
+void DiskCachePlanner::LogPlan() const
+{
+    for( uint32 i = 0; i < (uint32)FileId::_COUNT; i++ )
+    {
+        const FileUsage& file = _files[i];
+
+        if( file.useCount == 0 )
+            continue;
+
+        size_t maxUse = 0;
+        for( uint32 j = 0; j < file.useCount; j++ )
+            maxUse = std::max( maxUse, file.uses[j] );
+
+        Log::Line( "  %-8s: %6.2lf / %6.2lf GiB cached ( %u uses )",
+            file.name, (double)file.cacheSize BtoGB, (double)maxUse BtoGB, file.useCount );
+    }
+
+    const uint64 totalIO = TotalIOBytes();
+    const uint64 savedIO = SavedIOBytes();
+
+    Log::Line( "  Estimated temp I/O saved: %.2lf / %.2lf GiB ( %.2lf%% )",
+        (double)savedIO BtoGB, (double)totalIO BtoGB, totalIO ? savedIO / (double)totalIO * 100.0 : 0.0 );
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "plotting/Tables.h"
+#include "FileId.h"
+
+/**
+ * Decides how much of the user-specified cache (--cache) each temporary file set gets.
+ *
+ * Each file set registers its expected 'uses', where a use is a single write pass
+ * of a given size which is later read back in full (ex. the y values of table 3,
+ * which are written by table 3 and read by table 4).
+ *
+ * A cached file set keeps a memory prefix per bucket (see HybridStream), so caching
+ * x bytes of a file set saves 2 * min( x, useSize ) bytes of I/O for each use.
+ * The cache is then handed out greedily to the file sets which save the most I/O per
+ * byte of cache, which is optimal since the savings for each file set are concave in x.
+ */
+class DiskCachePlanner
+{
+public:
+    static constexpr uint32 MAX_USES_PER_FILE = 8;
+
+    DiskCachePlanner( const size_t blockSize );
+
+    // Register a write + read pass of 'size' bytes on the given file set.
+    // 'bucketCount' must be the same for all uses of the same file set.
+    void AddUse( const FileId fileId, const char* name, const uint32 bucketCount, const size_t size );
+
+    // Distribute 'cacheSize' bytes amongst all the registered file sets.
+    // Returns the total bytes assigned, which may be less than 'cacheSize'
+    // due to block alignment or if the file sets don't need it all.
+    size_t Plan( const size_t cacheSize );
+
+    // Cache size assigned to a file set. Always a multiple of (bucketCount * blockSize).
+    inline size_t CacheSize( const FileId fileId ) const { return _files[(int)fileId].cacheSize; }
+
+    // Estimated I/O bytes saved across all uses by the planned cache sizes.
+    uint64 SavedIOBytes() const;
+
+    // Estimated I/O bytes performed on the registered file sets, without any cache.
+    uint64 TotalIOBytes() const;
+
+    void LogPlan() const;
+
+private:
+    struct FileUsage
+    {
+        const char* name        = nullptr;
+        size_t      uses[MAX_USES_PER_FILE];
+        uint32      useCount    = 0;
+        uint32      bucketCount = 0;
+        size_t      cacheSize   = 0;
+    };
+
+    size_t    _blockSize;
+    FileUsage _files[(int)FileId::_COUNT];
+};
@@ -73,7 +73,7 @@ struct DiskF1
             const uint32 bucketBits       = bblog2( _numBuckets );
             const uint32 bucketBitShift   = _k - bucketBits;
             const int32  entriesPerBlock  = kF1BlockSizeBits / (int32)_k;
-            const size_t entrySizeBits    = Info::YBitSize + _k;    // y + x
+            const uint32 entrySizeBits    = Info::YBitSize + _k;    // y + x
 
             uint32* blocks  = _blocks[id];
             uint64* entries = _entries;
@@ -178,17 +178,12 @@ struct DiskF1
                     ASSERT( counts[i] >= 2 );
 
                     // Compress a couple of entries first, so that we don't get any simultaneaous writes to the same fields
-                    writer.Write( entry[0], entrySizeBits );
-                    writer.Write( entry[1], entrySizeBits );
+                    writer.WriteValues<entrySizeBits>( entry, 2 );
                     entry += 2;
 
                     self->SyncThreads();
 
-                    while( entry < end )
-                    {
-                        writer.Write( *entry, entrySizeBits );
-                        entry++;
-                    }
+                    writer.WriteValues<entrySizeBits>( entry, (int64)( end - entry ) );
                 }
 
                 // Write to disk
@@ -211,7 +206,7 @@ struct DiskF1
             Fence fence;
             _context.ioQueue->SignalFence( fence );
             _context.ioQueue->CommitCommands();
-            fence.Wait();
+            fence.Wait( _context.p1TableWaitTime[(int)TableId::Table1] );
         }
     }
 
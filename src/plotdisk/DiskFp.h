@@ -359,7 +359,7 @@ public:
 
                 if( count )
                     memcpy( xBuffer + offset, ((uint32*)map) + offset, (size_t)count * sizeof( uint32 ) );
-            });
+            }, "DiskFp::WriteMap" );
 
             _xWriter.SubmitBuffer( _ioQueue, (size_t)entryCount );
 
@@ -475,13 +475,11 @@ public:
                 const uint64* mapToWriteEndPass1 = mapToWrite + std::min( counts[i], 2u ); 
                 ASSERT( counts[i] > 2 );
 
-                while( mapToWrite < mapToWriteEndPass1 )
-                    writer.Write( *mapToWrite++, bitSize );
+                writer.WriteValues<bitSize>( mapToWrite, (int64)( mapToWriteEndPass1 - mapToWrite ) );
 
                 self->SyncThreads();
 
-                while( mapToWrite < mapToWriteEnd )
-                    writer.Write( *mapToWrite++, bitSize );
+                writer.WriteValues<bitSize>( mapToWriteEndPass1, (int64)( mapToWriteEnd - mapToWriteEndPass1 ) );
             }
 
             // Write the overflow bucket and then write to disk
@@ -500,8 +498,7 @@ public:
 
                     const uint64* mapToWrite  = outMapBuckets + writeOffset;
                     const uint64* mapWriteEnd = mapToWrite + overflowCount;
-                    while( mapToWrite < mapWriteEnd )
-                        writer.Write( *mapToWrite++, bitSize );
+                    writer.WriteValues<bitSize>( mapToWrite, (int64)( mapWriteEnd - mapToWrite ) );
                 }
 
                 bitWriter.Submit();
@@ -575,7 +572,7 @@ public:
             PackPairs( 2, pair, writer );
             self->SyncThreads();
             PackPairs( count-2, pair+2, writer );
-        });
+        }, "DiskFp::WritePairsToDisk" );
 
         _pairBitWriter.Submit();
         _ioQueue.SignalFence( _pairWriteFence, bucket + 1 );   // #TODO: Don't signal here, signal on cross-bucket?
@@ -591,13 +588,17 @@ public:
 
         const Pair* end = pair + entryCount;
 
+        BitPacker packer( writer );
+
         while( pair < end )
         {
             ASSERT( pair->right - pair->left < 512 );
 
-            writer.Write( ( (uint64)(pair->right - pair->left) << shift ) | ( pair->left & mask ), entrySizeBits );
+            packer.Write<entrySizeBits>( ( (uint64)(pair->right - pair->left) << shift ) | ( pair->left & mask ) );
             pair++;
         }
+
+        packer.Flush();
     }
 
     //-----------------------------------------------------------
@@ -956,27 +957,31 @@ public:
         const EntryOut* entry = entries;
         const EntryOut* end   = entry + entryCount;
 
+        BitPacker packer( writer );
+
         while( entry < end )
         {
-            writer.Write( entry->ykey, ykeyBits );
+            packer.Write<ykeyBits>( entry->ykey );
 
             if constexpr ( metaOutMulti == 2 )
             {
-                writer.Write( entry->meta, 64 );
+                packer.Write<64>( entry->meta );
             }
             else if constexpr ( metaOutMulti == 3 )
             {
-                writer.Write( entry->meta.m0, 64 );
-                writer.Write( entry->meta.m1, 32 );
+                packer.Write<64>( entry->meta.m0 );
+                packer.Write<32>( entry->meta.m1 );
             }
             else if constexpr ( metaOutMulti == 4 )
             {
-                writer.Write( entry->meta.m0, 64 );
-                writer.Write( entry->meta.m1, 64 );
+                packer.Write<64>( entry->meta.m0 );
+                packer.Write<64>( entry->meta.m1 );
             }
 
             entry++;
         }
+
+        packer.Flush();
     }
 
     //-----------------------------------------------------------
@@ -1017,7 +1022,7 @@ public:
                 if constexpr ( metaMultipler > 1 )
                     meta[i] = e.meta;
             }
-        });
+        }, "DiskFp::UnpackEntries" );
     }
 
     //-----------------------------------------------------------
@@ -1031,7 +1036,7 @@ public:
 
             const uint32 remainderBits = _k - yBitSize;
             EntrySort<remainderBits>( self, count, offset, entries, tmpEntries );
-        });
+        }, "DiskFp::SortEntries" );
     }
 
     //-----------------------------------------------------------
@@ -1113,7 +1118,7 @@ public:
             const size_t bitCapacity    = CDiv( packedEntrySize * (uint64)entryCount, 64 ) * 64;
 
             DiskFp<table,_numBuckets,IsT7Out>::ExpandEntries<TEntry>( packedEntries, inputBitOffset, bitCapacity, expendedEntries + offset, count );
-        });
+        }, "DiskFp::ExpandEntries" );
     }
 
     //-----------------------------------------------------------
@@ -1126,7 +1131,7 @@ public:
         constexpr uint32 metaMultipler   = IsT7Out ? 0 : InInfo::MetaMultiplier;
         constexpr uint32 packedEntrySize = IsT7Out ? yBits + mapBits : InInfo::EntrySizePackedBits;
         
-        BitReader reader( (uint64*)packedEntries, bitCapacity, inputBitOffset );
+        BitUnpacker reader( (uint64*)packedEntries, bitCapacity, inputBitOffset );
 
               TEntry* out = expendedEntries;
         const TEntry* end = out + entryCount;
@@ -1135,30 +1140,30 @@ public:
         {
             if constexpr ( table == TableId::Table2 || IsT7Out )
             {
-                out->ykey = reader.ReadBits64( packedEntrySize );
+                out->ykey = reader.Read<packedEntrySize>();
             }
             else
             {
                 // #TODO: Can still get ykey in a single step like above
-                const uint64 y   = reader.ReadBits64( yBits   );
-                const uint64 map = reader.ReadBits64( mapBits );
+                const uint64 y   = reader.Read<yBits>();
+                const uint64 map = reader.Read<mapBits>();
 
                 out->ykey = y | ( map << yBits );
 
                 if constexpr ( metaMultipler == 2 )
                 {
-                    out->meta = reader.ReadBits64( 64 );
+                    out->meta = reader.Read<64>();
                 }
                 else if constexpr ( metaMultipler == 3 )
                 {
                     // #TODO: Try aligning entries to 32-bits instead.
-                    out->meta.m0 = reader.ReadBits64( 64 );
-                    out->meta.m1 = reader.ReadBits64( 32 );
+                    out->meta.m0 = reader.Read<64>();
+                    out->meta.m1 = reader.Read<32>();
                 }
                 else if constexpr ( metaMultipler == 4 )
                 {
-                    out->meta.m0 = reader.ReadBits64( 64 );
-                    out->meta.m1 = reader.ReadBits64( 64 );
+                    out->meta.m0 = reader.Read<64>();
+                    out->meta.m1 = reader.Read<64>();
                 }
             }
         }
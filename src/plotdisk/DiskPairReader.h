@@ -126,14 +126,14 @@ struct DiskMapReader
                     ASSERT( count > 0 );
 
                     TMap* unpackedMap = _unpackdMaps[_bucketsUnpacked & 1];
-                    BitReader reader( (uint64*)GetBucketBuffer( _bucketsUnpacked ), _mapBits * bucketLength, offset * _mapBits );
+                    BitUnpacker reader( (uint64*)GetBucketBuffer( _bucketsUnpacked ), _mapBits * bucketLength, offset * _mapBits );
 
                     const uint32 idxShift     = _finalIdxBits;
                     const uint64 finalIdxMask = ( 1ull << idxShift ) - 1;
 
                     for( int64 i = offset; i < end; i++ )
                     {
-                        const uint64 packedMap = reader.ReadBits64( (uint32)_mapBits );
+                        const uint64 packedMap = reader.Read<_mapBits>();
                         const uint64 map       = packedMap & finalIdxMask;
                         const uint64 dstIdx    = packedMap >> idxShift;
 
@@ -184,7 +184,7 @@ struct DiskMapReader
             }
             else
                 self->WaitForRelease();
-        });
+        }, "DiskMapReader::ReadEntries" );
     }
 
     //-----------------------------------------------------------
@@ -378,17 +378,17 @@ struct DiskPairAndMapReader
             GetThreadOffsets( self, bucketLength, count, offset, end );
 
             const size_t bitOffset = startBit + (size_t)offset * _pairBits;
-            BitReader reader( (uint64*)pairBuffer, fullBitSize, bitOffset );
+            BitUnpacker reader( (uint64*)pairBuffer, fullBitSize, bitOffset );
 
             for( int64 i = offset; i < end; i++ )
             {
                 Pair pair;
-                pair.left  = (uint32)reader.ReadBits64( _lBits );
-                pair.right = pair.left +  (uint32)reader.ReadBits64( _rBits );
+                pair.left  = (uint32)reader.Read<_lBits>();
+                pair.right = pair.left +  (uint32)reader.Read<_rBits>();
 
                 pairs[i] = pair;
             }
-        });
+        }, "DiskPairAndMapReader::UnpackBucket" );
 
         // #TODO: Try not to start another threaded job, and instead do it in the same MT job?
         if( !_noMap )
@@ -640,8 +640,8 @@ private:
     BlockReader<T> _reader;
     uint32         _bucketsLoaded = 0;
     uint32         _bucketsRead   = 0;
-    uint32         _bucketCounts   [_numBuckets ];
-    T              _retainedEntries[_retainCount];
+    uint32         _bucketCounts   [_numBuckets ] = {};
+    T              _retainedEntries[_retainCount] = {};
 };
 
 
@@ -0,0 +1,351 @@
+#include "DiskPlotCheckpoint.h"
+#include "DiskPlotContext.h"
+#include "plotting/PlotTools.h"
+#include "plotting/GlobalPlotConfig.h"
+#include "io/FileStream.h"
+#include "util/Log.h"
+#include "util/Util.h"
+
+#define BB_DP_CHECKPOINT_MAGIC   "BBDPCKPT"
+#define BB_DP_CHECKPOINT_VERSION 4
+
+#define BB_DP_CHECKPOINT_MAX_PATH 1024
+
+static_assert( BB_PLOT_ID_LEN == 32, "Checkpoint plot id size mismatch." );
+static_assert( BB_PLOT_MEMO_MAX_SIZE == 128, "Checkpoint plot memo size mismatch." );
+
+struct CheckpointHeader
+{
+    char          magic[8];
+    uint32        version;
+    DiskPlotStage stage;
+    uint32        numBuckets;
+    uint32        bounded;
+    uint32        alternateBuckets;
+    uint32        plotMemoSize;
+    uint64        stageDataSize;
+    byte          plotId  [BB_PLOT_ID_LEN];
+    byte          plotMemo[BB_PLOT_MEMO_MAX_SIZE];
+    char          plotFileName[256];
+    char          tmpPath2    [BB_DP_CHECKPOINT_MAX_PATH];
+    char          outputFolder[BB_DP_CHECKPOINT_MAX_PATH];
+};
+
+static char* GetCheckpointPath( const char* dir, const char* suffix = "" );
+static bool  ReadCheckpointHeader( FileStream& file, const char* path, CheckpointHeader& header );
+static void  WriteCheckpointCounters( FileStream& file, DiskPlotContext& cx );
+static void  ReadCheckpointCounters( FileStream& file, DiskPlotContext& cx );
+
+
+//-----------------------------------------------------------
+DiskPlotCheckpoint::DiskPlotCheckpoint( DiskPlotContext& context )
+    : _context( context )
+{}
+
+//-----------------------------------------------------------
+DiskPlotCheckpoint::~DiskPlotCheckpoint()
+{
+    free( _path );
+    free( _stageData );
+}
+
+//-----------------------------------------------------------
+bool DiskPlotCheckpoint::IsStageResumable( const DiskPlotStage stage ) const
+{
+    const DiskPlotConfig& cfg = *_context.cfg;
+
+    if( stage == DiskPlotStage::None || cfg.noCheckpoint || !cfg.bounded )
+        return false;
+
+    // Within Phase 1 the fx file sets may be held in the cache,
+    // and alternating mode overwrites the previous table's buckets in-place.
+    if( stage <= DiskPlotStage::P1Table7 )
+    {
+        #if BB_DP_FP_MATCH_X_BUCKET
+            return false;
+        #endif
+        return !cfg.alternateBuckets && _context.cacheSize == 0;
+    }
+
+    // Phase 3 keeps the LP and map buckets in the cache
+    if( stage >= DiskPlotStage::P3Table2 )
+        return _context.cacheSize == 0;
+
+    // The marking tables may only exist in the cache
+    if( stage == DiskPlotStage::Phase2 )
+        return !cfg.cacheMarks;
+
+    return true;
+}
+
+//-----------------------------------------------------------
+void DiskPlotCheckpoint::Save( const DiskPlotStage stage, const void* stageData, const size_t stageDataSize )
+{
+    if( !IsStageResumable( stage ) )
+        return;
+
+    ASSERT( stageDataSize == 0 || stageData );
+
+    DiskPlotContext& cx      = _context;
+    DiskBufferQueue& ioQueue = *cx.ioQueue;
+
+    // Ensure everything up to this point has been written
+    {
+        Fence& fence = cx.fencePool->RequireFence();
+        ioQueue.SignalFence( fence );
+        ioQueue.CommitCommands();
+        fence.Wait();
+        cx.fencePool->ReleaseFence( fence );
+    }
+
+    const auto timer = TimerBegin();
+
+    CheckpointHeader header;
+    ZeroMem( &header );
+
+    memcpy( header.magic, BB_DP_CHECKPOINT_MAGIC, sizeof( header.magic ) );
+    header.version          = BB_DP_CHECKPOINT_VERSION;
+    header.stage            = stage;
+    header.numBuckets       = cx.numBuckets;
+    header.bounded          = cx.cfg->bounded          ? 1 : 0;
+    header.alternateBuckets = cx.cfg->alternateBuckets ? 1 : 0;
+    header.plotMemoSize     = cx.plotMemoSize;
+    header.stageDataSize    = stageDataSize;
+    memcpy( header.plotId  , cx.plotId  , BB_PLOT_ID_LEN  );
+    memcpy( header.plotMemo, cx.plotMemo, cx.plotMemoSize );
+
+    const char* outputFolder = cx.cfg->globalCfg->outputFolder ? cx.cfg->globalCfg->outputFolder : "";
+    FatalIf( strlen( cx.plotFileName ) >= sizeof( header.plotFileName ) ||
+             strlen( cx.tmpPath2     ) >= sizeof( header.tmpPath2     ) ||
+             strlen( outputFolder    ) >= sizeof( header.outputFolder ),
+             "Checkpoint path too long." );
+
+    strcpy( header.plotFileName, cx.plotFileName );
+    strcpy( header.tmpPath2    , cx.tmpPath2     );
+    strcpy( header.outputFolder, outputFolder    );
+
+    // Write to a temporary file first, so that a crash while saving
+    // leaves the previous checkpoint intact.
+    char* tmpPath  = GetCheckpointPath( cx.tmpPath, ".tmp" );
+    char* path     = GetCheckpointPath( cx.tmpPath );
+
+    {
+        FileStream file;
+        FatalIf( !file.Open( tmpPath, FileMode::Create, FileAccess::Write ),
+            "Failed to open checkpoint file '%s' with error %d.", tmpPath, file.GetError() );
+
+        FatalIf( file.Write( &header, sizeof( header ) ) != (ssize_t)sizeof( header ),
+            "Failed to write checkpoint header with error %d.", file.GetError() );
+
+        WriteCheckpointCounters( file, cx );
+
+        if( stageDataSize )
+        {
+            FatalIf( file.Write( stageData, stageDataSize ) != (ssize_t)stageDataSize,
+                "Failed to write checkpoint stage data with error %d.", file.GetError() );
+        }
+
+        ioQueue.WriteFileSetStates( file );
+
+        FatalIf( !file.Flush(), "Failed to flush checkpoint file with error %d.", file.GetError() );
+        file.Close();
+    }
+
+    int32 err = 0;
+    FatalIf( !FileStream::Move( tmpPath, path, &err ),
+        "Failed to move checkpoint file '%s' to '%s' with error %d.", tmpPath, path, err );
+
+    free( tmpPath );
+    free( path );
+
+    const double elapsed = TimerEnd( timer );
+    Log::Line( "Saved checkpoint in %.2lf seconds.", elapsed );
+}
+
+//-----------------------------------------------------------
+void DiskPlotCheckpoint::Delete()
+{
+    char* path = GetCheckpointPath( _context.tmpPath );
+
+    if( FileStream::Exists( path ) )
+        remove( path );
+
+    free( path );
+}
+
+//-----------------------------------------------------------
+void DiskPlotCheckpoint::Load( const char* dir )
+{
+    ASSERT( dir );
+
+    free( _path );
+    free( _stageData );
+    _stageData     = nullptr;
+    _stageDataSize = 0;
+
+    _path = GetCheckpointPath( dir );
+
+    FileStream file;
+    FatalIf( !file.Open( _path, FileMode::Open, FileAccess::Read ),
+        "No checkpoint found at '%s' ( error %d ).", _path, file.GetError() );
+
+    CheckpointHeader header;
+    FatalIf( !ReadCheckpointHeader( file, _path, header ), "Invalid checkpoint file '%s'.", _path );
+
+    FatalIf( header.stage <= DiskPlotStage::None || header.stage >= DiskPlotStage::_Count ||
+             header.plotMemoSize > BB_PLOT_MEMO_MAX_SIZE ||
+             header.plotFileName[sizeof( header.plotFileName )-1] != 0,
+             "Corrupt checkpoint file '%s'.", _path );
+
+    _stage        = header.stage;
+    _plotMemoSize = (uint16)header.plotMemoSize;
+    memcpy( _plotId      , header.plotId      , sizeof( _plotId       ) );
+    memcpy( _plotMemo    , header.plotMemo    , sizeof( _plotMemo     ) );
+    memcpy( _plotFileName, header.plotFileName, sizeof( _plotFileName ) );
+
+    // Skip the counters, they are restored once the plot begins
+    _countersOffset = (int64)sizeof( header );
+
+    const int64 countersSize = (int64)( sizeof( _context.bucketCounts ) + sizeof( _context.entryCounts ) +
+                                        sizeof( _context.bucketSlices ) + sizeof( _context.ptrTableBucketCounts ) +
+                                        sizeof( _context.plotTablePointers ) + sizeof( _context.plotTableSizes ) );
+
+    FatalIf( !file.Seek( _countersOffset + countersSize, SeekOrigin::Begin ),
+        "Failed to seek checkpoint file with error %d.", file.GetError() );
+
+    if( header.stageDataSize )
+    {
+        _stageDataSize = (size_t)header.stageDataSize;
+        _stageData     = bbmalloc<byte>( _stageDataSize );
+
+        FatalIf( file.Read( _stageData, _stageDataSize ) != (ssize_t)_stageDataSize,
+            "Failed to read checkpoint stage data with error %d.", file.GetError() );
+    }
+
+    _fileSetsOffset = _countersOffset + countersSize + (int64)_stageDataSize;
+}
+
+//-----------------------------------------------------------
+void DiskPlotCheckpoint::Restore()
+{
+    ASSERT( _path );
+
+    FileStream file;
+    FatalIf( !file.Open( _path, FileMode::Open, FileAccess::Read ),
+        "Failed to open checkpoint file '%s' with error %d.", _path, file.GetError() );
+
+    FatalIf( !file.Seek( _countersOffset, SeekOrigin::Begin ),
+        "Failed to seek checkpoint file with error %d.", file.GetError() );
+
+    ReadCheckpointCounters( file, _context );
+
+    FatalIf( !file.Seek( _fileSetsOffset, SeekOrigin::Begin ),
+        "Failed to seek checkpoint file with error %d.", file.GetError() );
+
+    _context.ioQueue->ReadFileSetStates( file );
+}
+
+//-----------------------------------------------------------
+void DiskPlotCheckpoint::ApplyToConfig( const char* dir, DiskPlotConfig& cfg )
+{
+    char* path = GetCheckpointPath( dir );
+
+    FileStream file;
+    FatalIf( !file.Open( path, FileMode::Open, FileAccess::Read ),
+        "No checkpoint found at '%s' ( error %d ).", path, file.GetError() );
+
+    CheckpointHeader header;
+    FatalIf( !ReadCheckpointHeader( file, path, header ), "Invalid checkpoint file '%s'.", path );
+
+    header.tmpPath2    [sizeof( header.tmpPath2     )-1] = 0;
+    header.outputFolder[sizeof( header.outputFolder )-1] = 0;
+
+    if( cfg.numBuckets != header.numBuckets || cfg.bounded != (header.bounded != 0) ||
+        cfg.alternateBuckets != (header.alternateBuckets != 0) )
+    {
+        Log::Line( "Using bucket settings from the checkpoint: %u buckets, %sbounded%s.",
+            header.numBuckets, header.bounded ? "" : "un", header.alternateBuckets ? ", alternating" : "" );
+    }
+
+    cfg.numBuckets       = header.numBuckets;
+    cfg.bounded          = header.bounded != 0;
+    cfg.alternateBuckets = header.alternateBuckets != 0;
+
+    if( !cfg.tmpPath2 )
+        cfg.tmpPath2 = strdup( header.tmpPath2 );
+
+    if( !cfg.globalCfg->outputFolder && header.outputFolder[0] )
+        cfg.globalCfg->outputFolder = strdup( header.outputFolder );
+
+    free( path );
+}
+
+//-----------------------------------------------------------
+char* GetCheckpointPath( const char* dir, const char* suffix )
+{
+    const size_t dirLen    = strlen( dir );
+    const size_t nameLen   = strlen( DiskPlotCheckpoint::FILE_NAME );
+    const size_t suffixLen = strlen( suffix );
+
+    char* path = bbmalloc<char>( dirLen + nameLen + suffixLen + 2 );
+    memcpy( path, dir, dirLen );
+
+    size_t len = dirLen;
+    if( len && path[len-1] != '/' && path[len-1] != '\\' )
+        path[len++] = '/';
+
+    memcpy( path + len, DiskPlotCheckpoint::FILE_NAME, nameLen );
+    len += nameLen;
+    memcpy( path + len, suffix, suffixLen );
+    len += suffixLen;
+    path[len] = 0;
+
+    return path;
+}
+
+//-----------------------------------------------------------
+bool ReadCheckpointHeader( FileStream& file, const char* path, CheckpointHeader& header )
+{
+    if( file.Read( &header, sizeof( header ) ) != (ssize_t)sizeof( header ) )
+        return false;
+
+    if( memcmp( header.magic, BB_DP_CHECKPOINT_MAGIC, sizeof( header.magic ) ) != 0 )
+        return false;
+
+    FatalIf( header.version != BB_DP_CHECKPOINT_VERSION,
+        "Checkpoint '%s' has unsupported version %u.", path, header.version );
+
+    return true;
+}
+
+//-----------------------------------------------------------
+void WriteCheckpointCounters( FileStream& file, DiskPlotContext& cx )
+{
+    auto Write = [&]( const void* data, const size_t size ) {
+        FatalIf( file.Write( data, size ) != (ssize_t)size,
+            "Failed to write checkpoint with error %d.", file.GetError() );
+    };
+
+    Write( cx.bucketCounts        , sizeof( cx.bucketCounts         ) );
+    Write( cx.entryCounts         , sizeof( cx.entryCounts          ) );
+    Write( cx.bucketSlices        , sizeof( cx.bucketSlices         ) );
+    Write( cx.ptrTableBucketCounts, sizeof( cx.ptrTableBucketCounts ) );
+    Write( cx.plotTablePointers   , sizeof( cx.plotTablePointers    ) );
+    Write( cx.plotTableSizes      , sizeof( cx.plotTableSizes       ) );
+}
+
+//-----------------------------------------------------------
+void ReadCheckpointCounters( FileStream& file, DiskPlotContext& cx )
+{
+    auto Read = [&]( void* data, const size_t size ) {
+        FatalIf( file.Read( data, size ) != (ssize_t)size,
+            "Failed to read checkpoint with error %d.", file.GetError() );
+    };
+
+    Read( cx.bucketCounts        , sizeof( cx.bucketCounts         ) );
+    Read( cx.entryCounts         , sizeof( cx.entryCounts          ) );
+    Read( cx.bucketSlices        , sizeof( cx.bucketSlices         ) );
+    Read( cx.ptrTableBucketCounts, sizeof( cx.ptrTableBucketCounts ) );
+    Read( cx.plotTablePointers   , sizeof( cx.plotTablePointers    ) );
+    Read( cx.plotTableSizes      , sizeof( cx.plotTableSizes       ) );
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "plotting/Tables.h"
+
+struct DiskPlotContext;
+struct DiskPlotConfig;
+
+// Completed plotting stages, in plotting order.
+// A checkpoint saved at a stage means that plotting can be resumed after it.
+enum class DiskPlotStage : uint32
+{
+    None = 0,
+
+    // Bounded Phase 1: Completed table N (Table 1 is F1)
+    P1Table1,
+    P1Table2,
+    P1Table3,
+    P1Table4,
+    P1Table5,
+    P1Table6,
+    P1Table7,
+
+    Phase1,     // F7 sorted and C tables written
+    Phase2,     // Marks written
+
+    // Phase 3: Completed compressing table N-1 into table N
+    P3Table2,
+    P3Table3,
+    P3Table4,
+    P3Table5,
+    P3Table6,
+    P3Table7,
+
+    _Count
+}; ImplementArithmeticOps( DiskPlotStage );
+
+//-----------------------------------------------------------
+inline DiskPlotStage P1TableToStage( const TableId table )
+{
+    return DiskPlotStage::P1Table1 + (int)table;
+}
+
+//-----------------------------------------------------------
+inline DiskPlotStage P3TableToStage( const TableId rTable )
+{
+    ASSERT( rTable >= TableId::Table2 );
+    return DiskPlotStage::P3Table2 + ( (int)rTable - 1 );
+}
+
+/**
+ * Persists the plotting state at table and phase boundaries so that
+ * an interrupted plot can be continued with 'diskplot --resume <temp1 dir>'.
+ *
+ * A checkpoint holds the plot id, memo and settings, the DiskPlotContext counters
+ * (bucket counts, entry counts, table pointers, etc.), optional stage-specific data,
+ * and a manifest of the temporary file sets, including their bucket slice sizes.
+ * It is saved to the temp1 directory.
+ *
+ * #NOTE: Stages whose inputs can't survive a crash are not checkpointed:
+ *        File sets in the memory cache (--cache) or in alternating mode (-a) are
+ *        either lost or overwritten in place, so with those options only the stages
+ *        which don't depend on them are saved.
+ */
+class DiskPlotCheckpoint
+{
+public:
+    static constexpr const char* FILE_NAME = "bladebit_diskplot.checkpoint";
+
+    DiskPlotCheckpoint( DiskPlotContext& context );
+    ~DiskPlotCheckpoint();
+
+    // Save a checkpoint for a stage that has just been completed.
+    // Waits for all pending I/O to complete first.
+    // Does nothing if the stage can't be resumed from with the current configuration.
+    void Save( const DiskPlotStage stage, const void* stageData = nullptr, const size_t stageDataSize = 0 );
+
+    // Delete the checkpoint once the plot has been completed.
+    void Delete();
+
+    bool IsStageResumable( const DiskPlotStage stage ) const;
+
+    // Load a checkpoint from the given directory to resume from. Fails fatally if it is invalid.
+    void Load( const char* dir );
+
+    // Restore the context counters and the I/O queue's file set states.
+    // Must be called before opening any temporary file set.
+    void Restore();
+
+    // Apply the settings from a checkpoint in the given directory
+    // to the plotting config, so that we can resume with matching settings.
+    static void ApplyToConfig( const char* dir, DiskPlotConfig& cfg );
+
+    inline DiskPlotStage Stage()          const { return _stage; }
+    inline const byte*   PlotId()         const { return _plotId; }
+    inline const byte*   PlotMemo()       const { return _plotMemo; }
+    inline uint16        PlotMemoSize()   const { return _plotMemoSize; }
+    inline const char*   PlotFileName()   const { return _plotFileName; }
+    inline const void*   StageData()      const { return _stageData; }
+    inline size_t        StageDataSize()  const { return _stageDataSize; }
+
+private:
+    DiskPlotContext& _context;
+
+    // Loaded checkpoint
+    char*         _path               = nullptr;
+    DiskPlotStage _stage              = DiskPlotStage::None;
+    byte          _plotId  [32]       = {};
+    byte          _plotMemo[128]      = {};
+    uint16        _plotMemoSize       = 0;
+    char          _plotFileName[256]  = {};
+    byte*         _stageData          = nullptr;
+    size_t        _stageDataSize      = 0;
+    int64         _countersOffset     = 0;      // Offset to the context counters in the checkpoint file
+    int64         _fileSetsOffset     = 0;      // Offset to the file set states in the checkpoint file
+};
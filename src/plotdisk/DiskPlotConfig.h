@@ -26,6 +26,19 @@
 // Might change it to dynamic.
 #define BB_DISK_QUEUE_MAX_CMDS (4096*8) //1024
 
+// Size of the buffer through which the plot file is written in whole blocks when using direct I/O
+#define BB_DP_PLOT_WRITE_BUFFER_SIZE ( 8ull MB )
+
+// Number of park buffers Phase 3 cycles through when writing parks to the plot file,
+// so that the next buckets can be encoded while the previous ones are still being written.
+#define BB_DP_P3_PARK_BUFFER_COUNT 3
+
+// Maximum number of directories finished plots can be moved to (--dest)
+#define BB_DP_MAX_DEST_DIRS 64
+
+// Size of the buffer used to copy finished plots to their destination directory
+#define BB_DP_RELOCATE_BUFFER_SIZE ( 64ull MB )
+
 // Use at 256 buckets for line points so that
 // we can save 1 iteration when sorting it.
 #define BB_DPP3_LP_BUCKET_COUNT 256
@@ -1,11 +1,13 @@
 #pragma once
 #include "DiskPlotConfig.h"
 #include "DiskBufferQueue.h"
+#include "DiskPlotCheckpoint.h"
 #include "threading/ThreadPool.h"
 #include "threading/MTJob.h"
 #include "plotting/PlotTypes.h"
 #include "plotting/Tables.h"
 #include "ChiaConsts.h"
+#include <atomic>
 
 struct GlobalPlotConfig;
 
@@ -14,6 +16,14 @@ struct DiskPlotConfig
     GlobalPlotConfig* globalCfg                = nullptr;
     const char*       tmpPath                  = nullptr;
     const char*       tmpPath2                 = nullptr;
+    const char*       resumePath               = nullptr; // Temp 1 directory of an interrupted plot to resume
+    const char*       metricsPath              = nullptr; // Directory in which to write a JSON metrics report for each plot
+    const char*       tracePath                = nullptr; // Directory in which to write a Chrome trace of each plot
+    uint32            traceEvents              = 1u << 16;// Trace spans kept per thread
+    const char*       statsSocketPath          = nullptr; // Unix socket on which to serve live plot stats
+    const char*       destPaths[BB_DP_MAX_DEST_DIRS] = {};// Directories to move finished plots to. The output directory is then only used for staging.
+    uint32            destCount                = 0;
+    size_t            destBandwidth            = 0;       // Maximum speed in bytes per second at which plots are copied to their destination. 0 is unlimited.
     size_t            expectedTmpDirBlockSize  = 0;
     uint32            numBuckets               = 256;
     uint32            ioThreadCount            = 0;
@@ -24,6 +34,10 @@ struct DiskPlotConfig
     bool              alternateBuckets         = false; // Alternate bucket writing method between interleaved and not
     bool              noTmp1DirectIO           = false; // Disable direct I/O on tmp 1
     bool              noTmp2DirectIO           = false; // Disable direct I/O on tmp 1
+    bool              noPlotDirectIO           = false; // Disable direct I/O on the plot file
+    bool              noCheckpoint             = false; // Do not save checkpoints to resume from
+    bool              cacheMarks               = false; // Keep the Phase 2 marking tables in the cache for Phase 3
+    bool              p2AtomicMarks            = false; // Mark Phase 2 entries in a single pass with atomic bit sets, instead of 2 passes with a barrier
 
     uint32            f1ThreadCount            = 0;
     uint32            fpThreadCount            = 0;
@@ -32,6 +46,80 @@ struct DiskPlotConfig
     uint32            p3ThreadCount            = 0;
 };
 
+// Position of the plotter in the plot being created.
+// Written by the plotting threads and read concurrently by the stats server (--stats-socket).
+// Each field is atomic on its own, so readers may see slightly stale or mismatched values.
+struct DiskPlotProgress
+{
+    template<typename T>
+    using Field = std::atomic<T>;
+
+    Field<uint32> phase;            // 1-3, 4 while completing the plot file, 0 when not plotting
+    Field<uint32> table;            // Table being processed, 1-7
+    Field<uint32> step;             // Index of the table pass being processed in the current phase
+    Field<uint32> stepCount;        // Number of table passes in the current phase
+    Field<uint32> bucket;           // Bucket being processed in the current table pass
+    Field<uint64> tableEntries;     // Input entries of the current table pass
+    Field<uint32> plotCount;        // Plots completed since the plotter started
+    Field<int64>  plotStart;        // Start times as steady clock ticks
+    Field<int64>  phaseStart;
+    Field<int64>  tableStart;
+
+    //-----------------------------------------------------------
+    inline static int64 Now() { return (int64)TimerBegin().time_since_epoch().count(); }
+
+    //-----------------------------------------------------------
+    template<typename T>
+    inline static T Get( const Field<T>& field ) { return field.load( std::memory_order_relaxed ); }
+
+    //-----------------------------------------------------------
+    template<typename T>
+    inline static void Set( Field<T>& field, const T value ) { field.store( value, std::memory_order_relaxed ); }
+
+    // Not an atomic read-modify-write: Only a single thread may update a field.
+    //-----------------------------------------------------------
+    template<typename T>
+    inline static void Add( Field<T>& field, const T value ) { Set( field, Get( field ) + value ); }
+
+    //-----------------------------------------------------------
+    inline void SetBucket( const uint32 bucketIdx ) { Set( bucket, bucketIdx ); }
+
+    //-----------------------------------------------------------
+    inline void BeginPlot()
+    {
+        Set( phase    , 0u    );
+        Set( plotStart, Now() );
+    }
+
+    //-----------------------------------------------------------
+    inline void BeginPhase( const uint32 phaseNumber, const uint32 phaseStepCount )
+    {
+        Set( table     , 0u             );
+        Set( step      , 0u             );
+        Set( bucket    , 0u             );
+        Set( stepCount , phaseStepCount );
+        Set( phaseStart, Now()          );
+        Set( phase     , phaseNumber    );
+    }
+
+    //-----------------------------------------------------------
+    inline void BeginTable( const TableId tableId, const uint32 tableStep, const uint64 entries )
+    {
+        Set( bucket      , 0u                  );
+        Set( tableEntries, entries             );
+        Set( tableStart  , Now()               );
+        Set( step        , tableStep           );
+        Set( table       , (uint32)tableId + 1 );
+    }
+
+    //-----------------------------------------------------------
+    inline void EndPlot()
+    {
+        Set( phase    , 0u                  );
+        Set( plotCount, Get( plotCount ) + 1 );
+    }
+};
+
 struct DiskPlotContext
 {
     const DiskPlotConfig* cfg;
@@ -52,6 +140,11 @@ struct DiskPlotContext
     size_t       cacheSize;         // Size of memory cache to reserve for IO (region in file that never gets written to disk).
     byte*        cache;
 
+    // Marking tables kept at the start of the cache by Phase 2 for Phase 3 (--cache-marks).
+    // nullptr for the tables whose marks were written to temp 1 instead.
+    uint64*      cachedMarks[(uint)TableId::_Count];
+    size_t       cachedMarksSize;   // Bytes of the cache taken by the cached marking tables
+
     uint32       numBuckets;        // Divide entries into this many buckets
 
     uint32       ioThreadCount;     // How many threads to use for the disk buffer writer/reader
@@ -64,6 +157,10 @@ struct DiskPlotContext
     const byte*  plotId;
     const byte*  plotMemo;
     uint16       plotMemoSize;
+    const char*  plotFileName;
+
+    DiskPlotCheckpoint* checkpoint;
+    DiskPlotStage       resumeStage;    // Last completed stage of the plot being resumed, if any
 
     uint32       bucketCounts[(uint)TableId::_Count][BB_DP_MAX_BUCKET_COUNT+1];
     uint64       entryCounts [(uint)TableId::_Count];
@@ -86,10 +183,12 @@ struct DiskPlotContext
     uint64       plotTablePointers[10];
     uint64       plotTableSizes   [10];
 
-    Duration ioWaitTime;                                // Total Plot I/O wait time
+    DiskPlotProgress::Field<Duration> ioWaitTime;       // Total Plot I/O wait time. Atomic, as it is read by the stats server.
     Duration p1TableWaitTime[(uint)TableId::_Count];    // Phase 1 per-table I/O wait time
     Duration p2TableWaitTime[(uint)TableId::_Count];    // Phase 2 per-table I/O wait time
     Duration p3TableWaitTime[(uint)TableId::_Count];    // Phase 3 per-table I/O wait time
     Duration cTableWaitTime;
     Duration p7WaitTime;
+
+    DiskPlotProgress progress;
 };
@@ -7,6 +7,7 @@
 #include "jobs/LookupMapJob.h"
 #include "plotting/TableWriter.h"
 #include "util/StackAllocator.h"
+#include "plotting/PlotMetrics.h"
 #include "DiskF1.h"
 #include "DiskFp.h"
 
@@ -223,7 +224,7 @@ void DiskPlotPhase1::Run()
     }
     #endif
 
-    Log::Line( " Phase 1 Total I/O wait time: %.2lf", TicksToSeconds( _cx.ioWaitTime ) + _cx.ioQueue->IOBufferWaitTime() );
+    Log::Line( " Phase 1 Total I/O wait time: %.2lf", TicksToSeconds( DiskPlotProgress::Get( _cx.ioWaitTime ) ) + _cx.ioQueue->IOBufferWaitTime() );
 
 #if BB_DP_DBG_SKIP_TO_C_TABLES
     CTables:
@@ -260,7 +261,12 @@ void DiskPlotPhase1::GenF1()
     
     double elapsed = TimerEnd( timer );
     Log::Line( "Finished f1 generation in %.2lf seconds. ", elapsed );
-    Log::Line( "Table 1 I/O wait time: %.2lf seconds.", _cx.ioQueue->IOBufferWaitTime() );
+    Log::Line( "Table 1 I/O wait time: %.2lf seconds.", TicksToSeconds( _cx.p1TableWaitTime[(int)TableId::Table1] ) );
+
+    PlotMetrics::SetF64( elapsed, "tables.p1.t1.elapsed" );
+    PlotMetrics::SetU64( _cx.entryCounts[(int)TableId::Table1], "tables.p1.t1.entries" );
+
+    DiskPlotProgress::Add( _cx.ioWaitTime, _cx.p1TableWaitTime[(int)TableId::Table1] );
 
     #if BB_IO_METRICS_ON
         const double writeThroughput = _cx.ioQueue->GetAverageWriteThroughput();
@@ -315,9 +321,13 @@ void DiskPlotPhase1::ForwardPropagate()
                 Fatal( "Invalid table." );
                 break;
         }
-        Log::Line( "Completed table %u in %.2lf seconds with %.llu entries.", table+1, TimerEnd( timer ), _cx.entryCounts[(int)table] );
+        const double elapsed = TimerEnd( timer );
+        Log::Line( "Completed table %u in %.2lf seconds with %.llu entries.", table+1, elapsed, _cx.entryCounts[(int)table] );
         Log::Line( "Table %u I/O wait time: %.2lf seconds.",  table+1, TicksToSeconds( _tableIOWaitTime ) );
 
+        PlotMetrics::SetF64( elapsed, "tables.p1.t%u.elapsed", (uint32)table+1 );
+        PlotMetrics::SetU64( _cx.entryCounts[(int)table], "tables.p1.t%u.entries", (uint32)table+1 );
+
         std::swap( _fxIn, _fxOut );
 
         // No longer need fxout. Delete it
@@ -391,7 +401,8 @@ void DiskPlotPhase1::ForwardPropagateBuckets()
     fp.Run();
 
     _tableIOWaitTime = fp.IOWaitTime();
-    _cx.ioWaitTime   += _tableIOWaitTime;
+    _cx.p1TableWaitTime[(int)table] = _tableIOWaitTime;
+    DiskPlotProgress::Add( _cx.ioWaitTime, _tableIOWaitTime );
 
     #if BB_DP_DBG_VALIDATE_FX
         #if !_DEBUG
@@ -456,5 +467,9 @@ void DiskPlotPhase1::WriteCTablesBuckets()
     const double elapsed = TimerEnd( timer );
     Log::Line( "Completed C processing tables in %.2lf seconds.", elapsed );
     Log::Line( "C Tables I/O wait time: %.2lf.", TicksToSeconds( fp.IOWaitTime() ) );
+    DiskPlotProgress::Add( _cx.ioWaitTime, fp.IOWaitTime() );
+
+    PlotMetrics::SetF64( elapsed, "tables.p1.c.elapsed" );
+    PlotMetrics::SetF64( TicksToSeconds( fp.IOWaitTime() ), "tables.p1.c.io_wait" );
 }
 
@@ -1,8 +1,10 @@
 #include "DiskPlotPhase2.h"
+#include "MarkTableEntries.h"
 #include "util/BitField.h"
 #include "algorithm/RadixSort.h"
 #include "plotdisk/DiskPlotInfo.h"
 #include "util/StackAllocator.h"
+#include "plotting/PlotMetrics.h"
 #include "DiskPlotInfo.h"
 
 // #DEBUG
@@ -10,12 +12,6 @@
 #include "io/FileStream.h"
 #include "DiskPlotDebug.h"
 
-//-----------------------------------------------------------
-template<TableId table>
-inline void MarkTableEntries( int64 i, const int64 entryCount, BitField lTable, const BitField rTable,
-                              uint64 lTableOffset, const Pair* pairs, const uint64* map );
-
-
 //-----------------------------------------------------------
 DiskPlotPhase2::DiskPlotPhase2( DiskPlotContext& context )
     : _context( context )
@@ -49,6 +45,10 @@ DiskPlotPhase2::DiskPlotPhase2( DiskPlotContext& context )
     ioQueue.SeekBucket( FileId::MAP7, 0, SeekOrigin::Begin );
 
     ioQueue.CommitCommands();
+
+    // Set by Run(), if the marks are kept in the cache
+    memset( context.cachedMarks, 0, sizeof( context.cachedMarks ) );
+    context.cachedMarksSize = 0;
 }
 
 //-----------------------------------------------------------
@@ -119,6 +119,14 @@ void DiskPlotPhase2::RunWithBuckets()
     bitFields[0] = allocator.AllocT<uint64>( _markingTableSize, blockSize );
     bitFields[1] = allocator.AllocT<uint64>( _markingTableSize, blockSize );
 
+    uint32 bitFieldWrites[2] = { 0, 0 };    // Fence value signalled once the last write from each bitfield has completed
+    uint32 writeCount        = 0;
+
+    // With --cache-marks, the tables are marked directly in the cache, for as long as they fit.
+    // Phase 3 then reads them from there instead of from disk.
+    byte*  marksCache     = context.cfg->cacheMarks ? context.cache     : nullptr;
+    size_t marksCacheSize = context.cfg->cacheMarks ? context.cacheSize : 0;
+
     #if _DEBUG && BB_DP_DBG_SKIP_PHASE_2
         return;
     #endif
@@ -127,14 +135,15 @@ void DiskPlotPhase2::RunWithBuckets()
     // Mark all tables
     FileId  lTableFileId  = FileId::MARKED_ENTRIES_6;
 
-    uint64* lMarkingTable = bitFields[0];
     uint64* rMarkingTable = bitFields[1];
 
     for( TableId table = TableId::Table7; table > TableId::Table2; table = table-1 )
     {
         readFence.Reset( 0 );
+        _ioTableWaitTime = Duration::zero();
 
         const auto timer = TimerBegin();
+        context.progress.BeginTable( table, (uint32)( TableId::Table7 - table ), context.entryCounts[(int)table] );
         
         const size_t stackMarker = allocator.Size();
         DiskPairAndMapReader<_numBuckets, _bounded> reader( context, context.p2ThreadCount, readFence, table, allocator, table == TableId::Table7 );
@@ -144,7 +153,33 @@ void DiskPlotPhase2::RunWithBuckets()
         // Log::Line( "Allocated work heap of %.2lf GiB out of %.2lf GiB.", 
         //     (double)(allocator.Size() + _markingTableSize*2 ) BtoGB, (double)context.heapSize BtoGB );
 
-        memset( lMarkingTable, 0, _markingTableSize );
+        const TableId lTable     = table - 1;
+        const size_t  lMarksSize = RoundUpToNextBoundaryT( CDiv( context.entryCounts[(int)lTable], 8 ), (uint64)blockSize );
+
+        uint64* lMarkingTable;
+        int32   lBitField = -1;
+
+        if( lMarksSize <= marksCacheSize )
+        {
+            lMarkingTable   = (uint64*)marksCache;
+            marksCache     += lMarksSize;
+            marksCacheSize -= lMarksSize;
+
+            context.cachedMarks[(int)lTable] = lMarkingTable;
+            context.cachedMarksSize         += lMarksSize;
+
+            memset( lMarkingTable, 0, lMarksSize );
+        }
+        else
+        {
+            // Use the bitfield which does not hold the r table, once it has been written to disk
+            lBitField     = rMarkingTable == bitFields[0] ? 1 : 0;
+            lMarkingTable = bitFields[lBitField];
+
+            bitFieldFence.Wait( bitFieldWrites[lBitField], _ioTableWaitTime );
+            memset( lMarkingTable, 0, _markingTableSize );
+        }
+
         MarkTable<_numBuckets>( table, reader, pairs, map, BitField( lMarkingTable, context.entryCounts[(int)table-1] ), 
                                                            BitField( rMarkingTable, context.entryCounts[(int)table] ) );
 
@@ -383,26 +418,28 @@ void DiskPlotPhase2::RunWithBuckets()
         }
         #endif
 
-        // Ensure the last table finished writing to the bitfield
-        _ioTableWaitTime = Duration::zero();
-
-        if( table < TableId::Table7 )
-            bitFieldFence.Wait( _ioTableWaitTime );
-
         // Submit l marking table for writing
-        queue.WriteFile( lTableFileId, 0, lMarkingTable, _markingTableSize );
-        queue.SignalFence( bitFieldFence );
-        queue.CommitCommands();
+        if( lBitField >= 0 )
+        {
+            queue.WriteFile( lTableFileId, 0, lMarkingTable, _markingTableSize );
+            queue.SignalFence( bitFieldFence, ++writeCount );
+            queue.CommitCommands();
 
-        // Swap marking tables
-        std::swap( lMarkingTable, rMarkingTable );
-        lTableFileId = (FileId)( (int)lTableFileId - 1 );
+            bitFieldWrites[lBitField] = writeCount;
+        }
+
+        // The l table is the r table of the next table
+        rMarkingTable = lMarkingTable;
+        lTableFileId  = (FileId)( (int)lTableFileId - 1 );
 
         const double elapsed = TimerEnd( timer );
         Log::Line( "Finished marking table %d in %.2lf seconds.", table, elapsed );
         Log::Line( "Table %d I/O wait time: %.2lf seconds.", table, TicksToSeconds( _ioTableWaitTime ) );
         p2WaitTime += _ioTableWaitTime;
 
+        PlotMetrics::SetF64( elapsed, "tables.p2.t%u.elapsed", (uint32)table+1 );
+        PlotMetrics::SetF64( TicksToSeconds( _ioTableWaitTime ), "tables.p2.t%u.io_wait", (uint32)table+1 );
+
         allocator.PopToMarker( stackMarker );
         ASSERT( allocator.Size() == stackMarker );
 
@@ -447,8 +484,15 @@ void DiskPlotPhase2::RunWithBuckets()
         queue.CommitCommands();
         bitFieldFence.Wait( 0xFFFFFFFF );
 
+    if( context.cfg->cacheMarks )
+        Log::Line( " Kept the marks of %u tables in the cache ( %.2lf MiB ).", 
+            (uint32)std::count_if( context.cachedMarks, context.cachedMarks + (int)TableId::_Count, []( const uint64* m ) { return m != nullptr; } ),
+            (double)context.cachedMarksSize BtoMB );
+
     Log::Line( " Phase 2 Total I/O wait time: %.2lf seconds.", TicksToSeconds( p2WaitTime ) );    
-    _context.ioWaitTime += p2WaitTime;
+    DiskPlotProgress::Add( _context.ioWaitTime, p2WaitTime );
+
+    PlotMetrics::MaxU64( allocator.HighWater(), "heap.p2_high_water" );
     //         TicksToSeconds( context.readWaitTime ), TicksToSeconds( context.writeWaitTime ), context.ioQueue->IOBufferWaitTime() );
 }
 
@@ -476,6 +520,8 @@ template<TableId rTable, uint32 _numBuckets, bool _bounded>
 void DiskPlotPhase2::MarkTableBuckets( DiskPairAndMapReader<_numBuckets, _bounded> reader, 
                                        Pair* pairs, uint64* map, BitField lTableMarks, const BitField rTableMarks )
 {
+    const bool atomicMarks = _context.cfg->p2AtomicMarks;
+
     // Load initial bucket
     reader.LoadNextBucket();
 
@@ -483,6 +529,8 @@ void DiskPlotPhase2::MarkTableBuckets( DiskPairAndMapReader<_numBuckets, _bounde
 
     for( uint32 bucket = 0; bucket < _numBuckets; bucket++ )
     {
+        _context.progress.SetBucket( bucket );
+
         reader.LoadNextBucket();
         reader.UnpackBucket( bucket, pairs, map, _ioTableWaitTime );
 
@@ -506,45 +554,23 @@ void DiskPlotPhase2::MarkTableBuckets( DiskPairAndMapReader<_numBuckets, _bounde
             int64 count, offset, _;
             GetThreadOffsets( self, (int64)bucketEntryCount, count, offset, _ );
 
-            // We need to do 2 passes to ensure no 2 threads attempt to write to the same field at the same time
-            const int64 firstPassCount = count / 2;
-            
-            MarkTableEntries<rTable>( offset, firstPassCount, lTableMarks, rTableMarks, lTableOffset, pairs, map );
-            self->SyncThreads();
-            MarkTableEntries<rTable>( offset + firstPassCount, count - firstPassCount, lTableMarks, rTableMarks, lTableOffset, pairs, map );
+            if( atomicMarks )
+            {
+                // The bits are set atomically, as the pairs of
+                // neighbouring threads may reference entries in the same field.
+                MarkTableEntriesAtomic<rTable>( offset, count, lTableMarks, rTableMarks, lTableOffset, pairs, map );
+            }
+            else
+            {
+                // We need to do 2 passes to ensure no 2 threads attempt to write to the same field at the same time
+                const int64 firstPassCount = count / 2;
 
-        });
+                MarkTableEntries<rTable>( offset, firstPassCount, lTableMarks, rTableMarks, lTableOffset, pairs, map );
+                self->SyncThreads();
+                MarkTableEntries<rTable>( offset + firstPassCount, count - firstPassCount, lTableMarks, rTableMarks, lTableOffset, pairs, map );
+            }
+        }, "DiskPlotPhase2::MarkTableBuckets" );
 
         lTableOffset += _context.bucketCounts[(int)rTable-1][bucket];
     }
 }
-
-//-----------------------------------------------------------
-template<TableId table>
-inline void MarkTableEntries( int64 i, const int64 entryCount, BitField lTable, const BitField rTable,
-                              uint64 lTableOffset, const Pair* pairs, const uint64* map )
-{
-    for( const int64 end = i + entryCount ; i < end; i++ )
-    {
-#if _DEBUG
-    // if( table == TableId::Table3 && pairs[i].left == 4213663 && pairs[i].right == 4214002 ) BBDebugBreak();
-    // if( table == TableId::Table3 && pairs[i].left + lTableOffset == 910154188 && pairs[i].right + lTableOffset == 910154527 ) BBDebugBreak();
-#endif
-        if constexpr ( table < TableId::Table7 )
-        {
-            const uint64 rTableIdx = map[i];
-            if( !rTable.Get( rTableIdx ) )
-                continue;
-        }
-
-        const Pair&  pair  = pairs[i];
-        const uint64 left  = lTableOffset + pair.left;
-        const uint64 right = lTableOffset + pair.right;
-
-        // #TODO Test with atomic sets so that we can write into the
-        //       mapped index, and not have to do mapped readings when
-        //       reading from the R table here, or in Phase 3.
-        lTable.Set( left  );
-        lTable.Set( right );
-    }
-}
@@ -2,10 +2,12 @@
 #include "util/BitField.h"
 #include "plotdisk/BitBucketWriter.h"
 #include "plotdisk/MapWriter.h"
+#include "plotdisk/DiskCachePlanner.h"
 #include "plotmem/LPGen.h"
 #include "algorithm/RadixSort.h"
 #include "plotting/TableWriter.h"
 #include "plotmem/ParkWriter.h"
+#include "plotting/PlotMetrics.h"
 
 #if _DEBUG
     #include "DiskPlotDebug.h"
@@ -21,6 +23,15 @@
 
 #endif
 
+// State needed to resume after a table has been compressed
+struct P3CheckpointData
+{
+    uint64 lMapPrunedBucketCounts[BB_DP_MAX_BUCKET_COUNT+1];
+    uint64 tablePrunedEntryCount [7];
+    FileId mapReadId;
+    FileId mapWriteId;
+};
+
 // Extra L entries to load per bucket to ensure we
 // have cross bucket entries accounted for
 #define P3_EXTRA_L_ENTRIES_TO_LOAD BB_DP_CROSS_BUCKET_MAX_ENTRIES
@@ -161,6 +172,29 @@ public:
     //-----------------------------------------------------------
     inline Duration GetIOWaitTime() const { return _ioWaitTime; }
 
+    // Use a marking table that was read by the previous table's step 2.
+    // It is placed at the end of the heap, so our buffers are allocated below it.
+    //-----------------------------------------------------------
+    inline void UsePrefetchedMarks( void* rMarks, Fence& marksFence )
+    {
+        _prefetchedMarks = rMarks;
+        _marksFence      = &marksFence;
+    }
+
+    // Use a marking table that Phase 2 kept in the cache
+    //-----------------------------------------------------------
+    inline void UseCachedMarks( void* rMarks )
+    {
+        _cachedMarks = rMarks;
+    }
+
+    //-----------------------------------------------------------
+    inline static size_t GetRMarksAllocSize( const size_t tmp1BlockSize )
+    {
+        const uint64 maxBucketEntries = (uint64)( ( (1ull << _k) / _numBuckets ) * P3_BUCKET_MULTIPLER );
+        return RoundUpToNextBoundary( maxBucketEntries * _numBuckets / 8, (int)tmp1BlockSize );
+    }
+
     //-----------------------------------------------------------
     void Allocate( const bool dryRun, IAllocator& allocator, const size_t tmp1BlockSize, const size_t tmp2BlockSize, const uint64* inLMapBucketCounts,
         void*&                  rMarks,
@@ -175,11 +209,9 @@ public:
     {
         const TableId lTable           = rTable - 1;
         const uint64  maxBucketEntries = (uint64)( ( (1ull << _k) / _numBuckets ) * P3_BUCKET_MULTIPLER );
-        const size_t  rMarksSize       =  RoundUpToNextBoundary( maxBucketEntries * _numBuckets  / 8, (int)tmp1BlockSize );
-        //RoundUpToNextBoundary( _context.entryCounts[(int)rTable] / 8, (int)context.tmp1BlockSize );
-
 
-        rMarks       = allocator.Alloc( rMarksSize, tmp1BlockSize );
+        rMarks       = _prefetchedMarks ? _prefetchedMarks :
+                       _cachedMarks     ? _cachedMarks     : allocator.Alloc( GetRMarksAllocSize( tmp1BlockSize ), tmp1BlockSize );
         rTableReader = dryRun ? PMReader( allocator, tmp1BlockSize )
                               : PMReader( _context, _threadCount, _readFence, rTable, allocator, false );
 
@@ -236,7 +268,8 @@ public:
         const size_t  rMarksSize = RoundUpToNextBoundary( context.entryCounts[(int)rTable] / 8, (int)context.tmp1BlockSize );
 
         // Allocate buffers
-        StackAllocator allocator( context.heapBuffer, context.heapSize );
+        const size_t heapSize = _prefetchedMarks ? (size_t)( (byte*)_prefetchedMarks - context.heapBuffer ) : context.heapSize;
+        StackAllocator allocator( context.heapBuffer, heapSize );
 
         void*                  rMarks;
         PMReader               rTableReader;
@@ -258,6 +291,7 @@ public:
             map );
 
         Log::Line( "Step 1 Allocated %.2lf / %.2lf MiB", (double)allocator.Size() BtoMB, (double)allocator.Capacity() BtoMB );
+        PlotMetrics::MaxU64( allocator.HighWater(), "heap.p3_high_water" );
 
 
         auto GetLLoadCount = [=]( const uint32 bucket ) { 
@@ -284,13 +318,21 @@ public:
 
 
         // Load initial bucket and the whole marking table
-        if( rTable < TableId::Table7 )
+        if( rTable < TableId::Table7 && !_prefetchedMarks && !_cachedMarks )
             ioQueue.ReadFile( FileId::MARKED_ENTRIES_2 + (FileId)rTable - 1, 0, rMarks, rMarksSize );
 
         LoadBucket( 0 );
 
+        if( _prefetchedMarks )
+            _marksFence->Wait( 1, _ioWaitTime );
+
+        // Each table is compressed in 2 passes: step 1 and step 2
+        context.progress.BeginTable( rTable, (uint32)( rTable - TableId::Table2 ) * 2, context.entryCounts[(int)rTable] );
+
         for( uint32 bucket = 0; bucket < _numBuckets; bucket++ )
         {
+            context.progress.SetBucket( bucket );
+
             // Load next bucket in the background
             const bool isLastbucket = bucket + 1 == _numBuckets;
 
@@ -468,7 +510,7 @@ private:
                     ASSERT( x || y );                    outLinePoints[i] = SquareToLinePoint( x, y );
                 }
             }
-        });
+        }, "P3StepOne::ConvertToLinePoints" );
 
         int64 prunedEntryCount = 0;
         for( int32 i = 0; i < (int32)_threadCount; i++ )
@@ -603,15 +645,17 @@ private:
     //-----------------------------------------------------------
     inline void PackEntries( const int64 count, BitWriter& writer, const uint64* lps, const uint64* indices, const uint32 bucket )
     {
-        BitReader reader( (uint64*)writer.Fields(), writer.Capacity(), writer.Position() );
-        
+        BitPacker packer( writer );
+
         for( int64 i = 0; i < count; i++ )
         {
-            writer.Write( lps    [i], _lpBits  );
-            writer.Write( indices[i], _idxBits );
+            packer.Write<_lpBits >( lps    [i] );
+            packer.Write<_idxBits>( indices[i] );
 
             ASSERT( indices[i] < (1ull << _K) + ((1ull << _K) / _numBuckets) );
         }
+
+        packer.Flush();
     }
 
     //-----------------------------------------------------------
@@ -640,6 +684,10 @@ private:
     byte*            _lpWriteBuffer[2] = { nullptr };
 
     uint64           _prunedEntryCount = 0;
+
+    void*            _prefetchedMarks  = nullptr;
+    Fence*           _marksFence       = nullptr;
+    void*            _cachedMarks      = nullptr;
 };
 
 template<TableId rTable, uint32 _numBuckets>
@@ -688,6 +736,19 @@ public:
     //-----------------------------------------------------------
     inline Duration GetIOWaitTime() const { return _ioWaitTime; }
 
+    // Read the next table's marking table into the end of the heap while our buckets are processed,
+    // so that step 1 of the next table does not have to wait for it. The fence is signalled with 1 once read.
+    //-----------------------------------------------------------
+    inline void PrefetchMarks( const FileId fileId, byte* buffer, const size_t size, Fence& fence )
+    {
+        ASSERT( buffer >= _context.heapBuffer && buffer + size <= _context.heapBuffer + _context.heapSize );
+
+        _marksFileId = fileId;
+        _marksBuffer = buffer;
+        _marksSize   = size;
+        _marksFence  = &fence;
+    }
+
     //-----------------------------------------------------------
     inline static size_t GetRequiredHeapSize( const size_t tmp1BlockSize, const size_t tmp2BlockSize )
     {
@@ -732,8 +793,9 @@ public:
 
         _maxParkCount     = maxBucketEntries / kEntriesPerPark;
         _lpLeftOverBuffer = allocator.CAlloc<uint64>( kEntriesPerPark );
-        _parkBuffers[0]   = allocator.AllocT<byte>( parkSize * _maxParkCount );
-        _parkBuffers[1]   = allocator.AllocT<byte>( parkSize * _maxParkCount );
+        for( uint32 i = 0; i < BB_DP_P3_PARK_BUFFER_COUNT; i++ )
+            _parkBuffers[i] = allocator.AllocT<byte>( parkSize * _maxParkCount );
+
         _finalPark        = allocator.AllocT<byte>( parkSize );
     }
 
@@ -754,11 +816,14 @@ public:
         uint64*     indices;
         uint64*     tmpIndices;
         
-        StackAllocator allocator( _context.heapBuffer, _context.heapSize );
+        const size_t heapSize = _marksBuffer ? (size_t)( _marksBuffer - _context.heapBuffer ) : _context.heapSize;
+
+        StackAllocator allocator( _context.heapBuffer, heapSize );
         Allocate( false, allocator, _context.tmp1BlockSize, _context.tmp2BlockSize, 
                   mapWriter, readBuffers, linePoints, tmpLinePoints, indices, tmpIndices );
         
         Log::Line( "Step 2 using %.2lf / %.2lf GiB.", (double)allocator.Size() BtoGB, (double)allocator.Capacity() BtoGB );
+        PlotMetrics::MaxU64( allocator.HighWater(), "heap.p3_high_water" );
 
 
         // Start processing buckets
@@ -774,9 +839,13 @@ public:
 
         uint64 mapOffset = 0;
 
+        _context.progress.BeginTable( rTable, (uint32)( rTable - TableId::Table2 ) * 2 + 1, _context.entryCounts[(int)rTable] );
+
         const uint32 endBucket = rTable == TableId::Table7 ? _numBuckets : _numBuckets-1;
         for( uint32 bucket = 0; bucket <= endBucket; bucket++ )
         {
+            _context.progress.SetBucket( bucket );
+
             const bool isLastBucket     = bucket == endBucket;
             const bool nextBucketEmpty  = !isLastBucket && inLPBucketCounts[bucket+1] == 0;
             const bool hasNextBucket    = !isLastBucket && !nextBucketEmpty;
@@ -790,6 +859,10 @@ public:
             if( hasNextBucket )
                 LoadBucket( bucket + 1 );
 
+            // Queue the marks in bucket-sized chunks after our own reads, to keep them from stalling our buckets
+            if( _marksBuffer )
+                ReadMarksChunk( CDiv( _marksSize, _numBuckets ) );
+
             _readFence.Wait( bucket + 1, _ioWaitTime );
 
 
@@ -839,6 +912,13 @@ public:
 
 
         mapWriter.SubmitFinalBits();
+
+        if( _marksBuffer )
+        {
+            ReadMarksChunk( _marksSize );
+            _ioQueue.SignalFence( *_marksFence, 1 );
+            _ioQueue.CommitCommands();
+        }
         
         // Wait for all writes to finish
         _ioQueue.SignalFence( _lpWriteFence, _numBuckets + 5 );
@@ -848,6 +928,21 @@ public:
 
 private:
 
+    //-----------------------------------------------------------
+    void ReadMarksChunk( const size_t maxSize )
+    {
+        const size_t blockSize = _context.tmp1BlockSize;
+        const size_t readSize  = std::min( RoundUpToNextBoundary( maxSize, (int)blockSize ), _marksSize - _marksReadSize );
+
+        if( readSize == 0 )
+            return;
+
+        _ioQueue.ReadFile( _marksFileId, 0, _marksBuffer + _marksReadSize, readSize );
+        _ioQueue.CommitCommands();
+
+        _marksReadSize += readSize;
+    }
+
     //-----------------------------------------------------------
     void UnpackEntries( const uint32 bucket, const int64 entryCount, const byte* packedEntries, uint64* outLinePoints, uint64* outIndices )
     {
@@ -856,7 +951,7 @@ private:
             int64 count, offset, end;
             GetThreadOffsets( self, entryCount, count, offset, end );
 
-            BitReader reader( (uint64*)packedEntries, _entrySizeBits * (uint64)entryCount, (uint64)offset * _entrySizeBits );
+            BitUnpacker reader( (uint64*)packedEntries, _entrySizeBits * (uint64)entryCount, (uint64)offset * _entrySizeBits );
 
             uint64* linePoints = outLinePoints;
             uint64* indices    = outIndices;
@@ -865,15 +960,15 @@ private:
             const uint64 bucketMask = ((uint64)bucket) << _lpBits;
             for( int64 i = offset; i < end; i++ )
             {
-                const uint64 lp  = reader.ReadBits64( _lpBits  ) | bucketMask;
-                const uint64 idx = reader.ReadBits64( _idxBits );
+                const uint64 lp  = reader.Read<_lpBits >() | bucketMask;
+                const uint64 idx = reader.Read<_idxBits>();
 
                 ASSERT( idx < (1ull << _K) + ((1ull << _K) / _numBuckets) );
 
                 linePoints[i] = lp;
                 indices   [i] = idx;
             }
-        });
+        }, "P3StepTwo::UnpackEntries" );
     }
 
     //-----------------------------------------------------------
@@ -910,23 +1005,15 @@ private:
             const TableId lTable          = rTable - 1;
             const size_t  parkSize        = CalculateParkSize( lTable );
 
-            uint64* parkLinePoints  = inLinePoints + offset * kEntriesPerPark;
-            byte*   parkWriteBuffer = parkBuffer   + offset * parkSize;
-            
-            for( uint64 i = 0; i < count; i++ )
-            {
-                // #NOTE: This functions mutates inLinePoints
-                WritePark( parkSize, kEntriesPerPark, (uint64*)parkLinePoints, parkWriteBuffer, lTable );
-                parkLinePoints  += kEntriesPerPark;
-                parkWriteBuffer += parkSize;
-            }
-        });
+            ParkEncoder encoder( lTable );
+            encoder.WriteParks( count, inLinePoints + offset * kEntriesPerPark, parkBuffer + offset * parkSize );
+        }, "P3StepTwo::WriteLinePointsToPlot" );
 
         const size_t sizeWritten = parkSize * parkCount;
         _context.plotTableSizes[(int)lTable] += sizeWritten;
 
         ioQueue.WriteFile( FileId::PLOT, 0, parkBuffer, sizeWritten );
-        ioQueue.SignalFence( _lpWriteFence, bucket );
+        ioQueue.SignalFence( _lpWriteFence, bucket + 1 );
         ioQueue.CommitCommands();
 
 
@@ -951,10 +1038,11 @@ private:
     //-----------------------------------------------------------
     byte* GetLPWriteBuffer( const uint32 bucket )
     {
-        if( bucket > 1 )
-            _lpWriteFence.Wait( bucket - 2, _ioWaitTime );
+        // Wait for the bucket that last used this buffer to be written
+        if( bucket >= BB_DP_P3_PARK_BUFFER_COUNT )
+            _lpWriteFence.Wait( bucket - BB_DP_P3_PARK_BUFFER_COUNT + 1, _ioWaitTime );
 
-        return _parkBuffers[bucket & 1];
+        return _parkBuffers[bucket % BB_DP_P3_PARK_BUFFER_COUNT];
     }
 
 private:
@@ -970,8 +1058,15 @@ private:
     uint64*          _lpLeftOverBuffer = nullptr;
     uint64           _lpParkLeftOvers  = 0;
     uint64           _maxParkCount     = 0;
-    byte*            _parkBuffers[2]   = { nullptr };
+    byte*            _parkBuffers[BB_DP_P3_PARK_BUFFER_COUNT] = { nullptr };
     byte*            _finalPark        = nullptr;
+
+    // Next table's marking table, when prefetched
+    FileId           _marksFileId      = FileId::None;
+    byte*            _marksBuffer      = nullptr;
+    size_t           _marksSize        = 0;
+    size_t           _marksReadSize    = 0;
+    Fence*           _marksFence       = nullptr;
 };
 
 
@@ -1012,13 +1107,15 @@ void DiskPlotPhase3::Run()
     ioQueue.CommitCommands();
 
     // Use up any cache for our line points and map
-    size_t lpCacheSize, mapCacheSize;
-    GetCacheSizes( lpCacheSize, mapCacheSize );
+    size_t lpCacheSize, mapCacheSizes[2];
+    GetCacheSizes( lpCacheSize, mapCacheSizes );
 
-    ASSERT( lpCacheSize / _context.tmp2BlockSize * _context.tmp2BlockSize == lpCacheSize );
-    ASSERT( mapCacheSize / _context.tmp2BlockSize * _context.tmp2BlockSize == mapCacheSize );
+    ASSERT( lpCacheSize      / _context.tmp2BlockSize * _context.tmp2BlockSize == lpCacheSize      );
+    ASSERT( mapCacheSizes[0] / _context.tmp2BlockSize * _context.tmp2BlockSize == mapCacheSizes[0] );
+    ASSERT( mapCacheSizes[1] / _context.tmp2BlockSize * _context.tmp2BlockSize == mapCacheSizes[1] );
 
-    byte* cache = _context.cache;
+    // The start of the cache may hold the marking tables kept by Phase 2
+    byte* cache = _context.cache + _context.cachedMarksSize;
 
     FileSetOptions opts = FileSetOptions::UseTemp2;
 
@@ -1035,10 +1132,12 @@ void DiskPlotPhase3::Run()
     ioQueue.InitFileSet( FileId::LP, "lp", _context.numBuckets, opts, &fdata );   // LP+origin idx buckets
     
     fdata.cache     = (cache += lpCacheSize);
-    fdata.cacheSize = mapCacheSize;
+    fdata.cacheSize = mapCacheSizes[0];
 
     ioQueue.InitFileSet( FileId::LP_MAP_0, "lp_map_0", _context.numBuckets+1, opts, &fdata );   // Reverse map write/read
-    fdata.cache = (cache += mapCacheSize);
+
+    fdata.cache     = (cache += mapCacheSizes[0]);
+    fdata.cacheSize = mapCacheSizes[1];
     ioQueue.InitFileSet( FileId::LP_MAP_1, "lp_map_1", _context.numBuckets+1, opts, &fdata );   // Reverse map read/write
 
     switch( _context.numBuckets )
@@ -1095,7 +1194,7 @@ size_t DiskPlotPhase3::GetRequiredHeapSizeForBuckets( const size_t t1BlockSize,
 }
 
 //-----------------------------------------------------------
-void DiskPlotPhase3::GetCacheSizes( size_t& outCacheSizeLP, size_t& outCacheSizeMap )
+void DiskPlotPhase3::GetCacheSizes( size_t& outCacheSizeLP, size_t outCacheSizeMap[2] )
 {
     switch( _context.numBuckets )
     {
@@ -1113,26 +1212,44 @@ void DiskPlotPhase3::GetCacheSizes( size_t& outCacheSizeLP, size_t& outCacheSize
 
 //-----------------------------------------------------------
 template<uint32 _numBuckets>
-void DiskPlotPhase3::GetCacheSizesForBuckets( size_t& outCacheSizeLP, size_t& outCacheSizeMap )
+void DiskPlotPhase3::GetCacheSizesForBuckets( size_t& outCacheSizeLP, size_t outCacheSizeMap[2] )
 {
-    const size_t lpEntrySize    = P3StepOne<TableId::Table2, _numBuckets, false>::_entrySizeBits;
-    const size_t mapEntrySizeX2 = MapWriter<_numBuckets, true>::EntryBitSize * 2;
-    
-    static_assert( mapEntrySizeX2 >= lpEntrySize );
+    outCacheSizeLP     = 0;
+    outCacheSizeMap[0] = 0;
+    outCacheSizeMap[1] = 0;
 
-    const size_t fullCache = _context.cacheSize;
-    const size_t blockSize = _context.tmp2BlockSize;
+    if( !_context.cache )
+        return;
 
-    double mapRatio = (double)mapEntrySizeX2 / ( mapEntrySizeX2 + lpEntrySize );
+    const size_t lpEntrySize  = P3StepOne<TableId::Table2, _numBuckets, false>::_entrySizeBits;
+    const size_t mapEntrySize = MapWriter<_numBuckets, true>::EntryBitSize;
 
-    const uint32 mapBuckets = _numBuckets + 1;
-    
-    outCacheSizeMap = ((size_t)(fullCache * mapRatio) / 2 ) / mapBuckets / blockSize * mapBuckets * blockSize;
-    outCacheSizeLP  = ( fullCache - outCacheSizeMap * 2 ) / _numBuckets / blockSize * _numBuckets * blockSize;
+    // Every table pair writes its line points in step 1 and reads them back in step 2.
+    // The reverse map is written in step 2 and read by the next table's step 1 (or by P7 for table 7),
+    // alternating between the 2 map file sets, starting with LP_MAP_1.
+    // #NOTE: We estimate with un-pruned table sizes, which are an upper bound.
+    DiskCachePlanner cachePlan( _context.tmp2BlockSize );
 
-    ASSERT( outCacheSizeMap + outCacheSizeLP <= fullCache );
-}
+    for( TableId rTable = TableId::Table2; rTable <= TableId::Table7; rTable++ )
+    {
+        const uint64 entryCount = _context.entryCounts[(int)rTable];
+        const FileId mapId      = ( (int)rTable & 1 ) ? FileId::LP_MAP_1 : FileId::LP_MAP_0;
 
+        cachePlan.AddUse( FileId::LP, "lp", _numBuckets, (size_t)CDiv( entryCount * lpEntrySize, 8 ) );
+        cachePlan.AddUse( mapId, mapId == FileId::LP_MAP_0 ? "lp_map_0" : "lp_map_1", _numBuckets+1, (size_t)CDiv( entryCount * mapEntrySize, 8 ) );
+    }
+
+    cachePlan.Plan( _context.cacheSize - _context.cachedMarksSize );
+
+    Log::Line( "Phase 3 cache placement:" );
+    cachePlan.LogPlan();
+
+    outCacheSizeLP     = cachePlan.CacheSize( FileId::LP       );
+    outCacheSizeMap[0] = cachePlan.CacheSize( FileId::LP_MAP_0 );
+    outCacheSizeMap[1] = cachePlan.CacheSize( FileId::LP_MAP_1 );
+
+    ASSERT( outCacheSizeLP + outCacheSizeMap[0] + outCacheSizeMap[1] <= _context.cacheSize - _context.cachedMarksSize );
+}
 
 
 //-----------------------------------------------------------
@@ -1153,6 +1270,21 @@ void DiskPlotPhase3::RunBuckets()
     _context.plotTablePointers[(int)startTable-1] = _ioQueue.PlotTablePointersAddress();
 #endif
 
+    if( _context.resumeStage >= DiskPlotStage::P3Table2 )
+    {
+        const TableId lastTable = TableId::Table2 + (int)( _context.resumeStage - DiskPlotStage::P3Table2 );
+        RestoreCheckpoint( lastTable );
+
+        startTable = lastTable + 1;
+        if( startTable <= TableId::Table7 )
+            Log::Line( "Resuming Phase 3 at tables %u and %u.", startTable, startTable+1 );
+    }
+
+    // #NOTE: The pairs and maps of each table are read here and again in Phase 2, but the 2 passes can't be fused.
+    //        Phase 2 marks from table 7 down to table 2, whereas step 1 of each table needs the reverse map
+    //        written by the table below it, so we must go from table 2 up, starting with the marks Phase 2 completes last.
+    //        Only table 3 is read back-to-back by both phases, and holding it in memory until then
+    //        would take more than the heap and, in most setups, the cache.
     for( TableId rTable = startTable; rTable <= TableId::Table7; rTable++ )
     {
         Log::Line( "Compressing tables %u and %u.", rTable, rTable+1 );
@@ -1191,6 +1323,7 @@ void DiskPlotPhase3::RunBuckets()
 
         const double elapsed = TimerEnd( timer );
         Log::Line( "Finished compressing tables %u and %u in %.2lf seconds.", rTable, rTable+1, elapsed );
+        PlotMetrics::SetF64( elapsed, "tables.p3.t%u.elapsed", (uint32)rTable+1 );
 
         std::swap( _mapReadId, _mapWriteId );
 
@@ -1200,6 +1333,14 @@ void DiskPlotPhase3::RunBuckets()
 
         // Set the table offset for the next table
         _context.plotTablePointers[(int)rTable] = _context.plotTablePointers[(int)rTable-1] + _context.plotTableSizes[(int)rTable-1];
+
+        // Input files were kept so that we could resume from the previous checkpoint
+        if( _context.checkpoint->IsStageResumable( P3TableToStage( rTable ) ) )
+        {
+            SaveCheckpoint( rTable );
+            DeleteTableInputs( rTable );
+            _ioQueue.CommitCommands();
+        }
     }
 
     // Finish up with table 7 which needs to be sorted on f7. We use its map for that
@@ -1211,7 +1352,10 @@ void DiskPlotPhase3::RunBuckets()
         Log::Line( "Finished writing P7 parks in %.2lf seconds.", elapsed );
         Log::Line( "P7 I/O wait time: %.2lf seconds", TicksToSeconds( _ioWaitTime ) );
 
-        _context.ioWaitTime += _ioWaitTime;
+        PlotMetrics::SetF64( elapsed, "tables.p3.p7.elapsed" );
+        PlotMetrics::SetF64( TicksToSeconds( _ioWaitTime ), "tables.p3.p7.io_wait" );
+
+        DiskPlotProgress::Add( _context.ioWaitTime, _ioWaitTime );
     }
 }
 
@@ -1228,24 +1372,30 @@ void DiskPlotPhase3::ProcessTable()
         memset( _lpPrunedBucketCounts, 0, sizeof( uint64 ) * (_numBuckets+1) );
 
         P3StepOne<rTable, _numBuckets, _bounded> stepOne( _context, _mapReadId, _readFence, _writeFence );
+
+        if( _context.cachedMarks[(int)rTable] )
+            stepOne.UseCachedMarks( _context.cachedMarks[(int)rTable] );
+        else if( _rMarksPrefetch )
+            stepOne.UsePrefetchedMarks( _rMarksPrefetch, _marksFence );
+
         prunedEntryCount = stepOne.Run( _lMapPrunedBucketCounts, _lpPrunedBucketCounts );
+        _rMarksPrefetch  = nullptr;
 
         _ioWaitTime = stepOne.GetIOWaitTime();
     }
 
     _ioQueue.SignalFence( _stepFence );
 
-    // OK to delete input files now
-    #if !BB_DP_P3_KEEP_FILES
-        if( rTable == TableId::Table2 )
-            _ioQueue.DeleteFile( FileId::T1, 0 );
-    
-        _ioQueue.DeleteFile( FileId::T1 + (FileId)rTable, 0 );
-        _ioQueue.DeleteBucket( FileId::MAP2 + (FileId)rTable-1 );
+    // OK to delete input files now, unless we are saving checkpoints for this table,
+    // in which case they are kept until its checkpoint has been saved.
+    if( !_context.checkpoint->IsStageResumable( P3TableToStage( rTable ) ) )
+    {
+        // The checkpoint saved after Phase 2 needs these files
+        if( rTable == TableId::Table2 && _context.checkpoint->IsStageResumable( DiskPlotStage::Phase2 ) )
+            _context.checkpoint->Delete();
 
-        if( rTable < TableId::Table7 )
-            _ioQueue.DeleteFile( FileId::MARKED_ENTRIES_2 + (FileId)rTable-1, 0 );
-    #endif
+        DeleteTableInputs( rTable );
+    }
 
     _ioQueue.CommitCommands();
 
@@ -1262,6 +1412,24 @@ void DiskPlotPhase3::ProcessTable()
         memset( _lMapPrunedBucketCounts, 0, sizeof( uint64 ) * (_numBuckets+1) );
 
         P3StepTwo<rTable, _numBuckets> stepTwo( _context, _readFence, _writeFence, _plotFence, _mapReadId, _mapWriteId );
+
+        // Step 1 of the next table can't start before we've written our whole reverse map,
+        // but its marking table does not depend on us, so we can read it in the meantime.
+        if constexpr ( rTable < TableId::Table6 )
+        {
+            byte* marks = _context.cachedMarks[(int)rTable+1] ? nullptr : GetMarksPrefetchBuffer<rTable+1, _numBuckets, _bounded>();
+
+            if( marks )
+            {
+                const TableId nextTable  = rTable + 1;
+                const size_t  marksSize  = RoundUpToNextBoundary( _context.entryCounts[(int)nextTable] / 8, (int)_context.tmp1BlockSize );
+
+                _marksFence.Reset();
+                stepTwo.PrefetchMarks( FileId::MARKED_ENTRIES_2 + (FileId)nextTable - 1, marks, marksSize, _marksFence );
+                _rMarksPrefetch = marks;
+            }
+        }
+
         stepTwo.Run( _lpPrunedBucketCounts, _lMapPrunedBucketCounts );
 
         _ioWaitTime += stepTwo.GetIOWaitTime();
@@ -1273,14 +1441,89 @@ void DiskPlotPhase3::ProcessTable()
 
     Log::Line( "Table %u I/O wait time: %.2lf seconds.", rTable, TicksToSeconds( _ioWaitTime ) );
 
+    PlotMetrics::SetU64( prunedEntryCount, "tables.p3.t%u.entries", (uint32)rTable+1 );
+    PlotMetrics::SetF64( TicksToSeconds( _ioWaitTime ), "tables.p3.t%u.io_wait", (uint32)rTable+1 );
+
 #if _DEBUG
     SavePrunedBucketCount( rTable, _lMapPrunedBucketCounts, false );
 #endif
 
-    _context.ioWaitTime += _ioWaitTime;
+    DiskPlotProgress::Add( _context.ioWaitTime, _ioWaitTime );
     _tablePrunedEntryCount[(int)rTable-1] = prunedEntryCount;
 }
 
+//-----------------------------------------------------------
+template<TableId rTable, uint32 _numBuckets, bool _bounded>
+byte* DiskPlotPhase3::GetMarksPrefetchBuffer()
+{
+    const size_t t1BlockSize = _context.tmp1BlockSize;
+    const size_t t2BlockSize = _context.tmp2BlockSize;
+
+    // The marks go at the end of the heap. Both step 2 of the previous table
+    // and the rest of step 1 of this table must fit below them.
+    const size_t marksSize   = RoundUpToNextBoundary( _context.entryCounts[(int)rTable] / 8, (int)t1BlockSize );
+    if( marksSize > _context.heapSize )
+        return nullptr;
+
+    const size_t marksOffset = ( _context.heapSize - marksSize ) / t1BlockSize * t1BlockSize;
+
+    const size_t s1Size = P3StepOne<rTable, _numBuckets, _bounded>::GetRequiredHeapSize( t1BlockSize, t2BlockSize )
+                        - P3StepOne<rTable, _numBuckets, _bounded>::GetRMarksAllocSize( t1BlockSize );
+    const size_t s2Size = P3StepTwo<rTable-1, _numBuckets>::GetRequiredHeapSize( t1BlockSize, t2BlockSize );
+
+    if( s1Size > marksOffset || s2Size > marksOffset )
+        return nullptr;
+
+    return _context.heapBuffer + marksOffset;
+}
+
+//-----------------------------------------------------------
+void DiskPlotPhase3::DeleteTableInputs( const TableId rTable )
+{
+    #if !BB_DP_P3_KEEP_FILES
+        if( rTable == TableId::Table2 )
+            _ioQueue.DeleteFile( FileId::T1, 0 );
+    
+        _ioQueue.DeleteFile( FileId::T1 + (FileId)rTable, 0 );
+        _ioQueue.DeleteBucket( FileId::MAP2 + (FileId)rTable-1 );
+
+        if( rTable < TableId::Table7 )
+            _ioQueue.DeleteFile( FileId::MARKED_ENTRIES_2 + (FileId)rTable-1, 0 );
+    #endif
+}
+
+//-----------------------------------------------------------
+void DiskPlotPhase3::SaveCheckpoint( const TableId rTable )
+{
+    P3CheckpointData data;
+    ZeroMem( &data );
+
+    memcpy( data.lMapPrunedBucketCounts, _lMapPrunedBucketCounts, sizeof( data.lMapPrunedBucketCounts ) );
+    memcpy( data.tablePrunedEntryCount , _tablePrunedEntryCount , sizeof( data.tablePrunedEntryCount  ) );
+    data.mapReadId  = _mapReadId;
+    data.mapWriteId = _mapWriteId;
+
+    _context.checkpoint->Save( P3TableToStage( rTable ), &data, sizeof( data ) );
+}
+
+//-----------------------------------------------------------
+void DiskPlotPhase3::RestoreCheckpoint( const TableId rTable )
+{
+    const DiskPlotCheckpoint& checkpoint = *_context.checkpoint;
+    FatalIf( checkpoint.StageDataSize() != sizeof( P3CheckpointData ), "Invalid Phase 3 checkpoint data." );
+
+    const P3CheckpointData& data = *(const P3CheckpointData*)checkpoint.StageData();
+
+    memcpy( _lMapPrunedBucketCounts, data.lMapPrunedBucketCounts, sizeof( data.lMapPrunedBucketCounts ) );
+    memcpy( _tablePrunedEntryCount , data.tablePrunedEntryCount , sizeof( data.tablePrunedEntryCount  ) );
+    _mapReadId  = data.mapReadId;
+    _mapWriteId = data.mapWriteId;
+
+    // The inputs of the last table were still around when the checkpoint was saved
+    DeleteTableInputs( rTable );
+    _ioQueue.CommitCommands();
+}
+
 //-----------------------------------------------------------
 template<uint32 _numBuckets>
 void DiskPlotPhase3::WritePark7( const uint64 inMapBucketCounts[_numBuckets+1] )
@@ -1308,18 +1551,19 @@ void DiskPlotPhase3::WritePark7( const uint64 inMapBucketCounts[_numBuckets+1] )
     // to copy left over entries from a bucket that did not fit into a park.
     uint64* t6Indices = allocator.CAlloc<uint64>( maxBucketEntries + kEntriesPerPark );
     
-    byte* parkBuffers[2] = {
-        allocator.AllocT<byte>( parkSize * maxParkCount, plotBlockSize ),
-        allocator.AllocT<byte>( parkSize * maxParkCount, plotBlockSize )
-    };
+    byte* parkBuffers[BB_DP_P3_PARK_BUFFER_COUNT];
+    for( uint32 i = 0; i < BB_DP_P3_PARK_BUFFER_COUNT; i++ )
+        parkBuffers[i] = allocator.AllocT<byte>( parkSize * maxParkCount, plotBlockSize );
+
+    PlotMetrics::MaxU64( allocator.HighWater(), "heap.p3_high_water" );
 
     /// Internal Funcs
     auto GetParkBuffer = [&]( const uint32 bucket ) {
 
-        if( bucket > 1 )
-            _writeFence.Wait( bucket - 2, waitTime );
+        if( bucket >= BB_DP_P3_PARK_BUFFER_COUNT )
+            _writeFence.Wait( bucket - BB_DP_P3_PARK_BUFFER_COUNT + 1, waitTime );
 
-        return parkBuffers[bucket & 1];
+        return parkBuffers[bucket % BB_DP_P3_PARK_BUFFER_COUNT];
     };
 
     auto LoadBucket = [&]( const uint32 bucket ) {
@@ -1354,8 +1598,13 @@ void DiskPlotPhase3::WritePark7( const uint64 inMapBucketCounts[_numBuckets+1] )
 
     LoadBucket( 0 );
 
+    // P7 is the last pass of Phase 3
+    context.progress.BeginTable( TableId::Table7, 12, context.entryCounts[(int)TableId::Table7] );
+
     for( uint32 bucket = 0; bucket <= _numBuckets; bucket++ )
     {
+        context.progress.SetBucket( bucket );
+
         const bool isLastBucket    = bucket == _numBuckets;
         const bool nextBucketEmpty = !isLastBucket && inMapBucketCounts[bucket+1] == 0;
         const bool hasNextBucket   = !isLastBucket && !nextBucketEmpty;
@@ -1393,13 +1642,13 @@ void DiskPlotPhase3::WritePark7( const uint64 inMapBucketCounts[_numBuckets+1] )
                 park7Entries    += kEntriesPerPark;
                 parkWriteBuffer += parkSize;
             }
-        });
+        }, "DiskPlotPhase3::WritePark7" );
 
         const size_t sizeWritten = parkSize * parkCount;
         context.plotTableSizes[(int)TableId::Table7] += sizeWritten;
 
         ioQueue.WriteFile( FileId::PLOT, 0, parkBuffer, sizeWritten );
-        ioQueue.SignalFence( _writeFence, bucket );
+        ioQueue.SignalFence( _writeFence, bucket + 1 );
         ioQueue.CommitCommands();
 
 
@@ -32,6 +32,17 @@ private:
     template<uint32 _numBuckets>
     void WritePark7( const uint64 inMapBucketCounts[_numBuckets+1] );
 
+    // Returns where to read rTable's marking table during the previous table's step 2,
+    // or nullptr if the heap is too small to hold it alongside both steps.
+    template<TableId rTable, uint32 _numBuckets, bool _bounded>
+    byte* GetMarksPrefetchBuffer();
+
+    // Delete the files which are no longer needed after step 1 of a table
+    void DeleteTableInputs( const TableId rTable );
+
+    void SaveCheckpoint( const TableId rTable );
+    void RestoreCheckpoint( const TableId rTable );
+
     // template<uint32 _numBuckets>
     // void WritePark7();
 
@@ -62,10 +73,10 @@ private:
     // void DeleteFile( FileId fileId, uint32 bucket );
     // void DeleteBucket( FileId fileId );
 
-    void GetCacheSizes( size_t& outCacheSizeLP, size_t& outCacheSizeMap );
+    void GetCacheSizes( size_t& outCacheSizeLP, size_t outCacheSizeMap[2] );
 
     template<uint32 _numBuckets>
-    void GetCacheSizesForBuckets( size_t& outCacheSizeLP, size_t& outCacheSizeMap );
+    void GetCacheSizesForBuckets( size_t& outCacheSizeLP, size_t outCacheSizeMap[2] );
     
     template<uint32 _numBuckets, const bool _bounded>
     static size_t GetRequiredHeapSizeForBuckets( const size_t t1BlockSize, const size_t t2BlockSize );
@@ -78,12 +89,15 @@ private:
     Fence _writeFence;
     Fence _stepFence;
     Fence _plotFence;
+    Fence _marksFence;
 
     Duration _ioWaitTime  = Duration::zero();
     
     FileId _mapReadId  = FileId::LP_MAP_0;
     FileId _mapWriteId = FileId::LP_MAP_1;
 
+    void*  _rMarksPrefetch = nullptr;   // Marking table of the next table, read during step 2
+
     // Read buffers
     // Pair*   _pairRead[2];
     // uint64* _rMapRead[2];
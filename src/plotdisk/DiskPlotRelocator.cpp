@@ -0,0 +1,308 @@
+#include "DiskPlotRelocator.h"
+#include "DiskPlotConfig.h"
+#include "io/FileStream.h"
+#include "util/Log.h"
+#include "util/Util.h"
+
+#if _WIN32
+    #define PATH_SEPA_STR "\\"
+    #define CheckPathSeparator( x ) ((x) == '\\' || (x) == '/')
+#else
+    #define PATH_SEPA_STR "/"
+    #define CheckPathSeparator( x ) ((x) == '/')
+#endif
+
+//-----------------------------------------------------------
+DiskPlotRelocator::DiskPlotRelocator( const char* const* destDirs, const uint32 destCount, const uint64 bandwidth )
+    : _bandwidth( bandwidth )
+{
+    ASSERT( destDirs  );
+    ASSERT( destCount );
+
+    for( uint32 i = 0; i < destCount; i++ )
+    {
+        std::string dir = destDirs[i];
+        FatalIf( dir.length() < 1, "Plot destination directory is empty." );
+
+        if( !CheckPathSeparator( dir.back() ) )
+            dir += PATH_SEPA_STR;
+
+        _destDirs.push_back( dir );
+    }
+
+    _buffer = bbvirtalloc<byte>( BB_DP_RELOCATE_BUFFER_SIZE );
+
+    _thread = new Thread();
+    _thread->Run( RelocatorThreadMain, this );
+}
+
+//-----------------------------------------------------------
+DiskPlotRelocator::~DiskPlotRelocator()
+{
+    WaitForCompletion();
+
+    {
+        std::lock_guard<std::mutex> lock( _lock );
+        _exit = true;
+    }
+    _signal.notify_all();
+
+    _thread->WaitForExit();
+    delete _thread;
+
+    bbvirtfree( _buffer );
+}
+
+//-----------------------------------------------------------
+void DiskPlotRelocator::Enqueue( const char* plotPath )
+{
+    ASSERT( plotPath );
+
+    std::unique_lock<std::mutex> lock( _lock );
+
+    if( !_plotPath.empty() )
+    {
+        Log::Line( "Waiting for the previous plot to be moved..." );
+        const auto timer = TimerBegin();
+
+        _signal.wait( lock, [this]() { return _plotPath.empty(); } );
+        Log::Line( "Waited %.2lf seconds for the previous plot to be moved.", TimerEnd( timer ) );
+    }
+
+    _plotPath = plotPath;
+    _signal.notify_all();
+}
+
+//-----------------------------------------------------------
+void DiskPlotRelocator::WaitForCompletion()
+{
+    std::unique_lock<std::mutex> lock( _lock );
+
+    if( !_plotPath.empty() )
+    {
+        Log::Line( "Waiting for the last plot to be moved..." );
+        _signal.wait( lock, [this]() { return _plotPath.empty(); } );
+    }
+}
+
+//-----------------------------------------------------------
+void DiskPlotRelocator::RelocatorThreadMain( DiskPlotRelocator* self )
+{
+    self->Run();
+}
+
+//-----------------------------------------------------------
+void DiskPlotRelocator::Run()
+{
+    for( ;; )
+    {
+        std::string plotPath;
+        {
+            std::unique_lock<std::mutex> lock( _lock );
+            _signal.wait( lock, [this]() { return !_plotPath.empty() || _exit; } );
+
+            if( _plotPath.empty() )
+                return;
+
+            plotPath = _plotPath;
+        }
+
+        Relocate( plotPath.c_str() );
+
+        {
+            std::lock_guard<std::mutex> lock( _lock );
+            _plotPath.clear();
+        }
+        _signal.notify_all();
+    }
+}
+
+//-----------------------------------------------------------
+void DiskPlotRelocator::Relocate( const char* plotPath )
+{
+    const char* fileName = plotPath + strlen( plotPath );
+    while( fileName > plotPath && !CheckPathSeparator( fileName[-1] ) )
+        fileName--;
+
+    uint64 plotSize = 0;
+    {
+        FileStream file;
+        ssize_t    size = -1;
+
+        if( file.Open( plotPath, FileMode::Open, FileAccess::Read, FileFlags::LargeFile ) )
+            size = file.Size();
+
+        if( size < 0 )
+        {
+            Log::Error( "Failed to open plot '%s' with error %d. It will not be moved.", plotPath, file.GetError() );
+            return;
+        }
+
+        plotSize = (uint64)size;
+    }
+
+    std::vector<bool> tried( _destDirs.size(), false );
+
+    for( ;; )
+    {
+        const int32 destIdx = SelectDestination( plotSize, tried );
+        if( destIdx < 0 )
+        {
+            Log::Error( "No destination directory can hold plot '%s'. It was left in the output directory.", plotPath );
+            return;
+        }
+
+        tried[destIdx] = true;
+
+        const std::string destPath    = _destDirs[destIdx] + fileName;
+        const std::string destTmpPath = destPath + ".tmp";
+
+        // Same file system: Nothing to copy. Move() does not copy across file systems.
+        if( FileStream::Move( plotPath, destPath.c_str() ) )
+        {
+            Log::Line( "Moved plot to '%s'.", destPath.c_str() );
+            return;
+        }
+
+        Log::Line( "Copying plot to '%s'...", destPath.c_str() );
+        const auto timer = TimerBegin();
+
+        if( !CopyPlot( plotPath, destTmpPath.c_str(), plotSize ) )
+        {
+            remove( destTmpPath.c_str() );
+            continue;
+        }
+
+        int32 error = 0;
+        if( !FileStream::Move( destTmpPath.c_str(), destPath.c_str(), &error ) )
+        {
+            Log::Error( "Failed to rename plot copy '%s' with error %d. Please rename it manually.", destTmpPath.c_str(), error );
+            return;
+        }
+
+        const double elapsed = TimerEnd( timer );
+        Log::Line( "Copied plot to '%s' in %.2lf seconds ( %.2lf MiB/s ).",
+            destPath.c_str(), elapsed, (double)plotSize BtoMB / std::max( elapsed, 0.001 ) );
+
+        if( remove( plotPath ) != 0 )
+            Log::Error( "Failed to delete plot '%s' after copying it with error %d.", plotPath, (int32)errno );
+
+        return;
+    }
+}
+
+//-----------------------------------------------------------
+bool DiskPlotRelocator::CopyPlot( const char* srcPath, const char* dstPath, const uint64 plotSize )
+{
+    // Prefer direct I/O, so that copying the plot does not evict
+    // the plotter's data from the page cache. Not all file systems support it.
+    const FileFlags directFlags = FileFlags::LargeFile | FileFlags::NoBuffering | FileFlags::NoWriteThrough;
+
+    FileStream src, dst;
+
+    if( !src.Open( srcPath, FileMode::Open, FileAccess::Read, directFlags ) &&
+        !src.Open( srcPath, FileMode::Open, FileAccess::Read, FileFlags::LargeFile ) )
+    {
+        Log::Error( "Failed to open plot '%s' for copying with error %d.", srcPath, src.GetError() );
+        return false;
+    }
+
+    if( !dst.Open( dstPath, FileMode::Create, FileAccess::Write, directFlags ) &&
+        !dst.Open( dstPath, FileMode::Create, FileAccess::Write, FileFlags::LargeFile ) )
+    {
+        Log::Error( "Failed to create plot copy '%s' with error %d.", dstPath, dst.GetError() );
+        return false;
+    }
+
+    const size_t blockSize = std::max( src.BlockSize(), dst.BlockSize() );
+    FatalIf( BB_DP_RELOCATE_BUFFER_SIZE % blockSize != 0, "Unsupported file system block size %llu.", (llu)blockSize );
+
+    const auto timer  = TimerBegin();
+    uint64     copied = 0;
+
+    while( copied < plotSize )
+    {
+        const size_t chunkSize = (size_t)std::min( plotSize - copied, (uint64)BB_DP_RELOCATE_BUFFER_SIZE );
+
+        // Direct I/O transfers whole blocks. The last read stops at the end of the file,
+        // and the padding of the last write is truncated below.
+        const size_t ioSize = RoundUpToNextBoundaryT( chunkSize, blockSize );
+
+        for( size_t sizeRead = 0; sizeRead < chunkSize; )
+        {
+            const ssize_t r = src.Read( _buffer + sizeRead, ioSize - sizeRead );
+            if( r <= 0 )
+            {
+                Log::Error( "Failed to read plot '%s' with error %d.", srcPath, src.GetError() );
+                return false;
+            }
+
+            sizeRead += (size_t)r;
+        }
+
+        if( ioSize > chunkSize )
+            memset( _buffer + chunkSize, 0, ioSize - chunkSize );
+
+        for( size_t sizeWritten = 0; sizeWritten < ioSize; )
+        {
+            const ssize_t r = dst.Write( _buffer + sizeWritten, ioSize - sizeWritten );
+            if( r <= 0 )
+            {
+                Log::Error( "Failed to write plot copy '%s' with error %d.", dstPath, dst.GetError() );
+                return false;
+            }
+
+            sizeWritten += (size_t)r;
+        }
+
+        copied += chunkSize;
+
+        // Throttle to the bandwidth limit
+        if( _bandwidth )
+        {
+            const double expected = (double)copied / (double)_bandwidth;
+            const double elapsed  = TimerEnd( timer );
+
+            if( expected > elapsed )
+                Thread::Sleep( (long)( ( expected - elapsed ) * 1000.0 ) );
+        }
+    }
+
+    if( !dst.Truncate( (ssize_t)plotSize ) )
+    {
+        Log::Error( "Failed to truncate plot copy '%s' with error %d.", dstPath, dst.GetError() );
+        return false;
+    }
+
+    if( !dst.Flush() )
+    {
+        Log::Error( "Failed to flush plot copy '%s' with error %d.", dstPath, dst.GetError() );
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------
+int32 DiskPlotRelocator::SelectDestination( const uint64 plotSize, const std::vector<bool>& tried ) const
+{
+    int32  selected     = -1;
+    uint64 selectedFree = 0;
+
+    for( size_t i = 0; i < _destDirs.size(); i++ )
+    {
+        if( tried[i] )
+            continue;
+
+        // Free space is checked for every plot, as other processes may be writing to the destinations too
+        const uint64 freeSpace = FileStream::GetFreeSpaceForPath( _destDirs[i].c_str() );
+
+        if( freeSpace >= plotSize && freeSpace > selectedFree )
+        {
+            selected     = (int32)i;
+            selectedFree = freeSpace;
+        }
+    }
+
+    return selected;
+}
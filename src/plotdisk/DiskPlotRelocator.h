@@ -0,0 +1,59 @@
+#pragma once
+#include "threading/Thread.h"
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+
+/**
+ * Moves finished plots from the output directory, used as a staging directory,
+ * to one of several destination directories on a background thread, so that
+ * the next plot can start while the previous one is being copied.
+ *
+ * Each plot goes to the destination with the most free space that can hold it,
+ * which fills the destinations evenly. Destinations on the same file system
+ * as the staging directory are moved to by renaming, which fails across file systems
+ * instead of copying. Otherwise the plot is copied
+ * with direct I/O, throttled to the given bandwidth, and then deleted from the staging directory.
+ *
+ * A single plot is moved at a time. If a plot is finished while the previous one
+ * is still being moved, the plotter waits for it, so that the staging directory
+ * never holds more than 2 plots.
+ */
+class DiskPlotRelocator
+{
+public:
+    // bandwidth: Maximum copy speed in bytes per second. 0 is unlimited.
+    DiskPlotRelocator( const char* const* destDirs, uint32 destCount, uint64 bandwidth );
+
+    // Waits for the queued plot to be moved, then stops the relocator thread.
+    ~DiskPlotRelocator();
+
+    // Queue a finished plot to be moved to a destination directory.
+    // Blocks while the previous plot is still being moved.
+    void Enqueue( const char* plotPath );
+
+    // Blocks until the queued plot has been moved.
+    void WaitForCompletion();
+
+private:
+    static void RelocatorThreadMain( DiskPlotRelocator* self );
+
+    void  Run();
+    void  Relocate( const char* plotPath );
+    bool  CopyPlot( const char* srcPath, const char* dstPath, uint64 plotSize );
+
+    // Index of the destination not yet tried with the most free space which can hold the plot, or -1.
+    int32 SelectDestination( uint64 plotSize, const std::vector<bool>& tried ) const;
+
+private:
+    std::vector<std::string> _destDirs;             // With a trailing path separator
+    uint64                   _bandwidth = 0;
+    byte*                    _buffer    = nullptr;  // Copy buffer of BB_DP_RELOCATE_BUFFER_SIZE bytes
+    Thread*                  _thread    = nullptr;
+
+    std::mutex               _lock;
+    std::condition_variable  _signal;
+    std::string              _plotPath;             // Plot being moved. Empty when idle.
+    bool                     _exit      = false;    // Signals the relocator thread to exit once idle
+};
@@ -0,0 +1,248 @@
+#include "DiskPlotStatsServer.h"
+#include "DiskPlotContext.h"
+#include "plotting/PlotMetrics.h"
+#include "util/Log.h"
+#include "util/Util.h"
+
+#if PLATFORM_IS_UNIX
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+// Phase weights used to estimate the time remaining until a plot has been completed
+static const double DefaultPhaseWeights[3] = { 0.55, 0.10, 0.35 };
+
+static std::string _socketPath;
+
+static void UnlinkSocket();
+static void AppendF( char* buffer, size_t bufferSize, size_t& length, const char* format, ... );
+
+//-----------------------------------------------------------
+DiskPlotStatsServer::DiskPlotStatsServer( const DiskPlotContext& context )
+    : _context( context )
+{
+    memcpy( _phaseWeights, DefaultPhaseWeights, sizeof( _phaseWeights ) );
+}
+
+//-----------------------------------------------------------
+void DiskPlotStatsServer::Start( const char* socketPath )
+{
+    ASSERT( socketPath );
+    ASSERT( !_thread );
+
+#if PLATFORM_IS_UNIX
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+
+    FatalIf( strlen( socketPath ) >= sizeof( addr.sun_path ), "Stats socket path is too long: '%s'.", socketPath );
+    strcpy( addr.sun_path, socketPath );
+
+    // Remove the socket left behind by a previous run, but never a regular file
+    struct stat st;
+    if( lstat( socketPath, &st ) == 0 )
+    {
+        FatalIf( !S_ISSOCK( st.st_mode ), "Stats socket path '%s' exists and is not a socket.", socketPath );
+        unlink( socketPath );
+    }
+
+    _socket = socket( AF_UNIX, SOCK_STREAM, 0 );
+    FatalIf( _socket == -1, "Failed to create stats socket with error: %d.", errno );
+
+    FatalIf( bind( _socket, (sockaddr*)&addr, sizeof( addr ) ) != 0,
+        "Failed to bind stats socket to '%s' with error: %d.", socketPath, errno );
+
+    FatalIf( listen( _socket, 8 ) != 0, "Failed to listen on stats socket with error: %d.", errno );
+
+    _socketPath = socketPath;
+    atexit( UnlinkSocket );
+
+    _sampleTime = TimerBegin();
+
+    _thread = new Thread();
+    _thread->Run( ServerThreadMain, this );
+
+    Log::Line( "Serving plot stats on '%s'.", socketPath );
+#else
+    Fatal( "--stats-socket is only supported on Unix platforms." );
+#endif
+}
+
+//-----------------------------------------------------------
+void DiskPlotStatsServer::SetPhaseDurations( const double durations[3] )
+{
+    const double total = durations[0] + durations[1] + durations[2];
+    if( total <= 0 )
+        return;
+
+    std::lock_guard<std::mutex> lock( _phaseLock );
+    for( int i = 0; i < 3; i++ )
+        _phaseWeights[i] = durations[i] / total;
+}
+
+//-----------------------------------------------------------
+void DiskPlotStatsServer::ServerThreadMain( DiskPlotStatsServer* self )
+{
+    self->Serve();
+}
+
+//-----------------------------------------------------------
+void DiskPlotStatsServer::Serve()
+{
+#if PLATFORM_IS_UNIX
+    char buffer[4096];
+
+    for( ;; )
+    {
+        const int client = accept( _socket, nullptr, nullptr );
+        if( client == -1 )
+        {
+            if( errno == EINTR || errno == ECONNABORTED )
+                continue;
+
+            Log::Error( "Stats socket failed to accept a connection with error: %d. No longer serving stats.", errno );
+            return;
+        }
+
+        const size_t length = WriteSnapshot( buffer, sizeof( buffer ) );
+
+        // The client may hang up early, which is not an error for us
+        for( size_t sent = 0; sent < length; )
+        {
+            const ssize_t r = send( client, buffer + sent, length - sent, MSG_NOSIGNAL );
+            if( r <= 0 )
+            {
+                if( r < 0 && errno == EINTR )
+                    continue;
+                break;
+            }
+
+            sent += (size_t)r;
+        }
+
+        close( client );
+    }
+#endif
+}
+
+//-----------------------------------------------------------
+size_t DiskPlotStatsServer::WriteSnapshot( char* buffer, const size_t bufferSize )
+{
+    const DiskPlotContext&  context  = _context;
+    const DiskPlotProgress& progress = context.progress;
+    const DiskBufferQueue&  ioQueue  = *context.ioQueue;
+
+    size_t length = 0;
+
+    auto SecondsSince = [=]( const int64 ticks ) {
+        return TicksToSeconds( TimerBegin() - TimePoint( Duration( ticks ) ) );
+    };
+
+    // Read the position once, as the plotting threads keep updating it
+    const uint32 phase       = DiskPlotProgress::Get( progress.phase        );
+    const uint32 table       = DiskPlotProgress::Get( progress.table        );
+    const uint32 step        = DiskPlotProgress::Get( progress.step         );
+    const uint32 stepCount   = DiskPlotProgress::Get( progress.stepCount    );
+    const uint32 bucket      = DiskPlotProgress::Get( progress.bucket       );
+    const uint64 entries     = DiskPlotProgress::Get( progress.tableEntries );
+    const uint32 plotCount   = DiskPlotProgress::Get( progress.plotCount    );
+    const uint32 numBuckets  = context.numBuckets;
+
+    AppendF( buffer, bufferSize, length, "{\"plots_completed\":%u,\"plotting\":%s", plotCount, phase ? "true" : "false" );
+
+    if( phase )
+    {
+        const double elapsed      = SecondsSince( DiskPlotProgress::Get( progress.plotStart  ) );
+        const double phaseElapsed = SecondsSince( DiskPlotProgress::Get( progress.phaseStart ) );
+        const double tableElapsed = table ? SecondsSince( DiskPlotProgress::Get( progress.tableStart ) ) : 0.0;
+
+        // Fraction of the current table pass and of the current phase completed
+        const double tableFraction = std::min( 1.0, (double)bucket / numBuckets );
+        const double phaseFraction = stepCount ? std::min( 1.0, ( step + tableFraction ) / stepCount ) : 0.0;
+
+        double plotFraction = 0.99;     // While completing the plot file
+        if( phase <= 3 )
+        {
+            std::lock_guard<std::mutex> lock( _phaseLock );
+
+            plotFraction = _phaseWeights[phase-1] * phaseFraction;
+            for( uint32 i = 0; i < phase-1; i++ )
+                plotFraction += _phaseWeights[i];
+        }
+
+        const double entriesPerSecond = tableElapsed > 0 ? entries * tableFraction / tableElapsed : 0.0;
+
+        AppendF( buffer, bufferSize, length, ",\"phase\":%u,\"table\":%u,\"bucket\":%u,\"bucket_count\":%u,\"step\":%u,\"step_count\":%u",
+               phase, table, bucket, numBuckets, step, stepCount );
+        AppendF( buffer, bufferSize, length, ",\"elapsed\":%.3lf,\"phase_elapsed\":%.3lf,\"table_elapsed\":%.3lf,\"progress\":%.4lf",
+               elapsed, phaseElapsed, tableElapsed, plotFraction );
+
+        if( plotFraction >= 0.01 )
+            AppendF( buffer, bufferSize, length, ",\"eta\":%.1lf", elapsed / plotFraction - elapsed );
+        else
+            AppendF( buffer, bufferSize, length, ",\"eta\":null" );
+
+        AppendF( buffer, bufferSize, length, ",\"entries_per_second\":%.1lf", entriesPerSecond );
+    }
+
+    // I/O throughput since the previous query, sampled at least a second apart
+    {
+        const uint64 bytesRead    = ioQueue.TotalBytesRead();
+        const uint64 bytesWritten = ioQueue.TotalBytesWritten();
+        const double sampleTime   = TicksToSeconds( TimerBegin() - _sampleTime );
+
+        if( sampleTime >= 1.0 )
+        {
+            _readRate           = (double)( bytesRead    - _sampleBytesRead    ) BtoMB / sampleTime;
+            _writeRate          = (double)( bytesWritten - _sampleBytesWritten ) BtoMB / sampleTime;
+            _sampleBytesRead    = bytesRead;
+            _sampleBytesWritten = bytesWritten;
+            _sampleTime         = TimerBegin();
+        }
+
+        AppendF( buffer, bufferSize, length, ",\"io\":{\"bytes_read\":%llu,\"bytes_written\":%llu,\"read_mib_s\":%.2lf,\"write_mib_s\":%.2lf,\"queue_depth\":%d,\"wait_time\":%.3lf}",
+               (llu)bytesRead, (llu)bytesWritten, _readRate, _writeRate, ioQueue.PendingCommandCount(),
+               TicksToSeconds( DiskPlotProgress::Get( context.ioWaitTime ) ) );
+    }
+
+    // The high-water marks are recorded after each table
+    {
+        uint64 highWater = 0;
+        for( uint32 i = 1; i <= 3; i++ )
+        {
+            uint64 phaseHighWater = 0;
+            if( PlotMetrics::GetU64( phaseHighWater, "heap.p%u_high_water", i ) )
+                highWater = std::max( highWater, phaseHighWater );
+        }
+
+        AppendF( buffer, bufferSize, length, ",\"heap\":{\"size\":%llu,\"high_water\":%llu}", (llu)context.heapSize, (llu)highWater );
+    }
+
+    AppendF( buffer, bufferSize, length, "}\n" );
+    return length;
+}
+
+//-----------------------------------------------------------
+void AppendF( char* buffer, const size_t bufferSize, size_t& length, const char* format, ... )
+{
+    // Truncates the output if the buffer is full
+    if( length + 1 >= bufferSize )
+        return;
+
+    va_list args;
+    va_start( args, format );
+    const int r = vsnprintf( buffer + length, bufferSize - length, format, args );
+    va_end( args );
+
+    if( r > 0 )
+        length = std::min( length + (size_t)r, bufferSize - 1 );
+}
+
+//-----------------------------------------------------------
+void UnlinkSocket()
+{
+#if PLATFORM_IS_UNIX
+    unlink( _socketPath.c_str() );
+#endif
+}
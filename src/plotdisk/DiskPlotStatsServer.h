@@ -0,0 +1,52 @@
+#pragma once
+#include "threading/Thread.h"
+#include <mutex>
+
+struct DiskPlotContext;
+
+/**
+ * Serves live progress and I/O statistics of the disk plotter over a local Unix socket,
+ * so that orchestration tools can poll a long running plotter.
+ *
+ * Each connection is sent a single JSON object with the current phase, table and bucket,
+ * the estimated time remaining, the entry throughput of the current table,
+ * I/O throughput and queue depth, and heap usage. The connection is then closed.
+ * ex: socat - UNIX-CONNECT:<path>
+ *
+ * The statistics are read without synchronizing with the plotting threads,
+ * so a snapshot may be slightly stale.
+ */
+class DiskPlotStatsServer
+{
+public:
+    DiskPlotStatsServer( const DiskPlotContext& context );
+
+    // Binds the socket and starts serving on a background thread.
+    // Replaces a stale socket file left at the path by a previous run.
+    void Start( const char* socketPath );
+
+    // Duration in seconds of each phase of the last plot.
+    // Used to weigh the phases when estimating the time remaining.
+    void SetPhaseDurations( const double durations[3] );
+
+private:
+    static void ServerThreadMain( DiskPlotStatsServer* self );
+
+    void   Serve();
+    size_t WriteSnapshot( char* buffer, size_t bufferSize );
+
+private:
+    const DiskPlotContext& _context;
+    Thread*                _thread = nullptr;
+    int                    _socket = -1;
+
+    std::mutex             _phaseLock;
+    double                 _phaseWeights[3];
+
+    // Last I/O totals sampled, to calculate the throughput between queries
+    uint64                 _sampleBytesRead    = 0;
+    uint64                 _sampleBytesWritten = 0;
+    TimePoint              _sampleTime;
+    double                 _readRate           = 0;     // MiB/s
+    double                 _writeRate          = 0;
+};
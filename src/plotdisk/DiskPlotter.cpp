@@ -4,6 +4,11 @@
 #include "util/CliParser.h"
 #include "util/jobs/MemJobs.h"
 #include "io/FileStream.h"
+#include "plotting/PlotTools.h"
+#include "plotting/PlotMetrics.h"
+#include "util/TraceLog.h"
+#include "DiskPlotStatsServer.h"
+#include "DiskPlotRelocator.h"
 
 #include "DiskFp.h"
 #include "DiskPlotPhase1.h"
@@ -15,6 +20,7 @@
 
 
 size_t ValidateTmpPathAndGetBlockSize( DiskPlotter::Config& cfg );
+static std::string GetPlotReportPath( const char* dir, const char* plotFileName, const char* extension );
 
 
 //-----------------------------------------------------------
@@ -24,6 +30,7 @@ size_t ValidateTmpPathAndGetBlockSize( DiskPlotter::Config& cfg );
 
 //-----------------------------------------------------------
 DiskPlotter::DiskPlotter( const Config& cfg )
+    : _cx()     // Zero-initialized. Not memset, as the progress fields are atomic.
 {
     ASSERT( cfg.tmpPath  );
     ASSERT( cfg.tmpPath2 );
@@ -31,8 +38,6 @@ DiskPlotter::DiskPlotter( const Config& cfg )
     // Initialize tables for matching
     LoadLTargets();
     
-    ZeroMem( &_cx );
-    
     GlobalPlotConfig& gCfg = *cfg.globalCfg;
 
     FatalIf( !GetTmpPathsBlockSizes( cfg.tmpPath, cfg.tmpPath2, _cx.tmp1BlockSize, _cx.tmp2BlockSize ),
@@ -111,11 +116,25 @@ DiskPlotter::DiskPlotter( const Config& cfg )
         }
     }
 
+    // Must be enabled before the threads to trace are started
+    if( cfg.tracePath )
+    {
+        FatalIf( cfg.traceEvents < 1, "--trace-events must be at least 1." );
+        TraceLog::Enable( cfg.traceEvents );
+    }
+
     // Initialize our Thread Pool and IO Queue
     const int32 ioThreadId = -1;    // Force unpinned IO thread for now. We should bind it to the last used thread, of the max threads used...
     _cx.threadPool = new ThreadPool( sysLogicalCoreCount, ThreadPool::Mode::Fixed, gCfg.disableCpuAffinity );
     _cx.ioQueue    = new DiskBufferQueue( _cx.tmpPath, _cx.tmpPath2, gCfg.outputFolder, _cx.heapBuffer, _cx.heapSize, _cx.ioThreadCount, ioThreadId );
     _cx.fencePool  = new FencePool( 8 );
+    _cx.checkpoint = new DiskPlotCheckpoint( _cx );
+
+    if( cfg.resumePath )
+    {
+        _cx.checkpoint->Load( cfg.resumePath );
+        _cx.resumeStage = _cx.checkpoint->Stage();
+    }
 
     // if( cfg.globalCfg->warmStart )
     // #TODO: IMPORTANT: Remove this after testing
@@ -133,6 +152,15 @@ DiskPlotter::DiskPlotter( const Config& cfg )
 
         Log::Line( "Memory initialized." );
     }
+
+    if( cfg.statsSocketPath )
+    {
+        _statsServer = new DiskPlotStatsServer( _cx );
+        _statsServer->Start( cfg.statsSocketPath );
+    }
+
+    if( cfg.destCount )
+        _relocator = new DiskPlotRelocator( cfg.destPaths, cfg.destCount, cfg.destBandwidth );
 }
 
 //-----------------------------------------------------------
@@ -146,7 +174,7 @@ void DiskPlotter::Plot( const PlotRequest& req )
     memset( _cx.ptrTableBucketCounts, 0, sizeof( _cx.ptrTableBucketCounts ) );
     memset( _cx.bucketSlices        , 0, sizeof( _cx.bucketSlices ) );
     memset( _cx.p1TableWaitTime     , 0, sizeof( _cx.p1TableWaitTime ) );
-    _cx.ioWaitTime      = Duration::zero();
+    DiskPlotProgress::Set( _cx.ioWaitTime, Duration::zero() );
     _cx.cTableWaitTime  = Duration::zero();
     _cx.p7WaitTime      = Duration::zero();
 
@@ -155,24 +183,58 @@ void DiskPlotter::Plot( const PlotRequest& req )
     _cx.plotId       = req.plotId;
     _cx.plotMemo     = req.plotMemo;
     _cx.plotMemoSize = req.plotMemoSize;
+    _cx.plotFileName = req.plotFileName;
+
+    const bool resuming = _cx.resumeStage != DiskPlotStage::None;
+    if( resuming )
+    {
+        FatalIf( memcmp( req.plotId, _cx.checkpoint->PlotId(), BB_PLOT_ID_LEN ) != 0,
+            "Plot id does not match the checkpoint's plot id." );
+
+        // Must be restored before any file sets are opened
+        _cx.checkpoint->Restore();
+    }
 
-    _cx.ioQueue->OpenPlotFile( req.plotFileName, req.plotId, req.plotMemo, req.plotMemoSize );
+    _cx.ioQueue->OpenPlotFile( req.plotFileName, req.plotId, req.plotMemo, req.plotMemoSize, !_cx.cfg->noPlotDirectIO );
 
     #if ( _DEBUG && ( BB_DP_DBG_SKIP_PHASE_1 || BB_DP_P1_SKIP_TO_TABLE || BB_DP_DBG_SKIP_TO_C_TABLES ) )
         BB_DP_DBG_ReadTableCounts( _cx );
     #endif
 
+    // Metrics are reported per plot, but the I/O counters are kept for the lifetime of the queue
+    uint64 startBytesRead   [(size_t)FileId::_COUNT];
+    uint64 startBytesWritten[(size_t)FileId::_COUNT];
+
+    for( FileId id = FileId::None; id < FileId::_COUNT; id++ )
+    {
+        startBytesRead   [(int)id] = _cx.ioQueue->FileBytesRead   ( id );
+        startBytesWritten[(int)id] = _cx.ioQueue->FileBytesWritten( id );
+    }
+
+    PlotMetrics::Clear();
+    _cx.threadPool->ResetBusyTime();
+
+    if( TraceLog::IsEnabled() )
+        TraceLog::Clear();
+
     Log::Line( "Started plot." );
     auto plotTimer = TimerBegin();
+    _stats = {};
+    _cx.progress.BeginPlot();
 
     {
         Log::Line( "Running Phase 1" );
         const auto timer = TimerBegin();
+        BeginPhaseStats( _stats.phases[0] );
+        // Tables 1-7, then the C tables
+        _cx.progress.BeginPhase( 1, 8 );
 
         if( bounded )
         {
+            // #NOTE: Always constructed, as it opens the Phase 1 file sets, which later phases use
             K32BoundedPhase1 phase1( _cx );
             #if !( _DEBUG && BB_DP_DBG_SKIP_PHASE_1 )
+            if( _cx.resumeStage < DiskPlotStage::Phase1 )
                 phase1.Run();
             #endif
         }
@@ -188,13 +250,20 @@ void DiskPlotter::Plot( const PlotRequest& req )
             BB_DP_DBG_WriteTableCounts( _cx );
         #endif
 
+        if( _cx.resumeStage < DiskPlotStage::Phase1 )
+            _cx.checkpoint->Save( DiskPlotStage::Phase1 );
+
         const double elapsed = TimerEnd( timer );
+        EndPhaseStats( _stats.phases[0], elapsed );
         Log::Line( "Finished Phase 1 in %.2lf seconds ( %.1lf minutes ).", elapsed, elapsed / 60 );
     }
 
     {
         Log::Line( "Running Phase 2" );
         const auto timer = TimerBegin();
+        BeginPhaseStats( _stats.phases[1] );
+        // Tables 7-3
+        _cx.progress.BeginPhase( 2, 5 );
 
         // if( bounded )
         // {
@@ -203,16 +272,24 @@ void DiskPlotter::Plot( const PlotRequest& req )
         // else
         {
             DiskPlotPhase2 phase2( _cx );
-            phase2.Run();
+            if( _cx.resumeStage < DiskPlotStage::Phase2 )
+            {
+                phase2.Run();
+                _cx.checkpoint->Save( DiskPlotStage::Phase2 );
+            }
         }
 
         const double elapsed = TimerEnd( timer );
+        EndPhaseStats( _stats.phases[1], elapsed );
         Log::Line( "Finished Phase 2 in %.2lf seconds ( %.1lf minutes ).", elapsed, elapsed / 60 );
     }
 
     {
         Log::Line( "Running Phase 3" );
         const auto timer = TimerBegin();
+        BeginPhaseStats( _stats.phases[2] );
+        // 2 passes for each of tables 2-7, then P7
+        _cx.progress.BeginPhase( 3, 13 );
 
         // if( bounded )
         // {
@@ -225,15 +302,17 @@ void DiskPlotter::Plot( const PlotRequest& req )
         }
 
         const double elapsed = TimerEnd( timer );
+        EndPhaseStats( _stats.phases[2], elapsed );
         Log::Line( "Finished Phase 3 in %.2lf seconds ( %.1lf minutes ).", elapsed, elapsed / 60 );
     }
-    Log::Line("Total plot I/O wait time: %.2lf seconds.", TicksToSeconds( _cx.ioWaitTime ) );
+    Log::Line("Total plot I/O wait time: %.2lf seconds.", TicksToSeconds( DiskPlotProgress::Get( _cx.ioWaitTime ) ) );
 
 
     {
         // Now we need to update the table sizes on the file
         Log::Line( "Waiting for plot file to complete pending writes..." );
         const auto timer = TimerBegin();
+        _cx.progress.BeginPhase( 4, 1 );
 
         // Update the table pointers location
         DiskBufferQueue& ioQueue = *_cx.ioQueue;
@@ -253,6 +332,10 @@ void DiskPlotter::Plot( const PlotRequest& req )
         ioQueue.CommitCommands();
         fence.Wait();
         _cx.fencePool->ReleaseFence( fence );
+
+        // Removes any files which had already been deleted before the checkpoint we resumed from
+        if( resuming )
+            ioQueue.EndResume();
         
         const double elapsed = TimerEnd( timer );
         Log::Line( "Completed pending writes in %.2lf seconds.", elapsed );
@@ -271,16 +354,195 @@ void DiskPlotter::Plot( const PlotRequest& req )
         Log::Line( "" );
 
         double plotElapsed = TimerEnd( plotTimer );
+        _stats.elapsed = plotElapsed;
         Log::Line( "Finished plotting in %.2lf seconds ( %.1lf minutes ).", plotElapsed, plotElapsed / 60 );
 
+        RecordPlotMetrics( req, startBytesRead, startBytesWritten );
+        if( _cfg.metricsPath )
+            WritePlotMetrics( req );
+        if( _cfg.tracePath )
+            WritePlotTrace( req );
+
         // Rename plot file
-        ioQueue.FinishPlot( fence );
+        const std::string plotPath = ioQueue.FinishPlot( fence );
+
+        _cx.checkpoint->Delete();
+        _cx.resumeStage = DiskPlotStage::None;
+
+        if( _relocator && !plotPath.empty() )
+            _relocator->Enqueue( plotPath.c_str() );
+    }
+
+    if( _statsServer )
+    {
+        const double phaseDurations[3] = { _stats.phases[0].elapsed, _stats.phases[1].elapsed, _stats.phases[2].elapsed };
+        _statsServer->SetPhaseDurations( phaseDurations );
+    }
+
+    _cx.progress.EndPlot();
+}
+
+//-----------------------------------------------------------
+void DiskPlotter::WaitForRelocations()
+{
+    // Waits for the last plot to be moved, then stops the relocator thread
+    delete _relocator;
+    _relocator = nullptr;
+}
+
+//-----------------------------------------------------------
+void DiskPlotter::BeginPhaseStats( PhaseStats& stats )
+{
+    stats.ioWaitTime   = TicksToSeconds( DiskPlotProgress::Get( _cx.ioWaitTime ) );
+    stats.bytesRead    = _cx.ioQueue->TotalBytesRead();
+    stats.bytesWritten = _cx.ioQueue->TotalBytesWritten();
+}
+
+//-----------------------------------------------------------
+void DiskPlotter::EndPhaseStats( PhaseStats& stats, const double elapsed )
+{
+    stats.elapsed      = elapsed;
+    stats.ioWaitTime   = TicksToSeconds( DiskPlotProgress::Get( _cx.ioWaitTime ) ) - stats.ioWaitTime;
+    stats.bytesRead    = _cx.ioQueue->TotalBytesRead()    - stats.bytesRead;
+    stats.bytesWritten = _cx.ioQueue->TotalBytesWritten() - stats.bytesWritten;
+}
+
+//-----------------------------------------------------------
+void DiskPlotter::RecordPlotMetrics( const PlotRequest& req, const uint64* startBytesRead, const uint64* startBytesWritten )
+{
+    char plotIdStr[BB_PLOT_ID_HEX_LEN+1];
+    PlotTools::PlotIdToString( req.plotId, plotIdStr );
+
+    PlotMetrics::SetStr( plotIdStr        , "plot.id" );
+    PlotMetrics::SetStr( req.plotFileName , "plot.file" );
+    PlotMetrics::SetU64( _K               , "plot.k" );
+    PlotMetrics::SetU64( _cx.numBuckets   , "plot.buckets" );
+    PlotMetrics::SetU64( _cfg.bounded     , "plot.bounded" );
+    PlotMetrics::SetF64( _stats.elapsed   , "plot.elapsed" );
+    PlotMetrics::SetF64( TicksToSeconds( DiskPlotProgress::Get( _cx.ioWaitTime ) ), "plot.io_wait" );
+
+    for( uint32 i = 0; i < 3; i++ )
+    {
+        const PhaseStats& phase = _stats.phases[i];
+
+        PlotMetrics::SetF64( phase.elapsed     , "phases.p%u.elapsed"      , i+1 );
+        PlotMetrics::SetF64( phase.ioWaitTime  , "phases.p%u.io_wait"      , i+1 );
+        PlotMetrics::SetU64( phase.bytesRead   , "phases.p%u.bytes_read"   , i+1 );
+        PlotMetrics::SetU64( phase.bytesWritten, "phases.p%u.bytes_written", i+1 );
+    }
+
+    for( TableId table = TableId::Table1; table <= TableId::Table7; table++ )
+        PlotMetrics::SetF64( TicksToSeconds( _cx.p1TableWaitTime[(int)table] ), "tables.p1.t%u.io_wait", (uint32)table+1 );
+
+    // I/O per file set
+    DiskBufferQueue& ioQueue = *_cx.ioQueue;
+
+    for( FileId id = FileId::None+1; id < FileId::_COUNT; id++ )
+    {
+        const uint64 bytesRead    = ioQueue.FileBytesRead   ( id ) - startBytesRead   [(int)id];
+        const uint64 bytesWritten = ioQueue.FileBytesWritten( id ) - startBytesWritten[(int)id];
+
+        if( bytesRead == 0 && bytesWritten == 0 )
+            continue;
+
+        // The plot file set is named after its full temporary path
+        const char* name = id == FileId::PLOT ? "plot" : ioQueue.FileName( id );
+
+        PlotMetrics::SetU64( bytesRead   , "io.%s.bytes_read"   , name );
+        PlotMetrics::SetU64( bytesWritten, "io.%s.bytes_written", name );
+    }
+
+    // Memory
+    PlotMetrics::SetU64( _cx.heapSize , "heap.size" );
+    PlotMetrics::SetU64( _cx.cacheSize, "heap.cache_size" );
+    PlotMetrics::SetU64( _cx.cachedMarksSize, "heap.cached_marks_size" );
+
+    // Time each worker thread spent running jobs
+    ThreadPool& pool = *_cx.threadPool;
+    double totalBusy = 0;
+
+    for( uint32 i = 0; i < pool.ThreadCount(); i++ )
+    {
+        const double busy = TicksToSeconds( pool.ThreadBusyTime( i ) );
+        totalBusy += busy;
+
+        PlotMetrics::SetF64( busy, "threads.busy.%u", i );
     }
+
+    PlotMetrics::SetU64( pool.ThreadCount(), "threads.count" );
+    PlotMetrics::SetF64( totalBusy         , "threads.busy_total" );
+}
+
+//-----------------------------------------------------------
+void DiskPlotter::WritePlotMetrics( const PlotRequest& req )
+{
+    ASSERT( _cfg.metricsPath );
+
+    const std::string path = GetPlotReportPath( _cfg.metricsPath, req.plotFileName, ".metrics.json" );
+
+    if( PlotMetrics::WriteJson( path.c_str() ) )
+        Log::Line( "Wrote plot metrics to '%s'.", path.c_str() );
+    else
+        Log::Error( "WARNING: Failed to write plot metrics to '%s'.", path.c_str() );
+}
+
+//-----------------------------------------------------------
+void DiskPlotter::WritePlotTrace( const PlotRequest& req )
+{
+    ASSERT( _cfg.tracePath );
+
+    const std::string path = GetPlotReportPath( _cfg.tracePath, req.plotFileName, ".trace.json" );
+
+    if( TraceLog::WriteJson( path.c_str() ) )
+        Log::Line( "Wrote plot trace to '%s'.", path.c_str() );
+    else
+        Log::Error( "WARNING: Failed to write plot trace to '%s'.", path.c_str() );
+}
+
+//-----------------------------------------------------------
+std::string GetPlotReportPath( const char* dir, const char* plotFileName, const char* extension )
+{
+    // Name the report after the plot file, without its extension
+    std::string path = dir;
+    if( !path.empty() && path.back() != '/' && path.back() != '\\' )
+        path += '/';
+
+    std::string name = plotFileName;
+    const size_t plotExtension = name.rfind( ".plot" );
+    if( plotExtension != std::string::npos )
+        name.resize( plotExtension );
+
+    path += name;
+    path += extension;
+
+    return path;
+}
+
+//-----------------------------------------------------------
+bool DiskPlotter::GetResumePlot( byte* outPlotId, byte* outPlotMemo, uint16& outPlotMemoSize, char* outPlotFileName ) const
+{
+    if( _cx.resumeStage == DiskPlotStage::None )
+        return false;
+
+    const DiskPlotCheckpoint& checkpoint = *_cx.checkpoint;
+
+    const char*  plotFileName = checkpoint.PlotFileName();
+    const size_t nameLength   = strlen( plotFileName );
+    FatalIf( nameLength > BB_PLOT_FILE_LEN_TMP, "Invalid plot file name in checkpoint: '%s'.", plotFileName );
+
+    memcpy( outPlotId  , checkpoint.PlotId()  , BB_PLOT_ID_LEN );
+    memcpy( outPlotMemo, checkpoint.PlotMemo(), checkpoint.PlotMemoSize() );
+    memcpy( outPlotFileName, plotFileName, nameLength + 1 );
+    outPlotMemoSize = checkpoint.PlotMemoSize();
+
+    return true;
 }
 
 //-----------------------------------------------------------
 void DiskPlotter::ParseCommandLine( CliParser& cli, Config& cfg )
 {
+    const char* destPath = nullptr;
+
     while( cli.HasArgs() )
     {
         if( cli.ReadU32( cfg.numBuckets,  "-b", "--buckets" ) ) 
@@ -297,8 +559,12 @@ void DiskPlotter::ParseCommandLine( CliParser& cli, Config& cfg )
             continue;
         if( cli.ReadSwitch( cfg.noTmp2DirectIO, "--no-t2-direct" ) )
             continue;
+        if( cli.ReadSwitch( cfg.noPlotDirectIO, "--no-plot-direct" ) )
+            continue;
         if( cli.ReadSize( cfg.cacheSize, "--cache" ) )
             continue;
+        if( cli.ReadSwitch( cfg.cacheMarks, "--cache-marks" ) )
+            continue;
         if( cli.ReadU32( cfg.f1ThreadCount, "--f1-threads" ) )
             continue;
         if( cli.ReadU32( cfg.fpThreadCount, "--fp-threads" ) )
@@ -307,8 +573,32 @@ void DiskPlotter::ParseCommandLine( CliParser& cli, Config& cfg )
             continue;
         if( cli.ReadU32( cfg.p2ThreadCount, "--p2-threads" ) )
             continue;
+        if( cli.ReadSwitch( cfg.p2AtomicMarks, "--p2-atomic-marks" ) )
+            continue;
         if( cli.ReadU32( cfg.p3ThreadCount, "--p3-threads" ) )
             continue;
+        if( cli.ReadStr( cfg.resumePath, "--resume" ) )
+            continue;
+        if( cli.ReadSwitch( cfg.noCheckpoint, "--no-checkpoint" ) )
+            continue;
+        if( cli.ReadStr( cfg.metricsPath, "--metrics-out" ) )
+            continue;
+        if( cli.ReadStr( cfg.tracePath, "--trace" ) )
+            continue;
+        if( cli.ReadU32( cfg.traceEvents, "--trace-events" ) )
+            continue;
+        if( cli.ReadStr( cfg.statsSocketPath, "--stats-socket" ) )
+            continue;
+        if( cli.ReadStr( destPath, "--dest" ) )
+        {
+            FatalIf( strlen( destPath ) == 0, "Invalid plot destination directory." );
+            FatalIf( cfg.destCount >= BB_DP_MAX_DEST_DIRS, "Too many destination directories. A maximum of %u are allowed.", (uint)BB_DP_MAX_DEST_DIRS );
+
+            cfg.destPaths[cfg.destCount++] = destPath;
+            continue;
+        }
+        if( cli.ReadSize( cfg.destBandwidth, "--dest-bw" ) )
+            continue;
         if( cli.ArgConsume( "-s", "--sizes" ) )
         {
             FatalIf( cfg.numBuckets < BB_DP_MIN_BUCKET_COUNT || cfg.numBuckets > BB_DP_MAX_BUCKET_COUNT,
@@ -346,6 +636,16 @@ void DiskPlotter::ParseCommandLine( CliParser& cli, Config& cfg )
         }
     }
 
+    // Continue with the same settings as the interrupted plot
+    if( cfg.resumePath )
+    {
+        if( cfg.tmpPath && strcmp( cfg.tmpPath, cfg.resumePath ) != 0 )
+            Log::Line( "Warning: Using the resume directory '%s' as the temp 1 directory.", cfg.resumePath );
+
+        cfg.tmpPath = cfg.resumePath;
+        DiskPlotCheckpoint::ApplyToConfig( cfg.resumePath, cfg );
+    }
+
     ///
     /// Validate some parameters
     ///
@@ -358,6 +658,9 @@ void DiskPlotter::ParseCommandLine( CliParser& cli, Config& cfg )
 
     FatalIf( ( cfg.numBuckets & ( cfg.numBuckets - 1 ) ) != 0, "Buckets must be power of 2." );
 
+    FatalIf( cfg.cacheMarks && cfg.cacheSize == 0, "--cache-marks requires a cache to be specified with --cache." );
+    FatalIf( cfg.destBandwidth && cfg.destCount == 0, "--dest-bw requires a destination directory to be specified with --dest." );
+
     FatalIf( cfg.numBuckets >= 1024, "1024 buckets are not allowed for plots < k33." );
     FatalIf( cfg.numBuckets < 128 && !cfg.bounded, "64 buckets is only allowed for bounded k=32 plots." );
 
@@ -495,6 +798,7 @@ static const char* USAGE = R"(diskplot [OPTIONS] <out_dir>
 Creates plots by making use of a disk to temporarily store and read values.
 
 <out_dir> : The output directory where the plot will be copied to after completion.
+            With --dest, plots are only staged there before being moved to a destination directory.
 
 [OPTIONS]
  -b, --buckets <n>  : The number of buckets to use. The default is 256.
@@ -518,6 +822,10 @@ Creates plots by making use of a disk to temporarily store and read values.
 
  --no-t2-direct     : Disable direct I/O on the temp 2 directory.
 
+ --no-plot-direct   : Disable direct I/O on the final plot file.
+                      By default the plot is written with direct I/O, in whole blocks,
+                      so that it does not evict everything else from the page cache.
+
  -s, --sizes        : Output the memory requirements for a specific bucket count.
                       To change the bucket count from the default, pass a value to -b
                       before using this argument. You may also pass a value to --temp and --temp2
@@ -528,6 +836,12 @@ Creates plots by making use of a disk to temporarily store and read values.
                       You need about 192GiB(+|-) for high-frequency I/O Phase 1 calculations
                       to be completely in-memory.
 
+ --cache-marks      : Keep the tables marked in Phase 2 in the cache, instead of writing them
+                      to the temp 1 directory and reading them back in Phase 3. That is ~512MiB
+                      of cache per table, for tables 2 to 6. The tables which do not fit are
+                      written to disk as usual. The rest of the cache is used by Phase 3.
+                      No checkpoint is saved after Phase 2 with this option.
+
  --f1-threads <n>   : Override the thread count for F1 generation.
 
  --fp-threads <n>   : Override the thread count for forward propagation.
@@ -538,8 +852,59 @@ Creates plots by making use of a disk to temporarily store and read values.
 
 --p2-threads <n>    : Override the thread count for Phase 2.
 
+--p2-atomic-marks   : Mark the Phase 2 tables in a single pass with atomic bit sets,
+                      instead of 2 passes with a barrier in between. Produces the same plot.
+                      Whether it is faster depends on the thread count and the memory system,
+                      so compare both with 'bench mark_halves mark_atomic' before using it.
+
 --p3-threads <n>    : Override the thread count for Phase 3.
 
+--resume <dir>      : Resume an interrupted plot from the checkpoint saved in the
+                      given temp 1 directory. The bucket count, temp 2 directory and
+                      output directory default to the ones of the interrupted plot.
+                      After the interrupted plot completes, new plots are created as usual.
+
+--no-checkpoint     : Do not save checkpoints to the temp 1 directory.
+                      By default the disk plotter saves a checkpoint after
+                      each table and phase, so that it can be resumed with --resume.
+                      With --alternate, no checkpoints are saved within Phase 1.
+                      With --cache, checkpoints are only saved after Phases 1 and 2.
+                      Unbounded plots can not be resumed.
+
+--metrics-out <dir> : Write a JSON report of the metrics of each plot to the given directory,
+                      named after the plot file: <plot_name>.metrics.json.
+                      It contains the time taken and the I/O wait time of each phase and table,
+                      the bytes read and written per phase and per temporary file,
+                      the heap high-water mark of each phase and the time each thread spent working.
+
+--trace <dir>       : Record a timeline of each plot and write it to the given directory as
+                      Chrome trace-event JSON, named <plot_name>.trace.json. Open it in
+                      chrome://tracing or https://ui.perfetto.dev.
+                      It contains a span for each job run, thread barrier wait, fence wait,
+                      I/O buffer wait and I/O command executed. I/O command spans carry their file id.
+
+--trace-events <n>  : Number of trace spans to keep per thread. When exceeded, the oldest spans
+                      are dropped. Each span takes 40 bytes. The default is 65536.
+
+--stats-socket <path>: Serve live progress stats on a Unix socket created at the given path.
+                      Each connection receives a single JSON object and is then closed.
+                      It contains the current phase, table and bucket, the estimated time remaining,
+                      the entries processed per second in the current table, I/O throughput,
+                      I/O queue depth and heap usage.
+                      ex: socat - UNIX-CONNECT:<path>
+
+--dest <dir>        : Move finished plots from <out_dir> to the given directory. May be specified
+                      multiple times. Each plot is moved to the directory with the most free space
+                      which can hold it, so that the directories are filled evenly.
+                      <out_dir> is then only used as a staging directory: Use a fast drive for it,
+                      so that the plot file is not written at the speed of the destination drives.
+                      Plots are moved in the background while the next plot is being created.
+                      If a plot is finished before the previous one has been moved, the plotter
+                      waits for it. Plots which fit in no destination are left in <out_dir>.
+
+--dest-bw <n>       : Maximum speed per second at which plots are copied to their destination,
+                      ex: 200MB. By default there is no limit. Moves within the same file system are not copied.
+
 -h, --help          : Print this help text and exit.
 
 
@@ -3,6 +3,8 @@
 #include "DiskPlotContext.h"
 #include "plotting/GlobalPlotConfig.h"
 class CliParser;
+class DiskPlotStatsServer;
+class DiskPlotRelocator;
 
 class DiskPlotter
 {
@@ -17,12 +19,37 @@ public:
         const char*  plotFileName;
     };
 
+    struct PhaseStats
+    {
+        double elapsed;         // Seconds
+        double ioWaitTime;      // Seconds spent waiting for I/O to complete
+        uint64 bytesRead;       // Sampled at the phase boundaries, so pending I/O
+        uint64 bytesWritten;    // may be counted towards the following phase
+    };
+
+    struct PlotStats
+    {
+        PhaseStats phases[3];
+        double     elapsed;     // Whole plot, including the final plot writes
+    };
+
 public:
     // DiskPlotter();
     DiskPlotter( const Config& cfg );
 
     void Plot( const PlotRequest& req );
 
+    // Blocks until the finished plots have been moved to their destination directory (--dest),
+    // then shuts down the relocator. Call it once, after the last plot.
+    void WaitForRelocations();
+
+    // If we were asked to resume an interrupted plot, outputs its plot id, memo and file name.
+    // The output buffers must be able to hold BB_PLOT_ID_LEN, BB_PLOT_MEMO_MAX_SIZE and BB_PLOT_FILE_LEN_TMP bytes respectively.
+    bool GetResumePlot( byte* outPlotId, byte* outPlotMemo, uint16& outPlotMemoSize, char* outPlotFileName ) const;
+
+    // Timings and I/O volumes of the last plot created
+    inline const PlotStats& LastPlotStats() const { return _stats; }
+
     static bool   GetTmpPathsBlockSizes(  const char* tmpPath1, const char* tmpPath2, size_t& tmpPath1Size, size_t& tmpPath2Size );
     static size_t GetRequiredSizeForBuckets( const bool bounded, const uint32 numBuckets, const char* tmpPath1, const char* tmpPath2, const uint32 threadCount );
     static size_t GetRequiredSizeForBuckets( const bool bounded, const uint32 numBuckets, const size_t fxBlockSize, const size_t pairsBlockSize, const uint32 threadCount );
@@ -32,7 +59,18 @@ public:
     static void PrintUsage();
 
 private:
-    DiskPlotContext   _cx;
-    Config            _cfg;
+    void BeginPhaseStats( PhaseStats& stats );
+    void EndPhaseStats( PhaseStats& stats, const double elapsed );
+
+    void RecordPlotMetrics( const PlotRequest& req, const uint64* startBytesRead, const uint64* startBytesWritten );
+    void WritePlotMetrics( const PlotRequest& req );
+    void WritePlotTrace( const PlotRequest& req );
+
+private:
+    DiskPlotContext      _cx;
+    Config               _cfg;
+    PlotStats            _stats       = {};
+    DiskPlotStatsServer* _statsServer = nullptr;    // Only created with --stats-socket
+    DiskPlotRelocator*   _relocator   = nullptr;    // Only created with --dest
 };
 
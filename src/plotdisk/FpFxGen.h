@@ -39,7 +39,7 @@ struct FpFxGen
             GetThreadOffsets( self, entryCount, count, offset, end );
 
             ComputeFx( count, pairs+offset, yIn, metaIn, yOut+offset, metaOut+offset, self->_jobId );
-        });
+        }, "FpFxGen::ComputeFx" );
     }
 
     //-----------------------------------------------------------
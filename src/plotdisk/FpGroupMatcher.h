@@ -136,7 +136,7 @@ struct FpGroupMatcher
                 if( self->IsLastThread()  )
                     SaveCrossBucketInfo( *crossBucketInfo, groupIndices + groupCount - 2, yEntries, meta );
             #endif
-        });
+        }, "FpGroupMatcher::Match" );
 
         const uint64* allMatches = _matchCounts;
         uint64 matchCount = 0;
@@ -145,13 +145,11 @@ public:
                 const uint64* mapToWriteEndPass1 = mapToWrite + std::min( counts[i], 2u ); 
                 ASSERT( counts[i] > 2 );
 
-                while( mapToWrite < mapToWriteEndPass1 )
-                    writer.Write( *mapToWrite++, bitSize );
+                writer.WriteValues<bitSize>( mapToWrite, (int64)( mapToWriteEndPass1 - mapToWrite ) );
 
                 self->SyncThreads();
 
-                while( mapToWrite < mapToWriteEnd )
-                    writer.Write( *mapToWrite++, bitSize );
+                writer.WriteValues<bitSize>( mapToWriteEndPass1, (int64)( mapToWriteEnd - mapToWriteEndPass1 ) );
             }
 
             // Write the overflow bucket and then write to disk
@@ -171,8 +169,7 @@ public:
 
                         const uint64* mapToWrite  = outMapBuckets + writeOffset;
                         const uint64* mapWriteEnd = mapToWrite + overflowCount;
-                        while( mapToWrite < mapWriteEnd )
-                            writer.Write( *mapToWrite++, bitSize );
+                        writer.WriteValues<bitSize>( mapToWrite, (int64)( mapWriteEnd - mapToWrite ) );
                     }
                 }
 
@@ -281,13 +278,11 @@ public:
             const uint64* mapToWriteEndPass1 = mapToWrite + std::min( counts[i], 2u ); 
             ASSERT( counts[i] > 2 );
 
-            while( mapToWrite < mapToWriteEndPass1 )
-                writer.Write( *mapToWrite++, bitSize );
+            writer.WriteValues<bitSize>( mapToWrite, (int64)( mapToWriteEndPass1 - mapToWrite ) );
 
             self->SyncThreads();
 
-            while( mapToWrite < mapToWriteEnd )
-                writer.Write( *mapToWrite++, bitSize );
+            writer.WriteValues<bitSize>( mapToWriteEndPass1, (int64)( mapToWriteEnd - mapToWriteEndPass1 ) );
         }
 
         // Write the overflow bucket and then write to disk
@@ -308,8 +303,7 @@ public:
 
                     const uint64* mapToWrite  = mapOut.Ptr() + writeOffset;
                     const uint64* mapWriteEnd = mapToWrite + overflowCount;
-                    while( mapToWrite < mapWriteEnd )
-                        writer.Write( *mapToWrite++, bitSize );
+                    writer.WriteValues<bitSize>( mapToWrite, (int64)( mapWriteEnd - mapToWrite ) );
                 }
             }
 
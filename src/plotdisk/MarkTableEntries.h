@@ -0,0 +1,78 @@
+#pragma once
+#include "plotting/PlotTypes.h"
+#include "plotting/Tables.h"
+#include "util/BitField.h"
+
+// How many entries ahead to prefetch the R table marks when marking.
+// The marks are looked up at random through the map, so marking is bound by memory latency.
+#define BB_DP_P2_MARK_PREFETCH_DISTANCE 32
+
+/// Phase 2 marking kernels: Mark the L table entries referenced by the pairs of the marked R table entries.
+/// All table 7 entries are considered marked.
+
+//-----------------------------------------------------------
+// Plain bit sets: Threads marking the same L table must not touch the same fields at the same time.
+// The caller splits the ranges of each thread in 2 halves, and marks them with a barrier in between.
+template<TableId table>
+inline void MarkTableEntries( int64 i, const int64 entryCount, BitField lTable, const BitField rTable,
+                              uint64 lTableOffset, const Pair* pairs, const uint64* map )
+{
+    for( const int64 end = i + entryCount ; i < end; i++ )
+    {
+        if constexpr ( table < TableId::Table7 )
+        {
+            const uint64 rTableIdx = map[i];
+            if( !rTable.Get( rTableIdx ) )
+                continue;
+        }
+
+        const Pair&  pair  = pairs[i];
+        const uint64 left  = lTableOffset + pair.left;
+        const uint64 right = lTableOffset + pair.right;
+
+        lTable.Set( left  );
+        lTable.Set( right );
+    }
+}
+
+//-----------------------------------------------------------
+// Single pass with atomic bit sets: Any ranges may be marked concurrently.
+template<TableId table>
+inline void MarkTableEntriesAtomic( int64 i, const int64 entryCount, BitField lTable, const BitField rTable,
+                                    const uint64 lTableOffset, const Pair* pairs, const uint64* map )
+{
+    const int64 end = i + entryCount;
+
+    if constexpr ( table < TableId::Table7 )
+    {
+        const int64 prefetchEnd = std::max( i, end - BB_DP_P2_MARK_PREFETCH_DISTANCE );
+
+        for( ; i < prefetchEnd; i++ )
+        {
+            rTable.Prefetch( map[i + BB_DP_P2_MARK_PREFETCH_DISTANCE] );
+
+            if( !rTable.Get( map[i] ) )
+                continue;
+
+            lTable.SetAtomic( lTableOffset + pairs[i].left  );
+            lTable.SetAtomic( lTableOffset + pairs[i].right );
+        }
+
+        for( ; i < end; i++ )
+        {
+            if( !rTable.Get( map[i] ) )
+                continue;
+
+            lTable.SetAtomic( lTableOffset + pairs[i].left  );
+            lTable.SetAtomic( lTableOffset + pairs[i].right );
+        }
+    }
+    else
+    {
+        for( ; i < end; i++ )
+        {
+            lTable.SetAtomic( lTableOffset + pairs[i].left  );
+            lTable.SetAtomic( lTableOffset + pairs[i].right );
+        }
+    }
+}
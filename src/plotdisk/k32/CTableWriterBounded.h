@@ -38,12 +38,6 @@ public:
     {
         auto& context = _context;
 
-        // #TODO: Make the whole thing parallel?
-        uint32 c1NextCheckpoint = 0;  // How many C1 entries to skip until the next checkpoint. If there's any entries here, it means the last bucket wrote a
-        uint32 c2NextCheckpoint = 0;  // checkpoint entry and still had entries which did not reach the next checkpoint.
-                                        // Ex. Last bucket had 10005 entries, so it wrote a checkpoint at 0 and 10000, then it counted 5 more entries, so
-                                        // the next checkpoint would be after 9995 entries.
-
         // These buffers are small enough on k32 (around 1.6MiB for C1, C2 is negligible), we keep the whole thing in memory,
         // while we write C3 to the actual file
         const uint32 c1Interval       = kCheckpoint1Interval;
@@ -92,10 +86,11 @@ public:
         LoadBucket( 0 );
 
         uint32* c1Writer = c1Buffer.Ptr();
-        uint32* c2Writer = c2Buffer.Ptr();
 
         for( uint32 bucket = 0; bucket < _numBuckets; bucket++ )
         {
+            context.progress.SetBucket( bucket );
+
             // Load next bucket in the background
             LoadBucket( bucket + 1 );
 
@@ -117,41 +112,8 @@ public:
 
             /// Now handle f7 and write them into C tables
             /// We will set the addersses to these tables accordingly.
-            
-            // Write C1
-            {
-                ASSERT( bucketLength > c1NextCheckpoint );
-
-                // #TODO: Do C1 multi-threaded? For now jsut single-thread it...
-                for( uint32 i = c1NextCheckpoint; i < bucketLength; i += c1Interval )
-                    *c1Writer++ = Swap32( f7[i] );
-                
-                // Track how many entries we covered in the last checkpoint region
-                const uint32 c1Length          = bucketLength - c1NextCheckpoint;
-                const uint32 c1CheckPointCount = CDiv( c1Length, (int)c1Interval );
-
-                c1NextCheckpoint = c1CheckPointCount * c1Interval - c1Length;
-            }
-
-            // Write C2
-            {
-                // C2 has so few entries on k=32 that there's no sense in doing it multi-threaded
-                if( c2NextCheckpoint >= bucketLength )
-                    c2NextCheckpoint -= bucketLength;   // No entries to write in this bucket
-                else
-                {
-                    for( uint32 i = c2NextCheckpoint; i < bucketLength; i += c2Interval )
-                        *c2Writer++ = Swap32( f7[i] );
-                
-                    // Track how many entries we covered in the last checkpoint region
-                    const uint32 c2Length          = bucketLength - c2NextCheckpoint;
-                    const uint32 c2CheckPointCount = CDiv( c2Length, (int)c2Interval );
-
-                    c2NextCheckpoint = c2CheckPointCount * c2Interval - c2Length;
-                }
-            }
 
-            // Write C3
+            // Write C1 and C3
             {
                 const bool isLastBucket = bucket == _numBuckets-1;
 
@@ -185,13 +147,16 @@ public:
                 uint32 parkCount       = c3BucketLength / kCheckpoint1Interval;
                 uint32 overflowEntries = c3BucketLength - ( parkCount * kCheckpoint1Interval );
 
-                // Greater than 1 because the first entry is excluded as it is written in C1 instead.
-                if( isLastBucket && overflowEntries > 1 )
+                if( isLastBucket )
                 {
-                    overflowEntries = 0;
-                    parkCount++;
+                    // Greater than 1 because the first entry is excluded as it is written in C1 instead.
+                    // A single trailing entry still gets a C1 entry, but no C3 park.
+                    if( overflowEntries > 1 )
+                        parkCount++;
+                    else if( overflowEntries )
+                        c1Writer[parkCount] = Swap32( c3F7[c3BucketLength-1] );
                 }
-                else if( overflowEntries && !isLastBucket )
+                else if( overflowEntries )
                 {
                     // Save any entries that don't fill-up a full park for the next bucket
                     memcpy( c3ParkOverflow, c3F7 + c3BucketLength - overflowEntries, overflowEntries * sizeof( uint32 ) );
@@ -203,13 +168,12 @@ public:
                 const size_t c3BufferSize = CalculateC3Size() * parkCount;
                       byte*  c3Buffer     = GetWriteBuffer( bucket );
 
-                // #NOTE: This function uses re-writes our f7 buffer, so ensure it is done after
+                // #NOTE: This re-writes our f7 buffer, so ensure it is done after
                 //        that buffer is no longer needed.
-                const size_t sizeWritten = TableWriter::WriteC3Parallel<BB_DP_MAX_JOBS>( *_context.threadPool, 
-                                                _threadCount, c3BucketLength, c3F7, c3Buffer );
-                ASSERT( sizeWritten == c3BufferSize );
+                WriteC1C3Parks( parkCount, c3BucketLength, c3F7, c1Writer, c3Buffer );
 
-                c3TableSizeBytes += sizeWritten;
+                c1Writer         += parkCount + ( isLastBucket && overflowEntries == 1 ? 1 : 0 );
+                c3TableSizeBytes += c3BufferSize;
 
                 // Write the C3 table to the plot file directly
                 _ioQueue.WriteFile( FileId::PLOT, 0, c3Buffer, c3BufferSize );
@@ -221,6 +185,13 @@ public:
         // Seek back to the begining of the C1 table and
         // write C1 and C2 buffers to file, then seek back to the end of the C3 table
 
+        ASSERT( c1Writer == c1Buffer.Ptr() + c1TotalEntries - 1 );
+
+        // C2 entries are every kCheckpoint2Interval'th C1 entry.
+        // C2 has so few entries on k=32 that there's no sense in doing it multi-threaded.
+        for( uint32 i = 0; i < c2TotalEntries-1; i++ )
+            c2Buffer[i] = c1Buffer[i * kCheckpoint2Interval];
+
         c1Buffer[c1TotalEntries-1] = 0;          // Chiapos adds a trailing 0
         c2Buffer[c2TotalEntries-1] = 0xFFFFFFFF; // C2 overflow protection      // #TODO: Remove?
 
@@ -290,6 +261,40 @@ private:
         _f7WriteBuffer[1] = allocator.CAllocSpan<uint32>( _entriesPerBucket, blockSize );
     }
 
+    //-----------------------------------------------------------
+    // Encode the C3 parks of a bucket, and write their C1 entry, which is the first f7 of each park,
+    // in a single parallel pass. The last park may be partial on the last bucket.
+    void WriteC1C3Parks( const uint32 parkCount, const uint32 c3Length, uint32* c3F7, uint32* c1Writer, byte* c3Buffer )
+    {
+        if( parkCount == 0 )
+            return;
+
+        const uint32 threadCount = std::min( _threadCount, parkCount );
+
+        AnonMTJob::Run( *_context.threadPool, threadCount, [=]( AnonMTJob* self ) {
+
+            const size_t c3Size = CalculateC3Size();
+
+            uint32 count, offset, end;
+            GetThreadOffsets( self, parkCount, count, offset, end );
+
+            // Save the C1 entries first, as encoding the parks re-writes the f7 buffer
+            for( uint32 i = offset; i < end; i++ )
+                c1Writer[i] = Swap32( c3F7[(size_t)i * kCheckpoint1Interval] );
+
+            // Only the last park of the last bucket may be partial
+            const uint32 lastParkLength = c3Length - ( parkCount - 1 ) * kCheckpoint1Interval;
+            const uint32 fullParkEnd    = lastParkLength < kCheckpoint1Interval ? std::min( end, parkCount - 1 ) : end;
+
+            TableWriter::WriteC3Parks( fullParkEnd - offset, c3F7 + (size_t)offset * kCheckpoint1Interval,
+                                       c3Buffer + offset * c3Size );
+
+            if( fullParkEnd < end )
+                TableWriter::WriteC3Park( lastParkLength-1, c3F7 + (size_t)fullParkEnd * kCheckpoint1Interval,
+                                          c3Buffer + fullParkEnd * c3Size );
+        }, "CTableWriterBounded::WriteC1C3Parks" );
+    }
+
     //-----------------------------------------------------------
     void WriteMap( const uint32 bucket, Span<uint32> indices, Span<uint64> mapBuffer )
     {
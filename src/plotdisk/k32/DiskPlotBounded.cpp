@@ -5,8 +5,10 @@
 #include "plotdisk/DiskPlotContext.h"
 #include "plotdisk/DiskPlotConfig.h"
 #include "plotdisk/DiskBufferQueue.h"
+#include "plotdisk/DiskCachePlanner.h"
 #include "CTableWriterBounded.h"
 #include "plotting/PlotTools.h"
+#include "plotting/PlotMetrics.h"
 
 #include "F1Bounded.inl"
 #include "FxBounded.inl"
@@ -50,34 +52,53 @@ K32BoundedPhase1::K32BoundedPhase1( DiskPlotContext& context )
 
         opts |= FileSetOptions::UseTemp2;
 
-        size_t metaCacheSize = 0;
+        DiskCachePlanner cachePlan( context.tmp2BlockSize );
 
         if( context.cache )
         {
             // In fully interleaved mode (bigger writes chunks), we need 192GiB for k=32
             // In alternating mode, we need 96 GiB (around 99GiB if we account for disk block-alignment requirements).
+            // With less than that, let the planner decide which files benefit the most from being in memory.
             
             opts |= FileSetOptions::Cachable;
             data.cache = context.cache;
 
-            // Proportion out the size required per file:
-            //  A single y or index file requires at maximum 16GiB
-            //  A asingle meta file at its maximum will require 64GiB
-            // Divide the whole cache into 12 (6 for alternating mode) equal parts, where each meta file represent 4 parts.
-            // Ex: 192 / 12 = 16.  This gives us 4 files of 16GiB and 2 files of 64GiB
-            size_t singleFileCacheSize = context.cacheSize / ( context.cfg->alternateBuckets ? 6 : 12 );
+            // Each table writes its y, index (tables 2-7) and metadata (tables 1-6)
+            // to the file set of its parity, and the next table reads them back.
+            // In alternating mode all tables use the same file set.
+            const uint64 tableEntries = 1ull << _K;
+            const size_t metaSizes[]  = { 
+                sizeof( K32MetaType<TableId::Table1>::Out ), sizeof( K32MetaType<TableId::Table2>::Out ),
+                sizeof( K32MetaType<TableId::Table3>::Out ), sizeof( K32MetaType<TableId::Table4>::Out ),
+                sizeof( K32MetaType<TableId::Table5>::Out ), sizeof( K32MetaType<TableId::Table6>::Out )
+            };
+
+            const char* yNames   [2] = { "y0"    , "y1"     };
+            const char* idxNames [2] = { "index0", "index1" };
+            const char* metaNames[2] = { "meta0" , "meta1"  };
+
+            for( TableId table = TableId::Table1; table <= TableId::Table7; table++ )
+            {
+                const int set = context.cfg->alternateBuckets ? 0 : ( (int)table & 1 );
 
-            // Align to block size
-            singleFileCacheSize = numBuckets * RoundUpToNextBoundaryT( singleFileCacheSize / numBuckets - context.tmp2BlockSize, context.tmp2BlockSize );
+                cachePlan.AddUse( FileId::FX0 + set, yNames[set], numBuckets, tableEntries * sizeof( uint32 ) );
 
-            data.cacheSize = singleFileCacheSize;
-            metaCacheSize  = data.cacheSize * 4;     // Meta needs 4 times as much as y and index
+                if( table > TableId::Table1 )
+                    cachePlan.AddUse( FileId::INDEX0 + set, idxNames[set], numBuckets, tableEntries * sizeof( uint32 ) );
+                
+                if( table < TableId::Table7 )
+                    cachePlan.AddUse( FileId::META0 + set, metaNames[set], numBuckets, tableEntries * metaSizes[(int)table] );
+            }
 
-            ASSERT( data.cacheSize && metaCacheSize );
+            cachePlan.Plan( context.cacheSize );
+
+            Log::Line( "Phase 1 cache placement:" );
+            cachePlan.LogPlan();
         }
 
-        auto InitCachableFileSet = [=]( FileId fileId, const char* fileName, uint32 numBuckets, FileSetOptions opts, FileSetInitData& data ) {
+        auto InitCachableFileSet = [&]( FileId fileId, const char* fileName, uint32 numBuckets, FileSetOptions opts, FileSetInitData& data ) {
                 
+            data.cacheSize = cachePlan.CacheSize( fileId );
             _ioQueue.InitFileSet( fileId, fileName, numBuckets, opts, &data );
             data.cache = (byte*)data.cache + data.cacheSize;
         };
@@ -100,7 +121,6 @@ K32BoundedPhase1::K32BoundedPhase1( DiskPlotContext& context )
             InitCachableFileSet( FileId::INDEX0, "index0", numBuckets, opts, data );
 
             data.maxSliceSize = sliceSizeMeta;
-            data.cacheSize        = metaCacheSize;
             InitCachableFileSet( FileId::META0, "meta0", numBuckets, opts, data );
         }
         else
@@ -109,8 +129,6 @@ K32BoundedPhase1::K32BoundedPhase1( DiskPlotContext& context )
             InitCachableFileSet( FileId::FX1   , "y1"    , numBuckets, opts, data );
             InitCachableFileSet( FileId::INDEX0, "index0", numBuckets, opts, data );
             InitCachableFileSet( FileId::INDEX1, "index1", numBuckets, opts, data );
-
-            data.cacheSize = metaCacheSize;
             InitCachableFileSet( FileId::META0, "meta0", numBuckets, opts, data );
             InitCachableFileSet( FileId::META1, "meta1", numBuckets, opts, data );
         }
@@ -198,7 +216,16 @@ void K32BoundedPhase1::RunWithBuckets()
         }
     }
     #else
-        RunF1<_numBuckets>();
+        if( _context.resumeStage >= DiskPlotStage::P1Table1 )
+        {
+            startTable = TableId::Table2 + (int)( _context.resumeStage - DiskPlotStage::P1Table1 );
+            Log::Line( "Resuming Phase 1 at table %u.", startTable+1 );
+        }
+        else
+        {
+            RunF1<_numBuckets>();
+            _context.checkpoint->Save( DiskPlotStage::P1Table1 );
+        }
     #endif
 
     #if BB_DP_FP_MATCH_X_BUCKET
@@ -249,6 +276,8 @@ void K32BoundedPhase1::RunWithBuckets()
                 _ioQueue.CommitCommands();
             }
         #endif
+
+        _context.checkpoint->Save( P1TableToStage( table ) );
     }
 #endif
 
@@ -258,13 +287,21 @@ void K32BoundedPhase1::RunWithBuckets()
 
         Log::Line( "Sorting F7 & Writing C Tables" );
         auto timer = TimerBegin();
+
+        // The C tables are processed as an 8th pass over table 7
+        _context.progress.BeginTable( TableId::Table7, 7, _context.entryCounts[(int)TableId::Table7] );
         CTableWriterBounded<_numBuckets> cWriter( _context );
 
         cWriter.Run( _allocator );
 
-        Log::Line( "Completed F7 tables in %.2lf seconds.", TimerEnd( timer ) );
+        const double elapsed = TimerEnd( timer );
+        Log::Line( "Completed F7 tables in %.2lf seconds.", elapsed );
         Log::Line( "F7/C Tables I/O wait time: %.2lf seconds.",  TicksToSeconds( cWriter.IOWait() ) );
-        _context.ioWaitTime += cWriter.IOWait();
+        DiskPlotProgress::Add( _context.ioWaitTime, cWriter.IOWait() );
+
+        PlotMetrics::SetF64( elapsed, "tables.p1.c.elapsed" );
+        PlotMetrics::SetF64( TicksToSeconds( cWriter.IOWait() ), "tables.p1.c.io_wait" );
+        PlotMetrics::MaxU64( _allocator.HighWater(), "heap.p1_high_water" );
     }
 
      #if !BB_DP_P1_KEEP_FILES
@@ -279,11 +316,13 @@ void K32BoundedPhase1::RunWithBuckets()
 template<uint32 _numBuckets>
 void K32BoundedPhase1::RunF1()
 {
-    _context.ioWaitTime = Duration::zero();
+    DiskPlotProgress::Set( _context.ioWaitTime, Duration::zero() );
 
     Log::Line( "Table 1: F1 generation" );
     Log::Line( "Generating f1..." );
 
+    _context.progress.BeginTable( TableId::Table1, 0, 1ull << _K );
+
     const auto timer = TimerBegin();
     StackAllocator allocator( _context.heapBuffer, _context.heapSize );
     K32BoundedF1<_numBuckets> f1( _context, allocator );
@@ -291,9 +330,13 @@ void K32BoundedPhase1::RunF1()
     const double elapsed = TimerEnd( timer );
 
     Log::Line( "Finished f1 generation in %.2lf seconds. ", elapsed );
-    Log::Line( "Table 1 I/O wait time: %.2lf seconds.", _context.p1TableWaitTime[(int)TableId::Table1] );
+    Log::Line( "Table 1 I/O wait time: %.2lf seconds.", TicksToSeconds( _context.p1TableWaitTime[(int)TableId::Table1] ) );
+
+    PlotMetrics::SetF64( elapsed, "tables.p1.t1.elapsed" );
+    PlotMetrics::SetU64( _context.entryCounts[(int)TableId::Table1], "tables.p1.t1.entries" );
+    PlotMetrics::MaxU64( allocator.HighWater(), "heap.p1_high_water" );
     
-    _context.ioWaitTime += _context.p1TableWaitTime[(int)TableId::Table1];
+    DiskPlotProgress::Add( _context.ioWaitTime, _context.p1TableWaitTime[(int)TableId::Table1] );
     _context.ioQueue->DumpWriteMetrics( TableId::Table1 );
 }
 
@@ -304,6 +347,8 @@ void K32BoundedPhase1::RunFx()
     Log::Line( "Table %u", table+1 );
     auto timer = TimerBegin();
 
+    _context.progress.BeginTable( table, (uint32)table, _context.entryCounts[(int)table-1] );
+
     #if BB_DP_FP_MATCH_X_BUCKET
         _allocator.PopToMarker( _xBucketStackMarker );
         
@@ -332,12 +377,17 @@ void K32BoundedPhase1::RunFx()
         #endif
     );
 
-    Log::Line( "Completed table %u in %.2lf seconds with %.llu entries.", table+1, TimerEnd( timer ), _context.entryCounts[(int)table] );
+    const double elapsed = TimerEnd( timer );
+    Log::Line( "Completed table %u in %.2lf seconds with %.llu entries.", table+1, elapsed, _context.entryCounts[(int)table] );
     Log::Line( "Table %u I/O wait time: %.2lf seconds.",  table+1, TicksToSeconds( fx._tableIOWait ) );
+
+    PlotMetrics::SetF64( elapsed, "tables.p1.t%u.elapsed", (uint32)table+1 );
+    PlotMetrics::SetU64( _context.entryCounts[(int)table], "tables.p1.t%u.entries", (uint32)table+1 );
+    PlotMetrics::MaxU64( _allocator.HighWater(), "heap.p1_high_water" );
     
     _context.ioQueue->DumpDiskMetrics( table );
     _context.p1TableWaitTime[(int)table] = fx._tableIOWait;
-    _context.ioWaitTime += fx._tableIOWait;
+    DiskPlotProgress::Add( _context.ioWaitTime, fx._tableIOWait );
 
     #if _DEBUG
         BB_DP_DBG_WriteTableCounts( _context );
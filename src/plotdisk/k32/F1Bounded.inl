@@ -89,6 +89,9 @@ public:
 
             for( uint32 bucket = 0; bucket < _numBuckets; bucket++ )
             {
+                if( self->IsControlThread() )
+                    _context.progress.SetBucket( bucket );
+
                 // Calculate f1 blocks
                 chacha8_get_keystream( &chacha, blockOffset, blockCount, (byte*)blocks.Ptr() );
 
@@ -6,6 +6,7 @@
 #include "plotdisk/MapWriter.h"
 #include "plotdisk/BlockWriter.h"
 #include "util/StackAllocator.h"
+#include "plotting/PlotMetrics.h"
 #include "FpMatchBounded.inl"
 #include "b3/blake3.h"
 
@@ -333,6 +334,11 @@ public:
         Log::Line( " Matching     : Completed in %.2lf seconds.", TicksToSeconds( _matchTime ) );
         Log::Line( " Fx           : Completed in %.2lf seconds.", TicksToSeconds( _fxTime    ) );
 
+        PlotMetrics::SetF64( TicksToSeconds( _sortTime       ), "tables.p1.t%u.sort"      , (uint32)rTable+1 );
+        PlotMetrics::SetF64( TicksToSeconds( _distributeTime ), "tables.p1.t%u.distribute", (uint32)rTable+1 );
+        PlotMetrics::SetF64( TicksToSeconds( _matchTime      ), "tables.p1.t%u.match"     , (uint32)rTable+1 );
+        PlotMetrics::SetF64( TicksToSeconds( _fxTime         ), "tables.p1.t%u.fx"        , (uint32)rTable+1 );
+
         // Ensure all I/O has completed
         _fxWriteFence.Wait( _numBuckets, _tableIOWait );
         _context.fencePool->RestoreAllFences();
@@ -372,6 +378,9 @@ private:
 
         for( uint32 bucket = 0; bucket < _numBuckets; bucket++ )
         {
+            if( self->IsControlThread() )
+                _context.progress.SetBucket( bucket );
+
             ReadNextBucket( self, bucket + 1 ); // Read next bucket in background
             WaitForFence( self, _yReadFence, bucket );
 
@@ -831,13 +840,17 @@ private:
         const Pair* pair = pairs.Ptr();
         const Pair* end  = pair + pairs.Length();
 
+        BitPacker packer( writer );
+
         while( pair < end )
         {
             ASSERT( pair->right - pair->left < _pairsMaxDelta );
 
-            writer.Write( ( (uint64)(pair->right - pair->left) << shift ) | ( pair->left & mask ), _pairBitSize );
+            packer.Write<_pairBitSize>( ( (uint64)(pair->right - pair->left) << shift ) | ( pair->left & mask ) );
             pair++;
         }
+
+        packer.Flush();
     }
 
     //-----------------------------------------------------------
@@ -1,11 +1,11 @@
 #pragma once
 #include "plotting/CTables.h"
+#include "plotting/ParkEncoder.h"
 #include "ChiaConsts.h"
 #include "threading/ThreadPool.h"
 
 struct WriteParkJob
 {
-    size_t  parkSize;       // #TODO: This should be a compile-time constant?
     uint64  parkCount;      // How many parks to write
     uint64* linePoints;     // Sorted line points to write to the park
     byte*   parkBuffer;     // Buffer into which the parks will be written
@@ -48,7 +48,6 @@ inline size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoi
     {
         auto& job = jobs[i];
 
-        job.parkSize   = parkSize;
         job.parkCount  = parksPerThread;
         job.linePoints = threadLinePoints;
         job.parkBuffer = threadParkBuffer;
@@ -241,19 +240,7 @@ inline void WritePark( const size_t parkSize, const uint64 count, uint64* linePo
 //-----------------------------------------------------------
 inline void WriteParkThread( WriteParkJob* job )
 {
-    const size_t  parkSize  = job->parkSize;
-    const uint64  parkCount = job->parkCount;
-    const TableId tableId   = job->tableId;
-
-    uint64* linePoints = job->linePoints;
-    byte*   parkBuffer = job->parkBuffer;
-
-    for( uint64 i = 0; i < parkCount; i++ )
-    {
-        WritePark( parkSize, kEntriesPerPark, linePoints, parkBuffer, tableId );
-        
-        linePoints += kEntriesPerPark;
-        parkBuffer += parkSize;
-    }
+    ParkEncoder encoder( job->tableId );
+    encoder.WriteParks( job->parkCount, job->linePoints, job->parkBuffer );
 }
 
@@ -0,0 +1,276 @@
+#pragma once
+#include "ChiaConsts.h"
+#include "plotting/CTables.h"
+
+#ifndef FSE_STATIC_LINKING_ONLY
+    #define FSE_STATIC_LINKING_ONLY
+#endif
+#include "fse/fse.h"
+
+// Number of parks encoded at once by ParkEncoder and TableWriter::WriteC3Parks
+#define BB_PARK_ENCODER_LANES 4
+
+//-----------------------------------------------------------
+// Same as FSE_compress_usingCTable(), but compresses several inputs of the same size at once.
+// The encoding of each input depends on the state of the previous symbol, so a single stream is bound by
+// the latency of its table lookups. Interleaving independent streams lets their lookups overlap.
+// The output of each stream is identical to FSE_compress_usingCTable() for the same destination capacity.
+// Each destination is written up to 7 bytes past its compressed size, as with FSE_compress_usingCTable().
+template<uint32 lanes>
+inline void FSECompressInterleaved( byte* const* dst, const size_t dstCapacity, const byte* const* src, const size_t srcSize,
+                                    const FSE_CTable* ct, size_t* outSizes );
+
+template<uint32 lanes, bool fast>
+inline void FSECompressInterleavedT( byte* const* dst, const size_t dstCapacity, const byte* const* src, const size_t srcSize,
+                                     const FSE_CTable* ct, size_t* outSizes );
+
+/**
+ * Encodes line point parks with the same output as WritePark, BB_PARK_ENCODER_LANES parks at a time,
+ * interleaving their FSE streams.
+ * Keep one per thread: It holds the small deltas of the parks being encoded,
+ * so unlike WritePark, the line points are not modified.
+ */
+class ParkEncoder
+{
+public:
+    inline ParkEncoder( const TableId tableId )
+        : _tableId ( tableId )
+        , _parkSize( CalculateParkSize( tableId ) )
+    {}
+
+    // Write parkCount consecutive full parks of kEntriesPerPark line points each
+    inline void WriteParks( const uint64 parkCount, const uint64* linePoints, byte* parkBuffer )
+    {
+        uint64 i = 0;
+        for( ; i + BB_PARK_ENCODER_LANES <= parkCount; i += BB_PARK_ENCODER_LANES )
+            EncodeParks<BB_PARK_ENCODER_LANES>( kEntriesPerPark, linePoints + i * kEntriesPerPark, parkBuffer + i * _parkSize );
+
+        for( ; i < parkCount; i++ )
+            EncodeParks<1>( kEntriesPerPark, linePoints + i * kEntriesPerPark, parkBuffer + i * _parkSize );
+    }
+
+    // Write a single park of up to kEntriesPerPark line points
+    inline void WritePark( const uint64 count, const uint64* linePoints, byte* parkBuffer )
+    {
+        EncodeParks<1>( count, linePoints, parkBuffer );
+    }
+
+    inline size_t ParkSize() const { return _parkSize; }
+
+private:
+    template<uint32 lanes>
+    inline void EncodeParks( const uint64 count, const uint64* linePoints, byte* parkBuffer );
+
+private:
+    TableId _tableId;
+    size_t  _parkSize;
+    byte    _smallDeltas[BB_PARK_ENCODER_LANES][kEntriesPerPark];
+};
+
+//-----------------------------------------------------------
+template<uint32 lanes>
+inline void ParkEncoder::EncodeParks( const uint64 count, const uint64* linePoints, byte* parkBuffer )
+{
+    static_assert( lanes <= BB_PARK_ENCODER_LANES );
+    ASSERT( count > 0 && count <= kEntriesPerPark );
+
+    constexpr uint64 stubBitSize      = (_K - kStubMinusBits);
+    constexpr uint64 stubMask         = ((1ULL << stubBitSize) - 1);
+    constexpr size_t lpSize           = sizeof( uint64 );
+    constexpr size_t stubSectionBytes = CDiv( (kEntriesPerPark - 1) * stubBitSize, 8 );
+    static_assert( stubBitSize + 7 <= 64 );
+
+    const size_t stubUsedBytes = CDiv( (count - 1) * stubBitSize, 8 );
+    const size_t deltaCount    = count - 1;
+
+    byte*       parks     [lanes];
+    byte*       deltaDst  [lanes];
+    const byte* deltaSrc  [lanes];
+    size_t      deltaSizes[lanes];
+
+    // Write stubs and gather the small deltas
+    for( uint32 lane = 0; lane < lanes; lane++ )
+    {
+        const uint64* lps  = linePoints + lane * kEntriesPerPark;
+        byte*         park = parkBuffer + lane * _parkSize;
+        byte*         smallDeltas = _smallDeltas[lane];
+
+        parks   [lane] = park;
+        deltaDst[lane] = park + lpSize + stubSectionBytes + 2;
+        deltaSrc[lane] = smallDeltas;
+
+        // Stubs are packed from the most significant bits of big-endian 64-bit fields.
+        // Instead of branching at field boundaries, always store the pending bits
+        // and advance by the whole bytes written.
+        byte*  stubWriter = park + lpSize;
+        uint64 field      = 0;      // Pending bits, left-aligned
+        uint64 bits       = 0;      // Pending bit count, < 8 between stubs
+
+        uint64 prevLinePoint = lps[0];
+
+        for( uint64 i = 1; i < count; i++ )
+        {
+            const uint64 linePoint = lps[i];
+            const uint64 lpDelta   = linePoint - prevLinePoint;
+            prevLinePoint = linePoint;
+
+            field |= ( lpDelta & stubMask ) << ( 64 - stubBitSize - bits );
+            bits  += stubBitSize;
+
+            const uint64 fieldBE = Swap64( field );
+            memcpy( stubWriter, &fieldBE, sizeof( fieldBE ) );
+
+            const uint64 bytesWritten = bits >> 3;
+            stubWriter += bytesWritten;
+            field     <<= bytesWritten * 8;
+            bits       &= 7;
+
+            smallDeltas[i-1] = (byte)( lpDelta >> stubBitSize );
+        }
+
+        // Zero-out any remaining unused bytes
+        memset( park + lpSize + stubUsedBytes, 0, stubSectionBytes - stubUsedBytes );
+    }
+
+    // Write small deltas
+    FSECompressInterleaved<lanes>( deltaDst, deltaCount * 8, deltaSrc, deltaCount, CTables[(int)_tableId], deltaSizes );
+
+    for( uint32 lane = 0; lane < lanes; lane++ )
+    {
+        byte*   park            = parks[lane];
+        byte*   deltaWriter     = deltaDst[lane];
+        uint16* deltaSizeWriter = (uint16*)( deltaWriter - 2 );
+        size_t  deltasSize      = deltaSizes[lane];
+
+        if( !deltasSize )
+        {
+            // Deltas were NOT compressed, we have to copy them raw
+            deltasSize = deltaCount;
+            *deltaSizeWriter = (uint16)(deltasSize | 0x8000);
+            memcpy( deltaWriter, _smallDeltas[lane], deltaCount );
+        }
+        else
+        {
+            // Deltas were compressed
+            *deltaSizeWriter = (uint16)deltasSize;
+        }
+
+        deltaWriter += deltasSize;
+
+        const size_t parkSizeWritten = (size_t)( deltaWriter - park );
+
+        if( parkSizeWritten > _parkSize )
+            Fatal( "Overran park buffer for table %d.", (int)_tableId + 1 );
+
+        // Zero-out any remaining bytes in the deltas section
+        memset( deltaWriter, 0, _parkSize - parkSizeWritten );
+
+        // Write the first line point as a full line point.
+        // Written last, as the FSE stream of the previous park may write a few bytes past its end.
+        const uint64 firstLinePoint = Swap64( linePoints[lane * kEntriesPerPark] );
+        memcpy( park, &firstLinePoint, sizeof( firstLinePoint ) );
+    }
+}
+
+//-----------------------------------------------------------
+template<uint32 lanes>
+inline void FSECompressInterleaved( byte* const* dst, const size_t dstCapacity, const byte* const* src, const size_t srcSize,
+                                    const FSE_CTable* ct, size_t* outSizes )
+{
+    if( dstCapacity >= FSE_BLOCKBOUND( srcSize ) )
+        FSECompressInterleavedT<lanes, true>( dst, dstCapacity, src, srcSize, ct, outSizes );
+    else
+        FSECompressInterleavedT<lanes, false>( dst, dstCapacity, src, srcSize, ct, outSizes );
+}
+
+//-----------------------------------------------------------
+// Follows FSE_compress_usingCTable_generic() in fse_compress.c step by step, for each stream.
+template<uint32 lanes, bool fast>
+inline void FSECompressInterleavedT( byte* const* dst, const size_t dstCapacity, const byte* const* src, const size_t srcSize,
+                                     const FSE_CTable* ct, size_t* outSizes )
+{
+    BIT_CStream_t bitC   [lanes];
+    FSE_CState_t  state1 [lanes];
+    FSE_CState_t  state2 [lanes];
+    const byte*   ip     [lanes];
+
+    #define FSEI_FLUSHBITS( s ) ( fast ? BIT_flushBitsFast( s ) : BIT_flushBits( s ) )
+
+    bool initFailed = srcSize <= 2;
+    for( uint32 l = 0; l < lanes && !initFailed; l++ )
+        initFailed = FSE_isError( BIT_initCStream( &bitC[l], dst[l], dstCapacity ) );
+
+    if( initFailed )
+    {
+        for( uint32 l = 0; l < lanes; l++ )
+            outSizes[l] = 0;
+        return;
+    }
+
+    for( uint32 l = 0; l < lanes; l++ )
+        ip[l] = src[l] + srcSize;
+
+    if( srcSize & 1 )
+    {
+        for( uint32 l = 0; l < lanes; l++ )
+        {
+            FSE_initCState2( &state1[l], ct, *--ip[l] );
+            FSE_initCState2( &state2[l], ct, *--ip[l] );
+            FSE_encodeSymbol( &bitC[l], &state1[l], *--ip[l] );
+            FSEI_FLUSHBITS( &bitC[l] );
+        }
+    }
+    else
+    {
+        for( uint32 l = 0; l < lanes; l++ )
+        {
+            FSE_initCState2( &state2[l], ct, *--ip[l] );
+            FSE_initCState2( &state1[l], ct, *--ip[l] );
+        }
+    }
+
+    // Join to mod 4
+    constexpr bool fourPerFlush = sizeof( bitC[0].bitContainer )*8 > FSE_MAX_TABLELOG*4+7;
+    constexpr bool twoPerFlush  = sizeof( bitC[0].bitContainer )*8 < FSE_MAX_TABLELOG*2+7;
+
+    if( fourPerFlush && ( ( srcSize - 2 ) & 2 ) )
+    {
+        for( uint32 l = 0; l < lanes; l++ )
+        {
+            FSE_encodeSymbol( &bitC[l], &state2[l], *--ip[l] );
+            FSE_encodeSymbol( &bitC[l], &state1[l], *--ip[l] );
+            FSEI_FLUSHBITS( &bitC[l] );
+        }
+    }
+
+    // All streams have the same number of symbols left
+    while( ip[0] > src[0] )
+    {
+        for( uint32 l = 0; l < lanes; l++ )
+        {
+            FSE_encodeSymbol( &bitC[l], &state2[l], *--ip[l] );
+
+            if constexpr ( twoPerFlush )
+                FSEI_FLUSHBITS( &bitC[l] );
+
+            FSE_encodeSymbol( &bitC[l], &state1[l], *--ip[l] );
+
+            if constexpr ( fourPerFlush )
+            {
+                FSE_encodeSymbol( &bitC[l], &state2[l], *--ip[l] );
+                FSE_encodeSymbol( &bitC[l], &state1[l], *--ip[l] );
+            }
+
+            FSEI_FLUSHBITS( &bitC[l] );
+        }
+    }
+
+    for( uint32 l = 0; l < lanes; l++ )
+    {
+        FSE_flushCState( &bitC[l], &state2[l] );
+        FSE_flushCState( &bitC[l], &state1[l] );
+        outSizes[l] = BIT_closeCStream( &bitC[l] );
+    }
+
+    #undef FSEI_FLUSHBITS
+}
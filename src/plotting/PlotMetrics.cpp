@@ -0,0 +1,238 @@
+#include "PlotMetrics.h"
+#include "util/Util.h"
+#include <vector>
+
+std::mutex                                 PlotMetrics::_lock;
+std::map<std::string, PlotMetrics::Metric> PlotMetrics::_metrics;
+
+static void WriteIndent( FILE* file, size_t depth );
+
+//-----------------------------------------------------------
+void PlotMetrics::Clear()
+{
+    std::lock_guard<std::mutex> lock( _lock );
+    _metrics.clear();
+}
+
+//-----------------------------------------------------------
+PlotMetrics::Metric& PlotMetrics::GetMetric( const Type type, const char* name, va_list args )
+{
+    char nameBuffer[256];
+    const int len = vsnprintf( nameBuffer, sizeof( nameBuffer ), name, args );
+    ASSERT( len > 0 && len < (int)sizeof( nameBuffer ) );
+    (void)len;
+
+    Metric& metric = _metrics[nameBuffer];
+    metric.type = type;
+
+    return metric;
+}
+
+//-----------------------------------------------------------
+void PlotMetrics::SetF64( const double value, const char* name, ... )
+{
+    std::lock_guard<std::mutex> lock( _lock );
+
+    va_list args;
+    va_start( args, name );
+    GetMetric( Type::F64, name, args ).f64 = value;
+    va_end( args );
+}
+
+//-----------------------------------------------------------
+void PlotMetrics::SetU64( const uint64 value, const char* name, ... )
+{
+    std::lock_guard<std::mutex> lock( _lock );
+
+    va_list args;
+    va_start( args, name );
+    GetMetric( Type::U64, name, args ).u64 = value;
+    va_end( args );
+}
+
+//-----------------------------------------------------------
+void PlotMetrics::SetStr( const char* value, const char* name, ... )
+{
+    ASSERT( value );
+    std::lock_guard<std::mutex> lock( _lock );
+
+    va_list args;
+    va_start( args, name );
+    GetMetric( Type::Str, name, args ).str = value;
+    va_end( args );
+}
+
+//-----------------------------------------------------------
+void PlotMetrics::AddF64( const double value, const char* name, ... )
+{
+    std::lock_guard<std::mutex> lock( _lock );
+
+    va_list args;
+    va_start( args, name );
+    GetMetric( Type::F64, name, args ).f64 += value;
+    va_end( args );
+}
+
+//-----------------------------------------------------------
+void PlotMetrics::AddU64( const uint64 value, const char* name, ... )
+{
+    std::lock_guard<std::mutex> lock( _lock );
+
+    va_list args;
+    va_start( args, name );
+    GetMetric( Type::U64, name, args ).u64 += value;
+    va_end( args );
+}
+
+//-----------------------------------------------------------
+void PlotMetrics::MaxU64( const uint64 value, const char* name, ... )
+{
+    std::lock_guard<std::mutex> lock( _lock );
+
+    va_list args;
+    va_start( args, name );
+    Metric& metric = GetMetric( Type::U64, name, args );
+    metric.u64 = std::max( metric.u64, value );
+    va_end( args );
+}
+
+//-----------------------------------------------------------
+bool PlotMetrics::GetU64( uint64& outValue, const char* name, ... )
+{
+    char nameBuffer[256];
+
+    va_list args;
+    va_start( args, name );
+    const int len = vsnprintf( nameBuffer, sizeof( nameBuffer ), name, args );
+    va_end( args );
+
+    ASSERT( len > 0 && len < (int)sizeof( nameBuffer ) );
+    (void)len;
+
+    std::lock_guard<std::mutex> lock( _lock );
+
+    auto it = _metrics.find( nameBuffer );
+    if( it == _metrics.end() || it->second.type != Type::U64 )
+        return false;
+
+    outValue = it->second.u64;
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotMetrics::WriteJson( const char* path )
+{
+    ASSERT( path );
+    std::lock_guard<std::mutex> lock( _lock );
+
+    FILE* file = fopen( path, "w" );
+    if( !file )
+        return false;
+
+    // Keys are sorted, so all the metrics nested in the same object are contiguous.
+    // Keep track of the objects currently open, and close/open objects as the key path changes.
+    std::vector<std::string> openObjects;
+    std::vector<std::string> keyPath;
+    bool                     firstInObject = true;
+
+    fprintf( file, "{" );
+
+    for( const auto& it : _metrics )
+    {
+        const std::string& name   = it.first;
+        const Metric&      metric = it.second;
+
+        keyPath.clear();
+        for( size_t start = 0; ; )
+        {
+            const size_t end = name.find( '.', start );
+            keyPath.push_back( name.substr( start, end - start ) );
+
+            if( end == std::string::npos )
+                break;
+            start = end + 1;
+        }
+
+        // Close objects that are no longer in the key path
+        size_t common = 0;
+        while( common < openObjects.size() && common + 1 < keyPath.size() && openObjects[common] == keyPath[common] )
+            common++;
+
+        while( openObjects.size() > common )
+        {
+            openObjects.pop_back();
+            fprintf( file, "\n" );
+            WriteIndent( file, openObjects.size() + 1 );
+            fprintf( file, "}" );
+            firstInObject = false;
+        }
+
+        // Open the new objects
+        while( openObjects.size() + 1 < keyPath.size() )
+        {
+            fprintf( file, firstInObject ? "\n" : ",\n" );
+            WriteIndent( file, openObjects.size() + 1 );
+            WriteJsonString( file, keyPath[openObjects.size()].c_str() );
+            fprintf( file, ": {" );
+
+            openObjects.push_back( keyPath[openObjects.size()] );
+            firstInObject = true;
+        }
+
+        fprintf( file, firstInObject ? "\n" : ",\n" );
+        WriteIndent( file, keyPath.size() );
+        WriteJsonString( file, keyPath.back().c_str() );
+        fprintf( file, ": " );
+
+        switch( metric.type )
+        {
+            case Type::F64: fprintf( file, "%.6lf", metric.f64 ); break;
+            case Type::U64: fprintf( file, "%llu", (llu)metric.u64 ); break;
+            case Type::Str: WriteJsonString( file, metric.str.c_str() ); break;
+        }
+
+        firstInObject = false;
+    }
+
+    while( !openObjects.empty() )
+    {
+        openObjects.pop_back();
+        fprintf( file, "\n" );
+        WriteIndent( file, openObjects.size() + 1 );
+        fprintf( file, "}" );
+    }
+
+    fprintf( file, "\n}\n" );
+
+    const bool ok = ferror( file ) == 0;
+    fclose( file );
+
+    return ok;
+}
+
+//-----------------------------------------------------------
+void PlotMetrics::WriteJsonString( FILE* file, const char* str )
+{
+    fputc( '"', file );
+
+    for( ; *str; str++ )
+    {
+        const char c = *str;
+
+        if( c == '"' || c == '\\' )
+            fprintf( file, "\\%c", c );
+        else if( (unsigned char)c < 0x20 )
+            fprintf( file, "\\u%04x", (uint32)(unsigned char)c );
+        else
+            fputc( c, file );
+    }
+
+    fputc( '"', file );
+}
+
+//-----------------------------------------------------------
+void WriteIndent( FILE* file, const size_t depth )
+{
+    for( size_t i = 0; i < depth; i++ )
+        fprintf( file, "  " );
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <mutex>
+#include <map>
+#include <string>
+#include <cstdio>
+
+/**
+ * Registry of the metrics collected while creating a plot, such as phase and table timings,
+ * I/O volumes and memory usage, so that they can be reported in a machine-readable form.
+ *
+ * Metric names are printf-style format strings. Dots in a name nest the metric
+ * into JSON objects: "phases.p1.elapsed" is written as { "phases": { "p1": { "elapsed": ... } } }.
+ * A name must not be used both as a value and as the parent of other metrics.
+ *
+ * All functions are thread-safe.
+ */
+class PlotMetrics
+{
+public:
+    // Removes all metrics. Called at the start of each plot.
+    static void Clear();
+
+    static void SetF64( double      value, const char* name, ... );
+    static void SetU64( uint64      value, const char* name, ... );
+    static void SetStr( const char* value, const char* name, ... );
+
+    // Adds to the current value of the metric, which starts at 0.
+    static void AddF64( double value, const char* name, ... );
+    static void AddU64( uint64 value, const char* name, ... );
+
+    // Keeps the greater of the current value of the metric and the given value.
+    static void MaxU64( uint64 value, const char* name, ... );
+
+    // Outputs the value of an integer metric. Returns false if it has not been recorded.
+    static bool GetU64( uint64& outValue, const char* name, ... );
+
+    // Writes all metrics as a JSON object to the given file path, replacing the file.
+    static bool WriteJson( const char* path );
+
+    // Writes a quoted and escaped JSON string.
+    static void WriteJsonString( FILE* file, const char* str );
+
+private:
+    enum class Type
+    {
+        F64,
+        U64,
+        Str
+    };
+
+    struct Metric
+    {
+        Type        type = Type::U64;
+        double      f64  = 0;
+        uint64      u64  = 0;
+        std::string str;
+    };
+
+    static Metric& GetMetric( Type type, const char* name, va_list args );
+
+private:
+    static std::mutex                    _lock;
+    static std::map<std::string, Metric> _metrics;    // Sorted, so that nested objects are contiguous
+};
@@ -1,5 +1,300 @@
 #include "PlotValidation.h"
-
+#include "plotting/Tables.h"
 #include "pos/chacha8.h"
 #include "b3/blake3.h"
 
+//-----------------------------------------------------------
+bool PlotValidation::ValidateFullProof( const uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64& outF7 )
+{
+    uint64   fx  [PROOF_X_COUNT];
+    MetaBits meta[PROOF_X_COUNT];
+
+    // Convert these x's to f1 values
+    {
+        const uint32 xShift = k - kExtraBits;
+        
+        // Prepare ChaCha key
+        byte key[32] = { 1 };
+        memcpy( key + 1, plotId, 31 );
+
+        chacha8_ctx chacha;
+        chacha8_keysetup( &chacha, key, 256, NULL );
+
+        // Enough to hold 2 cha-cha blocks since a value my span over 2 blocks
+        byte blocks[kF1BlockSize*2];
+
+        for( uint32 i = 0; i < PROOF_X_COUNT; i++ )
+        {
+            const uint64 x        = fullProofXs[i];
+            const uint64 blockIdx = x * k / kF1BlockSizeBits; 
+
+            chacha8_get_keystream( &chacha, blockIdx, 2, blocks );
+
+            // Get the starting and end locations of y in bits relative to our block
+            const uint64 bitStart = x * k - blockIdx * kF1BlockSizeBits;
+
+            CPBitReader hashBits( blocks, sizeof( blocks ) * 8 );
+            hashBits.Seek( bitStart );
+
+            // uint64 y = SliceUInt64FromBits( blocks, bitStart, k ); // #TODO: Figure out what's wrong with this method.
+            uint64 y = hashBits.Read64( k );
+            y = ( y << kExtraBits ) | ( x >> xShift );
+
+            fx  [i] = y;
+            meta[i] = MetaBits( x, k );
+        }
+    }
+
+    // Forward propagate f1 values to get the final f7
+    uint32 iterCount = PROOF_X_COUNT;
+    for( TableId table = TableId::Table2; table <= TableId::Table7; table++, iterCount >>= 1)
+    {
+        for( uint32 i = 0, dst = 0; i < iterCount; i+= 2, dst++ )
+        {
+            uint64 y0 = fx[i+0];
+            uint64 y1 = fx[i+1];
+
+            const MetaBits* lMeta = &meta[i+0];
+            const MetaBits* rMeta = &meta[i+1];
+
+            if( y0 > y1 ) 
+            {
+                std::swap( y0, y1 );
+                std::swap( lMeta, rMeta );
+            }
+
+            // Must be on the same group
+            if( !FxMatch( y0, y1 ) )
+                return false;
+
+            // FxGen
+            uint64 outY;
+            MetaBits outMeta;
+            FxGen( table, k, y0, *lMeta, *rMeta, outY, outMeta );
+
+            fx  [dst] = outY;
+            meta[dst] = outMeta;
+        }
+    }
+
+    outF7 = fx[0] >> kExtraBits;
+
+    return true;
+}
+
+
+// #TODO: Avoid code duplication here? At least for f1
+//-----------------------------------------------------------
+void PlotValidation::ReorderProof( const uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT] )
+{
+
+    uint64   fx  [PROOF_X_COUNT];
+    MetaBits meta[PROOF_X_COUNT];
+
+    uint64  xtmp[PROOF_X_COUNT];
+    uint64* xs = fullProofXs;
+
+    // Convert these x's to f1 values
+    GetProofF1( k, plotId, fullProofXs, fx );
+    for( uint32 i = 0; i < PROOF_X_COUNT; i++ )
+        meta[i] = MetaBits( xs[i], k );
+
+    // Forward propagate f1 values to get the final f7
+    uint32 iterCount = PROOF_X_COUNT;
+    for( TableId table = TableId::Table2; table <= TableId::Table7; table++, iterCount >>= 1)
+    {
+        for( uint32 i = 0, dst = 0; i < iterCount; i+= 2, dst++ )
+        {
+            uint64 y0 = fx[i+0];
+            uint64 y1 = fx[i+1];
+
+            const MetaBits* lMeta = &meta[i+0];
+            const MetaBits* rMeta = &meta[i+1];
+
+            if( y0 > y1 ) 
+            {
+                std::swap( y0, y1 );
+                std::swap( lMeta, rMeta );
+
+                // Swap X's so far that have generated this y
+                const uint32 count = 1u << ((int)table-1);
+                uint64* x = xs + i * count;
+                bbmemcpy_t( xtmp   , x      , count );
+                bbmemcpy_t( x      , x+count, count );
+                bbmemcpy_t( x+count, xtmp   , count );
+            }
+
+            // FxGen
+            uint64 outY;
+            MetaBits outMeta;
+            FxGen( table, k, y0, *lMeta, *rMeta, outY, outMeta );
+
+            fx  [dst] = outY;
+            meta[dst] = outMeta;
+        }
+    }
+}
+
+//-----------------------------------------------------------
+void PlotValidation::GetProofF1( uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64 fx[PROOF_X_COUNT] )
+{
+    const uint32 xShift = k - kExtraBits;
+        
+    // Prepare ChaCha key
+    byte key[32] = { 1 };
+    memcpy( key + 1, plotId, 31 );
+
+    chacha8_ctx chacha;
+    chacha8_keysetup( &chacha, key, 256, NULL );
+
+    // Enough to hold 2 cha-cha blocks since a value my span over 2 blocks
+    byte blocks[kF1BlockSize*2];
+
+    for( uint32 i = 0; i < PROOF_X_COUNT; i++ )
+    {
+        const uint64 x        = fullProofXs[i];
+        const uint64 blockIdx = x * k / kF1BlockSizeBits; 
+
+        chacha8_get_keystream( &chacha, blockIdx, 2, blocks );
+
+        // Get the starting and end locations of y in bits relative to our block
+        const uint64 bitStart = x * k - blockIdx * kF1BlockSizeBits;
+
+        CPBitReader hashBits( blocks, sizeof( blocks ) * 8 );
+        hashBits.Seek( bitStart );
+
+        // uint64 y = SliceUInt64FromBits( blocks, bitStart, k ); // #TODO: Figure out what's wrong with this method.
+        uint64 y = hashBits.Read64( k );
+        y = ( y << kExtraBits ) | ( x >> xShift );
+
+        fx[i] = y;
+    }
+}
+
+//-----------------------------------------------------------
+bool PlotValidation::FxMatch( uint64 yL, uint64 yR )
+{
+    const uint64 groupL = yL / kBC;
+    const uint64 groupR = yR / kBC;
+
+    if( groupR - groupL != 1 )
+        return false;
+
+    // Groups are adjacent, check if the y values actually match
+    const uint16 parity = groupL & 1;
+
+    const uint64 groupLRangeStart = groupL * kBC;
+    const uint64 groupRRangeStart = groupR * kBC;
+
+    const uint64 localLY = yL - groupLRangeStart;
+    const uint64 localRY = yR - groupRRangeStart;
+    
+    for( int iK = 0; iK < kExtraBitsPow; iK++ )
+    {
+        const uint64 targetR = L_targets[parity][localLY][iK];
+        
+        if( targetR == localRY )
+            return true;
+    } 
+
+    return false;
+}
+
+//-----------------------------------------------------------
+void PlotValidation::FxGen( const TableId table, const uint32 k, 
+                            const uint64 y, const MetaBits& metaL, const MetaBits& metaR,
+                            uint64& outY, MetaBits& outMeta )
+{
+    FxBits input( y, k + kExtraBits );
+
+    if( table < TableId::Table4 )
+    {
+        outMeta = metaL + metaR;
+        input += outMeta;
+    }
+    else
+    {
+        input += metaL;
+        input += metaR;
+    }
+
+    byte inputBytes[64];
+    byte hashBytes [32];
+
+    input.ToBytes( inputBytes );
+
+    blake3_hasher hasher;
+    blake3_hasher_init    ( &hasher );
+    blake3_hasher_update  ( &hasher, inputBytes, input.LengthBytes() );
+    blake3_hasher_finalize( &hasher, hashBytes, sizeof( hashBytes ) );
+
+    outY = BytesToUInt64( hashBytes ) >> ( 64 - (k + kExtraBits) );
+
+    if( table >= TableId::Table4 && table < TableId::Table7 )
+    {
+        size_t multiplier = 0;
+        switch( table )
+        {
+            case TableId::Table4: multiplier = TableMetaOut<TableId::Table4>::Multiplier; break;
+            case TableId::Table5: multiplier = TableMetaOut<TableId::Table5>::Multiplier; break;
+            case TableId::Table6: multiplier = TableMetaOut<TableId::Table6>::Multiplier; break;
+            default: 
+                ASSERT( 0 );
+                break;
+        }
+
+        const uint32 metaBits  = (uint32)( k * multiplier );
+        const uint32 yBits     = k + kExtraBits;
+        const uint32 startByte = yBits / 8 ;
+        const uint32 startBit  = yBits - startByte * 8;
+
+        outMeta = MetaBits( hashBytes + startByte, metaBits, startBit );
+    }
+}
+
+//-----------------------------------------------------------
+/// Convertes 8 bytes to uint64 and endian-swaps it.
+/// This takes any byte alignment, so that bytes does
+/// not have to be aligned to 64-bit boundary.
+/// This is for compatibility for how chiapos extracts
+/// bytes into integers.
+//-----------------------------------------------------------
+uint64 PlotValidation::BytesToUInt64( const byte bytes[8] )
+{
+    uint64 tmp;
+    memcpy( &tmp, bytes, sizeof( uint64 ) );
+    return Swap64( tmp );
+}
+
+//-----------------------------------------------------------
+// Treats bytes as a set of 64-bit big-endian fields,
+// from which it will extract a whole 64-bit value
+// at the given bit offset. 
+// The result may be truncated if the requested number of 
+// bits + the number of bits overflows the 64-bit field.
+// That is, if the local bit offset in the target bit field
+// + the bitCount is greater than 64.
+// This function is for compatibility with the way chiapos
+// slices bits off of binary byte blobs.
+//-----------------------------------------------------------
+uint64 PlotValidation::SliceUInt64FromBits( const byte* bytes, uint32 bitOffset, uint32 bitCount )
+{
+    ASSERT( bitCount <= 64 );
+     
+    // #TODO: This is wrong, it's not treating the bytes as 64-bit fields.
+    //        So that we may have swapped at the wrong position.
+    //        In fact we might have fields that span 2 64-bit values.
+    //        So we need to split it into 2, and do 2 swaps.
+    const uint64 startByte = bitOffset / 8;
+    bytes += startByte;
+
+    // Convert bit offset to be local to the uint64 field
+    bitOffset -= ( bitOffset >> 6 ) * 64; // bitOffset >> 6 == bitOffset / 64
+
+    uint64 field = BytesToUInt64( bytes );
+    
+    field <<= bitOffset;     // Start bits from the MSBits
+    field >>= 64 - bitCount; // Take the MSbits
+
+    return field;
+}
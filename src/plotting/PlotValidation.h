@@ -2,6 +2,7 @@
 #include "util/BitView.h"
 #include "ChiaConsts.h"
 #include "plotting/PlotTools.h"
+#include "plotting/Tables.h"
 
 #define PROOF_X_COUNT       64
 #define MAX_K_SIZE          48
@@ -15,9 +16,20 @@ typedef Bits<MAX_META_BIT_SIZE> MetaBits;
 typedef Bits<MAX_FX_BIT_SIZE>   FxBits;
 
 
+// Proof of space evaluation helpers, shared by the plot validator and the plot reader.
+// #NOTE: LoadLTargets() must have been called before using FxMatch/ValidateFullProof.
 class PlotValidation
 {
+public:
+    // Evaluates the 64 x's of a full proof to its f7.
+    // Returns false if any of the pairs don't match.
     static bool ValidateFullProof( const uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64& outF7 );
+
+    // Reorders the x's of a full proof from plot order (as fetched from the back pointers)
+    // to proof order, where the left side of each pair has the smaller y.
+    static void ReorderProof( const uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT] );
+
+    static void GetProofF1( uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64 fx[PROOF_X_COUNT] );
     
     static uint64 BytesToUInt64( const byte bytes[8] );
     static uint64 SliceUInt64FromBits( const byte* bytes, uint32 bitOffset, uint32 bitCount );
@@ -27,4 +39,4 @@ class PlotValidation
     static void FxGen( const TableId table, const uint32 k, 
                        const uint64 y, const MetaBits& metaL, const MetaBits& metaR,
                        uint64& outY, MetaBits& outMeta );
-};
\ No newline at end of file
+};
@@ -3,6 +3,7 @@
 #include "threading/ThreadPool.h"
 #include "threading/MTJob.h"
 #include "plotting/CTables.h"
+#include "plotting/ParkEncoder.h"
 
 struct TableWriter
 {
@@ -35,8 +36,12 @@ struct TableWriter
     template<uint MAX_JOBS>
     static size_t WriteC3Parallel( ThreadPool& pool, uint32 threadCount, const uint64 length, uint32* f7Entries, byte* c3Buffer );
 
-    static void WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* writeBuffer, uint32 jobId = 0 );
-    static void WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer, uint32 jobId = 0 );
+    static void WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* writeBuffer );
+    static void WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer );
+
+    // Write several C3 parks of the same length at once. Same output as WriteC3Park on each park.
+    template<uint32 lanes>
+    static void WriteC3ParksInterleaved( const uint64 length, uint32* f7Entries, byte* parkBuffer );
 };
 
 struct P7Job : MTJob<P7Job>
@@ -377,13 +382,23 @@ inline size_t TableWriter::WriteC3Parallel( ThreadPool& pool, uint32 threadCount
 }
 
 //-----------------------------------------------------------
-inline void TableWriter::WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* writeBuffer, uint32 jobId )
+inline void TableWriter::WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* writeBuffer )
 {
     const size_t c3Size = CalculateC3Size();
 
-    for( uint64 i = 0; i < parkCount; i++ )
+    // Encode BB_PARK_ENCODER_LANES parks at a time, interleaving their FSE streams
+    uint64 i = 0;
+    for( ; i + BB_PARK_ENCODER_LANES <= parkCount; i += BB_PARK_ENCODER_LANES )
+    {
+        WriteC3ParksInterleaved<BB_PARK_ENCODER_LANES>( kCheckpoint1Interval-1, f7Entries, writeBuffer );
+
+        f7Entries   += kCheckpoint1Interval * BB_PARK_ENCODER_LANES;
+        writeBuffer += c3Size * BB_PARK_ENCODER_LANES;
+    }
+
+    for( ; i < parkCount; i++ )
     {
-        WriteC3Park( kCheckpoint1Interval-1, f7Entries, writeBuffer, jobId  );
+        WriteC3Park( kCheckpoint1Interval-1, f7Entries, writeBuffer );
 
         f7Entries   += kCheckpoint1Interval;
         writeBuffer += c3Size;
@@ -391,53 +406,76 @@ inline void TableWriter::WriteC3Parks( const uint64 parkCount, uint32* f7Entries
 }
 
 //-----------------------------------------------------------
-inline void TableWriter::WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer, uint32 jobId )
+inline void TableWriter::WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer )
+{
+    WriteC3ParksInterleaved<1>( length, f7Entries, parkBuffer );
+}
+
+//-----------------------------------------------------------
+template<uint32 lanes>
+inline void TableWriter::WriteC3ParksInterleaved( const uint64 length, uint32* f7Entries, byte* parkBuffer )
 {
     ASSERT( length <= kCheckpoint1Interval-1 );
     
     const size_t c3Size = CalculateC3Size();
 
-    // Re-use f7Entries as the delta buffer. 
-    // We won't use f7 entries after this, so we can re-write it.
-    byte* deltaWriter = (byte*)f7Entries;
+    byte*       deltaDst  [lanes];
+    const byte* deltaSrc  [lanes];
+    size_t      deltaSizes[lanes];
 
-    // f7Entries must always start at an interval of kCheckpoint1Interval
-    // Therefore its first entry is a C1 entry, and not written as a delta.
-    uint32 prevF7 = *f7Entries;
-    
-    // Convert to deltas
-    for( uint64 i = 1; i <= length; i++ )
+    for( uint32 lane = 0; lane < lanes; lane++ )
     {
-        const uint32 f7    = f7Entries[i];
-        const uint32 delta = f7 - prevF7;
-        prevF7 = f7;
+        uint32* parkF7 = f7Entries + lane * kCheckpoint1Interval;
 
-        ASSERT( delta < 255 );
-        *deltaWriter++ = (byte)delta;
-    }
+        // Re-use f7Entries as the delta buffer. 
+        // We won't use f7 entries after this, so we can re-write it.
+        byte* deltaWriter = (byte*)parkF7;
 
-    ASSERT( (uint64)(deltaWriter - (byte*)f7Entries) == length );
+        // f7Entries must always start at an interval of kCheckpoint1Interval
+        // Therefore its first entry is a C1 entry, and not written as a delta.
+        uint32 prevF7 = *parkF7;
+        
+        // Convert to deltas
+        for( uint64 i = 1; i <= length; i++ )
+        {
+            const uint32 f7    = parkF7[i];
+            const uint32 delta = f7 - prevF7;
+            prevF7 = f7;
 
-    // Serialize them into the C3 park buffer
-    const size_t compressedSize = FSE_compress_usingCTable(
-        parkBuffer+2, c3Size, (byte*)f7Entries, 
-        length, (const FSE_CTable*)CTable_C3
-    );
-    ASSERT( (compressedSize+2) < c3Size );
-    
-    // Store size in the first 2 bytes
-    *((uint16*)parkBuffer) = Swap16( (uint16)compressedSize );
+            ASSERT( delta < 255 );
+            *deltaWriter++ = (byte)delta;
+        }
+
+        ASSERT( (uint64)(deltaWriter - (byte*)parkF7) == length );
 
-    // Zero-out remainder (not necessary, though...)
-    const size_t remainder = c3Size - (compressedSize + 2);
-    if( remainder )
-        memset( parkBuffer + compressedSize + 2, 0, remainder );
+        deltaSrc[lane] = (byte*)parkF7;
+        deltaDst[lane] = parkBuffer + lane * c3Size + 2;
+    }
+
+    // Serialize them into the C3 park buffers
+    FSECompressInterleaved<lanes>( deltaDst, c3Size, deltaSrc, length, (const FSE_CTable*)CTable_C3, deltaSizes );
+
+    for( uint32 lane = 0; lane < lanes; lane++ )
+    {
+        byte*        park           = parkBuffer + lane * c3Size;
+        const size_t compressedSize = deltaSizes[lane];
+        ASSERT( (compressedSize+2) < c3Size );
+        
+        // Store size in the first 2 bytes.
+        // Written after all streams, as the stream of the previous park may write up to here.
+        *((uint16*)park) = Swap16( (uint16)compressedSize );
+
+        // Zero-out remainder (not necessary, though...)
+        const size_t remainder = c3Size - (compressedSize + 2);
+        if( remainder )
+            memset( park + compressedSize + 2, 0, remainder );
+    }
 }
 
 //-----------------------------------------------------------
 inline void C3Job::Run()
 {
-    TableWriter::WriteC3Parks( this->parkCount, this->f7Entries, this->writeBuffer, this->_jobId );
+    TableWriter::WriteC3Parks( this->parkCount, this->f7Entries, this->writeBuffer );
 }
 
 
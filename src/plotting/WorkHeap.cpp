@@ -1,6 +1,7 @@
 #include "WorkHeap.h"
 #include "util/Util.h"
 #include "util/Log.h"
+#include "util/TraceLog.h"
 
 //-----------------------------------------------------------
 WorkHeap::WorkHeap( size_t size, byte* heapBuffer )
@@ -121,7 +122,10 @@ byte* WorkHeap::Alloc( size_t size, size_t alignment, bool blockUntilFreeBuffer,
         // No buffer found, we have to wait until buffers are released and then try again
         // Log::Line( "*************************** No Buffers available waiting..." );
         auto timer = TimerBegin();
-        _releaseSignal.Wait();
+        {
+            TRACE_SPAN( "WorkHeap::Alloc wait", "heap", (int64)size );
+            _releaseSignal.Wait();
+        }
 
         if( accumulator )
         {
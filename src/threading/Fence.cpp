@@ -1,4 +1,5 @@
 #include "Fence.h"
+#include "util/TraceLog.h"
 
 //-----------------------------------------------------------
 Fence::Fence()
@@ -38,12 +39,14 @@ void Fence::Reset( uint32 value )
 //-----------------------------------------------------------
 void Fence::Wait()
 {
+    TRACE_SPAN( "Fence::Wait", "fence" );
     _signal.Wait();
 }
 
 //-----------------------------------------------------------
 void Fence::Wait( Duration& accumulator )
 {
+    TRACE_SPAN( "Fence::Wait", "fence" );
     const auto startTime = TimerBegin();
     _signal.Wait();
     accumulator += TimerEndTicks( startTime );
@@ -52,6 +55,11 @@ void Fence::Wait( Duration& accumulator )
 //-----------------------------------------------------------
 void Fence::Wait( uint32 value )
 {
+    if( _value >= value )
+        return;
+
+    TRACE_SPAN( "Fence::Wait", "fence", value );
+
     // while( _value.load( std::memory_order_relaxed ) < value )
     while( _value < value )
         _signal.Wait();
@@ -60,6 +68,11 @@ void Fence::Wait( uint32 value )
 //-----------------------------------------------------------
 void Fence::Wait( uint32 value, Duration& accumulator )
 {
+    if( _value >= value )
+        return;
+
+    TRACE_SPAN( "Fence::Wait", "fence", value );
+
     while( _value < value )
     {
         const auto startTime = TimerBegin();
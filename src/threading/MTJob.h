@@ -3,7 +3,9 @@
 #include "Config.h"
 #include "threading/ThreadPool.h"
 #include "util/Util.h"
+#include "util/TraceLog.h"
 #include <cstring>
+#include <typeinfo>
 #if _DEBUG
     #include "util/Log.h"
 #endif
@@ -21,6 +23,7 @@ struct MTJobSyncT
     uint               _jobId;
     uint               _jobCount;
     TJob*              _jobs;
+    const char*        _name;           // Trace span name
 
     // Synchronize all threads before continuing to the next step
     inline void SyncThreads();
@@ -110,8 +113,10 @@ struct MTJobRunner
 {
     MTJobRunner( ThreadPool& pool );
 
-    double Run();
-    double Run( uint32 threadCount );
+    // name is the trace span name of the jobs. It must be a string literal.
+    // If null, the job type's name is used.
+    double Run( const char* name = nullptr );
+    double Run( uint32 threadCount, const char* name = nullptr );
 
     inline TJob& operator[]( uint64 index ) { return this->_jobs[index]; }
     inline TJob& operator[]( int64  index ) { return this->_jobs[index]; }
@@ -138,7 +143,7 @@ struct AnonMTJob : public MTJob<AnonMTJob>
     template<typename F,
         std::enable_if_t<
         std::is_invocable_r_v<void, F, AnonMTJob*>>* = nullptr>
-    inline static void Run( ThreadPool& pool, const uint32 threadCount, F&& func )
+    inline static void Run( ThreadPool& pool, const uint32 threadCount, F&& func, const char* name = "AnonMTJob" )
     {
         std::function<void(AnonMTJob*)> f = func;
         
@@ -149,13 +154,13 @@ struct AnonMTJob : public MTJob<AnonMTJob>
             job.func = &f;
         }
 
-        jobs.Run( threadCount );
+        jobs.Run( threadCount, name );
     }
 
     template<typename F>
-    inline static void Run( ThreadPool& pool, F&& func )
+    inline static void Run( ThreadPool& pool, F&& func, const char* name = "AnonMTJob" )
     {
-        Run( pool, pool.ThreadCount(), func );
+        Run( pool, pool.ThreadCount(), func, name );
     }
 };
 
@@ -167,14 +172,20 @@ inline MTJobRunner<TJob, MaxJobs>::MTJobRunner( ThreadPool& pool )
 {}
 
 template<typename TJob, uint MaxJobs>
-inline double MTJobRunner<TJob, MaxJobs>::Run()
+inline double MTJobRunner<TJob, MaxJobs>::Run( const char* name )
 {
-    return this->Run( this->_pool.ThreadCount() );
+    return this->Run( this->_pool.ThreadCount(), name );
 }
 
 template<typename TJob, uint MaxJobs>
-inline double MTJobRunner<TJob, MaxJobs>::Run( uint32 threadCount )
+inline double MTJobRunner<TJob, MaxJobs>::Run( uint32 threadCount, const char* name )
 {
+    if( !name )
+    {
+        static const char* typeName = TraceLog::TypeName( typeid( TJob ) );
+        name = typeName;
+    }
+
     // Set thread ids and atomic locks
     ASSERT( threadCount <= MaxJobs );
 
@@ -190,6 +201,7 @@ inline double MTJobRunner<TJob, MaxJobs>::Run( uint32 threadCount )
         job._jobId         = i;
         job._jobCount      = threadCount;
         job._jobs          = _jobs;
+        job._name          = name;
     }
 
     // Run the job
@@ -204,6 +216,7 @@ template<typename TJob, uint MaxJobs>
 inline void MTJobRunner<TJob, MaxJobs>::RunJobWrapper( TJob* job )
 {
     //job->Run();
+    TRACE_SPAN( job->_name, "job", job->JobId() );
     static_cast<MTJob<TJob>*>( job )->Run();
 }
 
@@ -229,6 +242,7 @@ inline bool MTJobSyncT<TJob>::LockThreads()
 
         // Trace( "Locking Threads..." );
         // Wait for all threads to finish
+        TRACE_SPAN( "LockThreads", "sync" );
         while( finishedCount.load( std::memory_order_relaxed ) != threadThreshold );
         // Trace( "---- All threads Locked ----." );
         return true;
@@ -269,6 +283,7 @@ inline void MTJobSyncT<TJob>::WaitForRelease()
     // Trace( "- locked: %d", count );
     
     // Wait for the control thread (id == 0 ) to signal us
+    TRACE_SPAN( "WaitForRelease", "sync" );
     while( finishedCount.load( std::memory_order_relaxed ) != 0 );
 
     // Ensure all threads have been released (prevent re-locking before another thread has been released)
@@ -522,7 +537,7 @@ struct AnonPrefixSumJob : public PrefixSumJob<AnonPrefixSumJob<TCount>, TCount>
     template<typename F,
         std::enable_if_t<
         std::is_invocable_r_v<void, F, AnonPrefixSumJob<TCount>*>>* = nullptr>
-    inline static void Run( ThreadPool& pool, const uint32 threadCount, F&& func )
+    inline static void Run( ThreadPool& pool, const uint32 threadCount, F&& func, const char* name = "AnonPrefixSumJob" )
     {
         std::function<void(AnonPrefixSumJob<TCount>*)> f = func;
         
@@ -533,13 +548,13 @@ struct AnonPrefixSumJob : public PrefixSumJob<AnonPrefixSumJob<TCount>, TCount>
             job.func = &f;
         }
 
-        jobs.Run( threadCount );
+        jobs.Run( threadCount, name );
     }
 
     template<typename F>
-    inline static void Run( ThreadPool& pool, F&& func )
+    inline static void Run( ThreadPool& pool, F&& func, const char* name = "AnonPrefixSumJob" )
     {
-        Run( pool, pool.ThreadCount(), func );
+        Run( pool, pool.ThreadCount(), func, name );
     }
 };
 
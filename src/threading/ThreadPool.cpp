@@ -1,6 +1,7 @@
 #include "ThreadPool.h"
 #include "util/Util.h"
 #include "util/Log.h"
+#include "util/TraceLog.h"
 #include "SysHost.h"
 
 
@@ -76,6 +77,13 @@ void ThreadPool::RunJob( JobFunc func, void* data, uint count, size_t dataSize )
         DispatchGreedy( func, (byte*)data, count, dataSize );
 }
 
+//-----------------------------------------------------------
+void ThreadPool::ResetBusyTime()
+{
+    for( uint i = 0; i < _threadCount; i++ )
+        _threadData[i].busyTime = Duration::zero();
+}
+
 //-----------------------------------------------------------
 void ThreadPool::DispatchFixed( JobFunc func, byte* data, uint count, size_t dataSize )
 {
@@ -147,6 +155,8 @@ void ThreadPool::FixedThreadRunner( void* tParam )
     if( !pool._disableAffinity )
         SysHost::SetCurrentThreadAffinityCpuId( d.cpuId );
 
+    TraceLog::SetThreadName( "pool", d.index );
+
     const uint index = (uint)d.index;
 
     std::atomic<bool>& exitSignal = pool._exitSignal;
@@ -166,7 +176,9 @@ void ThreadPool::FixedThreadRunner( void* tParam )
             return;
         
         // Run job
+        const auto timer = TimerBegin();
         pool._jobFunc( pool._jobData + pool._jobDataSize * index );
+        d.busyTime += TimerEndTicks( timer );
 
         // Finished job
         poolSignal.Release();
@@ -184,6 +196,8 @@ void ThreadPool::GreedyThreadRunner( void* tParam )
     if( !pool._disableAffinity )
         SysHost::SetCurrentThreadAffinityCpuId( d.cpuId );
 
+    TraceLog::SetThreadName( "pool", d.index );
+
     for( ;; )
     {
         if( pool._exitSignal.load( std::memory_order::memory_order_acquire ) )
@@ -210,7 +224,9 @@ void ThreadPool::GreedyThreadRunner( void* tParam )
                 ASSERT( pool._jobFunc );
 
                 // We acquired the job, run it
+                const auto timer = TimerBegin();
                 pool._jobFunc( pool._jobData + pool._jobDataSize * jobIndex );
+                d.busyTime += TimerEndTicks( timer );
             }
         }
 
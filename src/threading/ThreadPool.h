@@ -29,6 +29,17 @@ public:
     inline void RunJob( void (*TJobFunc)( T* ), T* data, uint count );
 
     inline uint ThreadCount() { return _threadCount; }
+
+    // Time the given thread has spent running jobs since the last reset.
+    // Only consistent while no jobs are running.
+    inline Duration ThreadBusyTime( const uint threadIndex ) const
+    {
+        ASSERT( threadIndex < _threadCount );
+        return _threadData[threadIndex].busyTime;
+    }
+
+    void ResetBusyTime();
+
 private:
 
     void DispatchFixed( JobFunc func, byte* data, uint count, size_t dataSize );
@@ -43,6 +54,7 @@ private:
         int         index;
         uint        cpuId;     // CPU Id affinity
         Semaphore   jobSignal; // Used for fixed mode
+        Duration    busyTime = Duration::zero();
     };
 
 private:
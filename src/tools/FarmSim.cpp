@@ -0,0 +1,309 @@
+#include "util/CliParser.h"
+#include "util/Log.h"
+#include "util/Util.h"
+#include "util/KeyTools.h"
+#include "PlotReader.h"
+#include "LatencyStats.h"
+#include "plotting/GlobalPlotConfig.h"
+#include "threading/Thread.h"
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+
+static const char* USAGE = R"(farmsim [OPTIONS] <plot_path> [<plot_path> ...]
+
+Simulates the harvester workload against a set of plots.
+For each random challenge (a signage point), every plot is checked against the plot filter.
+The plots that pass look up their qualities, and some of the qualities found are
+then looked up as full proofs, as when a proof is good enough to win.
+Reports the lookup latencies, measured from when the challenge was issued, and the read IOPS.
+
+[NOTES]
+Use the global -t, --threads option to set the number of lookup workers. The default is 8.
+Each plot is looked up by one worker at a time.
+
+[ARGUMENTS]
+<plot_path>             : Path to a plot file. Any number of plots may be specified.
+
+[OPTIONS]
+ -n, --count <n>        : Number of challenges to issue. The default is 1000.
+
+ -r, --rate <n>         : Challenges to issue per second. The default is 0, which issues them as fast as possible.
+                          Chia issues a signage point about every 9.4 seconds.
+
+ -f, --filter-bits <n>  : Plot filter size, in bits. A plot passes the filter for 1 in every 2^n challenges.
+                          The default is 9, as in chia. Use 0 to look up every plot for every challenge.
+
+ -p, --proof-chance <percent>
+                        : Chance that a quality found needs its full proof looked up. The default is 1.
+
+ -d, --direct           : Read the plots with direct IO, bypassing the OS page cache.
+
+ -h, --help             : Print this help message and exit.
+)";
+
+// Time after which chia warns that a harvester lookup is too slow
+#define FARMSIM_SLOW_LOOKUP_SECONDS 5.0
+
+struct SimPlot
+{
+    FilePlot    file;
+    PlotReader* reader = nullptr;
+    std::mutex  lock;               // Readers are not thread-safe
+};
+
+struct SimLookup
+{
+    uint32 plotIndex;
+    byte   challenge[BB_CHIA_CHALLENGE_SIZE];
+    byte   proofRandom;             // Decides if each quality fetches a full proof
+    std::chrono::steady_clock::time_point issueTime;
+};
+
+struct FarmSimContext
+{
+    SimPlot*                plots;
+    uint32                  proofChance;    // Out of 256
+
+    std::mutex              queueLock;
+    std::condition_variable queueSignal;
+    std::deque<SimLookup>   queue;
+    bool                    exit = false;
+
+    std::mutex              statsLock;
+    LatencyStats            qualityLatency;
+    LatencyStats            proofLatency;
+    uint64                  qualityCount = 0;
+    uint64                  proofCount   = 0;
+    std::atomic<uint64>     failedCount  = 0;
+};
+
+static void FarmSimWorker( FarmSimContext* cx );
+
+//-----------------------------------------------------------
+void FarmSimMain( GlobalPlotConfig& gCfg, CliParser& cli )
+{
+    std::vector<const char*> plotPaths;
+
+    uint32  count       = 1000;
+    float64 rate        = 0;
+    uint32  filterBits  = 9;
+    float64 proofChance = 1.0;
+    bool    directIO    = false;
+
+    while( cli.HasArgs() )
+    {
+        if( cli.ReadU32( count, "-n", "--count" ) )
+            continue;
+        else if( cli.ReadF64( rate, "-r", "--rate" ) )
+            continue;
+        else if( cli.ReadU32( filterBits, "-f", "--filter-bits" ) )
+            continue;
+        else if( cli.ReadF64( proofChance, "-p", "--proof-chance" ) )
+            continue;
+        else if( cli.ReadSwitch( directIO, "-d", "--direct" ) )
+            continue;
+        else if( cli.ArgConsume( "-h", "--help" ) )
+        {
+            Log::Line( USAGE );
+            exit( 0 );
+        }
+        else if( cli.Arg()[0] == '-' )
+        {
+            Fatal( "Unexpected argument '%s'.", cli.Arg() );
+        }
+        else
+        {
+            plotPaths.push_back( cli.ArgConsume() );
+        }
+    }
+
+    FatalIf( plotPaths.empty(), "Expected at least one plot path." );
+    FatalIf( count < 1, "Challenge count must be at least 1." );
+    FatalIf( filterBits > 32, "Invalid filter size. It must be 32 bits or less." );
+    FatalIf( proofChance < 0 || proofChance > 100, "Invalid proof chance." );
+    FatalIf( rate < 0, "Invalid challenge rate." );
+
+    const uint32 workerCount = gCfg.threadCount == 0 ? 8 : gCfg.threadCount;
+    const uint32 plotCount   = (uint32)plotPaths.size();
+
+    LoadLTargets();
+
+    FarmSimContext cx;
+    cx.plots       = new SimPlot[plotCount];
+    cx.proofChance = (uint32)( proofChance / 100.0 * 256.0 );
+
+    for( uint32 i = 0; i < plotCount; i++ )
+    {
+        SimPlot& plot = cx.plots[i];
+        FatalIf( !plot.file.Open( plotPaths[i], directIO ), "Failed to open plot at path '%s'.", plotPaths[i] );
+
+        plot.reader = new PlotReader( plot.file );
+    }
+
+    Log::Line( "Plots       : %u", plotCount );
+    Log::Line( "Workers     : %u", workerCount );
+    Log::Line( "Challenges  : %u", count );
+    if( rate > 0 )
+        Log::Line( "Rate        : %.3lf challenges/s", rate );
+    else
+        Log::Line( "Rate        : unlimited" );
+    Log::Line( "Filter bits : %u", filterBits );
+    Log::Line( "Direct IO   : %s", directIO ? "true" : "false" );
+    Log::Line( "" );
+
+    Thread* workers = new Thread[workerCount];
+    for( uint32 i = 0; i < workerCount; i++ )
+        workers[i].Run( FarmSimWorker, &cx );
+
+    // Issue the challenges
+    const uint64 filterMask = filterBits == 0 ? 0 : ~0ull << ( 64 - filterBits );
+
+    uint64 passedCount = 0;
+    const auto startTime = TimerBegin();
+
+    for( uint32 i = 0; i < count; i++ )
+    {
+        if( rate > 0 )
+        {
+            const double issueTime = (double)i / rate;
+            const double elapsed   = TimerEnd( startTime );
+
+            if( issueTime > elapsed )
+                Thread::Sleep( (long)( ( issueTime - elapsed ) * 1000.0 ) );
+        }
+
+        byte challengeHash[32], signagePoint[32];
+        SysHost::Random( challengeHash, sizeof( challengeHash ) );
+        SysHost::Random( signagePoint , sizeof( signagePoint  ) );
+
+        const auto issueTime = TimerBegin();
+
+        for( uint32 p = 0; p < plotCount; p++ )
+        {
+            // Plot filter: The same hash is used as the plot's proof of space challenge
+            byte filterInput[BB_PLOT_ID_LEN + 64];
+            memcpy( filterInput, cx.plots[p].file.PlotId(), BB_PLOT_ID_LEN );
+            memcpy( filterInput + BB_PLOT_ID_LEN     , challengeHash, 32 );
+            memcpy( filterInput + BB_PLOT_ID_LEN + 32, signagePoint , 32 );
+
+            SimLookup lookup = {};
+            bls::Util::Hash256( lookup.challenge, filterInput, sizeof( filterInput ) );
+
+            uint64 filterBits;
+            memcpy( &filterBits, lookup.challenge, sizeof( filterBits ) );
+
+            if( ( Swap64( filterBits ) & filterMask ) != 0 )
+                continue;
+
+            lookup.plotIndex   = p;
+            lookup.proofRandom = signagePoint[p % 32] ^ (byte)( p / 32 );
+            lookup.issueTime   = issueTime;
+            passedCount++;
+
+            {
+                std::lock_guard<std::mutex> lock( cx.queueLock );
+                cx.queue.push_back( lookup );
+            }
+            cx.queueSignal.notify_one();
+        }
+    }
+
+    // Let the workers drain the queue
+    {
+        std::lock_guard<std::mutex> lock( cx.queueLock );
+        cx.exit = true;
+    }
+    cx.queueSignal.notify_all();
+
+    for( uint32 i = 0; i < workerCount; i++ )
+        workers[i].WaitForExit();
+
+    const double elapsed = TimerEnd( startTime );
+
+    uint64 readCount = 0;
+    for( uint32 i = 0; i < plotCount; i++ )
+        readCount += cx.plots[i].file.ReadCount();
+
+    Log::Line( "Completed in %.3lf seconds.", elapsed );
+    Log::Line( "Plots passed filter : %llu ( %.3lf per challenge )", (llu)passedCount, (double)passedCount / count );
+    Log::Line( "Qualities found     : %llu", (llu)cx.qualityCount );
+    Log::Line( "Full proofs fetched : %llu", (llu)cx.proofCount );
+    Log::Line( "Failed lookups      : %llu", (llu)cx.failedCount.load() );
+    Log::Line( "Reads               : %llu ( %.1lf IOPS )", (llu)readCount, readCount / elapsed );
+    Log::Line( "Slow lookups (> %.0lfs) : %llu", FARMSIM_SLOW_LOOKUP_SECONDS, (llu)cx.qualityLatency.CountAbove( FARMSIM_SLOW_LOOKUP_SECONDS ) );
+    Log::Line( "" );
+
+    cx.qualityLatency.Print( "Quality lookup" );
+    cx.proofLatency  .Print( "Full proof lookup" );
+
+    exit( cx.failedCount == 0 ? 0 : 1 );
+}
+
+//-----------------------------------------------------------
+void FarmSimWorker( FarmSimContext* cx )
+{
+    std::vector<PlotQuality> qualities;
+
+    LatencyStats qualityLatency, proofLatency;
+    uint64 qualityCount = 0, proofCount = 0;
+
+    for( ;; )
+    {
+        SimLookup lookup;
+        {
+            std::unique_lock<std::mutex> lock( cx->queueLock );
+            cx->queueSignal.wait( lock, [=]() { return cx->exit || !cx->queue.empty(); } );
+
+            if( cx->queue.empty() )
+                break;
+
+            lookup = cx->queue.front();
+            cx->queue.pop_front();
+        }
+
+        SimPlot& plot = cx->plots[lookup.plotIndex];
+        std::lock_guard<std::mutex> plotLock( plot.lock );
+
+        if( !plot.reader->GetQualitiesForChallenge( lookup.challenge, qualities ) )
+        {
+            cx->failedCount++;
+            continue;
+        }
+
+        qualityLatency.samples.push_back( TicksToSeconds( TimerEndTicks( lookup.issueTime ) ) );
+        qualityCount += qualities.size();
+
+        for( size_t i = 0; i < qualities.size(); i++ )
+        {
+            const byte chance = (byte)( lookup.proofRandom + qualities[i].quality[0] );
+            if( chance >= cx->proofChance )
+                continue;
+
+            uint64 xs[PROOF_X_COUNT];
+
+            if( !plot.reader->GetFullProofForF7Index( qualities[i].f7Index, xs ) )
+            {
+                cx->failedCount++;
+                continue;
+            }
+
+            // Like qualities, from when the challenge was issued, as the proof must reach the farmer in time
+            proofLatency.samples.push_back( TicksToSeconds( TimerEndTicks( lookup.issueTime ) ) );
+            proofCount++;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock( cx->statsLock );
+    cx->qualityLatency.Add( qualityLatency );
+    cx->proofLatency  .Add( proofLatency );
+    cx->qualityCount += qualityCount;
+    cx->proofCount   += proofCount;
+}
+
+//-----------------------------------------------------------
+void FarmSimPrintUsage()
+{
+    Log::Line( USAGE );
+}
@@ -5,13 +5,28 @@
 #include "plotdisk/jobs/IOJob.h"
 #include "plotting/GlobalPlotConfig.h"
 #include "util/jobs/MemJobs.h"
+#include "plotdisk/DiskPlotConfig.h"
+#include "threading/Thread.h"
 
 void IOTestPrintUsage();
 
 static const size_t FILE_NAME_SIZE = 32;
 
+struct WorkloadOptions
+{
+    size_t      size         = 0;
+    uint32      bucketCount  = 256;
+    uint32      passCount    = 1;
+    double      passDelaySec = 0.0;
+    bool        directIO     = true;
+    bool        alternating  = false;
+    const char* t1Dir        = nullptr;
+    const char* t2Dir        = nullptr;
+};
+
 static void GetTmpFileName( char fileName[FILE_NAME_SIZE] );
 static void InitPages( ThreadPool& pool, const uint32 threadCount, void* mem, const size_t size );
+static void IOTestWorkload( const WorkloadOptions& opts );
 
 
 //-----------------------------------------------------------
@@ -23,6 +38,10 @@ void IOTestMain( GlobalPlotConfig& gCfg, CliParser& cli )
     uint32      passCount    = 1;
     size_t      memReserve   = 0;
     double      passDelaySec = 0.0;
+    bool        workload     = false;
+    uint32      bucketCount  = 256;
+    bool        alternating  = false;
+    const char* t2Dir        = nullptr;
 
     while( cli.HasArgs() )
     {
@@ -45,6 +64,14 @@ void IOTestMain( GlobalPlotConfig& gCfg, CliParser& cli )
                 passDelaySec = 0;
             continue;
         }
+        else if( cli.ReadSwitch( workload, "-w", "--workload" ) )
+            continue;
+        else if( cli.ReadU32( bucketCount, "-b", "--buckets" ) )
+            continue;
+        else if( cli.ReadSwitch( alternating, "-a", "--alternate" ) )
+            continue;
+        else if( cli.ReadStr( t2Dir, "--t2" ) )
+            continue;
         else if( cli.ArgConsume( "-h", "--help" ) )
         {
             IOTestPrintUsage();
@@ -63,6 +90,27 @@ void IOTestMain( GlobalPlotConfig& gCfg, CliParser& cli )
     FatalIf( testDir == nullptr || testDir[0] == 0, 
         "Expected an output directory as the last argument." );
 
+    if( workload )
+    {
+        FatalIf( memReserve > 0, "--memory is not supported in workload mode." );
+        FatalIf( bucketCount < BB_DP_MIN_BUCKET_COUNT || bucketCount > BB_DP_MAX_BUCKET_COUNT,
+            "Buckets must be between %u and %u.", BB_DP_MIN_BUCKET_COUNT, BB_DP_MAX_BUCKET_COUNT );
+        FatalIf( ( bucketCount & ( bucketCount - 1 ) ) != 0, "Buckets must be power of 2." );
+
+        WorkloadOptions opts;
+        opts.size         = writeSize;
+        opts.bucketCount  = bucketCount;
+        opts.passCount    = passCount;
+        opts.passDelaySec = passDelaySec;
+        opts.directIO     = !noDirectIO;
+        opts.alternating  = alternating;
+        opts.t1Dir        = testDir;
+        opts.t2Dir        = t2Dir ? t2Dir : testDir;
+
+        IOTestWorkload( opts );
+        return;
+    }
+
 
     char* filePath    = nullptr;
     char* fileNamePtr = nullptr;
@@ -250,6 +298,445 @@ void IOTestMain( GlobalPlotConfig& gCfg, CliParser& cli )
     remove( filePath );
 }
 
+///
+/// Workload mode
+///
+// Replays the temp file access pattern of the disk plotter (see DiskBufferQueue),
+// using a single IO thread per temp directory, as the plotter does.
+struct WorkloadFileSet
+{
+    const char*              name;
+    uint32                   fileCount;
+    FileStream*              files;
+    std::vector<std::string> paths;
+};
+
+struct WorkloadResult
+{
+    const char* name;
+    size_t      writeBytes   = 0;
+    size_t      readBytes    = 0;
+    double      writeElapsed = 0;
+    double      readElapsed  = 0;
+    bool        concurrent   = false;   // Writes and reads were concurrent, so only the combined throughput is reported
+};
+
+// Approximate bytes per entry moved on each temp directory by each phase of a k32 plot.
+// Phase 1 writes/reads the y, index and meta buckets on temp2 while writing back pointers and maps to temp1.
+// Phase 2 reads back pointers and maps to mark entries.
+// Phase 3 reads back pointers and maps while writing/reading line point buckets on temp2.
+struct PhaseTraffic
+{
+    const char* name;
+    uint32      t1Write, t1Read;
+    uint32      t2Write, t2Read;
+};
+
+static const PhaseTraffic PHASE_TRAFFIC[] = {
+    { "Phase 1 t1/t2", 13, 0 , 20, 20 },
+    { "Phase 2 t1/t2", 0 , 13, 0 , 0  },
+    { "Phase 3 t1/t2", 0 , 13, 12, 12 },
+};
+
+struct WorkloadBuckets
+{
+    WorkloadFileSet* set;
+    size_t           sliceSize;
+    uint64           slotSize;     // Fixed slice slot size in alternating mode, 0 otherwise
+    bool             interleaved;
+    byte*            buffer;       // Holds a whole bucket
+    size_t           writeBytes;
+    size_t           readBytes;
+    double           writeElapsed;
+    double           readElapsed;
+};
+
+struct WorkloadSequential
+{
+    WorkloadFileSet* set;
+    uint32           writeFile;    // Reads are always from file 1
+    size_t           writeSize;
+    size_t           readSize;
+    size_t           chunkSize;
+    byte*            buffer;
+    double           elapsed;
+};
+
+static void OpenWorkloadFiles( WorkloadFileSet& set, const char* dir, const char* name, uint32 fileCount, FileFlags flags );
+static void DeleteWorkloadFiles( WorkloadFileSet& set );
+static void RunBucketPattern( WorkloadBuckets* job );
+static void RunSequentialTraffic( WorkloadSequential* job );
+static void LogWorkloadResult( const WorkloadResult& r );
+
+//-----------------------------------------------------------
+inline static double MiBPerSec( const size_t bytes, const double elapsed )
+{
+    return elapsed > 0 ? bytes / elapsed BtoMB : 0.0;
+}
+
+//-----------------------------------------------------------
+void IOTestWorkload( const WorkloadOptions& opts )
+{
+    const uint32 bucketCount = opts.bucketCount;
+
+    FileFlags flags = FileFlags::LargeFile;
+    if( opts.directIO )
+        flags |= FileFlags::NoBuffering;
+
+    WorkloadFileSet t1Set, t2Set;
+    OpenWorkloadFiles( t1Set, opts.t1Dir, "t1", 2          , flags );
+    OpenWorkloadFiles( t2Set, opts.t2Dir, "t2", bucketCount, flags );
+
+    const size_t blockSize = t2Set.files[0].BlockSize();
+    FatalIf( blockSize < 1, "Invalid file system block size of 0." );
+
+    // Slices are written block-aligned by the plotter, so we do the same
+    const size_t sliceSize = RoundUpToNextBoundaryT( opts.size / ( (size_t)bucketCount * bucketCount ), blockSize );
+    FatalIf( opts.size / ( (size_t)bucketCount * bucketCount ) < blockSize, 
+        "The size is too small for %u buckets. Each slice must be at least one block (%llu bytes). Use a bigger --size or fewer --buckets.",
+        bucketCount, (llu)blockSize );
+
+    // Alternating mode writes slices at fixed slot boundaries, which are sized for the largest slice
+    const uint64 slotSize    = RoundUpToNextBoundaryT( (size_t)( sliceSize * BB_DP_XTRA_ENTRIES_PER_BUCKET ), blockSize );
+    const size_t bucketSize  = sliceSize * bucketCount;
+    const size_t patternSize = bucketSize * bucketCount;
+
+    Log::Line( "Workload   : %s", opts.alternating ? "alternating buckets" : "interleaved buckets" );
+    Log::Line( "Temp1      : %s", opts.t1Dir );
+    Log::Line( "Temp2      : %s", opts.t2Dir );
+    Log::Line( "Buckets    : %u", bucketCount );
+    Log::Line( "Slice size : %.2lf KiB", (double)sliceSize BtoKB );
+    Log::Line( "Data size  : %.2lf MiB", (double)patternSize BtoMB );
+    Log::Line( "Direct IO  : %s", opts.directIO ? "true" : "false" );
+    Log::Line( "Block size : %llu", (llu)blockSize );
+    Log::Line( "" );
+
+    const size_t chunkSize = RoundUpToNextBoundaryT( (size_t)( 8 MB ), blockSize );
+
+    byte* t2Buffer = bbvirtalloc<byte>( bucketCount * ( opts.alternating ? slotSize : sliceSize ) );
+    byte* t1Buffer = bbvirtalloc<byte>( chunkSize );
+    SysHost::Random( t2Buffer, bucketSize );
+    SysHost::Random( t1Buffer, chunkSize );
+
+    std::vector<WorkloadResult> results;
+
+    for( uint32 pass = 0; pass < opts.passCount; pass++ )
+    {
+        if( opts.passCount > 1 )
+            Log::Line( "[Pass %u/%u]", pass+1, opts.passCount );
+
+        auto runBuckets = [&]( const char* name, const bool interleaved, const uint64 slot ) {
+
+            WorkloadBuckets job = {};
+            job.set         = &t2Set;
+            job.sliceSize   = sliceSize;
+            job.slotSize    = slot;
+            job.interleaved = interleaved;
+            job.buffer      = t2Buffer;
+
+            Log::Line( "%s...", name );
+            RunBucketPattern( &job );
+
+            WorkloadResult r;
+            r.name         = name;
+            r.writeBytes   = job.writeBytes;
+            r.readBytes    = job.readBytes;
+            r.writeElapsed = job.writeElapsed;
+            r.readElapsed  = job.readElapsed;
+            
+            LogWorkloadResult( r );
+            results.push_back( r );
+        };
+
+        // Bucket slices appended to each bucket's file, then whole buckets read back (unbounded/t1 bucket sets)
+        runBuckets( "Sequential slices", false, 0 );
+
+        if( opts.alternating )
+        {
+            // Odd tables write each slice to its bucket's file, even tables write whole buckets to a single file.
+            // Either way, slices are at fixed slots, so every slice is seeked to.
+            runBuckets( "Alternating, slice writes" , false, slotSize );
+            runBuckets( "Alternating, bucket writes", true , slotSize );
+        }
+        else
+        {
+            // Whole buckets written to a single file, read back one slice from each file
+            runBuckets( "Interleaved", true, 0 );
+        }
+
+        // Concurrent temp1 and temp2 traffic, at each phase's ratio.
+        // Temp2 traffic replays the bucket pattern, while temp1 is written and read sequentially.
+        for( const PhaseTraffic& phase : PHASE_TRAFFIC )
+        {
+            const size_t entryCount = patternSize / 20;
+
+            WorkloadBuckets t2Job = {};
+            t2Job.set         = &t2Set;
+            t2Job.sliceSize   = RoundUpToNextBoundaryT( sliceSize * phase.t2Write / 20, blockSize );
+            t2Job.slotSize    = opts.alternating ? slotSize : 0;
+            t2Job.interleaved = true;
+            t2Job.buffer      = t2Buffer;
+
+            WorkloadSequential t1Job = {};
+            t1Job.set       = &t1Set;
+            t1Job.writeFile = 0;
+            t1Job.writeSize = RoundUpToNextBoundaryT( entryCount * phase.t1Write, chunkSize );
+            t1Job.readSize  = RoundUpToNextBoundaryT( entryCount * phase.t1Read , chunkSize );
+            t1Job.chunkSize = chunkSize;
+            t1Job.buffer    = t1Buffer;
+
+            // Data read from temp1 must exist before it's read, so write it up front
+            if( t1Job.readSize )
+            {
+                WorkloadSequential prepare = t1Job;
+                prepare.writeFile = 1;
+                prepare.writeSize = t1Job.readSize;
+                prepare.readSize  = 0;
+                RunSequentialTraffic( &prepare );
+            }
+
+            Log::Line( "%s...", phase.name );
+
+            const auto timer = TimerBegin();
+
+            Thread t1Thread;
+            t1Thread.Run( RunSequentialTraffic, &t1Job );
+
+            if( phase.t2Write )
+                RunBucketPattern( &t2Job );
+            
+            t1Thread.WaitForExit();
+
+            const double elapsed = TimerEnd( timer );
+
+            WorkloadResult r;
+            r.name         = phase.name;
+            r.writeBytes   = t2Job.writeBytes + t1Job.writeSize;
+            r.readBytes    = t2Job.readBytes  + t1Job.readSize;
+            r.writeElapsed = elapsed;
+            r.readElapsed  = elapsed;
+            r.concurrent   = true;
+
+            Log::Line( " temp1: %.2lf MiB written, %.2lf MiB read in %.2lf seconds @ %.2lf MiB/s.", 
+                (double)t1Job.writeSize BtoMB, (double)t1Job.readSize BtoMB, t1Job.elapsed, 
+                MiBPerSec( t1Job.writeSize + t1Job.readSize, t1Job.elapsed ) );
+
+            if( phase.t2Write )
+            {
+                const double t2Elapsed = t2Job.writeElapsed + t2Job.readElapsed;
+                Log::Line( " temp2: %.2lf MiB written, %.2lf MiB read in %.2lf seconds @ %.2lf MiB/s.", 
+                    (double)t2Job.writeBytes BtoMB, (double)t2Job.readBytes BtoMB, t2Elapsed,
+                    MiBPerSec( t2Job.writeBytes + t2Job.readBytes, t2Elapsed ) );
+            }
+
+            Log::Line( " Combined: %.2lf MiB/s.", MiBPerSec( r.writeBytes + r.readBytes, elapsed ) );
+            results.push_back( r );
+        }
+
+        Log::Line( "" );
+
+        if( pass+1 < opts.passCount && opts.passDelaySec > 0 )
+            Thread::Sleep( (long)( opts.passDelaySec * 1000.0 ) );
+    }
+
+    // Summary
+    Log::Line( "%-28s %12s %12s", "Pattern", "Write MiB/s", "Read MiB/s" );
+    for( const WorkloadResult& r : results )
+    {
+        if( r.concurrent )
+            Log::Line( "%-28s %12.2lf combined", r.name, MiBPerSec( r.writeBytes + r.readBytes, r.writeElapsed ) );
+        else
+            Log::Line( "%-28s %12.2lf %12.2lf", r.name, MiBPerSec( r.writeBytes, r.writeElapsed ), MiBPerSec( r.readBytes, r.readElapsed ) );
+    }
+
+    DeleteWorkloadFiles( t1Set );
+    DeleteWorkloadFiles( t2Set );
+
+    bbvirtfree( t1Buffer );
+    bbvirtfree( t2Buffer );
+}
+
+//-----------------------------------------------------------
+void OpenWorkloadFiles( WorkloadFileSet& set, const char* dir, const char* name, const uint32 fileCount, const FileFlags flags )
+{
+    char tmpName[FILE_NAME_SIZE+1];
+    GetTmpFileName( tmpName );
+    tmpName[FILE_NAME_SIZE] = 0;
+
+    std::string basePath = dir;
+    if( !basePath.empty() && basePath.back() != '/' && basePath.back() != '\\' )
+        basePath += '/';
+
+    set.name      = name;
+    set.fileCount = fileCount;
+    set.files     = new FileStream[fileCount];
+
+    for( uint32 i = 0; i < fileCount; i++ )
+    {
+        char fileName[FILE_NAME_SIZE + 32];
+        snprintf( fileName, sizeof( fileName ), "%s_%s_%u.tmp", tmpName, name, i );
+        set.paths.push_back( basePath + fileName );
+
+        FatalIf( !set.files[i].Open( set.paths[i].c_str(), FileMode::Create, FileAccess::ReadWrite, flags ),
+            "Failed to open temporary test file at path '%s' with error: %d.", set.paths[i].c_str(), set.files[i].GetError() );
+    }
+}
+
+//-----------------------------------------------------------
+void DeleteWorkloadFiles( WorkloadFileSet& set )
+{
+    delete[] set.files;
+    set.files = nullptr;
+
+    for( const std::string& path : set.paths )
+        remove( path.c_str() );
+}
+
+//-----------------------------------------------------------
+static void WorkloadSeek( WorkloadFileSet& set, const uint32 fileIdx, const int64 offset )
+{
+    FileStream& file = set.files[fileIdx];
+    FatalIf( !file.Seek( offset, SeekOrigin::Begin ), "Failed to seek %s file %u with error %d.", set.name, fileIdx, file.GetError() );
+}
+
+//-----------------------------------------------------------
+static void WorkloadWrite( WorkloadFileSet& set, const uint32 fileIdx, const byte* buffer, size_t size )
+{
+    FileStream& file = set.files[fileIdx];
+
+    while( size )
+    {
+        const ssize_t written = file.Write( buffer, size );
+        FatalIf( written <= 0, "Failed to write to %s file %u with error %d.", set.name, fileIdx, file.GetError() );
+
+        size   -= (size_t)written;
+        buffer += written;
+    }
+}
+
+//-----------------------------------------------------------
+static void WorkloadRead( WorkloadFileSet& set, const uint32 fileIdx, byte* buffer, size_t size )
+{
+    FileStream& file = set.files[fileIdx];
+
+    while( size )
+    {
+        const ssize_t read = file.Read( buffer, size );
+        FatalIf( read <= 0, "Failed to read from %s file %u with error %d.", set.name, fileIdx, file.GetError() );
+
+        size   -= (size_t)read;
+        buffer += read;
+    }
+}
+
+//-----------------------------------------------------------
+// Writes every bucket slice, then reads back every bucket, in the same order as DiskBufferQueue.
+// When interleaved, each round writes all of its slices to a single file, so reading a bucket
+// takes one slice from each file. Otherwise each slice goes to the file of its bucket.
+// When a slot size is given (alternating mode), each slice is at a fixed slot and is seeked to.
+void RunBucketPattern( WorkloadBuckets* job )
+{
+    WorkloadFileSet& set         = *job->set;
+    const uint32     bucketCount = set.fileCount;
+    const size_t     sliceSize   = job->sliceSize;
+    const uint64     slotSize    = job->slotSize;
+    const bool       interleaved = job->interleaved;
+    byte*            buffer      = job->buffer;
+
+    for( uint32 i = 0; i < bucketCount; i++ )
+        WorkloadSeek( set, i, 0 );
+
+    // Write
+    auto timer = TimerBegin();
+
+    for( uint32 round = 0; round < bucketCount; round++ )
+    {
+        if( interleaved && slotSize == 0 )
+        {
+            WorkloadWrite( set, round, buffer, sliceSize * bucketCount );
+            continue;
+        }
+
+        for( uint32 slice = 0; slice < bucketCount; slice++ )
+        {
+            const uint32 fileIdx = interleaved ? round : slice;
+
+            if( slotSize )
+                WorkloadSeek( set, fileIdx, (int64)( ( interleaved ? slice : round ) * slotSize ) );
+
+            WorkloadWrite( set, fileIdx, buffer + slice * sliceSize, sliceSize );
+        }
+    }
+
+    job->writeElapsed = TimerEnd( timer );
+    job->writeBytes   = sliceSize * bucketCount * bucketCount;
+
+    // Read
+    for( uint32 i = 0; i < bucketCount; i++ )
+        WorkloadSeek( set, i, 0 );
+
+    timer = TimerBegin();
+
+    for( uint32 bucket = 0; bucket < bucketCount; bucket++ )
+    {
+        if( !interleaved && slotSize == 0 )
+        {
+            WorkloadRead( set, bucket, buffer, sliceSize * bucketCount );
+            continue;
+        }
+
+        for( uint32 slice = 0; slice < bucketCount; slice++ )
+        {
+            const uint32 fileIdx = interleaved ? slice : bucket;
+
+            if( slotSize )
+                WorkloadSeek( set, fileIdx, (int64)( ( interleaved ? bucket : slice ) * slotSize ) );
+
+            WorkloadRead( set, fileIdx, buffer + slice * sliceSize, sliceSize );
+        }
+    }
+
+    job->readElapsed = TimerEnd( timer );
+    job->readBytes   = job->writeBytes;
+}
+
+//-----------------------------------------------------------
+// Sequential temp1 traffic: Writes to one file while reading from another, alternating chunks.
+void RunSequentialTraffic( WorkloadSequential* job )
+{
+    WorkloadFileSet& set = *job->set;
+
+    WorkloadSeek( set, job->writeFile, 0 );
+    WorkloadSeek( set, 1, 0 );
+
+    const auto timer = TimerBegin();
+
+    size_t written = 0, read = 0;
+    while( written < job->writeSize || read < job->readSize )
+    {
+        if( read < job->readSize )
+        {
+            WorkloadRead( set, 1, job->buffer, job->chunkSize );
+            read += job->chunkSize;
+        }
+
+        if( written < job->writeSize )
+        {
+            WorkloadWrite( set, job->writeFile, job->buffer, job->chunkSize );
+            written += job->chunkSize;
+        }
+    }
+
+    job->elapsed = TimerEnd( timer );
+}
+
+//-----------------------------------------------------------
+void LogWorkloadResult( const WorkloadResult& r )
+{
+    Log::Line( " Wrote %.2lf MiB in %.2lf seconds @ %.2lf MiB/s.", (double)r.writeBytes BtoMB, r.writeElapsed, MiBPerSec( r.writeBytes, r.writeElapsed ) );
+    Log::Line( " Read  %.2lf MiB in %.2lf seconds @ %.2lf MiB/s.", (double)r.readBytes  BtoMB, r.readElapsed , MiBPerSec( r.readBytes , r.readElapsed  ) );
+}
+
 //-----------------------------------------------------------
 void GetTmpFileName( char fileName[FILE_NAME_SIZE] )
 {
@@ -275,6 +762,13 @@ static const char* USAGE = R"(iotest [OPTIONS] <test_dir>
 
 Performs read/write test on the specified disk path.
 
+With --workload, the disk plotter's temp file access pattern is replayed instead:
+Bucket slices are written to and read from many bucket files, in the same order as
+the plotter does, followed by concurrent temp1 and temp2 traffic at the rough ratios
+of each plotting phase. The throughput of each pattern is reported.
+IO is issued from a single thread per temp directory, as the plotter does,
+so the -t option is not used in this mode.
+
 [OPTIONS]
  -s, --size <size>  : Size to write. Default is 4GB.
                       Ex: 512MB 1GB 16GB
@@ -287,6 +781,16 @@ Performs read/write test on the specified disk path.
  
  --delay <secs>     : Time (in seconds) to wait between passes.
 
+ -w, --workload     : Replay the disk plotter's bucket access pattern.
+                      The -s size is the size of the bucket data written by each pattern.
+
+ -b, --buckets <n>  : Number of buckets to use in workload mode. Default is 256.
+
+ -a, --alternate    : Use the plotter's alternating bucket mode (diskplot -a) in workload mode.
+
+ --t2 <dir>         : Directory for the high-frequency bucket files (diskplot -t2) in workload mode.
+                      By default <test_dir> is used for both.
+
  -h, --help         : Print this help message and exit.
 )";
 
@@ -0,0 +1,813 @@
+#include "util/CliParser.h"
+#include "util/Log.h"
+#include "util/Util.h"
+#include "threading/MTJob.h"
+#include "threading/ThreadPool.h"
+#include "algorithm/RadixSort.h"
+#include "pos/chacha8.h"
+#include "plotting/PlotTypes.h"
+#include "plotting/PlotTools.h"
+#include "plotdisk/k32/FpMatchBounded.inl"
+#include "plotdisk/FpFxGen.h"
+#include "plotmem/LPGen.h"
+#include "plotmem/ParkWriter.h"
+#include "plotdisk/MarkTableEntries.h"
+#include "util/BitView.h"
+#include "Version.h"
+#include <vector>
+
+static const char* USAGE = R"(bench [OPTIONS] [<kernel> ...]
+
+Times the plotter's hot kernels on synthetic data, at one or more thread counts,
+and reports the time per entry and the throughput of each kernel.
+Use it to compare CPUs and compiler flags, and to check kernel changes for regressions.
+
+Kernels are selected by name prefix, ex: 'bench sort fx_t3' runs all sorts and table 3 fx.
+All kernels are run if none are given. See --list for the available kernels.
+
+Each kernel is run once to warm up, then timed over --runs runs. The fastest run is
+reported as ns/entry and GB/s. GB/s counts the bytes of the kernel's input and
+output once per entry, so it is comparable between thread counts, not between kernels.
+
+[OPTIONS]
+ -e, --entries <n>   : Entries processed per run. The default is 16777216 (2^24),
+                       the size of a k32 bucket with 256 buckets.
+
+ -r, --runs <n>      : Timed runs per kernel and thread count. The default is 3.
+
+ -t, --threads <list>: Comma-separated thread counts to run each kernel with, ex: 1,4,16.
+                       The default is 1 and powers of 2 up to all logical CPUs.
+
+ -j, --json <path>   : Write the results to a JSON file.
+
+ -l, --list          : List the kernels and exit.
+
+ -h, --help          : Print this help message and exit.
+)";
+
+struct Bench
+{
+    ThreadPool* pool;
+    uint64      entries;
+    byte*       buffers[5];     // Synthetic inputs and outputs. See BUFFER_ENTRY_SIZES.
+};
+
+// Kernels prepare their input with Prepare, which is not timed,
+// and Run returns the number of bytes of input and output it processed.
+struct Kernel
+{
+    const char* name;
+    const char* description;
+    void      (*Prepare)( Bench& bench );
+    uint64    (*Run    )( Bench& bench, uint32 threadCount );
+};
+
+struct KernelResult
+{
+    const char* kernel;
+    uint32      threadCount;
+    double      best;       // Seconds
+    double      mean;
+    uint64      bytes;
+};
+
+// Bytes per entry of each of the benchmark buffers
+static const size_t BUFFER_ENTRY_SIZES[5] = { 8, 8, 16, 8, 16 };
+
+// Extra entries allocated in each buffer, for the kernels which read past their entry count
+static const uint64 BUFFER_EXTRA_ENTRIES = kEntriesPerPark + 64;
+
+static void   FillRandom( ThreadPool& pool, uint64* buffer, uint64 count, uint64 seed );
+static void   ParseThreadCounts( const char* list, const uint32 maxThreads, std::vector<uint32>& threadCounts );
+static void   WriteJson( const char* path, const Bench& bench, uint32 runCount, const std::vector<KernelResult>& results );
+
+template<typename T>
+static uint64 RunSort( Bench& bench, const uint32 threadCount );
+
+template<typename T, typename TKey>
+static uint64 RunSortWithKey( Bench& bench, const uint32 threadCount );
+
+template<TableId table>
+static void   PrepareFx( Bench& bench );
+
+template<TableId table>
+static uint64 RunFx( Bench& bench, const uint32 threadCount );
+
+static void   PrepareSort32( Bench& bench );
+static void   PrepareSort64( Bench& bench );
+static void   PrepareSortY ( Bench& bench );
+static uint64 RunSortY     ( Bench& bench, const uint32 threadCount );
+static uint64 RunSortYKey  ( Bench& bench, const uint32 threadCount );
+static void   PrepareNone  ( Bench& bench );
+static uint64 RunF1        ( Bench& bench, const uint32 threadCount );
+static void   PrepareMatch ( Bench& bench );
+static uint64 RunMatch     ( Bench& bench, const uint32 threadCount );
+static void   PrepareRandom( Bench& bench );
+static uint64 RunBitPack   ( Bench& bench, const uint32 threadCount );
+static uint64 RunBitPacker ( Bench& bench, const uint32 threadCount );
+static uint64 RunBitUnpack ( Bench& bench, const uint32 threadCount );
+static uint64 RunBitUnpacker( Bench& bench, const uint32 threadCount );
+static void   PrepareParks ( Bench& bench );
+static uint64 RunParks     ( Bench& bench, const uint32 threadCount );
+static uint64 RunParkEncoder( Bench& bench, const uint32 threadCount );
+static uint64 RunLinePoints( Bench& bench, const uint32 threadCount );
+static void   PrepareMarks ( Bench& bench );
+static uint64 RunMarkHalves( Bench& bench, const uint32 threadCount );
+static uint64 RunMarkAtomic( Bench& bench, const uint32 threadCount );
+
+static const Kernel KERNELS[] = {
+    { "sort32"     , "RadixSort256::Sort on 32-bit keys"                         , PrepareSort32, RunSort<uint32>                  },
+    { "sort32_key" , "RadixSort256::SortWithKey on 32-bit keys with a 32-bit key", PrepareSort32, RunSortWithKey<uint32, uint32> },
+    { "sort64"     , "RadixSort256::Sort on 64-bit keys"                         , PrepareSort64, RunSort<uint64>                  },
+    { "sort_y"     , "RadixSort256::SortY on 38-bit y values (5 passes)"         , PrepareSortY , RunSortY                         },
+    { "sort_y_key" , "RadixSort256::SortYWithKey on 38-bit y values"             , PrepareSortY , RunSortYKey                      },
+    { "f1"         , "ChaCha8 F1 keystream block generation"                     , PrepareNone  , RunF1                            },
+    { "fx_t2"      , "Fx blake3 hashing of table 2 pairs"                        , PrepareFx<TableId::Table2>, RunFx<TableId::Table2> },
+    { "fx_t3"      , "Fx blake3 hashing of table 3 pairs"                        , PrepareFx<TableId::Table3>, RunFx<TableId::Table3> },
+    { "fx_t4"      , "Fx blake3 hashing of table 4 pairs"                        , PrepareFx<TableId::Table4>, RunFx<TableId::Table4> },
+    { "fx_t5"      , "Fx blake3 hashing of table 5 pairs"                        , PrepareFx<TableId::Table5>, RunFx<TableId::Table5> },
+    { "fx_t6"      , "Fx blake3 hashing of table 6 pairs"                        , PrepareFx<TableId::Table6>, RunFx<TableId::Table6> },
+    { "fx_t7"      , "Fx blake3 hashing of table 7 pairs"                        , PrepareFx<TableId::Table7>, RunFx<TableId::Table7> },
+    { "match"      , "FxMatcherBounded::Match of a bucket of sorted y values"    , PrepareMatch , RunMatch                         },
+    { "bitpack"    , "Bit-packing of 40-bit entries into bucket bit fields"      , PrepareRandom, RunBitPack                       },
+    { "bitpack_n"  , "BitPacker: Bit-packing of 40-bit entries of a fixed size"  , PrepareRandom, RunBitPacker                     },
+    { "bitunpack"  , "BitReader: Unpacking of 40-bit entries from bit fields"    , PrepareRandom, RunBitUnpack                     },
+    { "bitunpack_n", "BitUnpacker: Unpacking of 40-bit entries of a fixed size"  , PrepareRandom, RunBitUnpacker                   },
+    { "park"       , "WritePark: FSE encoding of line point parks"               , PrepareParks , RunParks                         },
+    { "park_enc"   , "ParkEncoder: Line point parks encoded 4 at a time"        , PrepareParks , RunParkEncoder                   },
+    { "lp"         , "SquareToLinePoint conversion of back pointers"             , PrepareRandom, RunLinePoints                    },
+    { "mark_halves", "Phase 2 marking in 2 half passes with a barrier"           , PrepareMarks , RunMarkHalves                    },
+    { "mark_atomic", "Phase 2 marking in a single pass with atomic bit sets"     , PrepareMarks , RunMarkAtomic                    },
+};
+
+//-----------------------------------------------------------
+int main( int argc, const char* argv[] )
+{
+    SysHost::InstallCrashHandler();
+
+    const uint32 maxThreads = SysHost::GetLogicalCPUCount();
+
+    const char* jsonPath    = nullptr;
+    const char* threadList  = nullptr;
+    uint64      entryCount  = 1ull << 24;
+    uint32      runCount    = 3;
+
+    std::vector<const char*> kernelNames;
+
+    CliParser cli( --argc, ++argv );
+
+    while( cli.HasArgs() )
+    {
+        if( cli.ReadU64( entryCount, "-e", "--entries" ) )
+            continue;
+        else if( cli.ReadU32( runCount, "-r", "--runs" ) )
+            continue;
+        else if( cli.ReadStr( threadList, "-t", "--threads" ) )
+            continue;
+        else if( cli.ReadStr( jsonPath, "-j", "--json" ) )
+            continue;
+        else if( cli.ArgConsume( "-l", "--list" ) )
+        {
+            for( const Kernel& kernel : KERNELS )
+                Log::Line( " %-12s: %s", kernel.name, kernel.description );
+            exit( 0 );
+        }
+        else if( cli.ArgConsume( "-h", "--help" ) )
+        {
+            Log::Line( USAGE );
+            exit( 0 );
+        }
+        else
+            kernelNames.push_back( cli.ArgConsume() );
+    }
+
+    FatalIf( runCount < 1, "Run count must be at least 1." );
+    FatalIf( entryCount < kEntriesPerPark, "Entry count must be at least %u.", (uint32)kEntriesPerPark );
+    FatalIf( entryCount > 0xFFFFFFFFull - BUFFER_EXTRA_ENTRIES, "Entry count must fit in 32 bits." );
+
+    std::vector<uint32> threadCounts;
+    ParseThreadCounts( threadList, maxThreads, threadCounts );
+
+    // Select the kernels by name prefix
+    std::vector<const Kernel*> kernels;
+    for( const Kernel& kernel : KERNELS )
+    {
+        bool selected = kernelNames.empty();
+        for( const char* name : kernelNames )
+            selected = selected || strncmp( kernel.name, name, strlen( name ) ) == 0;
+
+        if( selected )
+            kernels.push_back( &kernel );
+    }
+
+    for( const char* name : kernelNames )
+    {
+        bool found = false;
+        for( const Kernel* kernel : kernels )
+            found = found || strncmp( kernel->name, name, strlen( name ) ) == 0;
+
+        FatalIf( !found, "Unknown kernel '%s'. See --list for the available kernels.", name );
+    }
+
+    // Initialize tables for matching
+    LoadLTargets();
+
+    Bench bench = {};
+    bench.pool    = new ThreadPool( maxThreads );
+    bench.entries = entryCount;
+
+    size_t heapSize = 0;
+    for( uint32 i = 0; i < 5; i++ )
+    {
+        bench.buffers[i] = bbvirtalloc<byte>( ( entryCount + BUFFER_EXTRA_ENTRIES ) * BUFFER_ENTRY_SIZES[i] );
+        heapSize += ( entryCount + BUFFER_EXTRA_ENTRIES ) * BUFFER_ENTRY_SIZES[i];
+    }
+
+    Log::Line( "[Kernel Bench]" );
+    Log::Line( " Entries : %llu", (llu)entryCount );
+    Log::Line( " Runs    : %u", runCount );
+    Log::Line( " Memory  : %.2lf GiB", (double)heapSize BtoGB );
+    Log::Line( "" );
+
+    std::vector<KernelResult> results;
+
+    for( const Kernel* kernel : kernels )
+    {
+        Log::Line( "%s: %s", kernel->name, kernel->description );
+
+        for( const uint32 threadCount : threadCounts )
+        {
+            KernelResult result = {};
+            result.kernel      = kernel->name;
+            result.threadCount = threadCount;
+            result.best        = std::numeric_limits<double>::max();
+
+            // Warm up
+            kernel->Prepare( bench );
+            kernel->Run( bench, threadCount );
+
+            for( uint32 run = 0; run < runCount; run++ )
+            {
+                kernel->Prepare( bench );
+
+                const auto timer = TimerBegin();
+                result.bytes = kernel->Run( bench, threadCount );
+                const double elapsed = TicksToSeconds( TimerEndTicks( timer ) );
+
+                result.best  = std::min( result.best, elapsed );
+                result.mean += elapsed / runCount;
+            }
+
+            Log::Line( " %3u threads: %9.3lf ns/entry | %8.2lf GB/s | mean %9.3lf ns/entry",
+                threadCount, result.best * 1e9 / entryCount, result.bytes / result.best / 1e9, result.mean * 1e9 / entryCount );
+
+            results.push_back( result );
+        }
+
+        Log::Line( "" );
+    }
+
+    if( jsonPath )
+        WriteJson( jsonPath, bench, runCount, results );
+
+    return 0;
+}
+
+//-----------------------------------------------------------
+void ParseThreadCounts( const char* list, const uint32 maxThreads, std::vector<uint32>& threadCounts )
+{
+    if( !list )
+    {
+        for( uint32 i = 1; i < maxThreads; i *= 2 )
+            threadCounts.push_back( i );
+
+        threadCounts.push_back( maxThreads );
+        return;
+    }
+
+    for( const char* str = list; *str; )
+    {
+        char* end = nullptr;
+        const unsigned long count = strtoul( str, &end, 10 );
+
+        FatalIf( end == str || ( *end != ',' && *end != 0 ), "Invalid thread count list '%s'.", list );
+        FatalIf( count < 1 || count > maxThreads, "Thread counts must be between 1 and %u.", maxThreads );
+        FatalIf( count > BB_MAX_JOBS, "Thread counts must not exceed %u.", (uint32)BB_MAX_JOBS );
+
+        threadCounts.push_back( (uint32)count );
+        str = *end ? end + 1 : end;
+    }
+}
+
+//-----------------------------------------------------------
+void FillRandom( ThreadPool& pool, uint64* buffer, const uint64 count, const uint64 seed )
+{
+    AnonMTJob::Run( pool, [=]( AnonMTJob* self ) {
+
+        uint64 threadCount, offset, end;
+        GetThreadOffsets( self, count, threadCount, offset, end );
+
+        // splitmix64
+        uint64 state = seed + offset * 0x9E3779B97F4A7C15ull;
+
+        for( uint64 i = offset; i < end; i++ )
+        {
+            uint64 z = ( state += 0x9E3779B97F4A7C15ull );
+            z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+            z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+            buffer[i] = z ^ ( z >> 31 );
+        }
+    });
+}
+
+//-----------------------------------------------------------
+void PrepareNone( Bench& bench )
+{
+    (void)bench;
+}
+
+//-----------------------------------------------------------
+void PrepareRandom( Bench& bench )
+{
+    FillRandom( *bench.pool, (uint64*)bench.buffers[0], bench.entries, 1 );
+}
+
+//-----------------------------------------------------------
+void PrepareSort32( Bench& bench )
+{
+    FillRandom( *bench.pool, (uint64*)bench.buffers[0], CDiv( bench.entries, 2 ), 2 );
+}
+
+//-----------------------------------------------------------
+void PrepareSort64( Bench& bench )
+{
+    FillRandom( *bench.pool, (uint64*)bench.buffers[0], bench.entries, 3 );
+}
+
+//-----------------------------------------------------------
+void PrepareSortY( Bench& bench )
+{
+    uint64* y = (uint64*)bench.buffers[0];
+    FillRandom( *bench.pool, y, bench.entries, 4 );
+
+    const uint64 yMask = ( 1ull << ( _K + kExtraBits ) ) - 1;
+    for( uint64 i = 0; i < bench.entries; i++ )
+        y[i] &= yMask;
+}
+
+//-----------------------------------------------------------
+template<typename T>
+uint64 RunSort( Bench& bench, const uint32 threadCount )
+{
+    RadixSort256::Sort<BB_MAX_JOBS>( *bench.pool, threadCount, (T*)bench.buffers[0], (T*)bench.buffers[1], bench.entries );
+    return bench.entries * sizeof( T ) * 2;
+}
+
+//-----------------------------------------------------------
+template<typename T, typename TKey>
+uint64 RunSortWithKey( Bench& bench, const uint32 threadCount )
+{
+    RadixSort256::SortWithKey<BB_MAX_JOBS>( *bench.pool, threadCount, (T*)bench.buffers[0], (T*)bench.buffers[1],
+                                            (TKey*)bench.buffers[2], (TKey*)bench.buffers[3], bench.entries );
+    return bench.entries * ( sizeof( T ) + sizeof( TKey ) ) * 2;
+}
+
+//-----------------------------------------------------------
+uint64 RunSortY( Bench& bench, const uint32 threadCount )
+{
+    // Same as RadixSort256::SortY, which does not take a thread count
+    RadixSort256::Sort<BB_MAX_JOBS, uint64, 5>( *bench.pool, threadCount, (uint64*)bench.buffers[0], (uint64*)bench.buffers[1], bench.entries );
+    return bench.entries * sizeof( uint64 ) * 2;
+}
+
+//-----------------------------------------------------------
+uint64 RunSortYKey( Bench& bench, const uint32 threadCount )
+{
+    // Same as RadixSort256::SortYWithKey, which does not take a thread count
+    RadixSort256::SortWithKey<BB_MAX_JOBS, uint64, uint32, 5>( *bench.pool, threadCount, (uint64*)bench.buffers[0], (uint64*)bench.buffers[1],
+                                                               (uint32*)bench.buffers[2], (uint32*)bench.buffers[3], bench.entries );
+    return bench.entries * ( sizeof( uint64 ) + sizeof( uint32 ) ) * 2;
+}
+
+//-----------------------------------------------------------
+uint64 RunF1( Bench& bench, const uint32 threadCount )
+{
+    const uint64 entriesPerBlock = kF1BlockSize / sizeof( uint32 );
+    const uint64 blockCount      = bench.entries / entriesPerBlock;
+    byte*        blocks          = bench.buffers[0];
+
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        byte key[BB_PLOT_ID_LEN] = { 1 };
+
+        chacha8_ctx chacha;
+        chacha8_keysetup( &chacha, key, 256, nullptr );
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, blockCount, count, offset, end );
+
+        chacha8_get_keystream( &chacha, offset, (uint32)count, blocks + offset * kF1BlockSize );
+    });
+
+    return blockCount * kF1BlockSize;
+}
+
+//-----------------------------------------------------------
+template<TableId table>
+void PrepareFx( Bench& bench )
+{
+    using TMetaIn = typename FpFxGen<table>::TMetaIn;
+
+    const uint64 entries = bench.entries;
+    Pair*        pairs   = (Pair*)bench.buffers[0];
+
+    FillRandom( *bench.pool, (uint64*)bench.buffers[1], entries + 64, 5 );
+    FillRandom( *bench.pool, (uint64*)bench.buffers[2], CDiv( ( entries + 64 ) * sizeof( TMetaIn ), 8 ), 6 );
+
+    // Matches are between nearby entries, as in a bucket sorted on y
+    uint64* rand = (uint64*)bench.buffers[3];
+    FillRandom( *bench.pool, rand, entries, 7 );
+
+    for( uint64 i = 0; i < entries; i++ )
+    {
+        pairs[i].left  = (uint32)i;
+        pairs[i].right = (uint32)( i + 1 + ( rand[i] & 63 ) );
+    }
+}
+
+//-----------------------------------------------------------
+template<TableId table>
+uint64 RunFx( Bench& bench, const uint32 threadCount )
+{
+    using Gen      = FpFxGen<table>;
+    using TMetaIn  = typename Gen::TMetaIn;
+    using TMetaOut = typename Gen::TMetaOut;
+    using TYOut    = typename Gen::TYOut;
+
+    Gen fx( *bench.pool, threadCount );
+    fx.ComputeFxMT( (int64)bench.entries, (Pair*)bench.buffers[0], (uint64*)bench.buffers[1], (TMetaIn*)bench.buffers[2],
+                    (TYOut*)bench.buffers[3], (TMetaOut*)bench.buffers[4] );
+
+    const size_t metaOutSize = Gen::MetaOutMulti == 0 ? 0 : sizeof( TMetaOut );
+    return bench.entries * ( sizeof( Pair ) + ( sizeof( uint64 ) + sizeof( TMetaIn ) ) * 2 + sizeof( TYOut ) + metaOutSize );
+}
+
+//-----------------------------------------------------------
+void PrepareMatch( Bench& bench )
+{
+    // A bucket of y values with the same density as a k32 bucket: 2^32 entries over a 2^38 y range
+    const uint64 entries = bench.entries;
+    const uint64 yRange  = entries << kExtraBits;
+
+    uint64* rand = (uint64*)bench.buffers[1];
+    uint32* y    = (uint32*)bench.buffers[0];
+
+    FillRandom( *bench.pool, rand, entries, 8 );
+
+    for( uint64 i = 0; i < entries; i++ )
+        y[i] = (uint32)( rand[i] % yRange );
+
+    RadixSort256::Sort<BB_MAX_JOBS>( *bench.pool, y, (uint32*)bench.buffers[1], entries );
+}
+
+//-----------------------------------------------------------
+uint64 RunMatch( Bench& bench, const uint32 threadCount )
+{
+    const uint64 entries = bench.entries;
+
+    FxMatcherBounded matcher( 256 );
+
+    const Span<uint32> yEntries( (uint32*)bench.buffers[0], (uint32)entries );
+    Span<uint32>       groups  ( (uint32*)bench.buffers[1], (uint32)entries );
+    Span<Pair>         pairs   ( (Pair*  )bench.buffers[2], (uint32)entries * 2 );
+
+    std::atomic<uint64> matchCount = 0;
+
+    AnonPrefixSumJob<uint32>::Run( *bench.pool, threadCount, [&]( AnonPrefixSumJob<uint32>* self ) {
+
+        const uint32 id        = self->JobId();
+        const uint32 maxGroups = (uint32)( groups.Length() / self->JobCount() );
+        const uint32 maxPairs  = (uint32)( pairs.Length()  / self->JobCount() );
+
+        auto matches = matcher.Match( self, 0, yEntries, groups.Slice( maxGroups * id, maxGroups ), pairs.Slice( maxPairs * id, maxPairs ) );
+        matchCount += matches.Length();
+    });
+
+    return entries * sizeof( uint32 ) + matchCount * sizeof( Pair );
+}
+
+//-----------------------------------------------------------
+uint64 RunBitPack( Bench& bench, const uint32 threadCount )
+{
+    const uint32  entryBits = 40;
+    const uint64  mask      = ( 1ull << entryBits ) - 1;
+    const uint64  entries   = bench.entries;
+    const uint64* input     = (uint64*)bench.buffers[0];
+    uint64*       fields    = (uint64*)bench.buffers[1];
+
+    // Each thread packs its entries at its bit offset in the shared fields, as with BitBucketWriter.
+    // Threads are padded by a field, so that they don't write to the same field.
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, entries, count, offset, end );
+
+        const uint64 startBit = offset * entryBits + self->JobId() * 64ull;
+        BitWriter writer( fields, ( entries * entryBits ) + self->JobCount() * 64ull, RoundUpToNextBoundaryT( startBit, (uint64)64 ) );
+
+        for( uint64 i = offset; i < end; i++ )
+            writer.Write( input[i] & mask, entryBits );
+    });
+
+    return entries * ( sizeof( uint64 ) + entryBits / 8 );
+}
+
+//-----------------------------------------------------------
+uint64 RunBitPacker( Bench& bench, const uint32 threadCount )
+{
+    const uint32  entryBits = 40;
+    const uint64  entries   = bench.entries;
+    const uint64* input     = (uint64*)bench.buffers[0];
+    uint64*       fields    = (uint64*)bench.buffers[1];
+
+    // Same layout as RunBitPack
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, entries, count, offset, end );
+
+        const uint64 startBit = offset * entryBits + self->JobId() * 64ull;
+        BitWriter writer( fields, ( entries * entryBits ) + self->JobCount() * 64ull, RoundUpToNextBoundaryT( startBit, (uint64)64 ) );
+
+        writer.WriteValues<entryBits>( input + offset, (int64)count );
+    });
+
+    return entries * ( sizeof( uint64 ) + entryBits / 8 );
+}
+
+//-----------------------------------------------------------
+uint64 RunBitUnpack( Bench& bench, const uint32 threadCount )
+{
+    const uint32  entryBits = 40;
+    const uint64  entries   = bench.entries;
+    const uint64* fields    = (uint64*)bench.buffers[0];
+    uint64*       output    = (uint64*)bench.buffers[1];
+
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, entries, count, offset, end );
+
+        BitReader reader( fields, entries * entryBits, offset * entryBits );
+
+        for( uint64 i = offset; i < end; i++ )
+            output[i] = reader.ReadBits64( entryBits );
+    });
+
+    return entries * ( sizeof( uint64 ) + entryBits / 8 );
+}
+
+//-----------------------------------------------------------
+uint64 RunBitUnpacker( Bench& bench, const uint32 threadCount )
+{
+    const uint32  entryBits = 40;
+    const uint64  entries   = bench.entries;
+    const uint64* fields    = (uint64*)bench.buffers[0];
+    uint64*       output    = (uint64*)bench.buffers[1];
+
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, entries, count, offset, end );
+
+        BitUnpacker reader( fields, entries * entryBits, offset * entryBits );
+
+        for( uint64 i = offset; i < end; i++ )
+            output[i] = reader.Read<entryBits>();
+    });
+
+    return entries * ( sizeof( uint64 ) + entryBits / 8 );
+}
+
+//-----------------------------------------------------------
+void PrepareParks( Bench& bench )
+{
+    // Sorted line points of a k32 table: 2^32 line points over a 2^63 range
+    uint64* linePoints = (uint64*)bench.buffers[0];
+    FillRandom( *bench.pool, linePoints, bench.entries, 9 );
+
+    uint64 linePoint = 0;
+    for( uint64 i = 0; i < bench.entries; i++ )
+    {
+        linePoint    += linePoints[i] & ( ( 1ull << _K ) - 1 );
+        linePoints[i] = linePoint;
+    }
+}
+
+//-----------------------------------------------------------
+uint64 RunParks( Bench& bench, const uint32 threadCount )
+{
+    const TableId table     = TableId::Table1;
+    const size_t  parkSize  = CalculateParkSize( table );
+    const uint64  entries   = bench.entries;
+    const uint64  parkCount = CDiv( entries, kEntriesPerPark );
+
+    uint64* linePoints = (uint64*)bench.buffers[0];
+    byte*   parkBuffer = bench.buffers[2];
+
+    ASSERT( parkCount * parkSize <= ( entries + BUFFER_EXTRA_ENTRIES ) * BUFFER_ENTRY_SIZES[2] );
+
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, parkCount, count, offset, end );
+
+        for( uint64 i = offset; i < end; i++ )
+        {
+            const uint64 parkEntries = std::min( (uint64)kEntriesPerPark, entries - i * kEntriesPerPark );
+            WritePark( parkSize, parkEntries, linePoints + i * kEntriesPerPark, parkBuffer + i * parkSize, table );
+        }
+    });
+
+    return entries * sizeof( uint64 ) + parkCount * parkSize;
+}
+
+//-----------------------------------------------------------
+uint64 RunParkEncoder( Bench& bench, const uint32 threadCount )
+{
+    const TableId table     = TableId::Table1;
+    const size_t  parkSize  = CalculateParkSize( table );
+    const uint64  entries   = bench.entries;
+    const uint64  parkCount = CDiv( entries, kEntriesPerPark );
+
+    const uint64* linePoints = (uint64*)bench.buffers[0];
+    byte*         parkBuffer = bench.buffers[2];
+
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, parkCount, count, offset, end );
+
+        ParkEncoder encoder( table );
+
+        // The last park may be partial
+        const uint64 lastParkEntries = entries - ( parkCount - 1 ) * kEntriesPerPark;
+        const uint64 fullParkEnd     = lastParkEntries < kEntriesPerPark ? std::min( end, parkCount - 1 ) : end;
+
+        encoder.WriteParks( fullParkEnd - offset, linePoints + offset * kEntriesPerPark, parkBuffer + offset * parkSize );
+
+        if( fullParkEnd < end )
+            encoder.WritePark( lastParkEntries, linePoints + fullParkEnd * kEntriesPerPark, parkBuffer + fullParkEnd * parkSize );
+    });
+
+    return entries * sizeof( uint64 ) + parkCount * parkSize;
+}
+
+//-----------------------------------------------------------
+uint64 RunLinePoints( Bench& bench, const uint32 threadCount )
+{
+    const uint64 entries    = bench.entries;
+    const Pair*  pairs      = (Pair*)bench.buffers[0];
+    uint64*      linePoints = (uint64*)bench.buffers[1];
+
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, entries, count, offset, end );
+
+        for( uint64 i = offset; i < end; i++ )
+            linePoints[i] = SquareToLinePoint( pairs[i].left, pairs[i].right );
+    });
+
+    return entries * ( sizeof( Pair ) + sizeof( uint64 ) );
+}
+
+// The R table marks span 32 bits per entry, so that they don't fit in the CPU caches, as with a real table
+static const uint64 MARK_R_BITS_PER_ENTRY = 32;
+
+//-----------------------------------------------------------
+void PrepareMarks( Bench& bench )
+{
+    const uint64 entries     = bench.entries;
+    const uint64 rEntries    = entries * MARK_R_BITS_PER_ENTRY;
+    const uint64 rFieldCount = rEntries / 64;
+
+    Pair*   pairs  = (Pair*)bench.buffers[0];
+    uint64* map    = (uint64*)bench.buffers[1];
+    uint64* rMarks = (uint64*)bench.buffers[2];
+    uint64* rand   = (uint64*)bench.buffers[4];
+
+    // Pairs reference nearby L entries, as in a bucket sorted on y
+    FillRandom( *bench.pool, rand, entries, 10 );
+
+    for( uint64 i = 0; i < entries; i++ )
+    {
+        pairs[i].left  = (uint32)i;
+        pairs[i].right = (uint32)( i + 1 + ( rand[i] & 511 ) );
+    }
+
+    FillRandom( *bench.pool, map, entries, 11 );
+    for( uint64 i = 0; i < entries; i++ )
+        map[i] %= rEntries;
+
+    // 75% of the R entries are marked
+    FillRandom( *bench.pool, rMarks, rFieldCount, 12 );
+    FillRandom( *bench.pool, rand, rFieldCount, 13 );
+    for( uint64 i = 0; i < rFieldCount; i++ )
+        rMarks[i] |= rand[i];
+}
+
+//-----------------------------------------------------------
+template<bool atomic>
+uint64 RunMarks( Bench& bench, const uint32 threadCount )
+{
+    const uint64  entries = bench.entries;
+    const Pair*   pairs   = (Pair*)bench.buffers[0];
+    const uint64* map     = (uint64*)bench.buffers[1];
+
+    const BitField rMarks( (uint64*)bench.buffers[2], entries * MARK_R_BITS_PER_ENTRY );
+    const BitField lMarks( (uint64*)bench.buffers[3], entries + 512 );
+
+    // Marked bits are skipped by the atomic kernel, so start each run from a clear table
+    memset( bench.buffers[3], 0, CDiv( entries + 512, 64 ) * sizeof( uint64 ) );
+
+    AnonMTJob::Run( *bench.pool, threadCount, [=]( AnonMTJob* self ) {
+
+        int64 count, offset, end;
+        GetThreadOffsets( self, (int64)entries, count, offset, end );
+
+        if constexpr ( atomic )
+            MarkTableEntriesAtomic<TableId::Table4>( offset, count, lMarks, rMarks, 0, pairs, map );
+        else
+        {
+            const int64 firstPassCount = count / 2;
+
+            MarkTableEntries<TableId::Table4>( offset, firstPassCount, lMarks, rMarks, 0, pairs, map );
+            self->SyncThreads();
+            MarkTableEntries<TableId::Table4>( offset + firstPassCount, count - firstPassCount, lMarks, rMarks, 0, pairs, map );
+        }
+    });
+
+    return entries * ( sizeof( Pair ) + sizeof( uint64 ) );
+}
+
+//-----------------------------------------------------------
+uint64 RunMarkHalves( Bench& bench, const uint32 threadCount )
+{
+    return RunMarks<false>( bench, threadCount );
+}
+
+//-----------------------------------------------------------
+uint64 RunMarkAtomic( Bench& bench, const uint32 threadCount )
+{
+    return RunMarks<true>( bench, threadCount );
+}
+
+//-----------------------------------------------------------
+void WriteJson( const char* path, const Bench& bench, const uint32 runCount, const std::vector<KernelResult>& results )
+{
+    FILE* file = fopen( path, "w" );
+    FatalIf( !file, "Failed to open '%s' for writing with error %d.", path, errno );
+
+    char compiler[256];
+    #if defined( __clang__ )
+        snprintf( compiler, sizeof( compiler ), "clang %s", __clang_version__ );
+    #elif defined( __GNUC__ )
+        snprintf( compiler, sizeof( compiler ), "gcc %s", __VERSION__ );
+    #elif defined( _MSC_VER )
+        snprintf( compiler, sizeof( compiler ), "msvc %d", _MSC_FULL_VER );
+    #else
+        snprintf( compiler, sizeof( compiler ), "unknown" );
+    #endif
+
+    #if _DEBUG
+        const bool debug = true;
+    #else
+        const bool debug = false;
+    #endif
+
+    fprintf( file, "{\n" );
+    fprintf( file, "  \"version\": \"%s\",\n", BLADEBIT_VERSION_STR );
+    fprintf( file, "  \"commit\": \"%s\",\n", BLADEBIT_GIT_COMMIT );
+    fprintf( file, "  \"compiler\": \"%s\",\n", compiler );
+    fprintf( file, "  \"debug\": %s,\n", debug ? "true" : "false" );
+    fprintf( file, "  \"logical_cpus\": %u,\n", SysHost::GetLogicalCPUCount() );
+    fprintf( file, "  \"entries\": %llu,\n", (llu)bench.entries );
+    fprintf( file, "  \"runs\": %u,\n", runCount );
+    fprintf( file, "  \"results\": [\n" );
+
+    for( size_t i = 0; i < results.size(); i++ )
+    {
+        const KernelResult& r = results[i];
+
+        fprintf( file, "    { \"kernel\": \"%s\", \"threads\": %u, \"ns_per_entry\": %.4lf, \"ns_per_entry_mean\": %.4lf, \"gb_s\": %.4lf }%s\n",
+            r.kernel, r.threadCount, r.best * 1e9 / bench.entries, r.mean * 1e9 / bench.entries, r.bytes / r.best / 1e9,
+            i+1 < results.size() ? "," : "" );
+    }
+
+    fprintf( file, "  ]\n" );
+    fprintf( file, "}\n" );
+    fclose( file );
+
+    Log::Line( "Wrote bench results to '%s'.", path );
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "util/Log.h"
+#include <vector>
+#include <algorithm>
+
+// Latency samples, in seconds, reported as percentiles.
+struct LatencyStats
+{
+    std::vector<double> samples;
+
+    //-----------------------------------------------------------
+    inline void Add( const LatencyStats& other )
+    {
+        samples.insert( samples.end(), other.samples.begin(), other.samples.end() );
+    }
+
+    //-----------------------------------------------------------
+    inline uint64 CountAbove( const double seconds ) const
+    {
+        return (uint64)std::count_if( samples.begin(), samples.end(), [=]( const double s ) { return s > seconds; } );
+    }
+
+    //-----------------------------------------------------------
+    inline double Percentile( const double p ) const
+    {
+        ASSERT( !samples.empty() );
+        ASSERT( std::is_sorted( samples.begin(), samples.end() ) );
+
+        const size_t count = samples.size();
+        return samples[std::min( count - 1, (size_t)( p * (double)count ) )];
+    }
+
+    //-----------------------------------------------------------
+    inline void Print( const char* name )
+    {
+        if( samples.empty() )
+            return;
+
+        std::sort( samples.begin(), samples.end() );
+
+        double total = 0;
+        for( const double s : samples )
+            total += s;
+
+        const size_t count = samples.size();
+
+        Log::Line( "%s latency (%llu samples):", name, (llu)count );
+        Log::Line( " Average : %8.3lf ms", total / (double)count * 1000.0 );
+        Log::Line( " p50     : %8.3lf ms", Percentile( 0.50  ) * 1000.0 );
+        Log::Line( " p99     : %8.3lf ms", Percentile( 0.99  ) * 1000.0 );
+        Log::Line( " p999    : %8.3lf ms", Percentile( 0.999 ) * 1000.0 );
+        Log::Line( " Max     : %8.3lf ms", samples.back() * 1000.0 );
+    }
+};
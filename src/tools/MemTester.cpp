@@ -5,14 +5,55 @@
 #include "util/CliParser.h"
 #include "util/Log.h"
 #include "util/jobs/MemJobs.h"
+#include <vector>
 
 void MemTestPrintUsage();
 
+// A NUMA node, or all CPUs when the system has no NUMA support
+struct MemTestNode
+{
+    uint32       id;
+    Span<uint32> cpuIds;
+};
+
+struct MemTestPageResult
+{
+    const char* name;
+    double      copyGiBs;
+    double      latencyNs;
+};
+
+struct MemTestResults
+{
+    std::vector<double>                       copyGiBs;         // Per pass
+    uint32                                    nodeCount = 0;
+    std::vector<double>                       numaCopyGiBs;     // nodeCount x nodeCount, [src * nodeCount + dst]
+    std::vector<double>                       numaLatencyNs;    // nodeCount x nodeCount, [cpu * nodeCount + mem]
+    std::vector<std::pair<uint32, double>>    sweepGiBs;        // Thread count, bandwidth
+    std::vector<MemTestPageResult>            pages;
+};
+
+static std::vector<MemTestNode> GetMemTestNodes();
+static byte*  AllocTestBuffer( ThreadPool& pool, uint32 threadCount, size_t size, int numaNode, int hugePages );
+static double CopyBandwidth( ThreadPool& pool, uint32 threadCount, byte* dst, const byte* src, size_t size, const Span<uint32>* cpuIds, uint32 passCount );
+static void   InitLatencyChain( byte* buffer, size_t size );
+static double RandomAccessLatency( ThreadPool& pool, const byte* buffer, size_t size, const uint32* cpuId );
+static void   WriteMemTestJson( const char* path, size_t memSize, size_t latencySize, uint32 threadCount, const MemTestResults& results );
+
+// Number of dependent loads performed to measure latency
+static const uint64 LATENCY_HOP_COUNT = 1ull << 22;
+static const size_t CACHE_LINE_SIZE   = 64;
+
 //-----------------------------------------------------------
 void MemTestMain( GlobalPlotConfig& gCfg, CliParser& cli )
 {
-    size_t memSize  = 16ull MB;
-    uint32 passCount = 1;
+    size_t      memSize      = 16ull MB;
+    size_t      latencySize  = 256ull MB;
+    uint32      passCount    = 1;
+    bool        numaMatrix   = false;
+    bool        threadSweep  = false;
+    bool        hugePages    = false;
+    const char* jsonPath     = nullptr;
 
     while( cli.HasArgs() )
     {
@@ -25,6 +66,18 @@ void MemTestMain( GlobalPlotConfig& gCfg, CliParser& cli )
             if( passCount < 1 ) passCount = 1;
             continue;
         }
+        else if( cli.ReadSize( latencySize, "-l", "--latency-size" ) )
+        {
+            FatalIf( latencySize < CACHE_LINE_SIZE * 2, "Latency test size is too small." );
+        }
+        else if( cli.ReadSwitch( numaMatrix, "-n", "--numa" ) )
+            continue;
+        else if( cli.ReadSwitch( threadSweep, "--sweep" ) )
+            continue;
+        else if( cli.ReadSwitch( hugePages, "--huge" ) )
+            continue;
+        else if( cli.ReadStr( jsonPath, "-j", "--json" ) )
+            continue;
         else if( cli.ArgConsume( "-h", "--help" ) )
         {
             MemTestPrintUsage();
@@ -39,7 +92,12 @@ void MemTestMain( GlobalPlotConfig& gCfg, CliParser& cli )
     const uint32 maxThreads  = SysHost::GetLogicalCPUCount();
     const uint32 threadCount = gCfg.threadCount == 0 ? 1 : std::min( gCfg.threadCount, maxThreads );
 
-    ThreadPool pool( threadCount, ThreadPool::Mode::Fixed, gCfg.disableCpuAffinity );
+    const bool extendedTests = numaMatrix || threadSweep || hugePages;
+
+    // The extended tests need as many threads as we have CPUs
+    ThreadPool pool( extendedTests ? maxThreads : threadCount, ThreadPool::Mode::Fixed, gCfg.disableCpuAffinity );
+
+    MemTestResults results;
 
     Log::Line( "Size   : %.2lf MiB", (double)memSize BtoMB );
     Log::Line( "Threads: %u",        threadCount );
@@ -67,33 +125,433 @@ void MemTestMain( GlobalPlotConfig& gCfg, CliParser& cli )
         MemCpyMT::Copy( dst, src, memSize, pool, threadCount );
         auto elapsed = TimerEnd( timer );
 
-        Log::Line( "Copied %.2lf MiB in %.2lf seconds @ %.2lf MiB/s (%.2lf GiB/s) or %2.lf MB/s (%.2lf GB/s).", 
+        Log::Line( "Copied %.2lf MiB in %.2lf seconds @ %.2lf MiB/s (%.2lf GiB/s) or %2.lf MB/s (%.2lf GB/s).",
                     sizeMB, elapsed, memSize / elapsed BtoMB, memSize / elapsed BtoGB,
                     memSize / elapsed / 1000000.0, memSize / elapsed / 1000000000.0 );
         Log::Line( "" );
+
+        results.copyGiBs.push_back( memSize / elapsed BtoGB );
+    }
+
+    bbvirtfree( src );
+    bbvirtfree( dst );
+
+    // Copy bandwidth at power of 2 thread counts, as the plotter's jobs would see it
+    if( threadSweep )
+    {
+        Log::Line( "Sweeping thread counts..." );
+
+        byte* sweepSrc = AllocTestBuffer( pool, maxThreads, memSize, -1, -1 );
+        byte* sweepDst = AllocTestBuffer( pool, maxThreads, memSize, -1, -1 );
+
+        for( uint32 threads = 1; ; threads = std::min( threads * 2, maxThreads ) )
+        {
+            const double gibs = CopyBandwidth( pool, threads, sweepDst, sweepSrc, memSize, nullptr, passCount );
+            results.sweepGiBs.push_back( { threads, gibs } );
+
+            if( threads == maxThreads )
+                break;
+        }
+
+        bbvirtfree( sweepSrc );
+        bbvirtfree( sweepDst );
+
+        Log::Line( "" );
+        Log::Line( "%8s %12s %12s", "Threads", "GiB/s", "Per thread" );
+        for( const auto& r : results.sweepGiBs )
+            Log::Line( "%8u %12.2lf %12.2lf", r.first, r.second, r.second / r.first );
+        Log::Line( "" );
+    }
+
+    // Normal vs huge pages
+    if( hugePages )
+    {
+        Log::Line( "Comparing normal and huge pages..." );
+
+        const char* names[2] = { "normal", "huge" };
+
+        for( int huge = 0; huge < 2; huge++ )
+        {
+            byte* pageSrc     = AllocTestBuffer( pool, maxThreads, memSize    , -1, huge );
+            byte* pageDst     = AllocTestBuffer( pool, maxThreads, memSize    , -1, huge );
+            byte* pageLatency = AllocTestBuffer( pool, maxThreads, latencySize, -1, huge );
+
+            if( pageSrc && pageDst && pageLatency )
+            {
+                InitLatencyChain( pageLatency, latencySize );
+
+                MemTestPageResult r;
+                r.name      = names[huge];
+                r.copyGiBs  = CopyBandwidth( pool, threadCount, pageDst, pageSrc, memSize, nullptr, passCount );
+                r.latencyNs = RandomAccessLatency( pool, pageLatency, latencySize, nullptr );
+                results.pages.push_back( r );
+            }
+            else
+                Log::Line( "Warning: %s pages are not supported on this system.", names[huge] );
+
+            if( pageSrc     ) bbvirtfree( pageSrc );
+            if( pageDst     ) bbvirtfree( pageDst );
+            if( pageLatency ) bbvirtfree( pageLatency );
+        }
+
+        Log::Line( "" );
+        Log::Line( "%8s %12s %12s", "Pages", "GiB/s", "Latency ns" );
+        for( const MemTestPageResult& r : results.pages )
+            Log::Line( "%8s %12.2lf %12.1lf", r.name, r.copyGiBs, r.latencyNs );
+        Log::Line( "" );
     }
 
+    // Node to node copy bandwidth and random access latency.
+    // This is last, as the pool's threads are pinned to each node's CPUs.
+    if( numaMatrix )
+    {
+        const std::vector<MemTestNode> nodes = GetMemTestNodes();
+        const uint32 nodeCount = (uint32)nodes.size();
+
+        if( !SysHost::GetNUMAInfo() )
+            Log::Line( "NUMA is not available. Testing all CPUs as a single node." );
+
+        Log::Line( "Testing %u NUMA nodes...", nodeCount );
+
+        std::vector<byte*> nodeSrc, nodeDst, nodeLatency;
+        for( uint32 i = 0; i < nodeCount; i++ )
+        {
+            const int node = SysHost::GetNUMAInfo() ? (int)nodes[i].id : -1;
+
+            nodeSrc    .push_back( AllocTestBuffer( pool, maxThreads, memSize    , node, -1 ) );
+            nodeDst    .push_back( AllocTestBuffer( pool, maxThreads, memSize    , node, -1 ) );
+            nodeLatency.push_back( AllocTestBuffer( pool, maxThreads, latencySize, node, -1 ) );
+
+            InitLatencyChain( nodeLatency[i], latencySize );
+        }
+
+        results.nodeCount = nodeCount;
+        results.numaCopyGiBs .resize( nodeCount * nodeCount );
+        results.numaLatencyNs.resize( nodeCount * nodeCount );
+
+        for( uint32 s = 0; s < nodeCount; s++ )
+        {
+            for( uint32 d = 0; d < nodeCount; d++ )
+            {
+                // Copies run on the CPUs of the destination node
+                const Span<uint32>& cpuIds = nodes[d].cpuIds;
+                const uint32 nodeThreads   = gCfg.threadCount == 0 ? (uint32)cpuIds.Length() : std::min( gCfg.threadCount, (uint32)cpuIds.Length() );
+
+                results.numaCopyGiBs[s * nodeCount + d] = CopyBandwidth( pool, nodeThreads, nodeDst[d], nodeSrc[s], memSize, &cpuIds, passCount );
+            }
+        }
+
+        // Latency of CPU node c accessing memory on node m
+        for( uint32 c = 0; c < nodeCount; c++ )
+        {
+            for( uint32 m = 0; m < nodeCount; m++ )
+                results.numaLatencyNs[c * nodeCount + m] = RandomAccessLatency( pool, nodeLatency[m], latencySize, &nodes[c].cpuIds[0] );
+        }
+
+        for( uint32 i = 0; i < nodeCount; i++ )
+        {
+            bbvirtfree( nodeSrc[i] );
+            bbvirtfree( nodeDst[i] );
+            bbvirtfree( nodeLatency[i] );
+        }
+
+        Log::Line( "" );
+        Log::Line( "Copy bandwidth in GiB/s (rows: source memory node, columns: destination node):" );
+        Log::Write( "%8s", "" );
+        for( uint32 d = 0; d < nodeCount; d++ )
+            Log::Write( " %9s%-3u", "node ", nodes[d].id );
+        Log::Line( "" );
+
+        for( uint32 s = 0; s < nodeCount; s++ )
+        {
+            Log::Write( "node %-3u", nodes[s].id );
+            for( uint32 d = 0; d < nodeCount; d++ )
+                Log::Write( " %12.2lf", results.numaCopyGiBs[s * nodeCount + d] );
+            Log::Line( "" );
+        }
+
+        Log::Line( "" );
+        Log::Line( "Random access latency in ns (rows: CPU node, columns: memory node):" );
+        Log::Write( "%8s", "" );
+        for( uint32 m = 0; m < nodeCount; m++ )
+            Log::Write( " %9s%-3u", "node ", nodes[m].id );
+        Log::Line( "" );
+
+        for( uint32 c = 0; c < nodeCount; c++ )
+        {
+            Log::Write( "node %-3u", nodes[c].id );
+            for( uint32 m = 0; m < nodeCount; m++ )
+                Log::Write( " %12.1lf", results.numaLatencyNs[c * nodeCount + m] );
+            Log::Line( "" );
+        }
+        Log::Line( "" );
+    }
+
+    if( jsonPath )
+        WriteMemTestJson( jsonPath, memSize, latencySize, threadCount, results );
 
     exit( 0 );
 }
 
+//-----------------------------------------------------------
+std::vector<MemTestNode> GetMemTestNodes()
+{
+    std::vector<MemTestNode> nodes;
+
+    const NumaInfo* numa = SysHost::GetNUMAInfo();
+    if( numa )
+    {
+        for( uint32 i = 0; i < numa->nodeCount; i++ )
+        {
+            // Nodes without CPUs (memory-only) can't run the tests
+            if( numa->cpuIds[i].Length() == 0 )
+                continue;
+
+            nodes.push_back( { i, Span<uint32>( numa->cpuIds[i].Ptr(), numa->cpuIds[i].Length() ) } );
+        }
+    }
+
+    if( nodes.empty() )
+    {
+        const uint32 cpuCount = SysHost::GetLogicalCPUCount();
+        uint32* cpuIds = new uint32[cpuCount];
+
+        for( uint32 i = 0; i < cpuCount; i++ )
+            cpuIds[i] = i;
+
+        nodes.push_back( { 0, Span<uint32>( cpuIds, cpuCount ) } );
+    }
+
+    return nodes;
+}
+
+//-----------------------------------------------------------
+// Allocates and faults a buffer, optionally bound to a NUMA node (numaNode >= 0)
+// and with huge pages enabled (hugePages == 1) or disabled (hugePages == 0).
+// Returns nullptr if the huge pages mode could not be set.
+byte* AllocTestBuffer( ThreadPool& pool, const uint32 threadCount, const size_t size, const int numaNode, const int hugePages )
+{
+    byte* buffer = bbvirtalloc<byte>( size );
+
+    if( hugePages >= 0 && !SysHost::VirtualAdviseHugePages( buffer, size, hugePages == 1 ) )
+    {
+        bbvirtfree( buffer );
+        return nullptr;
+    }
+
+    if( numaNode >= 0 )
+        SysHost::NumaAssignPages( buffer, size, (uint)numaNode );
+
+    FaultMemoryPages::RunJob( pool, threadCount, buffer, size );
+    return buffer;
+}
+
+//-----------------------------------------------------------
+// Returns the best copy bandwidth in GiB/s across all passes.
+// If cpuIds is given, the threads are pinned to those CPUs.
+double CopyBandwidth( ThreadPool& pool, const uint32 threadCount, byte* dst, const byte* src, const size_t size,
+                      const Span<uint32>* cpuIds, const uint32 passCount )
+{
+    double best = 0;
+
+    for( uint32 pass = 0; pass < passCount; pass++ )
+    {
+        double elapsed = 0;
+
+        AnonMTJob::Run( pool, threadCount, [&]( AnonMTJob* self ) {
+
+            if( cpuIds )
+                SysHost::SetCurrentThreadAffinityCpuId( (*cpuIds)[self->_jobId % cpuIds->Length()] );
+
+            size_t count, offset, end;
+            GetThreadOffsets( self, size, count, offset, end );
+
+            // Don't start timing until all threads are pinned
+            self->SyncThreads();
+
+            const auto timer = TimerBegin();
+
+            memcpy( dst + offset, src + offset, count );
+
+            self->SyncThreads();
+
+            if( self->IsControlThread() )
+                elapsed = TicksToSeconds( TimerEndTicks( timer ) );
+        });
+
+        if( elapsed > 0 )
+            best = std::max( best, size / elapsed BtoGB );
+    }
+
+    return best;
+}
+
+//-----------------------------------------------------------
+// Lays out a random cyclic chain of cache lines through the buffer (Sattolo's algorithm),
+// so that every load depends on the previous one and can't be prefetched.
+void InitLatencyChain( byte* buffer, const size_t size )
+{
+    const uint64 lineCount = size / CACHE_LINE_SIZE;
+    const uint64 stride    = CACHE_LINE_SIZE / sizeof( uint64 );
+
+    uint64* lines = (uint64*)buffer;
+
+    for( uint64 i = 0; i < lineCount; i++ )
+        lines[i * stride] = i;
+
+    uint64 seed;
+    SysHost::Random( (byte*)&seed, sizeof( seed ) );
+    seed |= 1;
+
+    for( uint64 i = lineCount - 1; i > 0; i-- )
+    {
+        // xorshift64
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        const uint64 j = seed % i;
+        std::swap( lines[i * stride], lines[j * stride] );
+    }
+}
+
+//-----------------------------------------------------------
+// Returns the average latency of a dependent random load, in nanoseconds.
+// If cpuId is given, the test thread is pinned to it.
+double RandomAccessLatency( ThreadPool& pool, const byte* buffer, const size_t size, const uint32* cpuId )
+{
+    const uint64  stride = CACHE_LINE_SIZE / sizeof( uint64 );
+    const uint64* lines  = (const uint64*)buffer;
+
+    double elapsed = 0;
+
+    AnonMTJob::Run( pool, 1, [&]( AnonMTJob* self ) {
+
+        if( cpuId )
+            SysHost::SetCurrentThreadAffinityCpuId( *cpuId );
+
+        // Warm up the TLB and caches a little
+        uint64 line = 0;
+        for( uint64 i = 0; i < std::min( LATENCY_HOP_COUNT / 16, (uint64)( size / CACHE_LINE_SIZE ) ); i++ )
+            line = lines[line * stride];
+
+        const auto timer = TimerBegin();
+
+        for( uint64 i = 0; i < LATENCY_HOP_COUNT; i++ )
+            line = lines[line * stride];
+
+        elapsed = TicksToSeconds( TimerEndTicks( timer ) );
+
+        // Keep the loop from being optimized away
+        if( line == ~0ull )
+            Log::Line( "" );
+    });
+
+    return elapsed * 1e9 / (double)LATENCY_HOP_COUNT;
+}
+
+//-----------------------------------------------------------
+void WriteMemTestJson( const char* path, const size_t memSize, const size_t latencySize, const uint32 threadCount, const MemTestResults& results )
+{
+    FILE* file = fopen( path, "w" );
+    FatalIf( !file, "Failed to open JSON file at '%s'.", path );
+
+    fprintf( file, "{\n" );
+    fprintf( file, "  \"size\": %llu,\n", (llu)memSize );
+    fprintf( file, "  \"latency_size\": %llu,\n", (llu)latencySize );
+    fprintf( file, "  \"threads\": %u,\n", threadCount );
+
+    fprintf( file, "  \"copy_gibs\": [" );
+    for( size_t i = 0; i < results.copyGiBs.size(); i++ )
+        fprintf( file, "%s%.3lf", i ? ", " : "", results.copyGiBs[i] );
+    fprintf( file, "]" );
+
+    const uint32 nodeCount = results.nodeCount;
+    if( nodeCount )
+    {
+        fprintf( file, ",\n  \"numa\": {\n" );
+        fprintf( file, "    \"nodes\": %u,\n", nodeCount );
+
+        fprintf( file, "    \"copy_gibs\": [" );
+        for( uint32 s = 0; s < nodeCount; s++ )
+        {
+            fprintf( file, "%s[", s ? ", " : "" );
+            for( uint32 d = 0; d < nodeCount; d++ )
+                fprintf( file, "%s%.3lf", d ? ", " : "", results.numaCopyGiBs[s * nodeCount + d] );
+            fprintf( file, "]" );
+        }
+        fprintf( file, "],\n" );
+
+        fprintf( file, "    \"latency_ns\": [" );
+        for( uint32 c = 0; c < nodeCount; c++ )
+        {
+            fprintf( file, "%s[", c ? ", " : "" );
+            for( uint32 m = 0; m < nodeCount; m++ )
+                fprintf( file, "%s%.2lf", m ? ", " : "", results.numaLatencyNs[c * nodeCount + m] );
+            fprintf( file, "]" );
+        }
+        fprintf( file, "]\n  }" );
+    }
+
+    if( !results.sweepGiBs.empty() )
+    {
+        fprintf( file, ",\n  \"sweep\": [" );
+        for( size_t i = 0; i < results.sweepGiBs.size(); i++ )
+            fprintf( file, "%s{ \"threads\": %u, \"copy_gibs\": %.3lf }", i ? ", " : "",
+                results.sweepGiBs[i].first, results.sweepGiBs[i].second );
+        fprintf( file, "]" );
+    }
+
+    if( !results.pages.empty() )
+    {
+        fprintf( file, ",\n  \"pages\": [" );
+        for( size_t i = 0; i < results.pages.size(); i++ )
+            fprintf( file, "%s{ \"pages\": \"%s\", \"copy_gibs\": %.3lf, \"latency_ns\": %.2lf }", i ? ", " : "",
+                results.pages[i].name, results.pages[i].copyGiBs, results.pages[i].latencyNs );
+        fprintf( file, "]" );
+    }
+
+    fprintf( file, "\n}\n" );
+    fclose( file );
+}
+
 //-----------------------------------------------------------
 static const char* USAGE = R"(memtest [OPTIONS]
 
 Performs a memory copy operation.
 Specify -t <n> in the global options to set the thread count.
 
+The extended tests help to pick the thread count, NUMA and affinity settings for a machine:
+--numa measures the copy bandwidth between every pair of NUMA nodes, and the latency
+of random accesses from the CPUs of each node to the memory of every node.
+--sweep measures the copy bandwidth at every power of 2 thread count.
+--huge compares the copy bandwidth and random access latency of normal and huge pages.
+
 [OPTIONS]
- -s, --size <size>  : Size of memory to copy.
-                      Ex: 512MB 1GB 4GB
+ -s, --size <size>         : Size of memory to copy.
+                             Ex: 512MB 1GB 4GB
+
+ -p, --passes <n>          : The number of passes to perform. By default it is 1.
+                             The extended tests report the best pass.
 
- -p, --passes <n>   : The number of passes to perform. By default it is 1.
+ -n, --numa                : Test every NUMA node pair.
+                             Copies are pinned to the CPUs of the destination node.
+                             Unless -t is specified, all of its CPUs are used.
 
- -h, --help         : Print this help message and exit.
+ --sweep                   : Test copy bandwidth with 1, 2, 4... up to all CPUs.
+
+ --huge                    : Compare normal and (transparent) huge pages.
+
+ -l, --latency-size <size> : Size of the buffer used for the random access latency tests.
+                             It should be much larger than the CPU caches. The default is 256MB.
+
+ -j, --json <path>         : Write the results to a JSON file.
+
+ -h, --help                : Print this help message and exit.
 )";
 
 //-----------------------------------------------------------
 void MemTestPrintUsage()
 {
     Log::Line( USAGE );
-}
\ No newline at end of file
+}
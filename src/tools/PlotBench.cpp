@@ -0,0 +1,427 @@
+#include "util/CliParser.h"
+#include "util/Log.h"
+#include "util/Util.h"
+#include "io/FileStream.h"
+#include "plotdisk/DiskPlotter.h"
+#include "plotting/GlobalPlotConfig.h"
+#include "tools/PlotTools.h"
+#include "b3/blake3.h"
+#include "Version.h"
+#include <vector>
+
+static const char* USAGE = R"(bench_plot -d <path> [OPTIONS] [<diskplot options>]
+
+Creates full k32 plots with the disk plotter using a fixed plot id and memo, and records
+per-phase timings and I/O volumes. The plots are optionally validated and compared
+against golden hashes to catch regressions.
+
+This is an end-to-end benchmark for nightly or release runs, not a per-commit check:
+Each run takes from tens of minutes to hours, and the work directory must hold the
+temporary files and the ~101GiB plot. For quick regression checks use 'bench',
+which times the plotter's kernels on synthetic data in seconds.
+
+Any arguments following the bench_plot options are passed to the disk plotter,
+so it can be configured as with 'bladebit diskplot'. Ex:
+ bench_plot -d /mnt/tmp -n 3 -j bench.json -g golden.txt -- -b 128 --cache 32G
+
+[NOTES]
+The plot id and memo are the same for every run, so the resulting plot is expected
+to be byte-identical for a given bucket count and mode. Use a tmpfs directory
+as the work directory to measure the plotter rather than the disk.
+
+Plots are always k32, as the disk plotter does not support other k sizes.
+A full plot is created on every run, so use --validate-offset to shorten validation.
+
+[OPTIONS]
+ -d, --dir <path>         : Work directory used for the temporary files and the plot. Required.
+                            It must have room for at least the final plot.
+
+ -n, --runs <n>           : Number of plots to create. The default is 1.
+
+ -t, --threads <n>        : Thread count. The default is all logical CPUs.
+
+ -j, --json <path>        : Write the results of all runs to a JSON file.
+
+ -g, --golden <path>      : Golden hashes file to compare the plot hashes against.
+                            Each line holds: <k> <buckets> <bounded|unbounded> <blake3 hex>.
+                            Exits with an error if a plot hash does not match.
+
+ --update-golden          : Write the plot hash to the golden hashes file instead of comparing it.
+
+ --no-validate            : Don't validate the plot's proofs.
+
+ --validate-offset <pct>  : Percentage offset at which to start validating proofs.
+                            Validating a whole k32 plot takes a long time,
+                            so you may want to validate only its tail. The default is 0.
+
+ --keep                   : Keep the plot file after the benchmark.
+
+ -h, --help               : Print this help message and exit.
+)";
+
+struct GoldenHash
+{
+    uint32 k;
+    uint32 numBuckets;
+    bool   bounded;
+    char   hash[65];
+};
+
+struct BenchRun
+{
+    DiskPlotter::PlotStats stats;
+    uint64                 plotSize;
+    char                   hash[65];
+    bool                   validated;
+    bool                   valid;
+    int                    goldenMatch;      // -1 if there was no golden hash for this plot
+};
+
+static const char* PHASE_NAMES[3] = { "phase1", "phase2", "phase3" };
+
+// Size of a k32 plot, rounded up. The temporary files need more on top of it.
+static const uint64 MIN_WORK_DIR_SPACE = 102ull GB;
+
+static void   GetBenchPlotIdAndMemo( byte plotId[BB_PLOT_ID_LEN], byte plotMemo[BB_PLOT_MEMO_MAX_SIZE] );
+static uint64 HashPlotFile( const char* path, char hashHex[65] );
+static void   ReadGoldenHashes( const char* path, std::vector<GoldenHash>& hashes );
+static void   WriteGoldenHashes( const char* path, const std::vector<GoldenHash>& hashes );
+static void   WriteJson( const char* path, const DiskPlotter::Config& cfg, const std::vector<BenchRun>& runs );
+
+//-----------------------------------------------------------
+int main( int argc, const char* argv[] )
+{
+    SysHost::InstallCrashHandler();
+
+    GlobalPlotConfig gCfg;
+    DiskPlotter::Config cfg;
+    cfg.globalCfg = &gCfg;
+
+    const char* workDir        = nullptr;
+    const char* jsonPath       = nullptr;
+    const char* goldenPath     = nullptr;
+    uint32      runCount       = 1;
+    bool        updateGolden   = false;
+    bool        noValidate     = false;
+    bool        keepPlot       = false;
+    float       validateOffset = 0.f;
+
+    CliParser cli( --argc, ++argv );
+
+    while( cli.HasArgs() )
+    {
+        if( cli.ReadStr( workDir, "-d", "--dir" ) )
+            continue;
+        else if( cli.ReadU32( runCount, "-n", "--runs" ) )
+            continue;
+        else if( cli.ReadU32( gCfg.threadCount, "-t", "--threads" ) )
+            continue;
+        else if( cli.ReadStr( jsonPath, "-j", "--json" ) )
+            continue;
+        else if( cli.ReadStr( goldenPath, "-g", "--golden" ) )
+            continue;
+        else if( cli.ReadSwitch( updateGolden, "--update-golden" ) )
+            continue;
+        else if( cli.ReadSwitch( noValidate, "--no-validate" ) )
+            continue;
+        else if( cli.ReadF32( validateOffset, "--validate-offset" ) )
+            continue;
+        else if( cli.ReadSwitch( keepPlot, "--keep" ) )
+            continue;
+        else if( cli.ArgConsume( "-h", "--help" ) )
+        {
+            Log::Line( USAGE );
+            exit( 0 );
+        }
+        else
+        {
+            // The rest are diskplot options
+            cli.ArgConsume( "--" );
+            break;
+        }
+    }
+
+    FatalIf( !workDir, "A work directory is required (-d). See 'bench_plot --help'." );
+    FatalIf( runCount < 1, "Run count must be at least 1." );
+    FatalIf( updateGolden && !goldenPath, "--update-golden requires a golden hashes file (-g)." );
+
+    cfg.tmpPath       = workDir;
+    gCfg.outputFolder = workDir;
+    DiskPlotter::ParseCommandLine( cli, cfg );
+    FatalIf( cfg.resumePath, "Resuming is not supported when benchmarking." );
+
+    // Fail early rather than after most of a plot
+    const uint64 freeSpace = FileStream::GetFreeSpaceForPath( workDir );
+    FatalIf( freeSpace < MIN_WORK_DIR_SPACE, "The work directory '%s' has %.2lf GiB free, but a k32 plot alone needs %.2lf GiB.",
+             workDir, (double)freeSpace / (1 GB), (double)MIN_WORK_DIR_SPACE / (1 GB) );
+
+    std::vector<GoldenHash> goldenHashes;
+    if( goldenPath && FileStream::Exists( goldenPath ) )
+        ReadGoldenHashes( goldenPath, goldenHashes );
+
+    byte plotId  [BB_PLOT_ID_LEN];
+    byte plotMemo[BB_PLOT_MEMO_MAX_SIZE];
+    GetBenchPlotIdAndMemo( plotId, plotMemo );
+
+    // Prepare the plot path
+    const size_t outDirLen = strlen( gCfg.outputFolder );
+    char* plotPath = new char[outDirLen + BB_PLOT_FILE_LEN_TMP + 2];
+    memcpy( plotPath, gCfg.outputFolder, outDirLen );
+
+    size_t plotNameOffset = outDirLen;
+    if( plotNameOffset > 0 && plotPath[plotNameOffset-1] != '/' && plotPath[plotNameOffset-1] != '\\' )
+        plotPath[plotNameOffset++] = '/';
+
+    char* plotFileName = plotPath + plotNameOffset;
+    PlotTools::GenPlotFileName( plotId, plotFileName );
+
+    DiskPlotter plotter( cfg );
+
+    std::vector<BenchRun> runs;
+    bool failed = false;
+
+    for( uint32 i = 0; i < runCount; i++ )
+    {
+        Log::Line( "[Bench run %u / %u]", i+1, runCount );
+
+        DiskPlotter::PlotRequest req;
+        req.plotId       = plotId;
+        req.plotMemo     = plotMemo;
+        req.plotMemoSize = (uint16)BB_PLOT_MEMO_MAX_SIZE;
+        req.plotFileName = plotFileName;
+        plotter.Plot( req );
+
+        BenchRun run = {};
+        run.stats       = plotter.LastPlotStats();
+        run.goldenMatch = -1;
+
+        // The finished plot has the .tmp extension removed
+        std::string finalPlotPath( plotPath, strlen( plotPath ) - 4 );
+
+        Log::Line( "Hashing plot..." );
+        run.plotSize = HashPlotFile( finalPlotPath.c_str(), run.hash );
+        Log::Line( "Plot hash: %s", run.hash );
+
+        if( goldenPath )
+        {
+            GoldenHash* golden = nullptr;
+            for( auto& g : goldenHashes )
+            {
+                if( g.k == _K && g.numBuckets == cfg.numBuckets && g.bounded == cfg.bounded )
+                {
+                    golden = &g;
+                    break;
+                }
+            }
+
+            if( updateGolden )
+            {
+                if( !golden )
+                {
+                    goldenHashes.push_back( { (uint32)_K, cfg.numBuckets, cfg.bounded, {} } );
+                    golden = &goldenHashes.back();
+                }
+
+                memcpy( golden->hash, run.hash, sizeof( run.hash ) );
+            }
+            else if( golden )
+            {
+                run.goldenMatch = strcmp( golden->hash, run.hash ) == 0 ? 1 : 0;
+
+                if( !run.goldenMatch )
+                {
+                    Log::Error( "Plot hash mismatch! Expected %s.", golden->hash );
+                    failed = true;
+                }
+                else
+                    Log::Line( "Plot hash matches the golden hash." );
+            }
+            else
+                Log::Line( "Warning: No golden hash for k%u, %u buckets, %sbounded.", (uint)_K, cfg.numBuckets, cfg.bounded ? "" : "un" );
+        }
+
+        if( !noValidate )
+        {
+            ValidatePlotOptions opts;
+            opts.plotPath    = finalPlotPath;
+            opts.threadCount = cfg.p3ThreadCount;
+            opts.startOffset = std::max( std::min( validateOffset / 100.f, 1.f ), 0.f );
+
+            run.validated = true;
+            run.valid     = ValidatePlot( opts );
+            failed       |= !run.valid;
+        }
+
+        if( !keepPlot )
+            remove( finalPlotPath.c_str() );
+
+        runs.push_back( run );
+        Log::Line( "" );
+    }
+
+    if( updateGolden )
+        WriteGoldenHashes( goldenPath, goldenHashes );
+
+    if( jsonPath )
+        WriteJson( jsonPath, cfg, runs );
+
+    Log::Line( "Bench results:" );
+    for( size_t i = 0; i < runs.size(); i++ )
+    {
+        const auto& stats = runs[i].stats;
+        Log::Line( " Run %llu: %.2lf s ( P1: %.2lf s | P2: %.2lf s | P3: %.2lf s )", (llu)i+1, stats.elapsed,
+            stats.phases[0].elapsed, stats.phases[1].elapsed, stats.phases[2].elapsed );
+    }
+
+    return failed ? 1 : 0;
+}
+
+//-----------------------------------------------------------
+void GetBenchPlotIdAndMemo( byte plotId[BB_PLOT_ID_LEN], byte plotMemo[BB_PLOT_MEMO_MAX_SIZE] )
+{
+    const char seed[] = "bladebit_bench_plot";
+
+    blake3_hasher hasher;
+    blake3_hasher_init( &hasher );
+    blake3_hasher_update( &hasher, seed, sizeof( seed ) - 1 );
+    blake3_hasher_finalize( &hasher, plotId, BB_PLOT_ID_LEN );
+
+    // Memo with a pool public key, farmer public key and a master secret key.
+    // It does not need to be valid for the plot to be created and validated.
+    blake3_hasher_init( &hasher );
+    blake3_hasher_update( &hasher, plotId, BB_PLOT_ID_LEN );
+    blake3_hasher_finalize( &hasher, plotMemo, BB_PLOT_MEMO_MAX_SIZE );
+}
+
+//-----------------------------------------------------------
+uint64 HashPlotFile( const char* path, char hashHex[65] )
+{
+    FileStream file;
+    FatalIf( !file.Open( path, FileMode::Open, FileAccess::Read ),
+        "Failed to open plot file '%s' with error %d.", path, file.GetError() );
+
+    const size_t bufferSize = 64ull MB;
+    byte* buffer = bbvirtalloc<byte>( bufferSize );
+
+    blake3_hasher hasher;
+    blake3_hasher_init( &hasher );
+
+    uint64 totalSize = 0;
+    for( ;; )
+    {
+        const ssize_t sizeRead = file.Read( buffer, bufferSize );
+        FatalIf( sizeRead < 0, "Failed to read plot file '%s' with error %d.", path, file.GetError() );
+
+        if( sizeRead == 0 )
+            break;
+
+        blake3_hasher_update( &hasher, buffer, (size_t)sizeRead );
+        totalSize += (uint64)sizeRead;
+    }
+
+    bbvirtfree( buffer );
+
+    byte hash[32];
+    blake3_hasher_finalize( &hasher, hash, sizeof( hash ) );
+
+    size_t numEncoded = 0;
+    BytesToHexStr( hash, sizeof( hash ), hashHex, 64, numEncoded );
+    hashHex[64] = 0;
+
+    return totalSize;
+}
+
+//-----------------------------------------------------------
+void ReadGoldenHashes( const char* path, std::vector<GoldenHash>& hashes )
+{
+    FILE* file = fopen( path, "r" );
+    FatalIf( !file, "Failed to open golden hashes file '%s' with error %d.", path, errno );
+
+    char line[256];
+    while( fgets( line, sizeof( line ), file ) )
+    {
+        if( line[0] == '#' || line[0] == '\n' || line[0] == '\r' || line[0] == 0 )
+            continue;
+
+        GoldenHash golden = {};
+        char mode[16] = {};
+
+        FatalIf( sscanf( line, "%u %u %15s %64s", &golden.k, &golden.numBuckets, mode, golden.hash ) != 4 ||
+                 strlen( golden.hash ) != 64 || ( strcmp( mode, "bounded" ) != 0 && strcmp( mode, "unbounded" ) != 0 ),
+                 "Invalid golden hash line in '%s': %s", path, line );
+
+        golden.bounded = strcmp( mode, "bounded" ) == 0;
+        hashes.push_back( golden );
+    }
+
+    fclose( file );
+}
+
+//-----------------------------------------------------------
+void WriteGoldenHashes( const char* path, const std::vector<GoldenHash>& hashes )
+{
+    FILE* file = fopen( path, "w" );
+    FatalIf( !file, "Failed to open golden hashes file '%s' for writing with error %d.", path, errno );
+
+    fprintf( file, "# <k> <buckets> <bounded|unbounded> <blake3 of the plot file>\n" );
+    for( const auto& g : hashes )
+        fprintf( file, "%u %u %s %s\n", g.k, g.numBuckets, g.bounded ? "bounded" : "unbounded", g.hash );
+
+    fclose( file );
+    Log::Line( "Updated golden hashes at '%s'.", path );
+}
+
+//-----------------------------------------------------------
+void WriteJson( const char* path, const DiskPlotter::Config& cfg, const std::vector<BenchRun>& runs )
+{
+    FILE* file = fopen( path, "w" );
+    FatalIf( !file, "Failed to open '%s' for writing with error %d.", path, errno );
+
+    fprintf( file, "{\n" );
+    fprintf( file, "  \"version\": \"%s\",\n", BLADEBIT_VERSION_STR );
+    fprintf( file, "  \"commit\": \"%s\",\n", BLADEBIT_GIT_COMMIT );
+    fprintf( file, "  \"k\": %u,\n", (uint)_K );
+    fprintf( file, "  \"buckets\": %u,\n", cfg.numBuckets );
+    fprintf( file, "  \"bounded\": %s,\n", cfg.bounded ? "true" : "false" );
+    fprintf( file, "  \"alternate\": %s,\n", cfg.alternateBuckets ? "true" : "false" );
+    fprintf( file, "  \"cache\": %llu,\n", (llu)cfg.cacheSize );
+    fprintf( file, "  \"threads\": { \"f1\": %u, \"fp\": %u, \"c\": %u, \"p2\": %u, \"p3\": %u, \"io\": %u },\n",
+        cfg.f1ThreadCount, cfg.fpThreadCount, cfg.cThreadCount, cfg.p2ThreadCount, cfg.p3ThreadCount, cfg.ioThreadCount );
+    fprintf( file, "  \"runs\": [\n" );
+
+    for( size_t i = 0; i < runs.size(); i++ )
+    {
+        const BenchRun& run = runs[i];
+
+        fprintf( file, "    {\n" );
+        fprintf( file, "      \"elapsed\": %.3lf,\n", run.stats.elapsed );
+        fprintf( file, "      \"plot_size\": %llu,\n", (llu)run.plotSize );
+        fprintf( file, "      \"hash\": \"%s\",\n", run.hash );
+
+        if( run.goldenMatch < 0 )
+            fprintf( file, "      \"golden_match\": null,\n" );
+        else
+            fprintf( file, "      \"golden_match\": %s,\n", run.goldenMatch ? "true" : "false" );
+
+        if( run.validated )
+            fprintf( file, "      \"valid\": %s,\n", run.valid ? "true" : "false" );
+        else
+            fprintf( file, "      \"valid\": null,\n" );
+
+        fprintf( file, "      \"phases\": {\n" );
+        for( uint32 p = 0; p < 3; p++ )
+        {
+            const DiskPlotter::PhaseStats& phase = run.stats.phases[p];
+            fprintf( file, "        \"%s\": { \"elapsed\": %.3lf, \"io_wait\": %.3lf, \"bytes_read\": %llu, \"bytes_written\": %llu }%s\n",
+                PHASE_NAMES[p], phase.elapsed, phase.ioWaitTime, (llu)phase.bytesRead, (llu)phase.bytesWritten, p < 2 ? "," : "" );
+        }
+        fprintf( file, "      }\n" );
+        fprintf( file, "    }%s\n", i+1 < runs.size() ? "," : "" );
+    }
+
+    fprintf( file, "  ]\n" );
+    fprintf( file, "}\n" );
+    fclose( file );
+
+    Log::Line( "Wrote bench results to '%s'.", path );
+}
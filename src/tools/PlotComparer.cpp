@@ -6,23 +6,23 @@
 #include "util/BitView.h"
 #include "plotting/PlotTools.h"
 #include "plotting/GlobalPlotConfig.h"
+#include "plotting/PlotMetrics.h"
 #include "plotdisk/jobs/IOJob.h"
 #include "threading/ThreadPool.h"
+#include "threading/MTJob.h"
+#include "PlotReader.h"
+#include "PlotTools.h"
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <unordered_map>
 
 class PlotInfo;
 
-void TestTable( TableId table, PlotInfo& ref, PlotInfo& tgt );
-void TestC3Table( PlotInfo& ref, PlotInfo& tgt );
-void TestTable( PlotInfo& ref, PlotInfo& tgt, TableId table );
-
 void UnpackPark7( const byte* srcBits, uint64* dstEntries );
 
 void DumpP7( PlotInfo& plot, const char* path );
 
-Span<uint> ReadC1Table( PlotInfo& plot );
-
 class PlotInfo
 {
 public:
@@ -286,19 +286,31 @@ private:
 
 
 //-----------------------------------------------------------
-const char USAGE[] = R"(plotcmp <plot_a_path> <plot_b_path>
+const char USAGE[] = R"(plotcmp [OPTIONS] <plot_a_path> <plot_b_path>
 
 Compares 2 plots for matching tables.
+Parks are streamed from both plots in parallel and compared byte for byte.
+Parks that differ are then decoded and compared entry by entry, so that parks
+which only differ in their encoding (ex: unused trailing bytes) are not reported as failures.
+
+[NOTES]
+You can specify the thread count in the bladebit global option '-t'.
 
 [ARGUMENTS]
 <plot_*_path> : Path to the plot files to be compared.
- -h, --help   : Print this help message and exit.
+
+[OPTIONS]
+ -e, --early-exit  : Stop comparing as soon as a differing park is found.
+
+ -j, --json <path> : Write a JSON summary, with the ranges of differing parks in each table, to a file.
+
+ -h, --help        : Print this help message and exit.
 )";
 
 //-----------------------------------------------------------
 void PlotCompareMainPrintUsage()
 {
-    Log::Line( "" );
+    Log::Line( USAGE );
     Log::Flush();
 }
 
@@ -307,10 +319,42 @@ void PlotCompareMainPrintUsage()
 //-----------------------------------------------------------
 struct PlotCompareOptions
 {
-    const char* plotAPath = "";
-    const char* plotBPath = "";
+    const char* plotAPath   = "";
+    const char* plotBPath   = "";
+    const char* jsonPath    = nullptr;
+    bool        earlyExit   = false;
+    uint32      threadCount = 0;
 };
 
+// Comparison results of a single plot table.
+// For the C1 and C2 tables, each entry is considered a park.
+struct TableCompareResult
+{
+    PlotTable table;
+    bool      compared      = false;    // False if skipped because of an early exit
+    bool      sizeMismatch  = false;
+    uint64    parkCount     = 0;
+    uint64    failedParks   = 0;
+    uint64    byteOnlyParks = 0;        // Parks with different bytes, but matching entries
+    std::vector<std::pair<uint64, uint64>> failedRanges;   // [start, end) park ranges
+};
+
+struct PlotCompareContext
+{
+    ThreadPool&       pool;
+    uint32            threadCount;
+    uint32            k;
+    bool              earlyExit;
+    PlotReader**      refReaders;       // Per thread
+    PlotReader**      tgtReaders;
+    std::atomic<bool> stop = false;
+};
+
+static void CompareTable( PlotCompareContext& cx, TableCompareResult& result );
+static void LogTableResult( const TableCompareResult& result );
+static void WriteCompareJson( const char* path, const PlotCompareOptions& opts, uint32 k, const TableCompareResult* results );
+static const char* PlotTableName( PlotTable table );
+
 //-----------------------------------------------------------
 void PlotCompareMain( GlobalPlotConfig& gCfg, CliParser& cli )
 {
@@ -323,6 +367,10 @@ void PlotCompareMain( GlobalPlotConfig& gCfg, CliParser& cli )
             PlotCompareMainPrintUsage();
             exit( 0 );
         }
+        else if( cli.ReadSwitch( opts.earlyExit, "-e", "--early-exit" ) )
+            continue;
+        else if( cli.ReadStr( opts.jsonPath, "-j", "--json" ) )
+            continue;
         else
             break;
     }
@@ -330,6 +378,9 @@ void PlotCompareMain( GlobalPlotConfig& gCfg, CliParser& cli )
     opts.plotAPath = cli.ArgConsume();
     opts.plotBPath = cli.ArgConsume();
 
+    const uint32 maxThreads = SysHost::GetLogicalCPUCount();
+    opts.threadCount = gCfg.threadCount == 0 ? maxThreads : std::min( maxThreads, gCfg.threadCount );
+
     PlotInfo refPlot; // Reference
     PlotInfo tgtPlot; // Target
 
@@ -343,6 +394,7 @@ void PlotCompareMain( GlobalPlotConfig& gCfg, CliParser& cli )
         refPlot.DumpHeader();
         Log::Line( "" );
         tgtPlot.DumpHeader();
+        Log::Line( "" );
     }
 
     FatalIf( refPlot.K() != 32, "Plot A is k%u. Only k32 plots are currently supported.", refPlot.K() );
@@ -352,333 +404,446 @@ void PlotCompareMain( GlobalPlotConfig& gCfg, CliParser& cli )
     FatalIf( !MemCmp( refPlot.PlotMemo(), tgtPlot.PlotMemo(), std::min( refPlot.PlotMemoSize(), tgtPlot.PlotMemoSize() ) ), "Plot memo mismatch." );
     FatalIf( refPlot.K() != tgtPlot.K(), "K value mismatch." );
 
-    // Test P7, dump it
-    // DumpP7( refPlot, "/mnt/p5510a/reference/p7.tmp" );
+    // Each thread streams parks through its own plot files and readers
+    const uint32 threadCount = opts.threadCount;
+
+    FilePlot refFile, tgtFile;
+    FatalIf( !refFile.Open( opts.plotAPath ), "Failed to open plot at path '%s'.", opts.plotAPath );
+    FatalIf( !tgtFile.Open( opts.plotBPath ), "Failed to open plot at path '%s'.", opts.plotBPath );
 
-    // TestTable( refPlot, tgtPlot, TableId::Table7 );
-    // TestTable( refPlot, tgtPlot, TableId::Table3 );
+    ThreadPool pool( threadCount );
+
+    PlotCompareContext cx = { pool, threadCount, refPlot.K(), opts.earlyExit };
+    cx.refReaders = new PlotReader*[threadCount];
+    cx.tgtReaders = new PlotReader*[threadCount];
+
+    for( uint32 i = 0; i < threadCount; i++ )
+    {
+        FilePlot* ref = new FilePlot( refFile );
+        FilePlot* tgt = new FilePlot( tgtFile );
+        FatalIf( !ref->IsOpen() || !tgt->IsOpen(), "Failed to open plot files." );
+
+        cx.refReaders[i] = new PlotReader( *ref );
+        cx.tgtReaders[i] = new PlotReader( *tgt );
+    }
+
+    // Compare the C tables first, since they're the smallest
+    const PlotTable tableOrder[10] = {
+        PlotTable::C1, PlotTable::C2, PlotTable::C3,
+        PlotTable::Table1, PlotTable::Table2, PlotTable::Table3, PlotTable::Table4,
+        PlotTable::Table5, PlotTable::Table6, PlotTable::Table7
+    };
+
+    TableCompareResult results[10];
+    bool match = true;
+
+    const auto timer = TimerBegin();
+
+    for( const PlotTable table : tableOrder )
+    {
+        TableCompareResult& result = results[(int)table];
+        result.table = table;
+
+        if( cx.stop )
+            continue;
+
+        Log::Line( "Comparing %s...", PlotTableName( table ) );
+        CompareTable( cx, result );
+        LogTableResult( result );
+
+        match = match && result.failedParks == 0 && !result.sizeMismatch;
+    }
+
+    const double elapsed = TimerEnd( timer );
+
+    Log::Line( "" );
+    Log::Line( "Compared plots in %.2lf seconds.", elapsed );
 
-    TestC3Table( refPlot, tgtPlot );
+    if( cx.stop )
+        Log::Line( "Stopped at the first difference." );
 
-    for( TableId table = TableId::Table1; table <= TableId::Table7; table++ )
-        TestTable( refPlot, tgtPlot, table );
+    Log::Line( "%s", match ? "Plots match!" : "Plots do not match." );
 
-    // TestC3Table( refPlot, tgtPlot );
+    if( opts.jsonPath )
+        WriteCompareJson( opts.jsonPath, opts, refPlot.K(), results );
+
+    exit( match ? 0 : 1 );
 }
 
 //-----------------------------------------------------------
-Span<uint> ReadC1Table( PlotInfo& plot )
+static bool ReadPlotBytes( IPlotFile& plot, const uint64 address, size_t size, byte* buffer )
 {
-    const size_t tableSize  = plot.TableSize( 7 );
-    const uint32 entryCount = (uint)( tableSize / sizeof( uint32 ) );
-    
-    uint32* c1 = bbvirtalloc<uint32>( tableSize );
-    plot.ReadTable( 7, c1 );
+    if( !plot.Seek( SeekOrigin::Begin, (int64)address ) )
+        return false;
 
-    for( uint i = 0; i < entryCount; i++ )
-        c1[i] = Swap32( c1[i] );
+    while( size )
+    {
+        const ssize_t read = plot.Read( size, buffer );
+        if( read <= 0 )
+            return false;
+
+        size   -= (size_t)read;
+        buffer += read;
+    }
 
-    return Span<uint>( c1, entryCount );
+    return true;
 }
 
 //-----------------------------------------------------------
-Span<uint> ReadC2Table( PlotInfo& plot )
+static size_t TableParkSize( const PlotTable table, const uint32 k )
 {
-    const size_t tableSize  = plot.TableSize( 8 );
-    const uint32 entryCount = (uint)( tableSize / sizeof( uint32 ) );
-    
-    uint32* c2 = bbvirtalloc<uint32>( tableSize );
-    plot.ReadTable( 8, c2 );
+    switch( table )
+    {
+        case PlotTable::C1:
+        case PlotTable::C2:
+            return CDiv( k, 8 );
 
-    for( uint i = 0; i < entryCount; i++ )
-        c2[i] = Swap32( c2[i] );
+        case PlotTable::C3:
+            return CalculateC3Size();
 
-    return Span<uint>( c2, entryCount );
+        case PlotTable::Table7:
+            return CalculatePark7Size( k );
+
+        default:
+            return CalculateParkSize( (TableId)table, k );
+    }
 }
 
-//-----------------------------------------------------------
-void TestC3Table( PlotInfo& ref, PlotInfo& tgt )
+// Buffers for decoding parks that differ
+struct ParkDecodeBuffers
 {
-    Log::Line( "Reading C tables..." );
-    // const size_t refSize = ref.TableSize( 9 );
-    // const size_t tgtSize = tgt.TableSize( 9 );
+    uint128* refLinePoints;
+    uint128* tgtLinePoints;
+    uint64*  refEntries;
+    uint64*  tgtEntries;
+};
 
-    // const size_t c3Size = std::min( refSize, tgtSize );
+//-----------------------------------------------------------
+// Returns the end of the shortest range starting at start and ending after minEnd, whose entries
+// are a permutation of each other in both plots, or -1 if there is none before end.
+static int64 MatchP7Group( const uint64* refEntries, const uint64* tgtEntries, const int64 start, const int64 minEnd,
+                           const int64 end, std::unordered_map<uint64, int64>& counts )
+{
+    counts.clear();
+    int64 unbalanced = 0;   // Entries with a non-zero count
 
-    // Read C1 so that we know how many parks we got
-    Span<uint> refC1 = ReadC1Table( ref );
-    Span<uint> tgtC1 = ReadC1Table( tgt );
+    auto count = [&]( const uint64 entry, const int64 delta ) {
+        int64& c = counts[entry];
+        unbalanced -= c != 0;
+        c += delta;
+        unbalanced += c != 0;
+    };
 
-    // Compare C1
-    const uint64 c1Length = (uint64)std::min( refC1.length, tgtC1.length );
+    for( int64 i = start; i < end; i++ )
     {
-        Log::Line( "Validating C1 table... " );
-        uint64 failCount = 0;
-        for( uint i = 0; i < c1Length; i++ )
+        if( refEntries[i] != tgtEntries[i] )
         {
-            if( refC1[i] != tgtC1[i] )
-            {
-                if( failCount == 0 )
-                    Log::Line( "C1 table mismatch @ index %u. Ref: %u Tgt: %u", i, refC1[i], tgtC1[i] );
-
-                failCount++;
-            }
+            count( refEntries[i],  1 );
+            count( tgtEntries[i], -1 );
         }
 
-        if( failCount == 0 )
-            Log::Line( "Success!" );
-        else
-            Log::Line( "C1 table mismatch: %llu entries failed.", failCount );
+        if( unbalanced == 0 && i >= minEnd )
+            return i + 1;
     }
 
-    // Check C2
-    Span<uint> refC2 = ReadC2Table( ref );
-    Span<uint> tgtC2 = ReadC2Table( tgt );
+    return -1;
+}
 
-    const uint64 c2Length = (uint64)std::min( refC2.length, tgtC2.length );
-    {
-        Log::Line( "Validating C2 table... " );
+//-----------------------------------------------------------
+// Entries sorted on f7 may be in a different order between plots when their f7 is the same,
+// so mismatching entries are compared as a group. As a group may span a park boundary on either side,
+// entries [0, entryCount) hold the parks around the compared range [start, end).
+bool CompareP7Entries( const uint64* refEntries, const uint64* tgtEntries, const int64 entryCount, const int64 start, const int64 end )
+{
+    std::unordered_map<uint64, int64> counts;
 
-        uint64 failCount = 0;
-        for( uint i = 0; i < c2Length; i++ )
+    for( int64 i = start; i < end; )
+    {
+        if( refEntries[i] == tgtEntries[i] )
         {
-            if( refC2[i] != tgtC2[i] )
-            {
-                if( failCount == 0 )
-                    Log::Line( "C2 table mismatch @ index %u. Ref: %u Tgt: %u", i, refC2[i], tgtC2[i] );
-
-                failCount++;
-            }
+            i++;
+            continue;
         }
 
-        if( failCount == 0 )
-            Log::Line( "Success!" );
-        else
-            Log::Line( "C2 table mismatch: %llu entries failed.", failCount );
+        int64 groupEnd = MatchP7Group( refEntries, tgtEntries, i, i, entryCount, counts );
+
+        // The group may have started before i, either before the range, or with entries
+        // that happened to be in place, or that were taken as a smaller group.
+        for( int64 groupStart = i - 1; groupStart >= 0 && groupEnd < 0; groupStart-- )
+            groupEnd = MatchP7Group( refEntries, tgtEntries, groupStart, i, entryCount, counts );
+
+        if( groupEnd < 0 )
+            return false;
+
+        i = groupEnd;
     }
 
-    const uint64 f7Count = c1Length * (uint64)kCheckpoint1Interval;
-    Log::Line( "F7 Count: ~%llu", f7Count );
+    return true;
+}
 
-    Log::Line( "Validating C3 table..." );
-    {
-        const size_t refC3Size = ref.TableSize( 9 );
-        const size_t tgtC3Size = tgt.TableSize( 9 );
+//-----------------------------------------------------------
+static bool CompareP7Park( PlotReader& ref, PlotReader& tgt, const uint64 park, const uint64 parkCount, ParkDecodeBuffers& buf )
+{
+    uint64* refEntries = buf.refEntries;
+    uint64* tgtEntries = buf.tgtEntries;
 
-        byte* refC3 = bbvirtalloc<byte>( refC3Size );
-        byte* tgtC3 = bbvirtalloc<byte>( tgtC3Size );
+    // Load the previous and next parks as well
+    const uint64 firstPark = park > 0 ? park - 1 : 0;
+    const uint64 endPark   = std::min( park + 2, parkCount );
 
-        ref.ReadTable( 9, refC3 );
-        tgt.ReadTable( 9, tgtC3 );
+    for( uint64 p = firstPark; p < endPark; p++ )
+    {
+        const uint64 offset = ( p - firstPark ) * kEntriesPerPark;
 
-        // const size_t c3Size = std::min( refC3Size, tgtC3Size );
+        if( !ref.ReadP7Entries( p, refEntries + offset ) || !tgt.ReadP7Entries( p, tgtEntries + offset ) )
+            return false;
+    }
 
-        const int64  parkCount  = (int64)(c1Length - 1);
-        const size_t c3ParkSize = CalculateC3Size();
+    const int64 start = (int64)( park - firstPark ) * kEntriesPerPark;
 
-        const byte* refC3Reader = refC3;
-        const byte* tgtC3Reader = tgtC3;
+    return CompareP7Entries( refEntries, tgtEntries, (int64)( endPark - firstPark ) * kEntriesPerPark,
+                             start, start + kEntriesPerPark );
+}
 
-        std::vector<int64> failures;
+//-----------------------------------------------------------
+// Compare the decoded entries of a park whose bytes differ.
+static bool CompareDecodedPark( const PlotTable table, PlotReader& ref, PlotReader& tgt, 
+                                const uint64 park, const uint64 parkCount, ParkDecodeBuffers& buf )
+{
+    switch( table )
+    {
+        // Nothing to decode
+        case PlotTable::C1:
+        case PlotTable::C2:
+            return false;
 
-        for( int64 i = 0; i < parkCount; i++ )
+        case PlotTable::C3:
         {
-            if( !MemCmp( refC3Reader, tgtC3Reader, c3ParkSize ) )
-            {
-                Log::Line( " C3 park %lld failed.", i );
-                failures.push_back( i );
-            }
-            // FatalIf( !MemCmp( refC3Reader, tgtC3Reader, c3ParkSize ), 
-            //     "C3 park mismatch @ park %lld / %lld", i, parkCount );
+            const int64 refCount = ref.ReadC3Park( park, buf.refEntries );
+            const int64 tgtCount = tgt.ReadC3Park( park, buf.tgtEntries );
 
-            refC3Reader += c3ParkSize;
-            tgtC3Reader += c3ParkSize;
+            return refCount >= 0 && refCount == tgtCount &&
+                   memcmp( buf.refEntries, buf.tgtEntries, sizeof( uint64 ) * (size_t)refCount ) == 0;
         }
 
-        if( failures.size() < 1 )
-            Log::Line( "Success!" );
-        else
-            Log::Line( "%llu / %lld C3 parks failed!", failures.size(), parkCount );
-        
-        SysHost::VirtualFree( refC3 );
-        SysHost::VirtualFree( tgtC3 );
-    }
+        case PlotTable::Table7:
+            return CompareP7Park( ref, tgt, park, parkCount, buf );
+
+        default:
+        {
+            uint64 refCount = 0, tgtCount = 0;
+            if( !ref.ReadLPPark( (TableId)table, park, buf.refLinePoints, refCount ) ||
+                !tgt.ReadLPPark( (TableId)table, park, buf.tgtLinePoints, tgtCount ) )
+                return false;
 
-    SysHost::VirtualFree( refC2.values );
-    SysHost::VirtualFree( tgtC2.values );
-    SysHost::VirtualFree( refC1.values );
-    SysHost::VirtualFree( tgtC1.values );
+            return refCount == tgtCount &&
+                   memcmp( buf.refLinePoints, buf.tgtLinePoints, sizeof( uint128 ) * refCount ) == 0;
+        }
+    }
 }
 
 //-----------------------------------------------------------
-uint64 CompareP7( PlotInfo& ref, PlotInfo& tgt, const byte* p7RefBytes, const byte* p7TgtBytes, const int64 parkCount )
+void CompareTable( PlotCompareContext& cx, TableCompareResult& result )
 {
-    // Double-buffer parks at a time so that we can compare entries across parks
-    uint64 refParks[2][kEntriesPerPark];
-    uint64 tgtParks[2][kEntriesPerPark];
+    const PlotTable table    = result.table;
+    IPlotFile&      refPlot  = cx.refReaders[0]->PlotFile();
+    IPlotFile&      tgtPlot  = cx.tgtReaders[0]->PlotFile();
+    const size_t    parkSize = TableParkSize( table, cx.k );
+    const size_t    refSize  = refPlot.TableSize( table );
+    const size_t    tgtSize  = tgtPlot.TableSize( table );
+
+    // C3 tables may have trailing space after the last park, so use the C1 table's park count.
+    uint64 parkCount = std::min( refSize, tgtSize ) / parkSize;
+    
+    if( table == PlotTable::C3 )
+        parkCount = std::min( parkCount, std::min( cx.refReaders[0]->GetC3ParkCount(), cx.tgtReaders[0]->GetC3ParkCount() ) );
 
-    uint64 refMatch[kEntriesPerPark];
-    uint64 tgtMatch[kEntriesPerPark];
+    result.compared     = true;
+    result.parkCount    = parkCount;
+    result.sizeMismatch = refSize != tgtSize;
 
-    // Unpack first park
-    ASSERT( parkCount );
+    const uint32 threadCount = cx.threadCount;
+    const uint64 chunkParks  = std::max( (size_t)( 4 MB ) / parkSize, (size_t)1 );
 
-    const size_t parkSize = CalculatePark7Size( ref.K() );
+    std::vector<uint64>* failedParks   = new std::vector<uint64>[threadCount];
+    uint64*              byteOnlyParks = bbcalloc<uint64>( threadCount );
+    memset( byteOnlyParks, 0, sizeof( uint64 ) * threadCount );
 
-    UnpackPark7( p7RefBytes, refParks[0] );
-    UnpackPark7( p7TgtBytes, tgtParks[0] );
-    p7RefBytes += parkSize;
-    p7TgtBytes += parkSize;
+    AnonMTJob::Run( cx.pool, threadCount, [&]( AnonMTJob* self ) {
 
-    uint64 parkFailCount = 0;
+        const uint32 id  = self->_jobId;
+        PlotReader&  ref = *cx.refReaders[id];
+        PlotReader&  tgt = *cx.tgtReaders[id];
 
-    for( int64 p = 0; p < parkCount; p++ )
-    {
-        const bool isLastPark = p + 1 == parkCount;
+        uint64 count, offset, end;
+        GetThreadOffsets( self, parkCount, count, offset, end );
 
-        // Load the next park, if we can
-        if( !isLastPark )
-        {
-            UnpackPark7( p7RefBytes, refParks[1] );
-            UnpackPark7( p7TgtBytes, tgtParks[1] );
-            p7RefBytes += parkSize;
-            p7TgtBytes += parkSize;
-        }
+        if( count == 0 )
+            return;
 
-        const uint64* ref = refParks[0];
-        const uint64* tgt = tgtParks[0];
+        byte* refChunk = bbvirtalloc<byte>( chunkParks * parkSize );
+        byte* tgtChunk = bbvirtalloc<byte>( chunkParks * parkSize );
 
-        const int64 entriesEnd = isLastPark ? kEntriesPerPark : kEntriesPerPark * 2;
+        ParkDecodeBuffers buf;
+        buf.refLinePoints = bbcalloc<uint128>( kEntriesPerPark );
+        buf.tgtLinePoints = bbcalloc<uint128>( kEntriesPerPark );
+        buf.refEntries    = bbcalloc<uint64>( std::max( (uint64)kCheckpoint1Interval, (uint64)kEntriesPerPark * 3 ) );
+        buf.tgtEntries    = bbcalloc<uint64>( std::max( (uint64)kCheckpoint1Interval, (uint64)kEntriesPerPark * 3 ) );
 
-        for( int64 i = 0; i < kEntriesPerPark; i++ )
+        const uint64 refAddress = ref.PlotFile().TableAddress( table );
+        const uint64 tgtAddress = tgt.PlotFile().TableAddress( table );
+
+        for( uint64 chunk = offset; chunk < end && !cx.stop; chunk += chunkParks )
         {
-            if( ref[i] == tgt[i] )
-                continue;
+            const uint64 chunkCount = std::min( chunkParks, end - chunk );
+            const size_t readSize   = chunkCount * parkSize;
 
-            // Potential out-of-order entries
-            // Try sorting and matching entry pairs until we run out of entries
-            int64 j = i + 1;
+            FatalIf( !ReadPlotBytes( ref.PlotFile(), refAddress + chunk * parkSize, readSize, refChunk ), 
+                "Failed to read %s parks from plot A.", PlotTableName( table ) );
+            FatalIf( !ReadPlotBytes( tgt.PlotFile(), tgtAddress + chunk * parkSize, readSize, tgtChunk ), 
+                "Failed to read %s parks from plot B.", PlotTableName( table ) );
 
-            bool matched = false;
-            for( ; j < entriesEnd; j++ )
+            // Fast path, the whole chunk matches
+            if( memcmp( refChunk, tgtChunk, readSize ) == 0 )
+                continue;
+
+            for( uint64 i = 0; i < chunkCount; i++ )
             {
-                const size_t matchCount = (size_t)( j - i ) + 1;
+                if( memcmp( refChunk + i * parkSize, tgtChunk + i * parkSize, parkSize ) == 0 )
+                    continue;
 
-                bbmemcpy_t( refMatch, ref+i, matchCount );
-                bbmemcpy_t( tgtMatch, tgt+i, matchCount );
-                
-                std::sort( refMatch, refMatch+matchCount );
-                std::sort( tgtMatch, tgtMatch+matchCount );
+                const uint64 park = chunk + i;
 
-                if( memcmp( refMatch, tgtMatch, matchCount * sizeof( uint64 ) ) == 0 )
+                if( CompareDecodedPark( table, ref, tgt, park, parkCount, buf ) )
                 {
-                    matched = true;
-                    break;
-                }
-                else
+                    byteOnlyParks[id]++;
                     continue;
-            }
+                }
 
-            if( !matched )
-            {
-                Log::Line( "T7 park %lld failed. First entry failed at index %lld", p, i );
-                parkFailCount++;
+                failedParks[id].push_back( park );
+
+                if( cx.earlyExit )
+                {
+                    cx.stop = true;
+                    break;
+                }
             }
-        
-            i = j;
         }
 
-        // Set next park as current park
-        memcpy( refParks[0], refParks[1], sizeof( uint64 ) * kEntriesPerPark );
-        memcpy( tgtParks[0], tgtParks[1], sizeof( uint64 ) * kEntriesPerPark );
-    }
-    
-    return parkFailCount;
-}
+        bbvirtfree( refChunk );
+        bbvirtfree( tgtChunk );
+        free( buf.refLinePoints );
+        free( buf.tgtLinePoints );
+        free( buf.refEntries );
+        free( buf.tgtEntries );
+    });
 
-//-----------------------------------------------------------
-void TestTable( PlotInfo& ref, PlotInfo& tgt, TableId table )
-{
-    Log::Line( "Reading Table %u...", table+1 );
+    // Threads process consecutive park ranges, so the failed parks are already sorted
+    for( uint32 i = 0; i < threadCount; i++ )
+    {
+        result.byteOnlyParks += byteOnlyParks[i];
 
-    const size_t parkSize = table < TableId::Table7 ? CalculateParkSize( table ) : CalculatePark7Size( ref.K() );
+        for( const uint64 park : failedParks[i] )
+        {
+            result.failedParks++;
 
-    const size_t sizeRef = ref.TableSize( (int)table );
-    const size_t sizeTgt = tgt.TableSize( (int)table );
+            if( !result.failedRanges.empty() && result.failedRanges.back().second == park )
+                result.failedRanges.back().second = park + 1;
+            else
+                result.failedRanges.push_back( { park, park + 1 } );
+        }
+    }
 
-    byte* tableParksRef = bbvirtalloc<byte>( sizeRef );
-    byte* tableParksTgt = bbvirtalloc<byte>( sizeTgt );
+    delete[] failedParks;
+    free( byteOnlyParks );
+}
 
-    ref.ReadTable( (int)table, tableParksRef );
-    tgt.ReadTable( (int)table, tableParksTgt );
+//-----------------------------------------------------------
+void LogTableResult( const TableCompareResult& result )
+{
+    const char* name = PlotTableName( result.table );
 
-    const size_t tableSize = std::min( sizeRef, sizeTgt );
-    const int64  parkCount = (int64)( tableSize / parkSize );
+    if( result.sizeMismatch )
+        Log::Line( " %s size mismatch.", name );
 
-    const byte* parkRef = tableParksRef;
-    const byte* parkTgt = tableParksTgt;
-    
-    Log::Line( "Validating Table %u...", table+1 );
+    if( result.byteOnlyParks )
+        Log::Line( " %llu %s parks have different bytes, but matching entries.", (llu)result.byteOnlyParks, name );
 
-    uint64 failureCount = 0;
-    if( table == TableId::Table7 )
+    if( result.failedParks == 0 )
     {
-        // Because entries can be found in different orders in P7,
-        // we compare them in a different manner than the other parks.
-        // (this can happen because these entries are sorted on f7,
-        //  and if there's multiple entries with the same value
-        //  there's no guarantee an implementation will sort it
-        //  into the same index as another )
-        failureCount = CompareP7( ref, tgt, tableParksRef, tableParksTgt, parkCount );
+        Log::Line( " Success! %llu parks match.", (llu)result.parkCount );
+        return;
     }
-    else
+
+    const size_t maxRangesLogged = 16;
+    for( size_t i = 0; i < std::min( result.failedRanges.size(), maxRangesLogged ); i++ )
     {
-        for( int64 i = 0; i < parkCount; i++ )
-        {
-            if( !MemCmp( parkRef, parkTgt, parkSize ) )
-            {
-                bool failed = true;
+        const auto& range = result.failedRanges[i];
 
-                if( failed )
-                {
-                    Log::Line( " T%u park %lld failed.", table+1, i );
-                    failureCount++;
-                }
+        if( range.second - range.first == 1 )
+            Log::Line( " Park %llu failed.", (llu)range.first );
+        else
+            Log::Line( " Parks %llu..%llu failed.", (llu)range.first, (llu)range.second - 1 );
+    }
 
-                // {
-                //     const byte* refBytes = parkRef;
-                //     const byte* tgtBytes = parkTgt;
-
-                //     // if( table != TableId::Table7 )
-                //     // {
-                //     //     refBytes += 8;
-                //     // }
-
-                //     for( uint64 b = 0; b < parkSize; b++ )
-                //     {
-                //         if( refBytes[b] != tgtBytes[b] )
-                //         {
-                //             Log::Line( "Byte mismatch @ byte %llu: 0x%02x (%3d) != 0x%02x (%3d)", b,
-                //              (int)refBytes[b], (int)refBytes[b], (int)tgtBytes[b], (int)tgtBytes[b] );
-                //             break;
-                //         }
-                //     }
-                // }
-            }
+    if( result.failedRanges.size() > maxRangesLogged )
+        Log::Line( " ... and %llu more ranges.", (llu)( result.failedRanges.size() - maxRangesLogged ) );
 
-            parkRef += parkSize;
-            parkTgt += parkSize;
-        }
-    }
+    Log::Line( " %llu / %llu %s parks failed.", (llu)result.failedParks, (llu)result.parkCount, name );
+}
 
+//-----------------------------------------------------------
+void WriteCompareJson( const char* path, const PlotCompareOptions& opts, const uint32 k, const TableCompareResult* results )
+{
+    FILE* file = fopen( path, "w" );
+    FatalIf( !file, "Failed to open JSON file at '%s'.", path );
+
+    bool match = true;
+    for( int i = 0; i < 10; i++ )
+        match = match && results[i].compared && results[i].failedParks == 0 && !results[i].sizeMismatch;
+
+    fprintf( file, "{\n" );
+    fprintf( file, "  \"plot_a\": " );
+    PlotMetrics::WriteJsonString( file, opts.plotAPath );
+    fprintf( file, ",\n  \"plot_b\": " );
+    PlotMetrics::WriteJsonString( file, opts.plotBPath );
+    fprintf( file, ",\n" );
+    fprintf( file, "  \"k\": %u,\n", k );
+    fprintf( file, "  \"match\": %s,\n", match ? "true" : "false" );
+    fprintf( file, "  \"tables\": [\n" );
+
+    for( int i = 0; i < 10; i++ )
+    {
+        const TableCompareResult& r = results[i];
+
+        fprintf( file, "    {\n" );
+        fprintf( file, "      \"table\": \"%s\",\n", PlotTableName( (PlotTable)i ) );
+        fprintf( file, "      \"compared\": %s,\n", r.compared ? "true" : "false" );
+        fprintf( file, "      \"size_mismatch\": %s,\n", r.sizeMismatch ? "true" : "false" );
+        fprintf( file, "      \"parks\": %llu,\n", (llu)r.parkCount );
+        fprintf( file, "      \"failed_parks\": %llu,\n", (llu)r.failedParks );
+        fprintf( file, "      \"byte_only_parks\": %llu,\n", (llu)r.byteOnlyParks );
+        fprintf( file, "      \"failed_ranges\": [" );
+
+        for( size_t j = 0; j < r.failedRanges.size(); j++ )
+            fprintf( file, "%s[%llu, %llu]", j ? ", " : "", (llu)r.failedRanges[j].first, (llu)r.failedRanges[j].second );
+
+        fprintf( file, "]\n" );
+        fprintf( file, "    }%s\n", i < 9 ? "," : "" );
+    }
 
-    if( failureCount < 1 )
-        Log::Line( "Success!" );
-    else
-        Log::Line( "%llu / %lld Table %u parks failed.", failureCount, parkCount, table+1 );
+    fprintf( file, "  ]\n" );
+    fprintf( file, "}\n" );
+    fclose( file );
+}
 
-    SysHost::VirtualFree( tableParksRef );
-    SysHost::VirtualFree( tableParksTgt );
+//-----------------------------------------------------------
+const char* PlotTableName( const PlotTable table )
+{
+    static const char* names[] = { "Table1", "Table2", "Table3", "Table4", "Table5", "Table6", "Table7", "C1", "C2", "C3" };
+    
+    ASSERT( table >= PlotTable::Table1 && table <= PlotTable::C3 );
+    return names[(int)table];
 }
 
 // Unpack a single park 7,
@@ -0,0 +1,129 @@
+#include "PlotParkCache.h"
+
+//-----------------------------------------------------------
+PlotParkCache::PlotParkCache( size_t capacityBytes )
+    : _capacity( capacityBytes )
+{}
+
+//-----------------------------------------------------------
+PlotParkCache::~PlotParkCache()
+{}
+
+//-----------------------------------------------------------
+PlotParkRef PlotParkCache::GetOrLoad( const byte plotId[BB_PLOT_ID_LEN], const PlotTable table, const uint64 parkIndex, const LoadParkFunc& loadPark )
+{
+    ASSERT( parkIndex < ( 1ull << 56 ) );
+
+    ParkKey key;
+    memcpy( &key.plot, plotId, sizeof( key.plot ) );
+    key.park = ( (uint64)table << 56 ) | parkIndex;
+
+    std::unique_lock<std::mutex> lock( _lock );
+
+    // Counted once per lookup, as a wait may be woken up by other parks being loaded
+    bool waited = false;
+
+    for( ;; )
+    {
+        auto it = _entries.find( key );
+
+        if( it == _entries.end() )
+            break;
+
+        CacheEntry& entry = it->second;
+
+        if( !entry.loading )
+        {
+            // Hit, move it to the front of the LRU list
+            _lru.splice( _lru.begin(), _lru, entry.lruIt );
+            _stats.hits++;
+            _stats.coalesced += waited;
+            return entry.park;
+        }
+
+        // Another thread is decoding this park, wait for it.
+        // The entry may be gone once it's done (if the decode failed or it was evicted),
+        // in which case we decode it ourselves.
+        waited = true;
+        _loadedSignal.wait( lock );
+    }
+
+    _stats.coalesced += waited;
+
+    // Miss, reserve the entry so that other threads wait on us
+    _stats.misses++;
+    _entries[key] = CacheEntry();
+
+    lock.unlock();
+
+    auto park = std::make_shared<PlotPark>();
+    const bool loaded = loadPark( *park );
+
+    lock.lock();
+
+    if( !loaded )
+    {
+        _entries.erase( key );
+        lock.unlock();
+
+        _loadedSignal.notify_all();
+        return nullptr;
+    }
+
+    CacheEntry& entry = _entries[key];
+    entry.park    = park;
+    entry.loading = false;
+
+    _lru.push_front( key );
+    entry.lruIt = _lru.begin();
+
+    _stats.usedBytes += park->SizeBytes();
+    Evict();
+
+    lock.unlock();
+    _loadedSignal.notify_all();
+
+    return park;
+}
+
+//-----------------------------------------------------------
+void PlotParkCache::Evict()
+{
+    // #NOTE: Must be called with the lock held.
+    //        A park bigger than the whole cache is still returned to the caller, it's just not kept.
+    while( _stats.usedBytes > _capacity && !_lru.empty() )
+    {
+        const ParkKey key = _lru.back();
+        _lru.pop_back();
+
+        auto it = _entries.find( key );
+        ASSERT( it != _entries.end() && !it->second.loading );
+
+        _stats.usedBytes -= it->second.park->SizeBytes();
+        _stats.evictions++;
+        _entries.erase( it );
+    }
+}
+
+//-----------------------------------------------------------
+void PlotParkCache::Clear()
+{
+    std::lock_guard<std::mutex> lock( _lock );
+
+    // Keep the entries that are still being decoded
+    for( const ParkKey& key : _lru )
+        _entries.erase( key );
+
+    _lru.clear();
+    _stats.usedBytes = 0;
+}
+
+//-----------------------------------------------------------
+PlotParkCacheStats PlotParkCache::GetStats()
+{
+    std::lock_guard<std::mutex> lock( _lock );
+
+    PlotParkCacheStats stats = _stats;
+    stats.parkCount = (uint64)_lru.size();
+    return stats;
+}
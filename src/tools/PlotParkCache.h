@@ -0,0 +1,97 @@
+#pragma once
+#include "PlotReader.h"
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <list>
+
+// A fully decoded plot park.
+// Line point tables (1-6) use linePoints, while C3 and Table 7 parks use entries.
+struct PlotPark
+{
+    uint64               entryCount = 0;
+    std::vector<uint128> linePoints;
+    std::vector<uint64>  entries;
+
+    inline size_t SizeBytes() const
+    {
+        return sizeof( PlotPark ) + linePoints.capacity() * sizeof( uint128 ) + entries.capacity() * sizeof( uint64 );
+    }
+};
+
+struct PlotParkCacheStats
+{
+    uint64 hits       = 0;
+    uint64 misses     = 0;
+    uint64 coalesced  = 0;  // Lookups that waited on another thread decoding the same park
+    uint64 evictions  = 0;
+    size_t usedBytes  = 0;
+    uint64 parkCount  = 0;
+};
+
+/**
+ * Bounded, least-recently-used cache of decoded parks, shared between PlotReaders.
+ *
+ * Parks are keyed by plot id, table and park index, so a single cache
+ * can be shared by readers of different plots.
+ * This is the only part of proof lookups that is shared between threads:
+ * A PlotReader is not thread-safe, since it holds the read position of its plot file,
+ * so each thread must use its own reader and IPlotFile copy.
+ */
+class PlotParkCache
+{
+public:
+    // Decodes a park that is not in the cache. Returns false on failure.
+    using LoadParkFunc = std::function<bool( PlotPark& outPark )>;
+
+    PlotParkCache( size_t capacityBytes );
+    ~PlotParkCache();
+
+    // Get a park from the cache, or decode it with loadPark if it is not present.
+    // If another thread is already decoding the same park, this waits for it
+    // instead of decoding the park again.
+    // Returns nullptr if the park failed to decode.
+    PlotParkRef GetOrLoad( const byte plotId[BB_PLOT_ID_LEN], PlotTable table, uint64 parkIndex, const LoadParkFunc& loadPark );
+
+    void Clear();
+
+    PlotParkCacheStats GetStats();
+
+    inline size_t Capacity() const { return _capacity; }
+
+private:
+    struct ParkKey
+    {
+        uint64 plot;
+        uint64 park;    // Table in the high bits, park index in the low bits
+
+        inline bool operator==( const ParkKey& other ) const { return plot == other.plot && park == other.park; }
+    };
+
+    struct ParkKeyHash
+    {
+        inline size_t operator()( const ParkKey& key ) const
+        {
+            return (size_t)( key.plot ^ ( key.park * 0x9E3779B97F4A7C15ull ) );
+        }
+    };
+
+    struct CacheEntry
+    {
+        PlotParkRef                  park;
+        std::list<ParkKey>::iterator lruIt;
+        bool                         loading = true;    // A thread is decoding this park
+    };
+
+    void Evict();
+
+private:
+    size_t                   _capacity;
+    std::mutex               _lock;
+    std::condition_variable  _loadedSignal;
+    std::unordered_map<ParkKey, CacheEntry, ParkKeyHash> _entries;
+    std::list<ParkKey>       _lru;              // Most recently used at the front
+    PlotParkCacheStats       _stats;
+};
@@ -0,0 +1,296 @@
+#include "util/CliParser.h"
+#include "util/Log.h"
+#include "util/Util.h"
+#include "PlotReader.h"
+#include "PlotParkCache.h"
+#include "LatencyStats.h"
+#include "plotting/GlobalPlotConfig.h"
+#include "plotting/PlotValidation.h"
+#include "threading/MTJob.h"
+#include <algorithm>
+
+static const char* USAGE = R"(prove [OPTIONS] <plot_path>
+
+Looks up proofs for challenges in a plot, the same way a farmer does, and reports the lookup latency.
+For each challenge, the quality strings of all matching proofs are fetched,
+and optionally their full proofs.
+
+[ARGUMENTS]
+<plot_path>             : Path to the plot file.
+
+[OPTIONS]
+ -n, --count <n>        : Number of random challenges to look up. The default is 100.
+
+ -c, --challenge <hex>  : Look up a single challenge, given as a 32 byte hex string,
+                          and print the qualities and full proofs found.
+
+ -f, --full-proofs      : Also fetch the full proof of every quality found,
+                          as a farmer does when a proof is good enough to win.
+
+ --verify               : Validate every full proof fetched. Implies --full-proofs.
+
+ -m, --in-ram           : Load the whole plot into memory first.
+                          This measures the lookup cost without the disk latency.
+
+ --cache <MiB>          : Size of the decoded park cache shared by all threads, in MiB.
+                          The default is 0, which disables the cache.
+
+ Use the global -t, --threads option to look up challenges concurrently.
+ Each thread uses its own reader, sharing the park cache.
+
+ -h, --help             : Print this help message and exit.
+)";
+
+static void LogQualitiesAndProofs( PlotReader& reader, const byte challenge[BB_CHIA_CHALLENGE_SIZE] );
+
+//-----------------------------------------------------------
+void PlotProverMain( GlobalPlotConfig& gCfg, CliParser& cli )
+{
+    const char* plotPath     = nullptr;
+    const char* challengeStr = nullptr;
+    uint32      count        = 100;
+    bool        fullProofs   = false;
+    bool        verify       = false;
+    bool        inRAM        = false;
+    uint32      cacheMiB     = 0;
+
+    while( cli.HasArgs() )
+    {
+        if( cli.ReadU32( count, "-n", "--count" ) )
+            continue;
+        else if( cli.ReadStr( challengeStr, "-c", "--challenge" ) )
+            continue;
+        else if( cli.ReadSwitch( fullProofs, "-f", "--full-proofs" ) )
+            continue;
+        else if( cli.ReadSwitch( verify, "--verify" ) )
+            continue;
+        else if( cli.ReadSwitch( inRAM, "-m", "--in-ram" ) )
+            continue;
+        else if( cli.ReadU32( cacheMiB, "--cache" ) )
+            continue;
+        else if( cli.ArgConsume( "-h", "--help" ) )
+        {
+            Log::Line( USAGE );
+            exit( 0 );
+        }
+        else if( cli.IsLastArg() )
+        {
+            plotPath = cli.ArgConsume();
+        }
+        else
+        {
+            Fatal( "Unexpected argument '%s'.", cli.Arg() );
+        }
+    }
+
+    FatalIf( !plotPath, "Expected a plot path." );
+    FatalIf( count < 1, "Challenge count must be at least 1." );
+    fullProofs = fullProofs || verify;
+
+    const uint32 maxThreads  = SysHost::GetLogicalCPUCount();
+    const uint32 threadCount = gCfg.threadCount == 0 ? 1 : std::min( maxThreads, gCfg.threadCount );
+
+    // Each thread needs its own plot file, since readers are not thread-safe
+    IPlotFile** plotFiles = new IPlotFile*[threadCount];
+
+    if( inRAM )
+    {
+        Log::Line( "Reading plot file into memory..." );
+        auto* memPlot = new MemoryPlot();
+        FatalIf( !memPlot->Open( plotPath ), "Failed to open plot at path '%s'.", plotPath );
+
+        plotFiles[0] = memPlot;
+        for( uint32 i = 1; i < threadCount; i++ )
+            plotFiles[i] = new MemoryPlot( *memPlot );
+    }
+    else
+    {
+        auto* filePlot = new FilePlot();
+        FatalIf( !filePlot->Open( plotPath ), "Failed to open plot at path '%s'.", plotPath );
+
+        plotFiles[0] = filePlot;
+        for( uint32 i = 1; i < threadCount; i++ )
+            plotFiles[i] = new FilePlot( *filePlot );
+    }
+
+    for( uint32 i = 1; i < threadCount; i++ )
+        FatalIf( !plotFiles[i]->IsOpen(), "Failed to open plot at path '%s'.", plotPath );
+
+    IPlotFile* plotFile = plotFiles[0];
+
+    PlotParkCache* parkCache = cacheMiB > 0 ? new PlotParkCache( (size_t)cacheMiB MB ) : nullptr;
+
+    LoadLTargets();
+    PlotReader* readers = bbcalloc<PlotReader>( threadCount );
+    for( uint32 i = 0; i < threadCount; i++ )
+    {
+        new ( (void*)&readers[i] ) PlotReader( *plotFiles[i] );
+        readers[i].SetParkCache( parkCache );
+    }
+
+    PlotReader& reader = readers[0];
+
+    const uint32 k = plotFile->K();
+    Log::Line( "Plot    : %s", plotPath );
+    Log::Line( "K       : %u", k );
+    Log::Line( "C3 Parks: %llu", (llu)reader.GetC3ParkCount() );
+    Log::Line( "Threads : %u", threadCount );
+    Log::Line( "Cache   : %u MiB", cacheMiB );
+    Log::Line( "" );
+
+    byte challenge[BB_CHIA_CHALLENGE_SIZE];
+
+    if( challengeStr )
+    {
+        const size_t len = strlen( challengeStr );
+        FatalIf( len != BB_CHIA_CHALLENGE_SIZE * 2, "Invalid challenge. Expected %u hex characters.", BB_CHIA_CHALLENGE_SIZE * 2 );
+        HexStrToBytes( challengeStr, len, challenge, sizeof( challenge ) );
+
+        LogQualitiesAndProofs( reader, challenge );
+        exit( 0 );
+    }
+
+    LatencyStats* qualityLatencies = new LatencyStats[threadCount];
+    LatencyStats* proofLatencies   = new LatencyStats[threadCount];
+    uint64*       qualityCounts    = bbcalloc<uint64>( threadCount );
+    uint64*       failedCounts     = bbcalloc<uint64>( threadCount );
+
+    memset( qualityCounts, 0, sizeof( uint64 ) * threadCount );
+    memset( failedCounts , 0, sizeof( uint64 ) * threadCount );
+
+    Log::Line( "Looking up %u random challenges...", count );
+
+    ThreadPool pool( threadCount );
+    const auto lookupTimer = TimerBegin();
+
+    AnonMTJob::Run( pool, threadCount, [&]( AnonMTJob* self ) {
+
+        const uint32 id         = self->_jobId;
+        PlotReader&  reader     = readers[id];
+        const byte*  plotId     = reader.PlotFile().PlotId();
+        LatencyStats& qLatency  = qualityLatencies[id];
+        LatencyStats& pLatency  = proofLatencies[id];
+
+        uint32 challengeCount, offset, end;
+        GetThreadOffsets( self, count, challengeCount, offset, end );
+
+        byte challenge[BB_CHIA_CHALLENGE_SIZE];
+        std::vector<PlotQuality> qualities;
+
+        for( uint32 i = offset; i < end; i++ )
+        {
+            SysHost::Random( challenge, sizeof( challenge ) );
+
+            const auto timer = TimerBegin();
+            FatalIf( !reader.GetQualitiesForChallenge( challenge, qualities ), "Failed to read qualities from the plot." );
+            qLatency.samples.push_back( TicksToSeconds( TimerEndTicks( timer ) ) );
+
+            qualityCounts[id] += qualities.size();
+
+            if( !fullProofs )
+                continue;
+
+            // The farmer requests a full proof for a specific quality
+            for( const PlotQuality& quality : qualities )
+            {
+                PlotProof proof;
+                proof.f7Index = quality.f7Index;
+
+                const auto proofTimer = TimerBegin();
+                FatalIf( !reader.GetFullProofForF7Index( quality.f7Index, proof.xs ), "Failed to fetch full proof for f7 %llu.", (llu)quality.f7Index );
+                pLatency.samples.push_back( TicksToSeconds( TimerEndTicks( proofTimer ) ) );
+
+                if( verify )
+                {
+                    const uint64 f7 = PlotValidation::BytesToUInt64( challenge ) >> ( 64 - k );
+
+                    uint64 outF7 = 0;
+                    if( !PlotValidation::ValidateFullProof( k, plotId, proof.xs, outF7 ) || outF7 != f7 )
+                    {
+                        Log::Line( "Invalid proof for f7 %llu at index %llu.", (llu)f7, (llu)quality.f7Index );
+                        failedCounts[id]++;
+                    }
+                }
+            }
+        }
+    });
+
+    const double lookupElapsed = TimerEnd( lookupTimer );
+
+    LatencyStats qualityLatency, proofLatency;
+    uint64 qualityCount = 0;
+    uint64 failedCount  = 0;
+
+    for( uint32 i = 0; i < threadCount; i++ )
+    {
+        qualityLatency.Add( qualityLatencies[i] );
+        proofLatency  .Add( proofLatencies[i] );
+        qualityCount += qualityCounts[i];
+        failedCount  += failedCounts[i];
+    }
+
+    Log::Line( "" );
+    Log::Line( "Challenges: %u | Proofs found: %llu ( %.3lf per challenge )", count, (llu)qualityCount, (double)qualityCount / count );
+    Log::Line( "Completed in %.3lf seconds ( %.1lf challenges/s )", lookupElapsed, count / lookupElapsed );
+    qualityLatency.Print( "Quality lookup" );
+    proofLatency.Print( "Full proof lookup" );
+
+    if( parkCache )
+    {
+        const PlotParkCacheStats stats = parkCache->GetStats();
+        const uint64 lookups = stats.hits + stats.misses;
+
+        Log::Line( "Park cache: %llu lookups | %.2lf%% hits | %llu coalesced | %llu evictions | %llu parks ( %.2lf MiB )",
+            (llu)lookups, lookups ? stats.hits * 100.0 / lookups : 0.0, (llu)stats.coalesced, 
+            (llu)stats.evictions, (llu)stats.parkCount, (double)stats.usedBytes BtoMB );
+    }
+
+    if( verify )
+        Log::Line( "Invalid proofs: %llu / %llu", (llu)failedCount, (llu)qualityCount );
+
+    exit( failedCount == 0 ? 0 : 1 );
+}
+
+//-----------------------------------------------------------
+void LogQualitiesAndProofs( PlotReader& reader, const byte challenge[BB_CHIA_CHALLENGE_SIZE] )
+{
+    const uint32 k = reader.PlotFile().K();
+
+    std::vector<PlotQuality> qualities;
+    std::vector<PlotProof>   proofs;
+
+    FatalIf( !reader.GetQualitiesForChallenge( challenge, qualities ), "Failed to read qualities from the plot." );
+    FatalIf( !reader.GetFullProofsForChallenge( challenge, proofs ), "Failed to read full proofs from the plot." );
+    ASSERT( qualities.size() == proofs.size() );
+
+    Log::Line( "Found %llu proofs.", (llu)qualities.size() );
+
+    const size_t proofSize = k * PROOF_X_COUNT / 8;
+    byte* proofBytes = bbmalloc<byte>( proofSize );
+    char* hexStr     = bbmalloc<char>( proofSize * 2 + 1 );
+
+    for( size_t i = 0; i < qualities.size(); i++ )
+    {
+        size_t numEncoded = 0;
+        BytesToHexStr( qualities[i].quality, BB_CHIA_QUALITY_SIZE, hexStr, proofSize * 2, numEncoded );
+        hexStr[numEncoded*2] = 0;
+
+        Log::Line( "[%llu] f7 index: %llu", (llu)i, (llu)qualities[i].f7Index );
+        Log::Line( " Quality: %s", hexStr );
+
+        PlotReader::ProofToBytes( k, proofs[i].xs, proofBytes );
+        BytesToHexStr( proofBytes, proofSize, hexStr, proofSize * 2, numEncoded );
+        hexStr[numEncoded*2] = 0;
+
+        Log::Line( " Proof  : %s", hexStr );
+    }
+
+    free( proofBytes );
+    free( hexStr );
+}
+
+//-----------------------------------------------------------
+void PlotProverPrintUsage()
+{
+    Log::Line( USAGE );
+}
@@ -1,9 +1,13 @@
 #include "PlotReader.h"
+#include "PlotParkCache.h"
 #include "ChiaConsts.h"
 #include "util/BitView.h"
 #include "plotting/PlotTools.h"
 #include "plotting/CTables.h"
 #include "plotting/DTables.h"
+#include "plotmem/LPGen.h"
+#include "util/KeyTools.h"
+#include <algorithm>
 
 ///
 /// Plot Reader
@@ -18,6 +22,9 @@ PlotReader::PlotReader( IPlotFile& plot )
 
     _parkBuffer   = bbmalloc<uint64>( largestParkSize );
     _deltasBuffer = bbmalloc<byte>  ( maxDecompressedDeltasSize );
+    _f7Buffer     = bbcalloc<uint64>( kCheckpoint1Interval );
+    _c1Buffer     = bbmalloc<byte>  ( kCheckpoint2Interval * sizeof( uint64 ) );
+    _p7Entries    = bbcalloc<uint64>( kEntriesPerPark );
 }
 
 //-----------------------------------------------------------
@@ -25,6 +32,15 @@ PlotReader::~PlotReader()
 {
     free( _parkBuffer );
     free( _deltasBuffer );
+    free( _f7Buffer );
+    free( _c1Buffer );
+    free( _p7Entries );
+
+    if( _lpBuffer )
+        free( _lpBuffer );
+
+    if( _c2Entries )
+        free( _c2Entries );
 }
 
 //-----------------------------------------------------------
@@ -127,7 +143,7 @@ int64 PlotReader::ReadC3Park( uint64 parkIndex, uint64* f7Buffer )
         return -1;
 
     compressedSize = Swap16( compressedSize );
-    if( compressedSize > c3ParkSize )
+    if( compressedSize > c3ParkSize - sizeof( uint16 ) )
         return -1;
 
     // memset( _parkBuffer, 0, _parkBufferSize );
@@ -136,7 +152,7 @@ int64 PlotReader::ReadC3Park( uint64 parkIndex, uint64* f7Buffer )
 
     // Now we can read the f7 deltas from the C3 park
     const size_t deltaCount = FSE_decompress_usingDTable( 
-                                _deltasBuffer, kCheckpoint1Interval, 
+                                _deltasBuffer, kCheckpoint1Interval - 1, 
                                 _parkBuffer, compressedSize, 
                                 (const FSE_DTable*)DTable_C3 );
 
@@ -256,7 +272,10 @@ bool PlotReader::ReadLPParkComponents( TableId table, uint64 parkIndex,
     {
         // Uncompressed
         compressedDeltasSize &= 0x7fff;
-        if( _plot.Read( compressedDeltasSize, compressedDeltaBuffer ) != compressedDeltasSize )
+        if( compressedDeltasSize > kEntriesPerPark - 1 )
+            return false;
+
+        if( _plot.Read( compressedDeltasSize, deltaBuffer ) != compressedDeltasSize )
             return false;
 
         deltaCount = compressedDeltasSize;
@@ -325,6 +344,26 @@ bool PlotReader::ReadLP( TableId table, uint64 index, uint128& outLinePoint )
 {
     outLinePoint = 0;
 
+    if( _parkCache )
+    {
+        // Decode the whole park, so that any other line point in it is a cache hit
+        const uint64 parkIndex = index / kEntriesPerPark;
+
+        const uint128* linePoints = nullptr;
+        uint64         entryCount = 0;
+        PlotParkRef    park;
+
+        if( !GetLPPark( table, parkIndex, linePoints, entryCount, park ) )
+            return false;
+
+        const uint64 lpLocalIdx = index - parkIndex * kEntriesPerPark;
+        if( lpLocalIdx >= entryCount )
+            return false;
+
+        outLinePoint = linePoints[lpLocalIdx];
+        return true;
+    }
+
     CPBitReader stubReader;
     byte*       deltaBuffer   = nullptr;
     uint128     baseLinePoint = 0;
@@ -361,11 +400,528 @@ bool PlotReader::ReadLP( TableId table, uint64 index, uint128& outLinePoint )
 }
 
 //-----------------------------------------------------------
-bool PlotReader::FetchProofFromP7Entry( uint64 p7Entry, uint64 proof[32] )
+bool PlotReader::ReadP7Entry( uint64 f7Index, uint64& outP7Entry )
+{
+    const uint64 parkIndex = f7Index / kEntriesPerPark;
+
+    if( _parkCache )
+    {
+        PlotParkRef park = _parkCache->GetOrLoad( _plot.PlotId(), PlotTable::Table7, parkIndex, [=]( PlotPark& outPark ) {
+            outPark.entries.resize( kEntriesPerPark );
+            outPark.entryCount = kEntriesPerPark;
+            return ReadP7Entries( parkIndex, outPark.entries.data() );
+        });
+
+        if( !park )
+            return false;
+
+        outP7Entry = park->entries[f7Index - parkIndex * kEntriesPerPark];
+        return true;
+    }
+
+    if( parkIndex != _p7ParkIndex )
+    {
+        if( !ReadP7Entries( parkIndex, _p7Entries ) )
+        {
+            _p7ParkIndex = std::numeric_limits<uint64>::max();
+            return false;
+        }
+
+        _p7ParkIndex = parkIndex;
+    }
+
+    outP7Entry = _p7Entries[f7Index - parkIndex * kEntriesPerPark];
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::LoadC2Entries()
+{
+    if( _c2Entries )
+        return true;
+
+    const uint32 k           = _plot.K();
+    const size_t f7SizeBytes = CDiv( k, 8 );
+    const size_t c2TableSize = _plot.TableSize( PlotTable::C2 );
+    const uint64 maxEntries  = c2TableSize / f7SizeBytes;
+
+    if( maxEntries < 1 )
+        return false;
+
+    byte* c2Bytes = bbmalloc<byte>( c2TableSize );
+
+    if( !_plot.Seek( SeekOrigin::Begin, (int64)_plot.TableAddress( PlotTable::C2 ) ) ||
+         _plot.Read( c2TableSize, c2Bytes ) != (ssize_t)c2TableSize )
+    {
+        free( c2Bytes );
+        return false;
+    }
+
+    _c2Entries = bbcalloc<uint64>( maxEntries );
+    _c2Count   = 0;
+
+    for( uint64 i = 0; i < maxEntries; i++ )
+    {
+        uint64 f7 = 0;
+        memcpy( &f7, c2Bytes + i * f7SizeBytes, f7SizeBytes );
+        f7 = Swap64( f7 ) >> ( 64 - k );
+
+        // The table ends with an empty entry
+        if( i > 0 && f7 == 0 )
+            break;
+
+        _c2Entries[_c2Count++] = f7;
+    }
+
+    free( c2Bytes );
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::FindF7IndicesForChallenge( const byte challenge[BB_CHIA_CHALLENGE_SIZE], uint64& outF7Index, uint64& outCount )
+{
+    const uint64 f7 = PlotValidation::BytesToUInt64( challenge ) >> ( 64 - _plot.K() );
+    return FindF7Indices( f7, outF7Index, outCount );
+}
+
+//-----------------------------------------------------------
+bool PlotReader::FindF7Indices( const uint64 f7, uint64& outF7Index, uint64& outCount )
+{
+    outF7Index = 0;
+    outCount   = 0;
+
+    const uint64 c1Count = GetC3ParkCount();
+    if( c1Count == 0 )
+        return true;
+
+    if( !LoadC2Entries() )
+        return false;
+
+    // Each C2 entry is the C1 entry at every kCheckpoint2Interval-th C1 entry,
+    // and each C1 entry is the first f7 of a C3 park. The first matching f7 may be
+    // in the last park which starts with a value < f7, so we start searching from there.
+    const uint64 c2Index = (uint64)( std::lower_bound( _c2Entries, _c2Entries + _c2Count, f7 ) - _c2Entries );
+
+    uint64 startPark = 0;
+
+    if( c2Index > 0 )
+    {
+        const uint32 k           = _plot.K();
+        const size_t f7SizeBytes = CDiv( k, 8 );
+        const uint64 c1Start     = ( c2Index - 1 ) * kCheckpoint2Interval;
+        const uint64 c1End       = std::min( c1Start + kCheckpoint2Interval, c1Count );
+        const uint64 c1ReadCount = c1End - c1Start;
+        const size_t readSize    = c1ReadCount * f7SizeBytes;
+
+        if( !_plot.Seek( SeekOrigin::Begin, (int64)( _plot.TableAddress( PlotTable::C1 ) + c1Start * f7SizeBytes ) ) ||
+             _plot.Read( readSize, _c1Buffer ) != (ssize_t)readSize )
+            return false;
+
+        // Find the first C1 entry >= f7. The first entry in this range is always < f7.
+        uint64 lo = 1, hi = c1ReadCount;
+        while( lo < hi )
+        {
+            const uint64 mid = ( lo + hi ) / 2;
+
+            uint64 c1 = 0;
+            memcpy( &c1, _c1Buffer + mid * f7SizeBytes, f7SizeBytes );
+            c1 = Swap64( c1 ) >> ( 64 - k );
+
+            if( c1 < f7 )
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        startPark = c1Start + lo - 1;
+    }
+
+    // Decode C3 parks until we go past the f7
+    for( uint64 park = startPark; park < c1Count; park++ )
+    {
+        const uint64* f7s        = nullptr;
+        uint64        entryCount = 0;
+        PlotParkRef   c3Park;
+
+        if( !GetC3Park( park, f7s, entryCount, c3Park ) )
+            return false;
+
+        for( uint64 i = 0; i < entryCount; i++ )
+        {
+            const uint64 entry = f7s[i];
+
+            if( entry == f7 )
+            {
+                if( outCount == 0 )
+                    outF7Index = park * kCheckpoint1Interval + i;
+
+                outCount++;
+            }
+            else if( entry > f7 )
+                return true;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::GetQualitiesForChallenge( const byte challenge[BB_CHIA_CHALLENGE_SIZE], std::vector<PlotQuality>& outQualities )
+{
+    outQualities.clear();
+
+    uint64 f7Index, matchCount;
+    if( !FindF7IndicesForChallenge( challenge, f7Index, matchCount ) )
+        return false;
+
+    for( uint64 i = 0; i < matchCount; i++ )
+    {
+        PlotQuality quality;
+        quality.f7Index = f7Index + i;
+
+        if( !GetQualityForF7Index( quality.f7Index, challenge, quality.quality ) )
+            return false;
+
+        outQualities.push_back( quality );
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::GetFullProofsForChallenge( const byte challenge[BB_CHIA_CHALLENGE_SIZE], std::vector<PlotProof>& outProofs )
+{
+    outProofs.clear();
+
+    uint64 f7Index, matchCount;
+    if( !FindF7IndicesForChallenge( challenge, f7Index, matchCount ) )
+        return false;
+
+    if( matchCount == 0 )
+        return true;
+
+    std::vector<uint64> f7Indices( matchCount );
+    for( uint64 i = 0; i < matchCount; i++ )
+        f7Indices[i] = f7Index + i;
+
+    outProofs.resize( matchCount );
+    if( !GetFullProofsForF7Indices( f7Indices.data(), matchCount, outProofs.data() ) )
+    {
+        outProofs.clear();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::GetQualityForF7Index( uint64 f7Index, const byte challenge[BB_CHIA_CHALLENGE_SIZE], byte outQuality[BB_CHIA_QUALITY_SIZE] )
+{
+    const uint32 k = _plot.K();
+    
+    uint64 position;
+    if( !ReadP7Entry( f7Index, position ) )
+        return false;
+
+    // The last 5 bits of the challenge determine which back pointer
+    // we follow on tables 6 to 2 to get to 2 adjacent x's.
+    const uint32 last5Bits = challenge[31] & 0x1f;
+
+    BackPtr ptr;
+    for( TableId table = TableId::Table6; table > TableId::Table1; table-- )
+    {
+        if( !ReadBackPtr( table, position, ptr ) )
+            return false;
+
+        position = ( ( last5Bits >> ( (uint32)table - 1 ) ) & 1 ) == 0 ? ptr.y : ptr.x;
+    }
+
+    if( !ReadBackPtr( TableId::Table1, position, ptr ) )
+        return false;
+
+    // The quality is sha256( challenge + x1 + x2 ), with x1 being the smaller x,
+    // and the x's packed into k bits each, big-endian.
+    const uint32 xBytes = CDiv( k * 2, 8 );
+    byte hashInput[BB_CHIA_CHALLENGE_SIZE + 16] = { 0 };
+    memcpy( hashInput, challenge, BB_CHIA_CHALLENGE_SIZE );
+
+    const uint128 xs = ( ( (uint128)ptr.y << k ) | ptr.x ) << ( xBytes * 8 - k * 2 );
+    for( uint32 i = 0; i < xBytes; i++ )
+        hashInput[BB_CHIA_CHALLENGE_SIZE + i] = (byte)( xs >> ( ( xBytes - i - 1 ) * 8 ) );
+
+    bls::Util::Hash256( outQuality, hashInput, BB_CHIA_CHALLENGE_SIZE + xBytes );
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::GetFullProofForF7Index( uint64 f7Index, uint64 fullProofXs[PROOF_X_COUNT] )
+{
+    uint64 p7Entry;
+    if( !ReadP7Entry( f7Index, p7Entry ) )
+        return false;
+
+    if( !FetchProofsFromP7Entries( &p7Entry, 1, fullProofXs ) )
+        return false;
+
+    PlotValidation::ReorderProof( _plot.K(), _plot.PlotId(), fullProofXs );
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::GetFullProofsForF7Indices( const uint64* f7Indices, const uint64 count, PlotProof* outProofs )
+{
+    _batchP7Entries.resize( count );
+
+    for( uint64 i = 0; i < count; i++ )
+    {
+        if( !ReadP7Entry( f7Indices[i], _batchP7Entries[i] ) )
+            return false;
+    }
+
+    std::vector<uint64> xs( count * PROOF_X_COUNT );
+    if( !FetchProofsFromP7Entries( _batchP7Entries.data(), count, xs.data() ) )
+        return false;
+
+    for( uint64 i = 0; i < count; i++ )
+    {
+        PlotProof& proof = outProofs[i];
+        proof.f7Index = f7Indices[i];
+        memcpy( proof.xs, xs.data() + i * PROOF_X_COUNT, sizeof( proof.xs ) );
+
+        PlotValidation::ReorderProof( _plot.K(), _plot.PlotId(), proof.xs );
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::ReadBackPtr( TableId table, uint64 index, BackPtr& outPtr )
+{
+    uint128 lp = 0;
+    if( !ReadLP( table, index, lp ) )
+        return false;
+
+    outPtr = LinePointToBackPtr( lp );
+    return true;
+}
+
+//-----------------------------------------------------------
+BackPtr PlotReader::LinePointToBackPtr( const uint128 linePoint ) const
+{
+    // Line points of k <= 32 fit in 64 bits
+    if( _plot.K() <= 32 )
+        return LinePointToSquare64( (uint64)linePoint );
+    
+    return LinePointToSquare( linePoint );
+}
+
+//-----------------------------------------------------------
+bool PlotReader::GetLPPark( TableId table, uint64 parkIndex, const uint128*& outLinePoints, uint64& outEntryCount, PlotParkRef& outPark )
+{
+    if( _parkCache )
+    {
+        outPark = _parkCache->GetOrLoad( _plot.PlotId(), (PlotTable)table, parkIndex, [=]( PlotPark& park ) {
+            park.linePoints.resize( kEntriesPerPark );
+            return ReadLPPark( table, parkIndex, park.linePoints.data(), park.entryCount );
+        });
+
+        if( !outPark )
+            return false;
+
+        outLinePoints = outPark->linePoints.data();
+        outEntryCount = outPark->entryCount;
+        return true;
+    }
+
+    if( !_lpBuffer )
+        _lpBuffer = bbmalloc<uint128>( kEntriesPerPark );
+
+    outLinePoints = _lpBuffer;
+    return ReadLPPark( table, parkIndex, _lpBuffer, outEntryCount );
+}
+
+//-----------------------------------------------------------
+bool PlotReader::GetC3Park( uint64 parkIndex, const uint64*& outF7s, uint64& outEntryCount, PlotParkRef& outPark )
+{
+    if( _parkCache )
+    {
+        outPark = _parkCache->GetOrLoad( _plot.PlotId(), PlotTable::C3, parkIndex, [=]( PlotPark& park ) {
+            park.entries.resize( kCheckpoint1Interval );
+
+            const int64 entryCount = ReadC3Park( parkIndex, park.entries.data() );
+            if( entryCount < 0 )
+                return false;
+
+            park.entryCount = (uint64)entryCount;
+            return true;
+        });
+
+        if( !outPark )
+            return false;
+
+        outF7s        = outPark->entries.data();
+        outEntryCount = outPark->entryCount;
+        return true;
+    }
+
+    const int64 entryCount = ReadC3Park( parkIndex, _f7Buffer );
+    if( entryCount < 0 )
+        return false;
+
+    outF7s        = _f7Buffer;
+    outEntryCount = (uint64)entryCount;
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::FetchProofFromP7Entry( uint64 p7Entry, uint64 fullProofXs[PROOF_X_COUNT] )
 {
-    // #TODO: Implement me
-    ASSERT( 0 );
-    return false;
+    uint64 lpIndices[2][PROOF_X_COUNT];
+
+    uint64* lpIdxSrc = lpIndices[0];
+    uint64* lpIdxDst = lpIndices[1];
+
+    *lpIdxSrc = p7Entry;
+
+    // Fetch line points to back pointers going through all our tables
+    // from 6 to 1, grabbing all of the x's that make up a proof.
+    uint32 lookupCount = 1;
+
+    for( TableId table = TableId::Table6; table >= TableId::Table1; table-- )
+    {
+        ASSERT( lookupCount <= 32 );
+
+        for( uint32 i = 0, dst = 0; i < lookupCount; i++, dst += 2 )
+        {
+            BackPtr ptr;
+            if( !ReadBackPtr( table, lpIdxSrc[i], ptr ) )
+                return false;
+
+            lpIdxDst[dst+0] = ptr.y;
+            lpIdxDst[dst+1] = ptr.x;
+        }
+
+        lookupCount <<= 1;
+
+        std::swap( lpIdxSrc, lpIdxDst );
+    }
+
+    // Full proof x's will be at the src ptr
+    memcpy( fullProofXs, lpIdxSrc, sizeof( uint64 ) * PROOF_X_COUNT );
+    return true;
+}
+
+//-----------------------------------------------------------
+bool PlotReader::FetchProofsFromP7Entries( const uint64* p7Entries, const uint64 count, uint64* fullProofXs )
+{
+    if( count == 0 )
+        return true;
+
+    ASSERT( count * PROOF_X_COUNT <= std::numeric_limits<uint32>::max() );
+
+    // Each proof's tree is laid out in PROOF_X_COUNT slots: Entry i of a table is at slot i,
+    // and its back pointers go to slots 2i and 2i+1 on the next table.
+    const uint64 slotCount = count * PROOF_X_COUNT;
+
+    _batchLPIndices[0].resize( slotCount );
+    _batchLPIndices[1].resize( slotCount );
+
+    uint64* lpIdxSrc = _batchLPIndices[0].data();
+    uint64* lpIdxDst = _batchLPIndices[1].data();
+
+    for( uint64 i = 0; i < count; i++ )
+        lpIdxSrc[i * PROOF_X_COUNT] = p7Entries[i];
+
+    uint32 lookupCount = 1;
+
+    for( TableId table = TableId::Table6; table >= TableId::Table1; table-- )
+    {
+        // Sort all the lookups of this table by line point index,
+        // so that the ones that fall in the same park are resolved together.
+        const uint64 tableLookups = count * lookupCount;
+        _batchOrder.resize( tableLookups );
+
+        uint32* order = _batchOrder.data();
+        for( uint64 i = 0; i < count; i++ )
+            for( uint32 j = 0; j < lookupCount; j++ )
+                *order++ = (uint32)( i * PROOF_X_COUNT + j );
+
+        order = _batchOrder.data();
+        std::sort( order, order + tableLookups, [=]( const uint32 a, const uint32 b ) {
+            return lpIdxSrc[a] < lpIdxSrc[b];
+        });
+
+        auto writeBackPtr = [=]( const uint32 slot, const BackPtr& ptr ) {
+            const uint32 dst = slot + slot % PROOF_X_COUNT;
+            lpIdxDst[dst+0] = ptr.y;
+            lpIdxDst[dst+1] = ptr.x;
+        };
+
+        for( uint64 i = 0; i < tableLookups; )
+        {
+            const uint64 parkIndex = lpIdxSrc[order[i]] / kEntriesPerPark;
+
+            uint64 end = i + 1;
+            while( end < tableLookups && lpIdxSrc[order[end]] / kEntriesPerPark == parkIndex )
+                end++;
+
+            if( end - i == 1 && !_parkCache )
+            {
+                // Only a single line point in this park, so we only decode up to it
+                BackPtr ptr;
+                if( !ReadBackPtr( table, lpIdxSrc[order[i]], ptr ) )
+                    return false;
+
+                writeBackPtr( order[i], ptr );
+            }
+            else
+            {
+                const uint128* linePoints = nullptr;
+                uint64         entryCount = 0;
+                PlotParkRef    park;
+
+                if( !GetLPPark( table, parkIndex, linePoints, entryCount, park ) )
+                    return false;
+
+                for( uint64 j = i; j < end; j++ )
+                {
+                    const uint64 lpLocalIdx = lpIdxSrc[order[j]] - parkIndex * kEntriesPerPark;
+                    if( lpLocalIdx >= entryCount )
+                        return false;
+
+                    writeBackPtr( order[j], LinePointToBackPtr( linePoints[lpLocalIdx] ) );
+                }
+            }
+
+            i = end;
+        }
+
+        lookupCount <<= 1;
+        std::swap( lpIdxSrc, lpIdxDst );
+    }
+
+    // Full proof x's will be at the src ptr
+    memcpy( fullProofXs, lpIdxSrc, sizeof( uint64 ) * slotCount );
+    return true;
+}
+
+//-----------------------------------------------------------
+void PlotReader::ProofToBytes( const uint32 k, const uint64 fullProofXs[PROOF_X_COUNT], byte* proofBytes )
+{
+    ASSERT( k <= 64 );
+    memset( proofBytes, 0, k * PROOF_X_COUNT / 8 );
+
+    uint64 bitPos = 0;
+    for( uint32 i = 0; i < PROOF_X_COUNT; i++ )
+    {
+        const uint64 x = fullProofXs[i];
+
+        for( int32 b = (int32)k - 1; b >= 0; b--, bitPos++ )
+        {
+            if( ( x >> b ) & 1 )
+                proofBytes[bitPos >> 3] |= (byte)( 0x80 >> ( bitPos & 7 ) );
+        }
+    }
 }
 
 ///
@@ -704,7 +1260,7 @@ FilePlot::FilePlot()
 FilePlot::FilePlot( const FilePlot& file )
 {
     if( file.IsOpen() )
-        Open( file._plotPath.c_str() ); // #TODO: Seek to same location
+        Open( file._plotPath.c_str(), file._directIO ); // #TODO: Seek to same location
     else
         _plotPath = "";
 }
@@ -712,15 +1268,34 @@ FilePlot::FilePlot( const FilePlot& file )
 //-----------------------------------------------------------
 FilePlot::~FilePlot()
 {
-
+    if( _blockBuffer )
+        SysHost::VirtualFree( _blockBuffer );
 }
 
 //-----------------------------------------------------------
 bool FilePlot::Open( const char* path )
 {
-    if( !_file.Open( path, FileMode::Open, FileAccess::Read, FileFlags::None ) )
+    return Open( path, false );
+}
+
+//-----------------------------------------------------------
+bool FilePlot::Open( const char* path, const bool directIO )
+{
+    const FileFlags flags = directIO ? FileFlags::NoBuffering : FileFlags::None;
+
+    if( !_file.Open( path, FileMode::Open, FileAccess::Read, flags ) )
         return false;
 
+    _directIO = directIO;
+    _position = 0;
+
+    if( directIO && !_blockBuffer )
+    {
+        // Large enough for most park reads to take a single read call
+        _blockBufferSize = RoundUpToNextBoundary( (size_t)( 64 KB ), (int)_file.BlockSize() );
+        _blockBuffer     = (byte*)SysHost::VirtualAlloc( _blockBufferSize );
+    }
+
     // Read the header
     int headerError = 0;
     if( !ReadHeader( headerError ) )
@@ -757,13 +1332,85 @@ size_t FilePlot::PlotSize() const
 //-----------------------------------------------------------
 ssize_t FilePlot::Read( size_t size, void* buffer )
 {
+    if( _directIO )
+        return ReadDirect( size, buffer );
+
+    _readCount++;
     return _file.Read( buffer, size );
 }
 
+//-----------------------------------------------------------
+ssize_t FilePlot::ReadDirect( size_t size, void* buffer )
+{
+    const size_t blockSize = _file.BlockSize();
+
+    byte*  writer    = (byte*)buffer;
+    size_t totalRead = 0;
+
+    while( totalRead < size )
+    {
+        // Read whole blocks containing the requested range, then copy out what was asked for
+        const int64  blockStart  = _position / (int64)blockSize * (int64)blockSize;
+        const size_t blockOffset = (size_t)( _position - blockStart );
+        const size_t readSize    = std::min( RoundUpToNextBoundary( blockOffset + size - totalRead, (int)blockSize ), _blockBufferSize );
+
+        if( !_file.Seek( blockStart, SeekOrigin::Begin ) )
+            return -1;
+
+        _readCount++;
+        const ssize_t sizeRead = _file.Read( _blockBuffer, readSize );
+        if( sizeRead < 0 )
+            return -1;
+
+        // End of file
+        if( (size_t)sizeRead <= blockOffset )
+            break;
+
+        const size_t copySize = std::min( (size_t)sizeRead - blockOffset, size - totalRead );
+        memcpy( writer + totalRead, _blockBuffer + blockOffset, copySize );
+
+        totalRead += copySize;
+        _position += (int64)copySize;
+
+        if( (size_t)sizeRead < readSize )
+            break;
+    }
+
+    return (ssize_t)totalRead;
+}
+
 //-----------------------------------------------------------
 bool FilePlot::Seek( SeekOrigin origin, int64 offset )
 {
-    return _file.Seek( offset, origin );
+    if( !_directIO )
+        return _file.Seek( offset, origin );
+
+    // Direct reads always seek to the block they need, so only track the position here
+    int64 absPosition = 0;
+
+    switch( origin )
+    {
+        case SeekOrigin::Begin:
+            absPosition = offset;
+            break;
+
+        case SeekOrigin::Current:
+            absPosition = _position + offset;
+            break;
+
+        case SeekOrigin::End:
+            absPosition = (int64)PlotSize() + offset;
+            break;
+    
+        default:
+            return false;
+    }
+
+    if( absPosition < 0 || absPosition > (int64)PlotSize() )
+        return false;
+
+    _position = absPosition;
+    return true;
 }
 
 //-----------------------------------------------------------
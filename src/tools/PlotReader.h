@@ -2,9 +2,19 @@
 #include "plotting/PlotTools.h"
 #include "io/FileStream.h"
 #include "util/Util.h"
+#include "plotting/PlotValidation.h"
 #include <vector>
+#include <memory>
 
 class CPBitReader;
+struct BackPtr;
+struct PlotPark;
+class PlotParkCache;
+
+using PlotParkRef = std::shared_ptr<const PlotPark>;
+
+#define BB_CHIA_CHALLENGE_SIZE 32
+#define BB_CHIA_QUALITY_SIZE   32
 
 enum class PlotTable
 {
@@ -29,6 +39,18 @@ struct PlotHeader
     uint64 tablePtrs[10]               = { 0 };
 };
 
+struct PlotQuality
+{
+    uint64 f7Index;                         // Index of the f7 entry that matched the challenge
+    byte   quality[BB_CHIA_QUALITY_SIZE];
+};
+
+struct PlotProof
+{
+    uint64 f7Index;
+    uint64 xs[PROOF_X_COUNT];               // In proof order
+};
+
 // Base Abstract class for read-only plot files
 class IPlotFile
 {
@@ -145,6 +167,11 @@ public:
     ~FilePlot();
 
     bool Open( const char* path ) override;
+
+    // Optionally bypass the OS page cache (O_DIRECT on Linux).
+    // Direct reads are done in whole blocks, through an aligned buffer.
+    bool Open( const char* path, bool directIO );
+
     bool IsOpen() const override;
 
     size_t PlotSize() const override;
@@ -155,17 +182,38 @@ public:
 
     int GetError() override;
 
+    // Number of read calls issued to the file
+    inline uint64 ReadCount() const { return _readCount; }
+
+private:
+    ssize_t ReadDirect( size_t size, void* buffer );
+
 private:
     FileStream  _file;
-    std::string _plotPath = "";
+    std::string _plotPath  = "";
+    uint64      _readCount = 0;
+
+    // Direct IO
+    bool        _directIO        = false;
+    int64       _position        = 0;
+    byte*       _blockBuffer     = nullptr;
+    size_t      _blockBufferSize = 0;
 };
 
+// #NOTE: A PlotReader is not thread-safe, it holds the read position of its plot file.
+//        To look up proofs from multiple threads, use one reader per thread,
+//        each with its own IPlotFile copy, and share a PlotParkCache between them.
 class PlotReader
 {
 public:
     PlotReader( IPlotFile& plot );
     ~PlotReader();
 
+    // Cache decoded parks in a (shared) park cache for proof lookups. Pass nullptr to disable it.
+    // ReadC3Park(), ReadP7Entries() and ReadLPPark() always read from the plot.
+    inline void SetParkCache( PlotParkCache* cache ) { _parkCache = cache; }
+    inline PlotParkCache* ParkCache() const { return _parkCache; }
+
     uint64 GetC3ParkCount() const;
 
     // Get the maximum potential F7 count.
@@ -185,14 +233,51 @@ public:
 
     bool ReadP7Entries( uint64 parkIndex, uint64* p7Indices );
 
-    uint64 GetFullProofForF7Index( uint64 f7Index, byte* fullProof );
+    // Read the p7 entry (the Table 6 line point index) of a single f7 entry.
+    bool ReadP7Entry( uint64 f7Index, uint64& outP7Entry );
+
+    // Find the f7 entries with the given value, by searching the C2 and C1 tables
+    // and then decoding the C3 parks that may contain it.
+    // Outputs the index of the first matching entry and the number of matches, which may be 0.
+    // Returns false if there was an error reading the plot.
+    bool FindF7Indices( uint64 f7, uint64& outF7Index, uint64& outCount );
+
+    // Same as FindF7Indices, using the first k bits of the challenge as the f7.
+    bool FindF7IndicesForChallenge( const byte challenge[BB_CHIA_CHALLENGE_SIZE], uint64& outF7Index, uint64& outCount );
+
+    // Get the quality strings for all the proofs matching a challenge.
+    // A quality only needs 2 of the proof's x's, chosen by the last 5 bits of the challenge,
+    // so only a single line point is read per table.
+    bool GetQualitiesForChallenge( const byte challenge[BB_CHIA_CHALLENGE_SIZE], std::vector<PlotQuality>& outQualities );
+
+    // Get the full proofs, in proof order, for all the proofs matching a challenge.
+    bool GetFullProofsForChallenge( const byte challenge[BB_CHIA_CHALLENGE_SIZE], std::vector<PlotProof>& outProofs );
+
+    bool GetQualityForF7Index( uint64 f7Index, const byte challenge[BB_CHIA_CHALLENGE_SIZE], byte outQuality[BB_CHIA_QUALITY_SIZE] );
+
+    // Get the full proof for an f7 entry, in proof order.
+    bool GetFullProofForF7Index( uint64 f7Index, uint64 fullProofXs[PROOF_X_COUNT] );
+
+    // Get the full proofs of multiple f7 entries, in proof order. See FetchProofsFromP7Entries().
+    bool GetFullProofsForF7Indices( const uint64* f7Indices, uint64 count, PlotProof* outProofs );
 
-    // void   FindF7ParkIndices( uintt64 f7, std::vector<uint64> indices );
     bool ReadLPPark( TableId table, uint64 parkIndex, uint128 linePoints[kEntriesPerPark], uint64& outEntryCount );
 
     bool ReadLP( TableId table, uint64 index, uint128& outLinePoint );
 
-    bool FetchProofFromP7Entry( uint64 p7Entry, uint64 proof[32] );
+    // Fetch the x's of a proof by following all of the back pointers from a Table 6 line point.
+    // The x's are output in plot order, see PlotValidation::ReorderProof().
+    bool FetchProofFromP7Entry( uint64 p7Entry, uint64 fullProofXs[PROOF_X_COUNT] );
+
+    // Fetch the x's of multiple proofs at once. fullProofXs must hold PROOF_X_COUNT x's per entry.
+    // The back pointer trees of all the proofs are walked together, one table at a time,
+    // so all the line points of a table are known up front and each park is decoded once
+    // for all of the line points it holds.
+    bool FetchProofsFromP7Entries( const uint64* p7Entries, uint64 count, uint64* fullProofXs );
+
+    // Convert the x's of a proof to the serialized chia proof format: The k-bit x's, packed big-endian.
+    // proofBytes must hold k * PROOF_X_COUNT / 8 bytes.
+    static void ProofToBytes( const uint32 k, const uint64 fullProofXs[PROOF_X_COUNT], byte* proofBytes );
 
     inline IPlotFile& PlotFile() const { return _plot; }
 
@@ -202,11 +287,39 @@ private:
                                CPBitReader& outStubs, byte*& outDeltas, 
                                uint128& outBaseLinePoint, uint64& outDeltaCounts );
 
+    bool ReadBackPtr( TableId table, uint64 index, BackPtr& outPtr );
+
+    BackPtr LinePointToBackPtr( const uint128 linePoint ) const;
+
+    // Get a decoded park, from the park cache if there is one.
+    // Otherwise the park is decoded into a buffer owned by the reader,
+    // which is only valid until the next call.
+    bool GetLPPark( TableId table, uint64 parkIndex, const uint128*& outLinePoints, uint64& outEntryCount, PlotParkRef& outPark );
+    bool GetC3Park( uint64 parkIndex, const uint64*& outF7s, uint64& outEntryCount, PlotParkRef& outPark );
+
+    bool LoadC2Entries();
+
 private:
     IPlotFile& _plot;
 
     // size_t  _parkBufferSize;
     uint64* _parkBuffer    ;        // Buffer for loading compressed park data.
     byte*   _deltasBuffer  ;        // Buffer for decompressing deltas in parks that have delta. 
+
+    // Proof lookup
+    uint64* _f7Buffer      = nullptr;   // Decoded C3 park
+    byte*   _c1Buffer      = nullptr;   // C1 entries between 2 C2 entries
+    uint64* _c2Entries     = nullptr;   // Loaded on the first lookup
+    uint64  _c2Count       = 0;
+    uint64* _p7Entries     = nullptr;   // Last P7 park read by ReadP7Entry
+    uint64  _p7ParkIndex   = std::numeric_limits<uint64>::max();
+    uint128* _lpBuffer     = nullptr;   // Decoded line point park, when there's no park cache
+
+    PlotParkCache* _parkCache = nullptr;
+
+    // Batched proof lookups
+    std::vector<uint64> _batchLPIndices[2];
+    std::vector<uint32> _batchOrder;
+    std::vector<uint64> _batchP7Entries;
 };
 
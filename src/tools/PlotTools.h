@@ -6,7 +6,18 @@ struct ValidatePlotOptions
     std::string plotPath    = "";
     bool        inRAM       = false;
     bool        unpacked    = false;
+    size_t      memoryBudget = 0;   // If > 0, unpacked validation streams the plot within this many bytes
     uint32      threadCount = 0;
     float       startOffset = 0.0f; // Offset percent at which to start
+    uint64      sampleCount = 0;    // If > 0, only validate this many randomly sampled proofs
+    float64     confidence  = 99.0; // Confidence level, in percent, of the reported invalid proof bound when sampling
 };
 
+// See PlotValidator.cpp. Returns true if all the proofs are valid.
+// #NOTE: Exits the process when validating unpacked.
+bool ValidatePlot( const ValidatePlotOptions& options );
+
+// See PlotComparer.cpp. Returns true if the P7 entries [start, end) of both plots match,
+// allowing entries with the same f7 to be in a different order.
+// Entries [0, entryCount) hold the surrounding parks, which groups of the same f7 may extend into.
+bool CompareP7Entries( const uint64* refEntries, const uint64* tgtEntries, int64 entryCount, int64 start, int64 end );
@@ -12,28 +12,19 @@
 #include "threading/MTJob.h"
 #include "util/CliParser.h"
 #include "plotting/GlobalPlotConfig.h"
+#include "plotting/PlotValidation.h"
 #include <mutex>
+#include <cmath>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-function"
 
-#define PROOF_X_COUNT       64
-#define MAX_K_SIZE          48
-#define MAX_META_MULTIPLIER 4
-#define MAX_Y_BIT_SIZE      ( MAX_K_SIZE + kExtraBits )
-#define MAX_META_BIT_SIZE   ( MAX_K_SIZE * MAX_META_MULTIPLIER )
-#define MAX_FX_BIT_SIZE     ( MAX_Y_BIT_SIZE + MAX_META_BIT_SIZE + MAX_META_BIT_SIZE )
-
 #define COLOR_NONE       "\033[0m"
 #define COLOR_RED        "\033[31m"
 #define COLOR_GREEN      "\033[32m"
 #define COLOR_RED_BOLD   "\033[1m\033[31m"
 #define COLOR_GREEN_BOLD "\033[1m\033[32m"
 
-typedef Bits<MAX_Y_BIT_SIZE>    YBits;
-typedef Bits<MAX_META_BIT_SIZE> MetaBits;
-typedef Bits<MAX_FX_BIT_SIZE>   FxBits;
-
 // #TODO: Add C1 & C2 table validation
 
 //-----------------------------------------------------------
@@ -58,6 +49,25 @@ You can specify the thread count in the bladebit global option '-t'.
                 it requires around 128GiB of RAM for k=32.
                 This is only supported for plots with k=32 and below.
 
+ --memory <size>
+              : Use with --unpack to validate with a bounded amount of memory. Ex: 32G
+                Proofs are validated in windows that fit within the given size,
+                and each window streams through the plot's tables in park order.
+
+ -s, --sample <n>
+              : Only validate n proofs, picked randomly and spread over the whole plot.
+                This takes seconds instead of hours, and reports an upper bound
+                on the fraction of invalid proofs in the plot.
+
+ --confidence <percent>
+              : Confidence level of the bound reported when sampling. The default is 99.
+                If --sample is not specified, enough proofs are sampled to
+                bound the invalid proofs to --max-invalid with this confidence.
+
+ --max-invalid <percent>
+              : Fraction of invalid proofs to bound when using --confidence
+                without --sample. The default is 0.1.
+
  -h, --help   : Print this help message and exit.
 )";
 
@@ -93,27 +103,11 @@ struct UnpackedK32Plot
 };
 
 
-static void GetProofF1( uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64 fx[PROOF_X_COUNT] );
-
-template<bool Use64BitLpToSquare>
-static bool FetchProof( PlotReader& plot, uint64 t6LPIndex, uint64 fullProofXs[PROOF_X_COUNT] );
-
-static bool ValidateFullProof( const uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64& outF7 );
-static void ReorderProof( PlotReader& plot, uint64 fullProofXs[PROOF_X_COUNT] );
-static void GetProofF1( uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64 fx[PROOF_X_COUNT] );
-
-static uint64 BytesToUInt64( const byte bytes[8] );
-static uint64 SliceUInt64FromBits( const byte* bytes, uint32 bitOffset, uint32 bitCount );
-
-static bool FxMatch( uint64 yL, uint64 yR );
-
-static void FxGen( const TableId table, const uint32 k, 
-                   const uint64 y, const MetaBits& metaL, const MetaBits& metaR,
-                   uint64& outY, MetaBits& outMeta );
-
-static bool ValidatePlot( const ValidatePlotOptions& options );
 
 static uint64 ValidateInMemory( UnpackedK32Plot& plot, ThreadPool& pool );
+static uint64 ValidateStreaming( IPlotFile** plotFiles, ThreadPool& pool, uint32 threadCount, size_t memoryBudget );
+static bool   ValidateSampled( IPlotFile** plotFiles, ThreadPool& pool, const ValidatePlotOptions& options );
+static float64 InvalidProofsUpperBound( uint64 sampleCount, uint64 failedCount, float64 confidence );
 
 // Thread-safe log
 static std::mutex _logLock;
@@ -137,10 +131,21 @@ void PlotValidatorMain( GlobalPlotConfig& gCfg, CliParser& cli )
 {
     ValidatePlotOptions opts;
 
+    float64 confidence = 0;
+    float64 maxInvalid = 0.1;
+
     while( cli.HasArgs() )
     {
         if( cli.ReadSwitch( opts.inRAM, "-m", "--in-ram" ) )
             continue;
+        else if( cli.ReadSize( opts.memoryBudget, "--memory" ) )
+            continue;
+        else if( cli.ReadU64( opts.sampleCount, "-s", "--sample" ) )
+            continue;
+        else if( cli.ReadF64( confidence, "--confidence" ) )
+            continue;
+        else if( cli.ReadF64( maxInvalid, "--max-invalid" ) )
+            continue;
         else if( cli.ReadSwitch( opts.unpacked, "-u", "--unpack" ) )
             continue;
         else if( cli.ReadF32( opts.startOffset, "-o", "--offset" ) )
@@ -165,6 +170,25 @@ void PlotValidatorMain( GlobalPlotConfig& gCfg, CliParser& cli )
     opts.threadCount = gCfg.threadCount == 0 ? maxThreads : std::min( maxThreads, gCfg.threadCount );
     opts.startOffset = std::max( std::min( opts.startOffset / 100.f, 100.f ), 0.f );
 
+    if( confidence > 0 )
+    {
+        FatalIf( confidence >= 100.0, "Confidence must be less than 100%%." );
+        opts.confidence = confidence;
+
+        if( opts.sampleCount == 0 )
+        {
+            FatalIf( maxInvalid <= 0 || maxInvalid >= 100.0, "Invalid --max-invalid percentage." );
+
+            // With no failures, the chance of missing an invalid fraction p with n samples is (1-p)^n
+            const float64 c = confidence / 100.0;
+            const float64 p = maxInvalid / 100.0;
+            opts.sampleCount = (uint64)std::ceil( std::log( 1.0 - c ) / std::log1p( -p ) );
+        }
+    }
+
+    FatalIf( opts.sampleCount > 0 && opts.unpacked, "--sample can't be used with --unpack." );
+    FatalIf( opts.memoryBudget > 0 && !opts.unpacked, "--memory can only be used with --unpack." );
+
     ValidatePlot( opts );
 
     exit( 0 );
@@ -218,6 +242,26 @@ bool ValidatePlot( const ValidatePlotOptions& options )
 
     // Duplicate the plot file,     
     ThreadPool pool( threadCount );
+
+    if( options.sampleCount > 0 )
+        return ValidateSampled( plotFiles, pool, options );
+
+    if( options.unpacked && options.memoryBudget > 0 )
+    {
+        const auto   timer       = TimerBegin();
+        const uint64 failedCount = ValidateStreaming( plotFiles, pool, threadCount, options.memoryBudget );
+        const double elapsed     = TimerEnd( timer );
+
+        Log::Line( "" );
+        Log::Line( "Finished validating plot in %.lf seconds.", elapsed );
+
+        if( failedCount )
+            Log::Line( "Plot has %llu invalid proofs.", (llu)failedCount );
+        else
+            Log::Line( "Perfect plot! All proofs are valid." );
+
+        return failedCount == 0;
+    }
     
     UnpackedK32Plot unpackedPlot;
     if( options.unpacked )
@@ -263,7 +307,7 @@ bool ValidatePlot( const ValidatePlotOptions& options )
         proofFailCount += jobs[i].failCount;
 
     if( proofFailCount )
-        Log::Line( "Plot has %llu invalid proofs." );
+        Log::Line( "Plot has %llu invalid proofs.", (llu)proofFailCount );
     else
         Log::Line( "Perfect plot! All proofs are valid." );
 
@@ -304,7 +348,7 @@ uint64 ValidateInMemory( UnpackedK32Plot& plot, ThreadPool& pool )
             if( plot.FetchProof( i, fullProofXs ) )
             {
                 uint64 outF7 = 0;
-                if( ValidateFullProof( plot.plot->K(), plot.plot->PlotId(), fullProofXs, outF7 ) )
+                if( PlotValidation::ValidateFullProof( plot.plot->K(), plot.plot->PlotId(), fullProofXs, outF7 ) )
                 {
                     const uint32 expectedF7 = plot.f7[i];
 
@@ -341,6 +385,460 @@ uint64 ValidateInMemory( UnpackedK32Plot& plot, ThreadPool& pool )
 }
 
 
+//-----------------------------------------------------------
+// Validates all of the plot's proofs, like ValidateInMemory(), but without unpacking the whole plot.
+// The proofs are processed in windows of consecutive C3 parks, sized to fit in the memory budget.
+// For each window, all of the proof trees are walked together one table at a time:
+// The table's lookups are bucketed by park, so that each thread streams through its own
+// range of parks in order, decoding every park once for all the lookups that fall in it.
+uint64 ValidateStreaming( IPlotFile** plotFiles, ThreadPool& pool, const uint32 threadCount, const size_t memoryBudget )
+{
+    const uint32 k = plotFiles[0]->K();
+    FatalIf( k > 32, "Streaming validation is only supported for plots with k=32 and below." );
+
+    PlotReader* readers = bbcalloc<PlotReader>( threadCount );
+    for( uint32 i = 0; i < threadCount; i++ )
+        new ( (void*)&readers[i] ) PlotReader( *plotFiles[i] );
+
+    const uint64 c3ParkCount = readers[0].GetC3ParkCount();
+    FatalIf( c3ParkCount < 1, "No F7s found." );
+
+    // Lookups are bucketed by groups of consecutive parks
+    const uint32 MaxBuckets = 1u << 16;
+
+    // Per proof: The f7, 2 tree slot buffers, the sorted lookups for the bottom table and a fail flag.
+    const size_t proofSize     = sizeof( uint32 ) * ( 1 + PROOF_X_COUNT * 2 + PROOF_X_COUNT / 2 ) + 1;
+    const size_t threadsSize   = ( sizeof( uint32 ) * MaxBuckets * 2 + sizeof( uint128 ) * kEntriesPerPark ) * threadCount;
+    FatalIf( memoryBudget <= threadsSize + sizeof( uint32 ) * MaxBuckets, "The memory budget is too small." );
+
+    // Slot indices are 32 bits
+    const uint64 maxWindowParks = ( 1ull << 32 ) / PROOF_X_COUNT / kCheckpoint1Interval;
+    const uint64 windowParks    = std::min( { ( memoryBudget - threadsSize - sizeof( uint32 ) * MaxBuckets ) / proofSize / kCheckpoint1Interval,
+                                              maxWindowParks, c3ParkCount } );
+    FatalIf( windowParks < 1, "The memory budget is too small. At least %llu MiB are required.",
+        (llu)CDiv( threadsSize + sizeof( uint32 ) * MaxBuckets + proofSize * kCheckpoint1Interval, 1 MB ) );
+
+    const uint64 windowProofs = windowParks * kCheckpoint1Interval;
+    const uint64 windowCount  = CDiv( c3ParkCount, windowParks );
+
+    Log::Line( "Validating plot in %llu windows of up to %llu proofs.", (llu)windowCount, (llu)windowProofs );
+
+    uint32* f7s          = bbcvirtallocbounded<uint32>( windowProofs );
+    uint32* slots[2]     = { bbcvirtallocbounded<uint32>( windowProofs * PROOF_X_COUNT ),
+                             bbcvirtallocbounded<uint32>( windowProofs * PROOF_X_COUNT ) };
+    uint32* lookupOrder  = bbcvirtallocbounded<uint32>( windowProofs * PROOF_X_COUNT / 2 );
+    byte*   failed       = bbcvirtallocbounded<byte>  ( windowProofs );
+    uint32* counts       = bbcalloc<uint32>( (size_t)MaxBuckets * threadCount );
+    uint32* pfxSums      = bbcalloc<uint32>( (size_t)MaxBuckets * threadCount );
+    uint32* bucketTotals = bbcalloc<uint32>( MaxBuckets );
+    int64*  parkCounts   = bbcalloc<int64> ( windowParks );
+
+    uint64 totalFailures = 0;
+
+    for( uint64 window = 0; window < windowCount; window++ )
+    {
+        const auto   timer           = TimerBegin();
+        const uint64 windowParkStart = window * windowParks;
+        const uint64 windowParkCount = std::min( windowParks, c3ParkCount - windowParkStart );
+        const uint64 f7Base          = windowParkStart * kCheckpoint1Interval;
+
+        // Read the f7s
+        AnonMTJob::Run( pool, threadCount, [&]( AnonMTJob* self ) {
+
+            PlotReader& reader = readers[self->_jobId];
+
+            uint64 count, offset, end;
+            GetThreadOffsets( self, windowParkCount, count, offset, end );
+
+            uint64 f7Buffer[kCheckpoint1Interval];
+
+            for( uint64 i = offset; i < end; i++ )
+            {
+                const int64 entryCount = reader.ReadC3Park( windowParkStart + i, f7Buffer );
+                parkCounts[i] = entryCount;
+
+                uint32* f7Writer = f7s + i * kCheckpoint1Interval;
+                for( int64 e = 0; e < entryCount; e++ )
+                    f7Writer[e] = (uint32)f7Buffer[e];
+            }
+        });
+
+        uint64 proofCount = 0;
+        for( uint64 i = 0; i < windowParkCount; i++ )
+        {
+            const uint64 park = windowParkStart + i;
+            FatalIf( parkCounts[i] < 0, "Failed to read C3 park %llu.", (llu)park );
+
+            // Only the last park may not be full
+            FatalIf( parkCounts[i] < kCheckpoint1Interval && park + 1 < c3ParkCount,
+                "Encountered a non-full C3 park at index %llu. These are unsupported.", (llu)park );
+
+            proofCount += (uint64)parkCounts[i];
+        }
+
+        // The roots of the proof trees are the p7 entries
+        AnonMTJob::Run( pool, threadCount, [&]( AnonMTJob* self ) {
+
+            PlotReader& reader = readers[self->_jobId];
+
+            uint64 count, offset, end;
+            GetThreadOffsets( self, proofCount, count, offset, end );
+
+            for( uint64 i = offset; i < end; i++ )
+            {
+                uint64 p7Entry = 0;
+                failed[i] = reader.ReadP7Entry( f7Base + i, p7Entry ) ? 0 : 1;
+
+                slots[0][i * PROOF_X_COUNT] = (uint32)p7Entry;
+            }
+        });
+
+        uint32* lpIdxSrc    = slots[0];
+        uint32* lpIdxDst    = slots[1];
+        uint32  lookupBits  = 0;
+
+        for( TableId table = TableId::Table6; table >= TableId::Table1; table-- )
+        {
+            const uint64 lookupCount    = proofCount << lookupBits;
+            const uint64 tableParkCount = plotFiles[0]->TableSize( (PlotTable)table ) / CalculateParkSize( table, k );
+            const uint64 parksPerBucket = std::max( CDiv( tableParkCount, (uint64)MaxBuckets ), (uint64)1 );
+            const uint32 bucketCount    = (uint32)std::max( CDiv( tableParkCount, parksPerBucket ), (uint64)1 );
+
+            AnonPrefixSumJob<uint32>::Run( pool, threadCount, [&]( AnonPrefixSumJob<uint32>* self ) {
+
+                const uint32 id      = self->JobId();
+                PlotReader&  reader  = readers[id];
+                uint32*      tCounts = counts  + (size_t)id * MaxBuckets;
+                uint32*      pfxSum  = pfxSums + (size_t)id * MaxBuckets;
+
+                // Lookup i is the (i % lookupsPerProof)-th entry of proof (i / lookupsPerProof)
+                const uint32 lookupMask = ( 1u << lookupBits ) - 1;
+                auto lookupSlot = [=]( const uint64 lookup ) {
+                    return (uint32)( ( lookup >> lookupBits ) * PROOF_X_COUNT + ( lookup & lookupMask ) );
+                };
+
+                // Out of range lookups go to the last bucket, and fail to decode there
+                auto lookupBucket = [=]( const uint32 lpIndex ) {
+                    return (uint32)std::min( lpIndex / kEntriesPerPark / parksPerBucket, (uint64)bucketCount - 1 );
+                };
+
+                uint64 count, offset, end;
+                GetThreadOffsets( self, lookupCount, count, offset, end );
+
+                memset( tCounts, 0, sizeof( uint32 ) * bucketCount );
+                for( uint64 i = offset; i < end; i++ )
+                    tCounts[lookupBucket( lpIdxSrc[lookupSlot( i )] )]++;
+
+                self->CalculatePrefixSum( bucketCount, tCounts, pfxSum, bucketTotals );
+
+                for( uint64 i = end; i-- > offset; )
+                {
+                    const uint32 slot = lookupSlot( i );
+                    lookupOrder[--pfxSum[lookupBucket( lpIdxSrc[slot] )]] = slot;
+                }
+
+                self->SyncThreads();
+
+                // Resolve the lookups of a range of buckets, in park order
+                uint32 bCount, bOffset, bEnd;
+                GetThreadOffsets( self, bucketCount, bCount, bOffset, bEnd );
+
+                uint64 bucketStart = 0;
+                for( uint32 b = 0; b < bOffset; b++ )
+                    bucketStart += bucketTotals[b];
+
+                uint128 linePoints[kEntriesPerPark];
+
+                for( uint32 b = bOffset; b < bEnd; b++ )
+                {
+                    uint32*      bucket        = lookupOrder + bucketStart;
+                    const uint64 bucketLookups = bucketTotals[b];
+                    bucketStart += bucketLookups;
+
+                    std::sort( bucket, bucket + bucketLookups, [=]( const uint32 l, const uint32 r ) {
+                        return lpIdxSrc[l] < lpIdxSrc[r];
+                    });
+
+                    for( uint64 i = 0; i < bucketLookups; )
+                    {
+                        const uint64 parkIndex = lpIdxSrc[bucket[i]] / kEntriesPerPark;
+
+                        uint64 parkEnd = i + 1;
+                        while( parkEnd < bucketLookups && lpIdxSrc[bucket[parkEnd]] / kEntriesPerPark == parkIndex )
+                            parkEnd++;
+
+                        uint64 parkEntryCount = 0;
+                        const bool parkRead = reader.ReadLPPark( table, parkIndex, linePoints, parkEntryCount );
+
+                        for( ; i < parkEnd; i++ )
+                        {
+                            const uint32 slot       = bucket[i];
+                            const uint32 dst        = slot + slot % PROOF_X_COUNT;
+                            const uint64 lpLocalIdx = lpIdxSrc[slot] - parkIndex * kEntriesPerPark;
+
+                            if( !parkRead || lpLocalIdx >= parkEntryCount )
+                            {
+                                failed[slot / PROOF_X_COUNT] = 1;
+                                lpIdxDst[dst+0] = 0;
+                                lpIdxDst[dst+1] = 0;
+                                continue;
+                            }
+
+                            // Since we only support k <= 32, we can do 64-bit LP reading
+                            const BackPtr bp = LinePointToSquare64( (uint64)linePoints[lpLocalIdx] );
+                            lpIdxDst[dst+0] = (uint32)bp.y;
+                            lpIdxDst[dst+1] = (uint32)bp.x;
+                        }
+                    }
+                }
+            });
+
+            lookupBits++;
+            std::swap( lpIdxSrc, lpIdxDst );
+        }
+
+        // Full proof x's are now at the src slots
+        std::atomic<uint64> windowFailures = 0;
+
+        AnonMTJob::Run( pool, threadCount, [&]( AnonMTJob* self ) {
+
+            uint64 count, offset, end;
+            GetThreadOffsets( self, proofCount, count, offset, end );
+
+            const byte* plotId = plotFiles[0]->PlotId();
+
+            uint64 fullProofXs[PROOF_X_COUNT];
+            uint64 failedCount = 0;
+
+            for( uint64 i = offset; i < end; i++ )
+            {
+                if( failed[i] )
+                {
+                    failedCount++;
+                    continue;
+                }
+
+                const uint32* xs = lpIdxSrc + i * PROOF_X_COUNT;
+                for( uint32 x = 0; x < PROOF_X_COUNT; x++ )
+                    fullProofXs[x] = xs[x];
+
+                uint64 outF7 = 0;
+                if( !PlotValidation::ValidateFullProof( k, plotId, fullProofXs, outF7 ) || outF7 != f7s[i] )
+                    failedCount++;
+            }
+
+            windowFailures.fetch_add( failedCount, std::memory_order_relaxed );
+        });
+
+        totalFailures += windowFailures;
+
+        Log::Line( "[%llu/%llu] Proofs %10llu..%-10llu validated in %.2lf seconds [ %sFailed: %llu%s ]",
+            (llu)window+1, (llu)windowCount, (llu)f7Base, (llu)( f7Base + proofCount ), TimerEnd( timer ),
+            totalFailures > 0 ? COLOR_RED_BOLD : COLOR_GREEN_BOLD, (llu)totalFailures, COLOR_NONE );
+    }
+
+    bbvirtfreebounded( f7s );
+    bbvirtfreebounded( slots[0] );
+    bbvirtfreebounded( slots[1] );
+    bbvirtfreebounded( lookupOrder );
+    bbvirtfreebounded( failed );
+    free( counts );
+    free( pfxSums );
+    free( bucketTotals );
+    free( parkCounts );
+
+    for( uint32 i = 0; i < threadCount; i++ )
+        readers[i].~PlotReader();
+    free( readers );
+
+    return totalFailures;
+}
+
+//-----------------------------------------------------------
+bool ValidateSampled( IPlotFile** plotFiles, ThreadPool& pool, const ValidatePlotOptions& options )
+{
+    const uint32 threadCount = options.threadCount;
+    const uint64 sampleCount = options.sampleCount;
+    const uint32 k           = plotFiles[0]->K();
+    const byte*  plotId      = plotFiles[0]->PlotId();
+
+    PlotReader* readers = bbcalloc<PlotReader>( threadCount );
+    for( uint32 i = 0; i < threadCount; i++ )
+        new ( (void*)&readers[i] ) PlotReader( *plotFiles[i] );
+
+    const uint64 maxF7Count = readers[0].GetMaxF7EntryCount();
+    FatalIf( maxF7Count < 1, "No F7s found." );
+
+    Log::Line( "Validating %llu sampled proofs...", (llu)sampleCount );
+
+    std::atomic<uint64> totalFailures = 0;
+    const auto timer = TimerBegin();
+
+    AnonMTJob::Run( pool, threadCount, [&]( AnonMTJob* self ) {
+
+        auto Log = [=]( const char* msg, ... ) {
+            va_list args;
+            va_start( args, msg );
+            TVLog( self->_jobId, msg, args );
+            va_end( args );
+        };
+
+        PlotReader& reader = readers[self->_jobId];
+
+        uint64 count, offset, end;
+        GetThreadOffsets( self, sampleCount, count, offset, end );
+
+        // Samples are fetched in batches, so that their proof trees are walked
+        // together with sorted reads, see PlotReader::FetchProofsFromP7Entries()
+        const uint32 BatchSize = 256;
+
+        uint64  random   [BatchSize];
+        uint64  f7Indices[BatchSize];
+        uint64  f7s      [BatchSize];
+        uint64  p7Entries[BatchSize];
+        uint64* proofXs      = bbcalloc<uint64>( BatchSize * PROOF_X_COUNT );
+        uint64* c3Entries    = bbcalloc<uint64>( kCheckpoint1Interval );
+        uint64  c3ParkIndex  = std::numeric_limits<uint64>::max();
+        int64   c3EntryCount = 0;
+        uint64  failedCount  = 0;
+
+        for( uint64 batchStart = offset; batchStart < end; batchStart += BatchSize )
+        {
+            const uint32 batchSize  = (uint32)std::min( (uint64)BatchSize, end - batchStart );
+            uint32       fetchCount = 0;
+
+            SysHost::Random( (byte*)random, sizeof( uint64 ) * batchSize );
+
+            for( uint32 i = 0; i < batchSize; i++ )
+            {
+                // Stratified sampling: Each sample is picked from its own equally-sized range of f7 indices,
+                // so the samples are spread over the whole plot, and come out sorted.
+                const uint64 sample     = batchStart + i;
+                const uint64 rangeStart = (uint64)( (uint128)sample       * maxF7Count / sampleCount );
+                const uint64 rangeEnd   = (uint64)( (uint128)( sample+1 ) * maxF7Count / sampleCount );
+
+                uint64       f7Index    = rangeStart + random[i] % std::max( rangeEnd - rangeStart, (uint64)1 );
+                const uint64 parkIndex  = f7Index / kCheckpoint1Interval;
+
+                // Get the expected f7 value from the C3 park
+                if( parkIndex != c3ParkIndex )
+                {
+                    c3ParkIndex  = parkIndex;
+                    c3EntryCount = reader.ReadC3Park( parkIndex, c3Entries );
+                }
+
+                if( c3EntryCount <= 0 )
+                {
+                    Log( "Failed to read C3 park %llu.", (llu)parkIndex );
+                    failedCount++;
+                    continue;
+                }
+
+                // Only the last park may not be full
+                uint64 localIdx = f7Index - parkIndex * kCheckpoint1Interval;
+                if( localIdx >= (uint64)c3EntryCount )
+                {
+                    localIdx = random[i] % (uint64)c3EntryCount;
+                    f7Index  = parkIndex * kCheckpoint1Interval + localIdx;
+                }
+
+                if( !reader.ReadP7Entry( f7Index, p7Entries[fetchCount] ) )
+                {
+                    Log( "Failed to read P7 entry for f7[%llu].", (llu)f7Index );
+                    failedCount++;
+                    continue;
+                }
+
+                f7Indices[fetchCount] = f7Index;
+                f7s      [fetchCount] = c3Entries[localIdx];
+                fetchCount++;
+            }
+
+            // If the batch fails, fetch proofs individually to find out which ones failed
+            const bool batchFetched = reader.FetchProofsFromP7Entries( p7Entries, fetchCount, proofXs );
+
+            for( uint32 i = 0; i < fetchCount; i++ )
+            {
+                uint64* xs = proofXs + i * PROOF_X_COUNT;
+
+                if( !batchFetched && !reader.FetchProofFromP7Entry( p7Entries[i], xs ) )
+                {
+                    Log( "Proof fetch failed for f7[%llu] = %llu.", (llu)f7Indices[i], (llu)f7s[i] );
+                    failedCount++;
+                    continue;
+                }
+
+                uint64 outF7 = 0;
+                if( !PlotValidation::ValidateFullProof( k, plotId, xs, outF7 ) || outF7 != f7s[i] )
+                {
+                    Log( "Invalid proof for f7[%llu] = %llu.", (llu)f7Indices[i], (llu)f7s[i] );
+                    failedCount++;
+                }
+            }
+        }
+
+        free( proofXs );
+        free( c3Entries );
+
+        totalFailures.fetch_add( failedCount, std::memory_order_relaxed );
+    });
+
+    const double elapsed     = TimerEnd( timer );
+    const uint64 failedCount = totalFailures;
+    const float64 bound      = InvalidProofsUpperBound( sampleCount, failedCount, options.confidence / 100.0 );
+
+    for( uint32 i = 0; i < threadCount; i++ )
+        readers[i].~PlotReader();
+    free( readers );
+
+    Log::Line( "" );
+    Log::Line( "Validated %llu sampled proofs in %.2lf seconds.", (llu)sampleCount, elapsed );
+    Log::Line( "[ %s%s%s ] Valid Proofs: %llu / %llu", 
+        failedCount == 0 ? COLOR_GREEN_BOLD : COLOR_RED_BOLD,
+        failedCount ? "FAILED" : "SUCCESS", COLOR_NONE,
+        (llu)( sampleCount - failedCount ), (llu)sampleCount );
+    Log::Line( "With %.2lf%% confidence, at most %.4lf%% of the plot's proofs are invalid.", options.confidence, bound * 100.0 );
+
+    return failedCount == 0;
+}
+
+//-----------------------------------------------------------
+// One-sided Clopper-Pearson upper bound on the fraction of invalid proofs:
+// The largest p for which seeing failedCount or fewer failures in sampleCount samples
+// still has a probability of at least ( 1 - confidence ).
+float64 InvalidProofsUpperBound( const uint64 sampleCount, const uint64 failedCount, const float64 confidence )
+{
+    if( failedCount >= sampleCount )
+        return 1.0;
+
+    const float64 n = (float64)sampleCount;
+
+    auto binomialCDF = [=]( const float64 p ) {
+        float64 cdf = 0;
+        for( uint64 i = 0; i <= failedCount; i++ )
+        {
+            const float64 x = (float64)i;
+            cdf += std::exp( std::lgamma( n + 1 ) - std::lgamma( x + 1 ) - std::lgamma( n - x + 1 ) +
+                             x * std::log( p ) + ( n - x ) * std::log1p( -p ) );
+        }
+        return cdf;
+    };
+
+    // The CDF decreases as p grows
+    float64 lo = (float64)failedCount / n, hi = 1.0;
+    for( uint32 i = 0; i < 64; i++ )
+    {
+        const float64 mid = ( lo + hi ) * 0.5;
+
+        if( binomialCDF( mid ) > 1.0 - confidence )
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return hi;
+}
+
 //-----------------------------------------------------------
 void ValidateJob::Log( const char* msg, ... )
 {
@@ -431,14 +929,7 @@ void ValidateJob::Run()
             const uint64 p7LocalIdx = f7Idx - p7ParkIndex * kEntriesPerPark;
             const uint64 t6Index    = p7Entries[p7LocalIdx];
 
-            bool success = true;
-
-            if( k <= 32 )
-            {
-                success = FetchProof<true>( plot, t6Index, fullProofXs );
-            }
-            else
-                success = FetchProof<false>( plot, t6Index, fullProofXs );
+            bool success = plot.FetchProofFromP7Entry( t6Index, fullProofXs );
 
             if( success )
             {
@@ -447,7 +938,7 @@ void ValidateJob::Run()
                 // Now we can validate the proof
                 uint64 outF7;
 
-                if( ValidateFullProof( k, plot.PlotFile().PlotId(), fullProofXs, outF7 ) )
+                if( PlotValidation::ValidateFullProof( k, plot.PlotFile().PlotId(), fullProofXs, outF7 ) )
                     success = f7 == outF7;
                 else
                     success = false;
@@ -722,353 +1213,6 @@ bool UnpackedK32Plot::FetchProof( const uint64 index, uint64 fullProofXs[PROOF_X
     return true;
 }
 
-//-----------------------------------------------------------
-template<bool Use64BitLpToSquare>
-bool FetchProof( PlotReader& plot, uint64 t6LPIndex, uint64 fullProofXs[PROOF_X_COUNT] )
-{
-    uint64 lpIndices[2][PROOF_X_COUNT];
-    // memset( lpIndices, 0, sizeof( lpIndices ) );
-
-    uint64* lpIdxSrc = lpIndices[0];
-    uint64* lpIdxDst = lpIndices[1];
-
-    *lpIdxSrc = t6LPIndex;
-
-    // Fetch line points to back pointers going through all our tables
-    // from 6 to 1, grabbing all of the x's that make up a proof.
-    uint32 lookupCount = 1;
-
-    for( TableId table = TableId::Table6; table >= TableId::Table1; table-- )
-    {
-        ASSERT( lookupCount <= 32 );
-
-        for( uint32 i = 0, dst = 0; i < lookupCount; i++, dst += 2 )
-        {
-            const uint64 idx = lpIdxSrc[i];
-
-            uint128 lp = 0;
-            if( !plot.ReadLP( table, idx, lp ) )
-                return false;
-
-            BackPtr ptr;
-            if constexpr ( Use64BitLpToSquare )
-                ptr = LinePointToSquare64( (uint64)lp );
-            else
-                ptr = LinePointToSquare( lp );
-
-            lpIdxDst[dst+0] = ptr.y;
-            lpIdxDst[dst+1] = ptr.x;
-        }
-
-        lookupCount <<= 1;
-
-        std::swap( lpIdxSrc, lpIdxDst );
-        // memset( lpIdxDst, 0, sizeof( uint64 ) * PROOF_X_COUNT );
-    }
-
-    // Full proof x's will be at the src ptr
-    memcpy( fullProofXs, lpIdxSrc, sizeof( uint64 ) * PROOF_X_COUNT );
-    return true;
-}
-
-//-----------------------------------------------------------
-bool ValidateFullProof( const uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64& outF7 )
-{
-    uint64   fx  [PROOF_X_COUNT];
-    MetaBits meta[PROOF_X_COUNT];
-
-    // Convert these x's to f1 values
-    {
-        const uint32 xShift = k - kExtraBits;
-        
-        // Prepare ChaCha key
-        byte key[32] = { 1 };
-        memcpy( key + 1, plotId, 31 );
-
-        chacha8_ctx chacha;
-        chacha8_keysetup( &chacha, key, 256, NULL );
-
-        // Enough to hold 2 cha-cha blocks since a value my span over 2 blocks
-        byte blocks[kF1BlockSize*2];
-
-        for( uint32 i = 0; i < PROOF_X_COUNT; i++ )
-        {
-            const uint64 x        = fullProofXs[i];
-            const uint64 blockIdx = x * k / kF1BlockSizeBits; 
-
-            chacha8_get_keystream( &chacha, blockIdx, 2, blocks );
-
-            // Get the starting and end locations of y in bits relative to our block
-            const uint64 bitStart = x * k - blockIdx * kF1BlockSizeBits;
-
-            CPBitReader hashBits( blocks, sizeof( blocks ) * 8 );
-            hashBits.Seek( bitStart );
-
-            // uint64 y = SliceUInt64FromBits( blocks, bitStart, k ); // #TODO: Figure out what's wrong with this method.
-            uint64 y = hashBits.Read64( k );
-            y = ( y << kExtraBits ) | ( x >> xShift );
-
-            fx  [i] = y;
-            meta[i] = MetaBits( x, k );
-        }
-    }
-
-    // Forward propagate f1 values to get the final f7
-    uint32 iterCount = PROOF_X_COUNT;
-    for( TableId table = TableId::Table2; table <= TableId::Table7; table++, iterCount >>= 1)
-    {
-        for( uint32 i = 0, dst = 0; i < iterCount; i+= 2, dst++ )
-        {
-            uint64 y0 = fx[i+0];
-            uint64 y1 = fx[i+1];
-
-            const MetaBits* lMeta = &meta[i+0];
-            const MetaBits* rMeta = &meta[i+1];
-
-            if( y0 > y1 ) 
-            {
-                std::swap( y0, y1 );
-                std::swap( lMeta, rMeta );
-            }
-
-            // Must be on the same group
-            if( !FxMatch( y0, y1 ) )
-                return false;
-
-            // FxGen
-            uint64 outY;
-            MetaBits outMeta;
-            FxGen( table, k, y0, *lMeta, *rMeta, outY, outMeta );
-
-            fx  [dst] = outY;
-            meta[dst] = outMeta;
-        }
-    }
-
-    outF7 = fx[0] >> kExtraBits;
-
-    return true;
-}
-
-
-// #TODO: Avoid code duplication here? At least for f1
-//-----------------------------------------------------------
-void ReorderProof( PlotReader& plot, uint64 fullProofXs[PROOF_X_COUNT] )
-{
-    const uint32 k = plot.PlotFile().K();
-
-    uint64   fx  [PROOF_X_COUNT];
-    MetaBits meta[PROOF_X_COUNT];
-
-    uint64  xtmp[PROOF_X_COUNT];
-    uint64* xs = fullProofXs;
-
-    // Convert these x's to f1 values
-    GetProofF1( k, plot.PlotFile().PlotId(), fullProofXs, fx );
-    for( uint32 i = 0; i < PROOF_X_COUNT; i++ )
-        meta[i] = MetaBits( xs[i], k );
-
-    // Forward propagate f1 values to get the final f7
-    uint32 iterCount = PROOF_X_COUNT;
-    for( TableId table = TableId::Table2; table <= TableId::Table7; table++, iterCount >>= 1)
-    {
-        for( uint32 i = 0, dst = 0; i < iterCount; i+= 2, dst++ )
-        {
-            uint64 y0 = fx[i+0];
-            uint64 y1 = fx[i+1];
-
-            const MetaBits* lMeta = &meta[i+0];
-            const MetaBits* rMeta = &meta[i+1];
-
-            if( y0 > y1 ) 
-            {
-                std::swap( y0, y1 );
-                std::swap( lMeta, rMeta );
-
-                // Swap X's so far that have generated this y
-                const uint32 count = 1u << ((int)table-1);
-                uint64* x = xs + i * count;
-                bbmemcpy_t( xtmp   , x      , count );
-                bbmemcpy_t( x      , x+count, count );
-                bbmemcpy_t( x+count, xtmp   , count );
-            }
-
-            // FxGen
-            uint64 outY;
-            MetaBits outMeta;
-            FxGen( table, k, y0, *lMeta, *rMeta, outY, outMeta );
-
-            fx  [dst] = outY;
-            meta[dst] = outMeta;
-        }
-    }
-}
-
-//-----------------------------------------------------------
-void GetProofF1( uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64 fullProofXs[PROOF_X_COUNT], uint64 fx[PROOF_X_COUNT] )
-{
-    const uint32 xShift = k - kExtraBits;
-        
-    // Prepare ChaCha key
-    byte key[32] = { 1 };
-    memcpy( key + 1, plotId, 31 );
-
-    chacha8_ctx chacha;
-    chacha8_keysetup( &chacha, key, 256, NULL );
-
-    // Enough to hold 2 cha-cha blocks since a value my span over 2 blocks
-    byte blocks[kF1BlockSize*2];
-
-    for( uint32 i = 0; i < PROOF_X_COUNT; i++ )
-    {
-        const uint64 x        = fullProofXs[i];
-        const uint64 blockIdx = x * k / kF1BlockSizeBits; 
-
-        chacha8_get_keystream( &chacha, blockIdx, 2, blocks );
-
-        // Get the starting and end locations of y in bits relative to our block
-        const uint64 bitStart = x * k - blockIdx * kF1BlockSizeBits;
-
-        CPBitReader hashBits( blocks, sizeof( blocks ) * 8 );
-        hashBits.Seek( bitStart );
-
-        // uint64 y = SliceUInt64FromBits( blocks, bitStart, k ); // #TODO: Figure out what's wrong with this method.
-        uint64 y = hashBits.Read64( k );
-        y = ( y << kExtraBits ) | ( x >> xShift );
-
-        fx[i] = y;
-    }
-}
-
-//-----------------------------------------------------------
-bool FxMatch( uint64 yL, uint64 yR )
-{
-    const uint64 groupL = yL / kBC;
-    const uint64 groupR = yR / kBC;
-
-    if( groupR - groupL != 1 )
-        return false;
-
-    // Groups are adjacent, check if the y values actually match
-    const uint16 parity = groupL & 1;
-
-    const uint64 groupLRangeStart = groupL * kBC;
-    const uint64 groupRRangeStart = groupR * kBC;
-
-    const uint64 localLY = yL - groupLRangeStart;
-    const uint64 localRY = yR - groupRRangeStart;
-    
-    for( int iK = 0; iK < kExtraBitsPow; iK++ )
-    {
-        const uint64 targetR = L_targets[parity][localLY][iK];
-        
-        if( targetR == localRY )
-            return true;
-    } 
-
-    return false;
-}
-
-//-----------------------------------------------------------
-void FxGen( const TableId table, const uint32 k, 
-            const uint64 y, const MetaBits& metaL, const MetaBits& metaR,
-            uint64& outY, MetaBits& outMeta )
-{
-    FxBits input( y, k + kExtraBits );
-
-    if( table < TableId::Table4 )
-    {
-        outMeta = metaL + metaR;
-        input += outMeta;
-    }
-    else
-    {
-        input += metaL;
-        input += metaR;
-    }
-
-    byte inputBytes[64];
-    byte hashBytes [32];
-
-    input.ToBytes( inputBytes );
-
-    blake3_hasher hasher;
-    blake3_hasher_init    ( &hasher );
-    blake3_hasher_update  ( &hasher, inputBytes, input.LengthBytes() );
-    blake3_hasher_finalize( &hasher, hashBytes, sizeof( hashBytes ) );
-
-    outY = BytesToUInt64( hashBytes ) >> ( 64 - (k + kExtraBits) );
-
-    if( table >= TableId::Table4 && table < TableId::Table7 )
-    {
-        size_t multiplier = 0;
-        switch( table )
-        {
-            case TableId::Table4: multiplier = TableMetaOut<TableId::Table4>::Multiplier; break;
-            case TableId::Table5: multiplier = TableMetaOut<TableId::Table5>::Multiplier; break;
-            case TableId::Table6: multiplier = TableMetaOut<TableId::Table6>::Multiplier; break;
-            default: 
-                ASSERT( 0 );
-                break;
-        }
-
-        const uint32 metaBits  = (uint32)( k * multiplier );
-        const uint32 yBits     = k + kExtraBits;
-        const uint32 startByte = yBits / 8 ;
-        const uint32 startBit  = yBits - startByte * 8;
-
-        outMeta = MetaBits( hashBytes + startByte, metaBits, startBit );
-    }
-}
-
-//-----------------------------------------------------------
-/// Convertes 8 bytes to uint64 and endian-swaps it.
-/// This takes any byte alignment, so that bytes does
-/// not have to be aligned to 64-bit boundary.
-/// This is for compatibility for how chiapos extracts
-/// bytes into integers.
-//-----------------------------------------------------------
-inline uint64 BytesToUInt64( const byte bytes[8] )
-{
-    uint64 tmp;
-    memcpy( &tmp, bytes, sizeof( uint64 ) );
-    return Swap64( tmp );
-}
-
-//-----------------------------------------------------------
-// Treats bytes as a set of 64-bit big-endian fields,
-// from which it will extract a whole 64-bit value
-// at the given bit offset. 
-// The result may be truncated if the requested number of 
-// bits + the number of bits overflows the 64-bit field.
-// That is, if the local bit offset in the target bit field
-// + the bitCount is greater than 64.
-// This function is for compatibility with the way chiapos
-// slices bits off of binary byte blobs.
-//-----------------------------------------------------------
-inline uint64 SliceUInt64FromBits( const byte* bytes, uint32 bitOffset, uint32 bitCount )
-{
-    ASSERT( bitCount <= 64 );
-     
-    // #TODO: This is wrong, it's not treating the bytes as 64-bit fields.
-    //        So that we may have swapped at the wrong position.
-    //        In fact we might have fields that span 2 64-bit values.
-    //        So we need to split it into 2, and do 2 swaps.
-    const uint64 startByte = bitOffset / 8;
-    bytes += startByte;
-
-    // Convert bit offset to be local to the uint64 field
-    bitOffset -= ( bitOffset >> 6 ) * 64; // bitOffset >> 6 == bitOffset / 64
-
-    uint64 field = BytesToUInt64( bytes );
-    
-    field <<= bitOffset;     // Start bits from the MSBits
-    field >>= 64 - bitCount; // Take the MSbits
-
-    return field;
-}
-
-
 //-----------------------------------------------------------
 void TVLog( const uint32 id, const char* msg, va_list args )
 {
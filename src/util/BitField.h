@@ -1,5 +1,9 @@
 #pragma once
 
+#if _WIN32
+    #include <intrin.h>
+#endif
+
 
 ///
 /// Unsafe use: It does not do any bounds checking.
@@ -47,6 +51,38 @@ public:
         fields[fieldIdx] = field | (1ull << lShift);
     }
 
+    //-----------------------------------------------------------
+    // Safe to call concurrently with other SetAtomic calls on the same field.
+    // Does not order any other memory accesses.
+    inline void SetAtomic( uint64 index )
+    {
+        ASSERT( index < _length );
+
+        uint64* field = _fields + ( index >> 6 );
+        const uint64 mask = 1ull << ( index & 63 );
+
+        // Skip the atomic operation if the bit is already set, as it's common for entries to be referenced twice
+        if( *(volatile uint64*)field & mask )
+            return;
+
+    #if _WIN32
+        _InterlockedOr64( (volatile long long*)field, (long long)mask );
+    #else
+        __atomic_fetch_or( field, mask, __ATOMIC_RELAXED );
+    #endif
+    }
+
+    // Hint the CPU to load the field containing a bit we'll read soon
+    //-----------------------------------------------------------
+    inline void Prefetch( uint64 index ) const
+    {
+    #if _WIN32
+        _mm_prefetch( (const char*)( _fields + ( index >> 6 ) ), _MM_HINT_T0 );
+    #else
+        __builtin_prefetch( _fields + ( index >> 6 ), 0, 3 );
+    #endif
+    }
+
     //-----------------------------------------------------------
     inline void SetBit( uint64 index, const uint64 bit )
     {
@@ -449,6 +449,12 @@ public:
         _position += bitCount;
     }
 
+    //-----------------------------------------------------------
+    // Write count values of a fixed bit size, faster than calling Write() for each. See BitPacker.
+    //-----------------------------------------------------------
+    template<uint32 bitCount>
+    inline void WriteValues( const uint64* values, int64 count );
+
     //-----------------------------------------------------------
     // dstOffset: Offset in bits as to where to start writing in fields
     //-----------------------------------------------------------
@@ -533,6 +539,163 @@ private:
     uint64  _position;  // Write poisition in bits
 };
 
+/**
+ * Packs values of compile-time bit widths in the same layout as BitWriter::Write.
+ * Instead of a read-modify-write of 1 or 2 fields per value, the current field
+ * is kept in a register and only stored once full, with a single shift and mask
+ * specialized on the value width.
+ * Only the partial fields at the start and at the end of the written range are merged
+ * with the existing bits, so just as with BitWriter, threads writing adjacent ranges
+ * must not write the fields they share at the same time.
+ * Call Flush() when done, which also advances the source BitWriter past the written bits.
+ */
+class BitPacker
+{
+public:
+    //-----------------------------------------------------------
+    inline BitPacker( BitWriter& writer )
+        : _writer( writer )
+        , _start ( writer.Fields() )
+        , _fields( writer.Fields() + ( writer.Position() >> 6 ) )
+        , _bits  ( (uint32)( writer.Position() & 63 ) )
+    {
+        // Keep the bits before our starting position
+        _field = _bits ? *_fields & ( 0xFFFFFFFFFFFFFFFFull >> ( 64 - _bits ) ) : 0;
+    }
+
+    //-----------------------------------------------------------
+    template<uint32 bitCount>
+    inline void Write( uint64 value )
+    {
+        static_assert( bitCount > 0 && bitCount <= 64 );
+
+        if constexpr ( bitCount < 64 )
+            value &= ( 1ull << bitCount ) - 1;
+
+        _field |= value << _bits;
+        _bits  += bitCount;
+
+        if( _bits >= 64 )
+        {
+            *_fields++ = _field;
+            _bits -= 64;
+
+            // Carry the bits that did not fit into the next field
+            if constexpr ( bitCount < 64 )
+                _field = value >> ( bitCount - _bits );
+            else
+                _field = _bits ? value >> ( 64 - _bits ) : 0;
+        }
+    }
+
+    //-----------------------------------------------------------
+    inline void Flush()
+    {
+        const uint64 position = (uint64)( _fields - _start ) * 64 + _bits;
+        ASSERT( position >= _writer.Position() && position <= _writer.Capacity() );
+
+        if( position == _writer.Position() )
+            return;
+
+        // Keep the bits after our end position
+        if( _bits )
+        {
+            const uint64 mask = 0xFFFFFFFFFFFFFFFFull >> ( 64 - _bits );
+            *_fields = ( *_fields & ~mask ) | _field;
+        }
+
+        _writer.Bump( position - _writer.Position() );
+    }
+
+private:
+    BitWriter& _writer;
+    uint64*    _start;      // Fields buffer of the writer
+    uint64*    _fields;     // Field currently being packed
+    uint64     _field;      // Pending bits of the current field
+    uint32     _bits;       // Pending bit count, < 64
+};
+
+//-----------------------------------------------------------
+template<uint32 bitCount>
+inline void BitWriter::WriteValues( const uint64* values, const int64 count )
+{
+    BitPacker packer( *this );
+
+    for( int64 i = 0; i < count; i++ )
+        packer.Write<bitCount>( values[i] );
+
+    packer.Flush();
+}
+
+/**
+ * Reads values of compile-time bit widths written by BitWriter or BitPacker.
+ * Same output as BitReader::ReadBits64, but the current field is kept in a register,
+ * so that each field is only loaded once.
+ * Fields are loaded only as they are needed, so no reads are done past the last value.
+ */
+class BitUnpacker
+{
+public:
+    //-----------------------------------------------------------
+    inline BitUnpacker( const uint64* fields, const size_t sizeBits, const uint64 bitOffset )
+        : _fields( fields + ( bitOffset >> 6 ) )
+    {
+        ASSERT( bitOffset <= sizeBits );
+
+        const uint32 fieldBits = (uint32)( bitOffset & 63 );
+
+        if( bitOffset < sizeBits )
+        {
+            _field = *_fields >> fieldBits;
+            _avail = 64 - fieldBits;
+        }
+        else
+        {
+            _field = 0;
+            _avail = 0;
+        }
+    }
+
+    //-----------------------------------------------------------
+    template<uint32 bitCount>
+    inline uint64 Read()
+    {
+        static_assert( bitCount > 0 && bitCount <= 64 );
+
+        uint64 value = _field;
+
+        if( _avail >= bitCount )
+        {
+            if constexpr ( bitCount < 64 )
+                _field >>= bitCount;
+            else
+                _field = 0;
+
+            _avail -= bitCount;
+        }
+        else
+        {
+            // Take the remaining bits from the next field
+            const uint64 next = *++_fields;
+            const uint32 used = bitCount - _avail;
+
+            value |= next << _avail;
+            _field = used < 64 ? next >> used : 0;
+            _avail = 64 - used;
+        }
+
+        if constexpr ( bitCount < 64 )
+            value &= ( 1ull << bitCount ) - 1;
+
+        return value;
+    }
+
+private:
+    const uint64* _fields;  // Field currently being read
+    uint64        _field;   // Unread bits of the current field, right-aligned
+    uint32        _avail;   // Unread bit count of the current field
+};
+
 template<size_t BitSize>
 class Bits
 {
@@ -82,7 +82,8 @@ public:
         FatalIf( !(_capacity - paddedSize >= size), "Allocation buffer overrun." );
 
         void* ptr = reinterpret_cast<void*>( _buffer + paddedSize );
-        _size = paddedSize + size;
+        _size      = paddedSize + size;
+        _highWater = std::max( _highWater, _size );
 
         return ptr;
     }
@@ -105,6 +106,13 @@ public:
         return _size;
     }
 
+    //-----------------------------------------------------------
+    // Greatest size the stack has reached
+    inline size_t HighWater() const
+    {
+        return _highWater;
+    }
+
     //-----------------------------------------------------------
     inline size_t Remainder() const
     {
@@ -133,6 +141,7 @@ public:
 
 private:
     byte*  _buffer;
-    size_t _capacity;   // Stack capacity
-    size_t _size = 0;   // Current allocated size/stack size
+    size_t _capacity;       // Stack capacity
+    size_t _size      = 0;  // Current allocated size/stack size
+    size_t _highWater = 0;  // Greatest allocated size
 };
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "TraceLog.h"
+#include "util/Util.h"
+#include "util/Log.h"
+#if defined( __GNUC__ ) || defined( __clang__ )
+    #include <cxxabi.h>
+#endif
+
+bool                                 TraceLog::_enabled   = false;
+uint32                               TraceLog::_capacity  = 0;
+TimePoint                            TraceLog::_startTime;
+std::mutex                           TraceLog::_bufferLock;
+std::vector<TraceLog::ThreadBuffer*> TraceLog::_buffers;
+
+thread_local TraceLog::ThreadBuffer* TraceLog::_threadBuffer    = nullptr;
+thread_local const char*             TraceLog::_threadName      = nullptr;
+thread_local int32                   TraceLog::_threadNameIndex = -1;
+
+//-----------------------------------------------------------
+void TraceLog::Enable( const uint32 eventsPerThread )
+{
+    ASSERT( eventsPerThread > 0 );
+    ASSERT( !_enabled );
+
+    _capacity  = eventsPerThread;
+    _startTime = TimerBegin();
+    _enabled   = true;
+}
+
+//-----------------------------------------------------------
+void TraceLog::SetThreadName( const char* name, const int32 index )
+{
+    _threadName      = name;
+    _threadNameIndex = index;
+
+    if( _threadBuffer )
+    {
+        _threadBuffer->name      = name;
+        _threadBuffer->nameIndex = index;
+    }
+}
+
+//-----------------------------------------------------------
+TraceLog::ThreadBuffer* TraceLog::CreateThreadBuffer()
+{
+    ThreadBuffer* buffer = new ThreadBuffer();
+    buffer->spans        = bbcalloc<Span>( _capacity );
+    buffer->count        = 0;
+    buffer->clearedCount = 0;
+    buffer->name         = _threadName;
+    buffer->nameIndex    = _threadNameIndex;
+
+    std::lock_guard<std::mutex> lock( _bufferLock );
+    buffer->tid = (uint32)_buffers.size() + 1;
+    _buffers.push_back( buffer );
+
+    return buffer;
+}
+
+//-----------------------------------------------------------
+void TraceLog::AddSpan( const char* name, const char* category, const TimePoint start, const TimePoint end, const int64 arg )
+{
+    ASSERT( _enabled );
+
+    ThreadBuffer* buffer = _threadBuffer;
+    if( !buffer )
+        buffer = _threadBuffer = CreateThreadBuffer();
+
+    const uint64 count = buffer->count.load( std::memory_order_relaxed );
+
+    Span& span = buffer->spans[count % _capacity];
+    span.name     = name;
+    span.category = category;
+    span.start    = start;
+    span.end      = end;
+    span.arg      = arg;
+
+    // Publish the span to WriteJson()
+    buffer->count.store( count + 1, std::memory_order_release );
+}
+
+//-----------------------------------------------------------
+void TraceLog::Clear()
+{
+    std::lock_guard<std::mutex> lock( _bufferLock );
+
+    // The owning threads may be recording spans, so only they modify count
+    for( ThreadBuffer* buffer : _buffers )
+        buffer->clearedCount = buffer->count.load( std::memory_order_acquire );
+}
+
+//-----------------------------------------------------------
+bool TraceLog::WriteJson( const char* path )
+{
+    ASSERT( path );
+    std::lock_guard<std::mutex> lock( _bufferLock );
+
+    FILE* file = fopen( path, "w" );
+    if( !file )
+        return false;
+
+    fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    fprintf( file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"bladebit\"}}" );
+
+    uint64 droppedCount = 0;
+    std::vector<Span> spans;
+
+    for( const ThreadBuffer* buffer : _buffers )
+    {
+        const char* name = buffer->name ? buffer->name : "thread";
+
+        if( buffer->nameIndex >= 0 )
+            fprintf( file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %d\"}}", buffer->tid, name, buffer->nameIndex );
+        else
+            fprintf( file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", buffer->tid, name );
+
+        // Copy the spans from oldest to newest, as the owning thread may keep recording them
+        const uint64 end   = buffer->count.load( std::memory_order_acquire );
+        const uint64 first = std::max( buffer->clearedCount, end - std::min( end, (uint64)_capacity ) );
+
+        spans.resize( end - first );
+        for( uint64 i = first; i < end; i++ )
+            spans[i - first] = buffer->spans[i % _capacity];
+
+        // Drop the spans that may have been overwritten while copying,
+        // including the slot of the span being recorded.
+        std::atomic_thread_fence( std::memory_order_acquire );
+        const uint64 newEnd     = buffer->count.load( std::memory_order_relaxed );
+        const uint64 validFirst = std::min( std::max( first, newEnd - std::min( newEnd, (uint64)_capacity - 1 ) ), end );
+
+        droppedCount += validFirst - buffer->clearedCount;
+
+        for( uint64 i = validFirst; i < end; i++ )
+        {
+            const Span& span = spans[i - first];
+
+            const double ts  = std::chrono::duration_cast<std::chrono::nanoseconds>( span.start - _startTime ).count() / 1000.0;
+            const double dur = std::chrono::duration_cast<std::chrono::nanoseconds>( span.end   - span.start ).count() / 1000.0;
+
+            fprintf( file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3lf,\"dur\":%.3lf",
+                     span.name, span.category, buffer->tid, ts, dur );
+
+            if( span.arg >= 0 )
+                fprintf( file, ",\"args\":{\"value\":%lld}}", (long long)span.arg );
+            else
+                fprintf( file, "}" );
+        }
+    }
+
+    fprintf( file, "\n]}\n" );
+
+    const bool ok = ferror( file ) == 0;
+    fclose( file );
+
+    if( droppedCount )
+        Log::Line( "Trace ring buffers were full: The oldest %llu spans were dropped.", (llu)droppedCount );
+
+    return ok;
+}
+
+//-----------------------------------------------------------
+const char* TraceLog::TypeName( const std::type_info& type )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    int   status    = 0;
+    char* demangled = abi::__cxa_demangle( type.name(), nullptr, nullptr, &status );
+
+    // #NOTE: Intentionally leaked, as it is kept by the spans. Called once per type.
+    if( status == 0 && demangled )
+        return demangled;
+#endif
+    return type.name();
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <typeinfo>
+
+/**
+ * Low-overhead timeline tracing of jobs, thread barriers, fence waits and I/O commands.
+ *
+ * Each thread records spans to its own fixed-size ring buffer, so recording a span takes no locks.
+ * When a ring buffer is full, the oldest spans of that thread are overwritten.
+ * The spans are exported as Chrome trace-event JSON, which can be opened in chrome://tracing
+ * or https://ui.perfetto.dev.
+ *
+ * Tracing is disabled by default, in which case a span costs a single branch.
+ * Span names and categories must be string literals, or otherwise outlive the trace.
+ */
+class TraceLog
+{
+public:
+    // Enables tracing. Must be called before the threads to trace start recording spans.
+    static void Enable( uint32 eventsPerThread );
+
+    inline static bool IsEnabled() { return _enabled; }
+
+    // Names the calling thread in the exported trace. name must be a string literal.
+    // May be called before tracing is enabled.
+    static void SetThreadName( const char* name, int32 index = -1 );
+
+    // Records a span on the calling thread. arg is exported if it is not negative.
+    static void AddSpan( const char* name, const char* category, const TimePoint start, const TimePoint end, int64 arg = -1 );
+
+    // Discards all recorded spans.
+    // Other threads may keep recording spans, which are kept.
+    static void Clear();
+
+    // Writes all recorded spans as Chrome trace-event JSON, replacing the file.
+    // Other threads may keep recording spans: Spans recorded while writing may be left out,
+    // as well as the oldest spans of a full ring buffer that were overwritten while writing.
+    static bool WriteJson( const char* path );
+
+    // Returns a readable name for a type, for span names. Demangled once per type.
+    static const char* TypeName( const std::type_info& type );
+
+private:
+    struct Span
+    {
+        const char* name;
+        const char* category;
+        TimePoint   start;
+        TimePoint   end;
+        int64       arg;
+    };
+
+    struct ThreadBuffer
+    {
+        Span*               spans;
+        std::atomic<uint64> count;          // Total spans recorded, including the ones overwritten. Only modified by the owning thread.
+        uint64              clearedCount;   // count when last cleared. Protected by _bufferLock.
+        uint32              tid;
+        const char* name;
+        int32       nameIndex;
+    };
+
+    static ThreadBuffer* CreateThreadBuffer();
+
+private:
+    static bool                       _enabled;
+    static uint32                     _capacity;     // Spans per thread
+    static TimePoint                  _startTime;
+    static std::mutex                 _bufferLock;
+    static std::vector<ThreadBuffer*> _buffers;
+
+    static thread_local ThreadBuffer* _threadBuffer;
+    static thread_local const char*   _threadName;
+    static thread_local int32         _threadNameIndex;
+};
+
+// Records a span from its construction to its destruction
+class TraceSpan
+{
+public:
+    //-----------------------------------------------------------
+    inline TraceSpan( const char* name, const char* category, const int64 arg = -1 )
+        : _name( TraceLog::IsEnabled() ? name : nullptr )
+    {
+        if( _name )
+        {
+            _category = category;
+            _arg      = arg;
+            _start    = TimerBegin();
+        }
+    }
+
+    //-----------------------------------------------------------
+    inline ~TraceSpan()
+    {
+        if( _name )
+            TraceLog::AddSpan( _name, _category, _start, TimerBegin(), _arg );
+    }
+
+private:
+    const char* _name;
+    const char* _category;
+    int64       _arg;
+    TimePoint   _start;
+};
+
+#define BB_TRACE_CONCAT_IMPL( a, b ) a##b
+#define BB_TRACE_CONCAT( a, b ) BB_TRACE_CONCAT_IMPL( a, b )
+
+// Traces the enclosing scope: TRACE_SPAN( name, category [, arg] )
+#define TRACE_SPAN( ... ) TraceSpan BB_TRACE_CONCAT( _traceSpan, __LINE__ )( __VA_ARGS__ )
@@ -0,0 +1,90 @@
+#include "TestUtil.h"
+#include "util/BitView.h"
+#include <random>
+#include <utility>
+#include <vector>
+
+// BitPacker and BitUnpacker must have the same layout as BitWriter::Write and BitReader::ReadBits64,
+// for every bit width, starting at any bit offset, and when a range is written in several parts.
+
+static std::mt19937_64 rng( 1234 );
+
+template<uint32 bitCount>
+static void TestBitCount();
+
+template<uint32... bitCounts>
+static void TestBitCounts( std::integer_sequence<uint32, bitCounts...> )
+{
+    ( TestBitCount<bitCounts+1>(), ... );
+}
+
+//-----------------------------------------------------------
+TEST_CASE( "bit-pack", "[unit-core]" )
+{
+    TestBitCounts( std::make_integer_sequence<uint32, 64>() );
+}
+
+//-----------------------------------------------------------
+template<uint32 bitCount>
+void TestBitCount()
+{
+    const uint64 valueMask  = bitCount < 64 ? ( 1ull << bitCount ) - 1 : 0xFFFFFFFFFFFFFFFFull;
+    const uint32 iterations = 16;
+    const int64  maxCount   = 300;
+
+    for( uint32 it = 0; it < iterations; it++ )
+    {
+        const uint64 startOffset = rng() % 200;
+        const int64  count       = (int64)( rng() % maxCount ) + 1;
+        const size_t fieldCount  = CDiv( startOffset + (uint64)count * bitCount, 64 ) + 2;
+        const size_t sizeBits    = fieldCount * 64;
+
+        // Unmasked values: The writers must only keep their low bits
+        std::vector<uint64> values( (size_t)count );
+        for( auto& v : values )
+            v = rng();
+
+        // Random bits around the written range must be kept
+        std::vector<uint64> refFields( fieldCount );
+        for( auto& f : refFields )
+            f = rng();
+
+        std::vector<uint64> testFields = refFields;
+
+        BitWriter refWriter( refFields.data(), sizeBits, startOffset );
+        for( int64 i = 0; i < count; i++ )
+            refWriter.Write( values[i] & valueMask, bitCount );
+
+        // Split the range in 3 parts: WriteValues, a BitPacker, and BitWriter::Write
+        const int64 split0 = (int64)( rng() % (uint64)( count + 1 ) );
+        const int64 split1 = split0 + (int64)( rng() % (uint64)( count - split0 + 1 ) );
+
+        BitWriter testWriter( testFields.data(), sizeBits, startOffset );
+        testWriter.WriteValues<bitCount>( values.data(), split0 );
+        {
+            BitPacker packer( testWriter );
+            for( int64 i = split0; i < split1; i++ )
+                packer.Write<bitCount>( values[i] );
+            packer.Flush();
+        }
+        for( int64 i = split1; i < count; i++ )
+            testWriter.Write( values[i] & valueMask, bitCount );
+
+        ENSURE( testWriter.Position() == refWriter.Position() );
+        ENSURE( memcmp( testFields.data(), refFields.data(), fieldCount * sizeof( uint64 ) ) == 0 );
+
+        // Read back from an arbitrary value onwards
+        const int64  readStart  = (int64)( rng() % (uint64)count );
+        const uint64 readOffset = startOffset + (uint64)readStart * bitCount;
+
+        BitUnpacker unpacker( testFields.data(), sizeBits, readOffset );
+        BitReader   reader  ( testFields.data(), sizeBits, readOffset );
+
+        for( int64 i = readStart; i < count; i++ )
+        {
+            const uint64 value = unpacker.Read<bitCount>();
+            ENSURE( value == ( values[i] & valueMask ) );
+            ENSURE( value == reader.ReadBits64( bitCount ) );
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "TestUtil.h"
+#include "plotdisk/DiskCachePlanner.h"
+
+const size_t blockSize = 4096;
+
+//-----------------------------------------------------------
+TEST_CASE( "cache-planner", "[unit-core]" )
+{
+    SECTION( "no-cache" )
+    {
+        DiskCachePlanner planner( blockSize );
+        planner.AddUse( FileId::FX0, "fx0", 64, 64 MB );
+
+        ENSURE( planner.Plan( 0 ) == 0 );
+        ENSURE( planner.CacheSize( FileId::FX0 ) == 0 );
+        ENSURE( planner.SavedIOBytes() == 0 );
+        ENSURE( planner.TotalIOBytes() == 2 * 64 MB );
+    }
+
+    SECTION( "enough-cache" )
+    {
+        // Every file set is cached in full, and the rest is left unassigned
+        DiskCachePlanner planner( blockSize );
+        planner.AddUse( FileId::FX0, "fx0", 64, 64 MB );
+        planner.AddUse( FileId::FX0, "fx0", 64, 32 MB );
+        planner.AddUse( FileId::T2 , "t2" , 1 , 16 MB );
+
+        ENSURE( planner.Plan( 1024 MB ) == 80 MB );
+        ENSURE( planner.CacheSize( FileId::FX0 ) == 64 MB );
+        ENSURE( planner.CacheSize( FileId::T2  ) == 16 MB );
+        ENSURE( planner.SavedIOBytes() == planner.TotalIOBytes() );
+    }
+
+    SECTION( "densest-first" )
+    {
+        // The first 32 MiB of FX0 are used 3 times, so they are cached before T2,
+        // which is used once. T2 and the tail of FX0 are then tied, and go in file id order.
+        DiskCachePlanner planner( blockSize );
+        planner.AddUse( FileId::FX0, "fx0", 64, 32 MB );
+        planner.AddUse( FileId::FX0, "fx0", 64, 32 MB );
+        planner.AddUse( FileId::FX0, "fx0", 64, 64 MB );
+        planner.AddUse( FileId::T2 , "t2" , 1 , 16 MB );
+
+        ENSURE( planner.Plan( 40 MB ) == 40 MB );
+        ENSURE( planner.CacheSize( FileId::FX0 ) == 40 MB );
+        ENSURE( planner.CacheSize( FileId::T2  ) == 0 );
+        ENSURE( planner.SavedIOBytes() == 2 * ( 32 MB * 3 + 8 MB ) );
+
+        // Re-planning resets the previous plan
+        ENSURE( planner.Plan( 16 MB ) == 16 MB );
+        ENSURE( planner.CacheSize( FileId::FX0 ) == 16 MB );
+        ENSURE( planner.CacheSize( FileId::T2  ) == 0 );
+    }
+
+    SECTION( "alignment" )
+    {
+        // Cache sizes are rounded down to a block per bucket
+        const uint32 bucketCount = 64;
+        const size_t granularity = bucketCount * blockSize;
+
+        DiskCachePlanner planner( blockSize );
+        planner.AddUse( FileId::FX0, "fx0", bucketCount, 64 MB );
+
+        ENSURE( planner.Plan( granularity * 3 + granularity / 2 ) == granularity * 3 );
+        ENSURE( planner.CacheSize( FileId::FX0 ) == granularity * 3 );
+        ENSURE( planner.Plan( granularity - 1 ) == 0 );
+    }
+}
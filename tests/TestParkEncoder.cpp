@@ -0,0 +1,96 @@
+#include "TestUtil.h"
+#include "plotmem/ParkWriter.h"
+#include <random>
+#include <vector>
+
+// ParkEncoder must write the same bytes as WritePark, whether it encodes
+// a single park, BB_PARK_ENCODER_LANES parks interleaved, or a partial park.
+
+static void GenerateLinePoints( std::mt19937_64& rng, uint64* linePoints, uint64 count );
+static void WriteReferenceParks( TableId table, uint64 parkCount, uint64 lastParkEntries, const uint64* linePoints, byte* parkBuffer );
+
+//-----------------------------------------------------------
+TEST_CASE( "park-encoder", "[unit-core]" )
+{
+    std::mt19937_64 rng( 1234 );
+
+    const TableId tables[] = { TableId::Table1, TableId::Table2, TableId::Table6 };
+
+    for( const TableId table : tables )
+    {
+        const size_t parkSize = CalculateParkSize( table );
+
+        // Enough parks for 2 interleaved groups and a remainder encoded alone
+        const uint64 parkCount = BB_PARK_ENCODER_LANES * 2 + 1;
+
+        std::vector<uint64> linePoints( parkCount * kEntriesPerPark );
+        std::vector<byte>   refParks  ( parkCount * parkSize );
+        std::vector<byte>   testParks ( parkCount * parkSize );
+
+        GenerateLinePoints( rng, linePoints.data(), linePoints.size() );
+
+        SECTION( "single-lane" )
+        {
+            WriteReferenceParks( table, 1, kEntriesPerPark, linePoints.data(), refParks.data() );
+
+            ParkEncoder encoder( table );
+            encoder.WriteParks( 1, linePoints.data(), testParks.data() );
+
+            ENSURE( memcmp( refParks.data(), testParks.data(), parkSize ) == 0 );
+        }
+
+        SECTION( "interleaved" )
+        {
+            WriteReferenceParks( table, parkCount, kEntriesPerPark, linePoints.data(), refParks.data() );
+
+            ParkEncoder encoder( table );
+            encoder.WriteParks( parkCount, linePoints.data(), testParks.data() );
+
+            for( uint64 i = 0; i < parkCount; i++ )
+                ENSURE( memcmp( refParks.data() + i * parkSize, testParks.data() + i * parkSize, parkSize ) == 0 );
+        }
+
+        SECTION( "partial-park" )
+        {
+            const uint64 counts[] = { 1, 2, 3, 777, kEntriesPerPark-1 };
+
+            for( const uint64 count : counts )
+            {
+                WriteReferenceParks( table, 1, count, linePoints.data(), refParks.data() );
+
+                ParkEncoder encoder( table );
+                encoder.WritePark( count, linePoints.data(), testParks.data() );
+
+                ENSURE( memcmp( refParks.data(), testParks.data(), parkSize ) == 0 );
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------
+void GenerateLinePoints( std::mt19937_64& rng, uint64* linePoints, const uint64 count )
+{
+    // Sorted line points of a k32 table: 2^32 line points over a 2^63 range, as in 'bench parks'
+    uint64 linePoint = 0;
+
+    for( uint64 i = 0; i < count; i++ )
+    {
+        linePoint    += rng() & ( ( 1ull << _K ) - 1 );
+        linePoints[i] = linePoint;
+    }
+}
+
+//-----------------------------------------------------------
+void WriteReferenceParks( const TableId table, const uint64 parkCount, const uint64 lastParkEntries, const uint64* linePoints, byte* parkBuffer )
+{
+    const size_t parkSize = CalculateParkSize( table );
+
+    // WritePark overwrites its line points with the small deltas
+    std::vector<uint64> lpCopy( linePoints, linePoints + parkCount * kEntriesPerPark );
+
+    for( uint64 i = 0; i < parkCount; i++ )
+    {
+        const uint64 entries = i + 1 == parkCount ? lastParkEntries : kEntriesPerPark;
+        WritePark( parkSize, entries, lpCopy.data() + i * kEntriesPerPark, parkBuffer + i * parkSize, table );
+    }
+}
@@ -0,0 +1,83 @@
+#include "TestUtil.h"
+#include "ChiaConsts.h"
+#include "tools/PlotTools.h"
+#include <algorithm>
+#include <vector>
+
+// Entries with the same f7 may be in a different order between two plots,
+// even when they span a park boundary. Only a genuine difference must fail.
+
+static const int64 parkCount  = 3;
+static const int64 entryCount = kEntriesPerPark * parkCount;
+
+static bool CompareParks( const std::vector<uint64>& ref, const std::vector<uint64>& tgt, int64 park );
+
+//-----------------------------------------------------------
+TEST_CASE( "plot-compare-p7", "[unit-core]" )
+{
+    std::vector<uint64> ref( entryCount );
+    for( int64 i = 0; i < entryCount; i++ )
+        ref[i] = (uint64)i * 7 + 1;
+
+    std::vector<uint64> tgt = ref;
+
+    SECTION( "identical" )
+    {
+        for( int64 park = 0; park < parkCount; park++ )
+            ENSURE( CompareParks( ref, tgt, park ) );
+    }
+
+    SECTION( "group-in-park" )
+    {
+        std::reverse( tgt.begin() + 100, tgt.begin() + 105 );
+
+        for( int64 park = 0; park < parkCount; park++ )
+            ENSURE( CompareParks( ref, tgt, park ) );
+    }
+
+    SECTION( "group-spans-parks" )
+    {
+        // The group starts at the end of park 0, and ends at the start of park 1
+        std::rotate( tgt.begin() + kEntriesPerPark - 2, tgt.begin() + kEntriesPerPark + 1, tgt.begin() + kEntriesPerPark + 2 );
+
+        // And another one that spans parks 1 and 2, with the first entry of park 2 in place
+        std::reverse( tgt.begin() + kEntriesPerPark * 2 - 3, tgt.begin() + kEntriesPerPark * 2 + 4 );
+
+        for( int64 park = 0; park < parkCount; park++ )
+            ENSURE( CompareParks( ref, tgt, park ) );
+    }
+
+    SECTION( "mismatch" )
+    {
+        // A differing entry in each park, following a group that spans from the previous park
+        std::reverse( tgt.begin() + kEntriesPerPark - 2, tgt.begin() + kEntriesPerPark + 2 );
+
+        for( int64 park = 0; park < parkCount; park++ )
+            tgt[park * kEntriesPerPark + 10] ^= 1;
+
+        for( int64 park = 0; park < parkCount; park++ )
+            ENSURE( !CompareParks( ref, tgt, park ) );
+    }
+
+    SECTION( "mismatch-at-park-start" )
+    {
+        tgt[kEntriesPerPark] ^= 1;
+
+        ENSURE(  CompareParks( ref, tgt, 0 ) );
+        ENSURE( !CompareParks( ref, tgt, 1 ) );
+        ENSURE(  CompareParks( ref, tgt, 2 ) );
+    }
+}
+
+//-----------------------------------------------------------
+bool CompareParks( const std::vector<uint64>& ref, const std::vector<uint64>& tgt, const int64 park )
+{
+    // Load the previous and next parks, as the plot comparer does
+    const int64 firstPark = std::max( park - 1, (int64)0 );
+    const int64 endPark   = std::min( park + 2, parkCount );
+    const int64 offset    = firstPark * kEntriesPerPark;
+    const int64 start     = ( park - firstPark ) * kEntriesPerPark;
+
+    return CompareP7Entries( ref.data() + offset, tgt.data() + offset, ( endPark - firstPark ) * kEntriesPerPark,
+                             start, start + kEntriesPerPark );
+}
@@ -0,0 +1,170 @@
+#include "TestUtil.h"
+#include "plotdisk/DiskBufferQueue.h"
+#include <random>
+#include <string>
+#include <vector>
+
+// Writes the same plot data through the I/O queue twice, with direct I/O:
+// Once uninterrupted, and once interrupted after a checkpoint, then resumed.
+// Both plot files must be identical.
+
+static const char* tmpDir    = "/tmp";
+static const size_t dataSize = 20ull MB;   // Crosses the plot write buffer more than once
+
+static const byte plotId[32] = {};
+static const byte plotMemo[] = { 1, 2, 3, 4, 5, 6, 7 };
+
+static DiskBufferQueue* CreateQueue();
+static void WritePlotData( DiskBufferQueue& ioQueue, const std::vector<size_t>& chunks, const byte* data, size_t chunkStart, size_t chunkEnd );
+static void FinishPlot( DiskBufferQueue& ioQueue, const byte* tablePointers );
+static std::vector<byte> ReadWholeFile( const std::string& path );
+
+//-----------------------------------------------------------
+TEST_CASE( "plot-file-resume", "[unit-core]" )
+{
+    std::mt19937_64 rng( 1234 );
+
+    std::vector<byte> data( dataSize );
+    for( auto& b : data )
+        b = (byte)rng();
+
+    byte tablePointers[80];
+    for( auto& b : tablePointers )
+        b = (byte)rng();
+
+    // Odd chunk sizes, so that the checkpoint falls in the middle of a block
+    std::vector<size_t> chunks;
+    for( size_t total = 0; total < dataSize; )
+    {
+        const size_t size = std::min( (size_t)( rng() % ( 512 * 1024 ) ) | 1, dataSize - total );
+        chunks.push_back( size );
+        total += size;
+    }
+
+    const size_t checkpointChunk = chunks.size() / 2;
+
+    // The queue keeps a pointer to the plot file name
+    const std::string refName       = "test-resume-ref.plot";
+    const std::string resumeName    = "test-resume.plot";
+    const std::string refTmpName    = refName    + ".tmp";
+    const std::string resumeTmpName = resumeName + ".tmp";
+    const std::string statesPath    = std::string( tmpDir ) + "/test-resume.states";
+
+    // Uninterrupted
+    {
+        DiskBufferQueue& ioQueue = *CreateQueue();
+        ioQueue.OpenPlotFile( refTmpName.c_str(), plotId, plotMemo, (uint16)sizeof( plotMemo ), true );
+        WritePlotData( ioQueue, chunks, data.data(), 0, chunks.size() );
+        FinishPlot( ioQueue, tablePointers );
+    }
+
+    // Interrupted after a checkpoint
+    {
+        DiskBufferQueue& ioQueue = *CreateQueue();
+        ioQueue.OpenPlotFile( resumeTmpName.c_str(), plotId, plotMemo, (uint16)sizeof( plotMemo ), true );
+        WritePlotData( ioQueue, chunks, data.data(), 0, checkpointChunk );
+
+        FileStream states;
+        ENSURE( states.Open( statesPath.c_str(), FileMode::Create, FileAccess::Write ) );
+        ioQueue.WriteFileSetStates( states );
+        states.Close();
+
+        // Work lost after the checkpoint: Write garbage, and force it out to disk
+        std::vector<byte> garbage( 3 * 4096 + 17, 0xCC );
+        Fence fence;
+        ioQueue.WriteFile( FileId::PLOT, 0, garbage.data(), garbage.size() );
+        ioQueue.SeekFile( FileId::PLOT, 0, 0, SeekOrigin::Current );
+        ioQueue.SignalFence( fence );
+        ioQueue.CommitCommands();
+        fence.Wait();
+
+        // #NOTE: The queue is not terminated, as its command thread can't exit yet.
+        //        Its plot file stays open, like the one of a plotter that was killed.
+    }
+
+    // Resumed
+    {
+        DiskBufferQueue& ioQueue = *CreateQueue();
+
+        FileStream states;
+        ENSURE( states.Open( statesPath.c_str(), FileMode::Open, FileAccess::Read ) );
+        ioQueue.ReadFileSetStates( states );
+        states.Close();
+
+        ioQueue.OpenPlotFile( resumeTmpName.c_str(), plotId, plotMemo, (uint16)sizeof( plotMemo ), true );
+        WritePlotData( ioQueue, chunks, data.data(), checkpointChunk, chunks.size() );
+        FinishPlot( ioQueue, tablePointers );
+        ioQueue.EndResume();
+    }
+
+    const std::vector<byte> refPlot    = ReadWholeFile( std::string( tmpDir ) + "/" + refName );
+    const std::vector<byte> resumePlot = ReadWholeFile( std::string( tmpDir ) + "/" + resumeName );
+
+    ENSURE( refPlot.size() > dataSize );
+    ENSURE( refPlot.size() == resumePlot.size() );
+    ENSURE( memcmp( refPlot.data(), resumePlot.data(), refPlot.size() ) == 0 );
+
+    // The data follows the block-aligned header
+    const size_t headerSize = refPlot.size() - dataSize;
+    ENSURE( memcmp( refPlot.data() + headerSize, data.data(), dataSize ) == 0 );
+
+    remove( ( std::string( tmpDir ) + "/" + refName    ).c_str() );
+    remove( ( std::string( tmpDir ) + "/" + resumeName ).c_str() );
+    remove( statesPath.c_str() );
+}
+
+//-----------------------------------------------------------
+DiskBufferQueue* CreateQueue()
+{
+    static byte dummyHeap = 1;
+    return new DiskBufferQueue( tmpDir, tmpDir, tmpDir, &dummyHeap, dummyHeap, 1 );
+}
+
+//-----------------------------------------------------------
+void WritePlotData( DiskBufferQueue& ioQueue, const std::vector<size_t>& chunks, const byte* data, size_t chunkStart, size_t chunkEnd )
+{
+    for( size_t i = 0; i < chunkStart; i++ )
+        data += chunks[i];
+
+    for( size_t i = chunkStart; i < chunkEnd; i++ )
+    {
+        ioQueue.WriteFile( FileId::PLOT, 0, data, chunks[i] );
+        data += chunks[i];
+    }
+
+    Fence fence;
+    ioQueue.SignalFence( fence );
+    ioQueue.CommitCommands();
+    fence.Wait();
+}
+
+//-----------------------------------------------------------
+void FinishPlot( DiskBufferQueue& ioQueue, const byte* tablePointers )
+{
+    // Seek back into the header, as when writing the table pointers
+    const int64 tablePointersOffset = 4 + 32;
+    ioQueue.SeekFile( FileId::PLOT, 0, tablePointersOffset, SeekOrigin::Begin );
+    ioQueue.WriteFile( FileId::PLOT, 0, tablePointers, 80 );
+    ioQueue.SeekFile( FileId::PLOT, 0, 0, SeekOrigin::End );
+
+    Fence fence;
+    ENSURE( ioQueue.FinishPlot( fence ).length() > 0 );
+}
+
+//-----------------------------------------------------------
+std::vector<byte> ReadWholeFile( const std::string& path )
+{
+    FileStream file;
+    FatalIf( !file.Open( path.c_str(), FileMode::Open, FileAccess::Read ), "Failed to open '%s'.", path.c_str() );
+
+    std::vector<byte> buffer( (size_t)file.Size() );
+
+    for( size_t offset = 0; offset < buffer.size(); )
+    {
+        const ssize_t r = file.Read( buffer.data() + offset, buffer.size() - offset );
+        FatalIf( r <= 0, "Failed to read '%s'.", path.c_str() );
+        offset += (size_t)r;
+    }
+
+    return buffer;
+}